@@ -3,6 +3,11 @@ package Bio::Easel;
 use 5.006;
 use strict;
 use warnings FATAL => 'all';
+use Carp;
+use Time::HiRes;
+use File::Path ();
+use File::Temp ();
+use Storable ();
 
 =head1 NAME
 
@@ -16,6 +21,26 @@ Version 0.01
 
 our $VERSION = '0.01';
 
+# number of threads for the parallel C kernels, undef for the
+# default, see set_threads()
+our $NTHREADS = undef;
+
+# progress reporting and cancellation of long running operations,
+# see set_progress_callback() and cancel()
+our $PROGRESS_CB       = undef;
+our $PROGRESS_INTERVAL = 1;
+our $CANCEL            = 0;
+
+# directory for cached results of expensive statistics, undef for
+# no caching, see set_cache_dir()
+our $CACHE_DIR = $ENV{BIO_EASEL_CACHE_DIR};
+
+# bump this when a cached result's format or meaning changes, so
+# old results are not reused
+our $CACHE_VERSION = 2;
+
+my $progress_last = 0; # time of the last progress callback from perl code, see _progress()
+
 
 =head1 SYNOPSIS
 
@@ -49,6 +74,310 @@ sub function1 {
 sub function2 {
 }
 
+=head2 set_threads
+
+  Title    : set_threads
+  Incept   : Sun Oct 18 11:52:36 2026
+  Usage    : Bio::Easel->set_threads($n)
+  Function : Set the number of threads used by the parallel C code
+           : in all Bio::Easel modules (pairwise identities, etc.),
+           : including the calling thread, so 1 means no threads.
+           : If never called, or called with undef or 0, the number
+           : is taken from the BIO_EASEL_THREADS environment variable,
+           : else from the number of CPUs allotted to the cluster job
+           : (SLURM_CPUS_PER_TASK, NSLOTS, PBS_NUM_PPN, NCPUS or
+           : LSB_DJOB_NUMPROC; 1 for a job that sets none of these),
+           : else the number of CPUs the process may run on.
+  Args     : $n: number of threads, undef or 0 for the default
+  Returns  : void
+  Dies     : if $n is not a non-negative integer
+
+=cut
+
+sub set_threads {
+  my ( $caller, $n ) = @_;
+
+  if ( defined $n && $n !~ m/^\d+$/ ) {
+    croak "set_threads() number of threads must be a non-negative integer, not $n";
+  }
+  $NTHREADS = ( defined $n && $n > 0 ) ? $n : undef;
+
+  return;
+}
+
+=head2 get_threads
+
+  Title    : get_threads
+  Incept   : Sun Oct 18 11:55:02 2026
+  Usage    : $n = Bio::Easel->get_threads()
+  Function : Return the number of threads the parallel C code will
+           : use, see set_threads().
+  Args     : none
+  Returns  : number of threads, >= 1
+
+=cut
+
+sub get_threads {
+  require Bio::Easel::MSA;
+
+  return Bio::Easel::MSA::_c_get_threads();
+}
+
+=head2 set_progress_callback
+
+  Title    : set_progress_callback
+  Incept   : Sun Oct 18 15:12:40 2026
+  Usage    : Bio::Easel->set_progress_callback($cb, $interval)
+  Function : Set a function to be called with the progress of
+           : long running operations: MSA rfam_qc_stats() (also
+           : rfam_qc_stats_stream(), reported as "rfam_qc_stats"),
+           : weight_GSC() and filter_msa_subset(), and SqFile
+           : create_ssi_index(), score_pssm(), load_all() and
+           : composition_stats(). It is called as
+           : $cb->($operation, $done, $total), where $operation is
+           : the name of the method and $done is the amount of work
+           : done out of $total (in units that depend on the
+           : operation), when the operation starts, at most once
+           : every $interval seconds while it runs, and when it is
+           : finished ($done == $total). It is always called from
+           : the calling thread, even when the work is done by
+           : several threads, which keep working meanwhile.
+           :
+           : The callback can stop the operation by calling
+           : cancel() or by dying; the operation then dies with
+           : "<operation> cancelled".
+           :
+           : The callback may call other Bio::Easel methods, but
+           : the worker threads are busy with the operation it
+           : reports on: parallel methods called from the callback
+           : run single threaded.
+  Args     : $cb:       code ref, undef for no callback
+           : $interval: minimum number of seconds between calls,
+           :            default 1
+  Returns  : void
+  Dies     : if $cb is not a code ref or $interval is not a
+           : non-negative number
+
+=cut
+
+sub set_progress_callback {
+  my ( $caller, $cb, $interval ) = @_;
+
+  if ( defined $cb && ref($cb) ne "CODE" ) {
+    croak "set_progress_callback() callback must be a code ref";
+  }
+  if ( defined $interval && $interval !~ m/^\d*\.?\d+(?:[eE][-+]?\d+)?$/ ) {
+    croak "set_progress_callback() interval must be a non-negative number of seconds, not $interval";
+  }
+  $PROGRESS_CB       = $cb;
+  $PROGRESS_INTERVAL = ( defined $interval ) ? $interval : 1;
+
+  return;
+}
+
+=head2 cancel
+
+  Title    : cancel
+  Incept   : Sun Oct 18 15:16:05 2026
+  Usage    : Bio::Easel->cancel()
+  Function : Cancel the operation in progress: meant to be called
+           : by the progress callback, see set_progress_callback().
+           : The operation stops at the end of the block of work
+           : it is on, and dies with "<operation> cancelled". If no
+           : operation is in progress the next one is cancelled
+           : as soon as it starts.
+  Args     : none
+  Returns  : void
+
+=cut
+
+sub cancel {
+  $CANCEL = 1;
+
+  return;
+}
+
+=head2 _progress
+
+  Title    : _progress
+  Incept   : Sun Oct 18 15:19:22 2026
+  Usage    : Bio::Easel::_progress($operation, $done, $total)
+  Function : For long running operations written in perl: report
+           : progress to the callback, if it's time to (see
+           : set_progress_callback()), and stop if cancelled.
+           : Call it with $done == 0 when the operation starts,
+           : between blocks of work, and with $done == $total when
+           : it's finished. (The C code has its own version of this,
+           : in bio_easel_threads.h.)
+  Args     : $operation: name of the operation
+           : $done:      amount of work done
+           : $total:     total amount of work
+  Returns  : void
+  Dies     : with "$operation cancelled" if cancel() was called or
+           : the callback died
+
+=cut
+
+sub _progress {
+  my ( $operation, $done, $total ) = @_;
+
+  if ($CANCEL) { $CANCEL = 0; croak "$operation cancelled"; }
+  if ( defined $PROGRESS_CB
+       && ( $done == 0 || $done == $total || Time::HiRes::time() - $progress_last >= $PROGRESS_INTERVAL ) ) {
+    $progress_last = Time::HiRes::time();
+    if ( ! eval { $PROGRESS_CB->( $operation, $done, $total ); 1; } ) {
+      my $err = $@;
+      $CANCEL = 0;
+      croak "$operation cancelled, progress callback died: $err";
+    }
+    if ($CANCEL) { $CANCEL = 0; croak "$operation cancelled"; }
+  }
+
+  return;
+}
+
+=head2 set_cache_dir
+
+  Title    : set_cache_dir
+  Incept   : Sun Oct 18 17:35:51 2026
+  Usage    : Bio::Easel->set_cache_dir($dir)
+  Function : Store the results of expensive per-alignment statistics
+           : (MSA rfam_qc_stats(), weight_GSC(), pos_covariation()
+           : and average_id()) in directory $dir, and reuse them,
+           : in this or a later process, for an alignment with the
+           : same sequences, names and annotation the statistic
+           : depends on, and the same parameters. The default is
+           : taken from the BIO_EASEL_CACHE_DIR environment
+           : variable, else no caching.
+           :
+           : Several processes can safely share a cache directory,
+           : results are written to a temporary file and renamed.
+           : Nothing is ever removed from it: delete old files, or
+           : the whole directory, to limit its size.
+  Args     : $dir: cache directory, created if it doesn't exist,
+           :       undef for no caching
+  Returns  : void
+  Dies     : if $dir can't be created or isn't a writable directory
+
+=cut
+
+sub set_cache_dir {
+  my ( $caller, $dir ) = @_;
+
+  if ( defined $dir ) {
+    if ( ! -d $dir ) {
+      eval { File::Path::mkpath($dir); };
+      if ( ! -d $dir ) { croak "set_cache_dir() unable to create cache directory $dir"; }
+    }
+    if ( ! -w $dir ) { croak "set_cache_dir() cache directory $dir is not writable"; }
+  }
+  $CACHE_DIR = $dir;
+
+  return;
+}
+
+=head2 get_cache_dir
+
+  Title    : get_cache_dir
+  Incept   : Sun Oct 18 17:37:14 2026
+  Usage    : $dir = Bio::Easel->get_cache_dir()
+  Function : Return the result cache directory, see set_cache_dir().
+  Args     : none
+  Returns  : cache directory, undef if results are not cached
+
+=cut
+
+sub get_cache_dir {
+  return $CACHE_DIR;
+}
+
+=head2 _cache_fetch
+
+  Title    : _cache_fetch
+  Incept   : Sun Oct 18 17:39:40 2026
+  Usage    : $resultR = Bio::Easel::_cache_fetch($key)
+  Function : Return the result cached under $key, see
+           : set_cache_dir(). A cache file that can't be read
+           : (e.g. truncated by a full disk) is treated as a miss.
+  Args     : $key: hexadecimal key, see Bio::Easel::MSA::_cache_key()
+  Returns  : reference to the cached result, undef if caching is
+           : off or $key is not in the cache
+
+=cut
+
+sub _cache_fetch {
+  my ( $key ) = @_;
+
+  if ( ! defined $CACHE_DIR ) { return undef; }
+  my $file = _cache_file($key);
+  if ( ! -e $file ) { return undef; }
+
+  my $resultR = eval { Storable::retrieve($file); };
+  return ( ref($resultR) eq "HASH" && defined $resultR->{version} && $resultR->{version} == $CACHE_VERSION )
+      ? $resultR->{result} : undef;
+}
+
+=head2 _cache_store
+
+  Title    : _cache_store
+  Incept   : Sun Oct 18 17:42:03 2026
+  Usage    : Bio::Easel::_cache_store($key, $resultR)
+  Function : Cache $resultR under $key, see set_cache_dir(),
+           : atomically: it is written to a temporary file in
+           : the cache directory, then renamed. Failing to
+           : write the cache only warns, the result is still
+           : good.
+  Args     : $key:     hexadecimal key, see Bio::Easel::MSA::_cache_key()
+           : $resultR: reference to the result, anything Storable
+           :           can serialize
+  Returns  : void
+
+=cut
+
+sub _cache_store {
+  my ( $key, $resultR ) = @_;
+
+  if ( ! defined $CACHE_DIR ) { return; }
+  my $file = _cache_file($key);
+  my ( $dir ) = ( $file =~ m/^(.*)\/[^\/]+$/ );
+
+  my $tmpfile;
+  my $ok = eval {
+    if ( ! -d $dir ) { File::Path::mkpath($dir); }
+    my $fh;
+    ( $fh, $tmpfile ) = File::Temp::tempfile( "$key.XXXXXX", DIR => $dir, SUFFIX => ".tmp", UNLINK => 0 );
+    Storable::nstore_fd( { version => $CACHE_VERSION, result => $resultR }, $fh ) || die "unable to write $tmpfile\n";
+    close($fh) || die "unable to write $tmpfile\n";
+    rename( $tmpfile, $file ) || die "unable to rename $tmpfile to $file\n";
+    1;
+  };
+  if ( ! $ok ) {
+    carp "unable to cache result in $CACHE_DIR: $@";
+    if ( defined $tmpfile && -e $tmpfile ) { unlink $tmpfile; }
+  }
+
+  return;
+}
+
+=head2 _cache_file
+
+  Title    : _cache_file
+  Incept   : Sun Oct 18 17:43:27 2026
+  Usage    : $file = Bio::Easel::_cache_file($key)
+  Function : Return the cache file for $key. Files are spread over
+           : 256 subdirectories, by the first two digits of the key,
+           : to keep directories small.
+  Args     : $key: hexadecimal key, see Bio::Easel::MSA::_cache_key()
+  Returns  : path of the cache file
+
+=cut
+
+sub _cache_file {
+  my ( $key ) = @_;
+
+  return $CACHE_DIR . "/" . substr( $key, 0, 2 ) . "/" . $key . ".stor";
+}
+
 =head1 AUTHOR
 
 Eric Nawrocki, C<< <nawrockie at janelia.hhmi.org> >>
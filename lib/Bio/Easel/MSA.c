@@ -1,14 +1,23 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <unistd.h>
+
 #include "easel.h"
 #include "esl_alphabet.h"
 #include "esl_distance.h"
+#include "esl_dmatrix.h"
 #include "esl_msa.h"
 #include "esl_msafile.h"
 #include "esl_sq.h"
 #include "esl_sqio.h"
+#include "esl_tree.h"
 #include "esl_vectorops.h"
 #include "esl_wuss.h"
 #include "esl_msaweight.h"
 
+#include "bio_easel_threads.h"
+
 /* Macros for converting C structs to perl, and back again)
 * from: http://www.mail-archive.com/inline@perl.org/msg03389.html
 * note the typedef in ~/perl/tw_modules/typedef
@@ -263,14 +272,116 @@ int _c_write_single_unaligned_seq(ESL_MSA *msa, int idx, char *outfile, int do_a
   return eslOK;
 }
 
+/* MSAs shared between perl interpreters.
+ *
+ * When an ithreads perl starts a thread it clones the interpreter,
+ * including every Bio::Easel::MSA object and so the ESL_MSA pointer
+ * inside it. Unless the MSA is copied for the new interpreter (see
+ * CLONE() in MSA.pm), both interpreters then own the same ESL_MSA, so
+ * we count the owners of such MSAs here and free one only when its
+ * last owner does. MSAs that were never shared aren't in the table.
+ * The table is process wide (all interpreters use this same code) and
+ * protected by a mutex.
+ */
+typedef struct {
+  ESL_MSA *msa;
+  int      nref;   /* number of interpreters that own <msa>, >= 2 */
+} SHARED_MSA;
+
+static SHARED_MSA      *shared_msaA       = NULL;  /* [0..nshared_msa-1] */
+static int              nshared_msa       = 0;
+static int              nalloc_shared_msa = 0;
+static pthread_mutex_t  shared_msa_lock   = PTHREAD_MUTEX_INITIALIZER;
+
+/* Function:  _c_share_msa()
+ * Incept:    Sun Oct 18 13:05:12 2026
+ * Synopsis:  Add an owner to <msa>: it is now owned by one more
+ *            interpreter than before.
+ * Returns:   void
+ * Dies:      if out of memory
+ */
+void _c_share_msa (ESL_MSA *msa)
+{
+  int status;
+  int i;
+
+  pthread_mutex_lock(&shared_msa_lock);
+  for(i = 0; i < nshared_msa; i++) {
+    if(shared_msaA[i].msa == msa) { shared_msaA[i].nref++; break; }
+  }
+  if(i == nshared_msa) {
+    if(nshared_msa == nalloc_shared_msa) {
+      ESL_REALLOC(shared_msaA, sizeof(SHARED_MSA) * (nalloc_shared_msa + 16));
+      nalloc_shared_msa += 16;
+    }
+    shared_msaA[nshared_msa].msa  = msa;
+    shared_msaA[nshared_msa].nref = 2;
+    nshared_msa++;
+  }
+  pthread_mutex_unlock(&shared_msa_lock);
+  return;
+
+ ERROR:
+  pthread_mutex_unlock(&shared_msa_lock);
+  croak("out of memory");
+  return;
+}
+
+/* Function:  _c_release_msa()
+ * Incept:    Sun Oct 18 13:09:47 2026
+ * Synopsis:  Remove an owner from <msa>.
+ * Returns:   TRUE if the caller was the last owner of <msa> (or the
+ *            only one, if it was never shared) and should free it,
+ *            FALSE if not.
+ */
+int _c_release_msa (ESL_MSA *msa)
+{
+  int i;
+  int is_last = TRUE;
+
+  pthread_mutex_lock(&shared_msa_lock);
+  for(i = 0; i < nshared_msa; i++) {
+    if(shared_msaA[i].msa == msa) {
+      if(--shared_msaA[i].nref > 0) is_last = FALSE;
+      else                          shared_msaA[i] = shared_msaA[--nshared_msa];
+      break;
+    }
+  }
+  pthread_mutex_unlock(&shared_msa_lock);
+
+  return is_last;
+}
+
+/* Function:  _c_msa_nref()
+ * Incept:    Sun Oct 18 13:12:20 2026
+ * Synopsis:  Return the number of owners of <msa>.
+ * Returns:   1 if <msa> isn't shared, else the number of
+ *            interpreters that own it.
+ */
+int _c_msa_nref (ESL_MSA *msa)
+{
+  int i;
+  int nref = 1;
+
+  pthread_mutex_lock(&shared_msa_lock);
+  for(i = 0; i < nshared_msa; i++) {
+    if(shared_msaA[i].msa == msa) { nref = shared_msaA[i].nref; break; }
+  }
+  pthread_mutex_unlock(&shared_msa_lock);
+
+  return nref;
+}
+
 /* Function:  _c_free_msa()
  * Incept:    EPN, Sat Feb  2 14:33:15 2013
- * Synopsis:  Free an MSA.
+ * Synopsis:  Free an MSA, unless it is shared with another
+ *            interpreter, in which case just give up our
+ *            ownership of it.
  * Returns:   void
  */
 void _c_free_msa (ESL_MSA *msa)
 {
-  esl_msa_Destroy(msa);
+  if(_c_release_msa(msa)) esl_msa_Destroy(msa);
   return;
 }
 
@@ -608,6 +719,30 @@ void _c_remove_sqwgts(ESL_MSA *msa)
   return;
 }
 
+/* Function:  _c_set_sqwgts()
+ * Incept:    Sun Oct 18 17:48:19 2026
+ * Synopsis:  Sets msa->wgt[i] to wgtAR->[i] for all sequences and
+ *            raises the eslMSA_HASWGTS flag.
+ * Returns:   void
+ * Dies:      if wgtAR doesn't have msa->nseq elements
+ */
+void _c_set_sqwgts(ESL_MSA *msa, AV *wgtAR)
+{
+  int  i;
+  SV **value;
+
+  if(av_len(wgtAR) + 1 != msa->nseq) croak("_c_set_sqwgts() wrong number of weights %d (nseq: %d)", (int) (av_len(wgtAR) + 1), msa->nseq);
+
+  for(i = 0; i < msa->nseq; i++) { 
+    value = av_fetch(wgtAR, i, 0);
+    if(value == NULL) croak("_c_set_sqwgts(), failed array lookup for element %d", i);
+    msa->wgt[i] = SvNV(*value);
+  }
+  msa->flags |= eslMSA_HASWGTS;
+
+  return;
+}
+
 /* Function:  _c_any_allgap_columns()
  * Incept:    EPN, Sat Feb  2 14:38:18 2013
  * Synopsis:  Checks for any all gap columns.
@@ -652,17 +787,130 @@ int _c_any_allgap_columns (ESL_MSA *msa, char *gapstr)
   return FALSE;
 }   
 
+/* Function:  _c_pid_rows_task()
+ * Incept:    Sun Oct 18 11:20:41 2026
+ * Synopsis:  Task function for _c_threads_parallel_for(): for each
+ *            sequence i in [start..end-1], the sum, minimum and
+ *            maximum of the pairwise identities between i and all
+ *            sequences j > i. Used by _c_average_id() and
+ *            _c_rfam_pid_stats().
+ */
+typedef struct {
+  ESL_MSA *msa;
+  double  *sumA;     /* [0..i..nseq-1]: sum of pid(i,j) for j > i */
+  double  *minA;     /* [0..i..nseq-1]: min of pid(i,j) for j > i */
+  double  *maxA;     /* [0..i..nseq-1]: max of pid(i,j) for j > i */
+  int     *statusA;  /* [0..tid..nthreads-1]: first non-eslOK status of an esl_dst_*PairId() call by thread tid */
+  BE_PROGRESS *prg;  /* progress, in pairs compared, NULL if not reported */
+} PID_ROWS_ARG;
+
+static void
+_c_pid_rows_task(void *varg, int64_t start, int64_t end, int tid)
+{
+  PID_ROWS_ARG *arg = (PID_ROWS_ARG *) varg;
+  ESL_MSA      *msa = arg->msa;
+  int64_t       i;
+  int           j;
+  int           status;
+  double        pid;
+
+  for(i = start; i < end; i++) {
+    if(_c_progress_cancelled(arg->prg)) return;
+    arg->sumA[i] = 0.;
+    arg->minA[i] = 1.;
+    arg->maxA[i] = 0.;
+    for(j = i+1; j < msa->nseq; j++) {
+      if(msa->flags & eslMSA_DIGITAL) status = esl_dst_XPairId(msa->abc, msa->ax[i], msa->ax[j], &pid, NULL, NULL);
+      else                            status = esl_dst_CPairId(msa->aseq[i], msa->aseq[j], &pid, NULL, NULL);
+      if(status != eslOK) { arg->statusA[tid] = status; return; }
+      arg->sumA[i] += pid;
+      arg->minA[i]  = ESL_MIN(arg->minA[i], pid);
+      arg->maxA[i]  = ESL_MAX(arg->maxA[i], pid);
+    }
+    _c_progress_add(arg->prg, msa->nseq - 1 - i);
+  }
+}
+
+/* Function:  _c_pid_rows()
+ * Incept:    Sun Oct 18 11:31:09 2026
+ * Synopsis:  Compute pairwise identities of all pairs of sequences,
+ *            in parallel, and return per-row sums, minima and maxima
+ *            (see _c_pid_rows_task()) in <arg>, which must have
+ *            <msa> and <prg> set and <sumA>, <minA>, <maxA> allocated
+ *            for msa->nseq values. If <prg> isn't NULL, progress is
+ *            reported to it and the results are only valid if it
+ *            wasn't cancelled.
+ * Returns:   eslOK on success, else the status of a failed esl_dst_*PairId() call.
+ */
+static int
+_c_pid_rows(PID_ROWS_ARG *arg)
+{
+  int     status;
+  int     nthreads = 1;
+  int     t;
+  int64_t grain;
+
+  /* threads only pay off above a few million residue comparisons */
+  if((double) arg->msa->nseq * (double) arg->msa->nseq * (double) arg->msa->alen > 4e6) nthreads = _c_threads_n();
+  ESL_ALLOC(arg->statusA, sizeof(int) * nthreads);
+  for(t = 0; t < nthreads; t++) arg->statusA[t] = eslOK;
+
+  /* rows get shorter as i increases, small tasks let the workers even that out;
+   * when reporting progress, smaller still so we can report it often */
+  grain = ESL_MAX(1, arg->msa->nseq / (nthreads * ((arg->prg != NULL && arg->prg->cb != NULL) ? 256 : 16)));
+  _c_threads_parallel_for_progress(nthreads, arg->msa->nseq, grain, _c_pid_rows_task, arg, arg->prg);
+
+  status = eslOK;
+  for(t = 0; t < nthreads; t++) if(arg->statusA[t] != eslOK) { status = arg->statusA[t]; break; }
+  free(arg->statusA);
+  arg->statusA = NULL;
+  return status;
+
+ ERROR:
+  croak("out of memory");
+  return eslEMEM;
+}
+
 /* Function:  _c_average_id()
  * Incept:    EPN, Sat Feb  2 14:38:18 2013
  * Purpose:   Calculate and return average fractional identity of 
  *            an alignment. If more than max_nseq sequences exist
  *            take a sample of (max_nseq)^2 pairs and return the 
  *            average fractional identity of those.
+ *
+ *            When all pairs are compared, they are compared in
+ *            parallel (see bio_easel_threads.h), otherwise this is
+ *            esl_dst_{X,C}AverageId().
  * Returns:   Average fractional identity.
  */
 float _c_average_id(ESL_MSA *msa, int max_nseq) 
 {
-  double avgid;
+  int          status;
+  double       avgid;
+  double       max_comparisons = (double) max_nseq * (double) max_nseq;
+  PID_ROWS_ARG arg;
+  int          i;
+
+  if(msa->nseq <= 1) return 1.0;
+
+  /* same test for an all-vs-all average as esl_dst_XAverageId() */
+  if(msa->nseq <= max_comparisons &&
+     msa->nseq <= sqrt(2. * max_comparisons) &&
+     ((double) msa->nseq * (double) (msa->nseq-1) / 2.) <= max_comparisons) {
+    arg.msa = msa;
+    arg.prg = NULL;
+    ESL_ALLOC(arg.sumA, sizeof(double) * msa->nseq);
+    ESL_ALLOC(arg.minA, sizeof(double) * msa->nseq);
+    ESL_ALLOC(arg.maxA, sizeof(double) * msa->nseq);
+    if((status = _c_pid_rows(&arg)) != eslOK) croak("_c_average_id() error, aligned seqs different lengths");
+    avgid = 0.;
+    for(i = 0; i < msa->nseq; i++) avgid += arg.sumA[i];
+    avgid /= (double) msa->nseq * (double) (msa->nseq-1) / 2.;
+    free(arg.sumA);
+    free(arg.minA);
+    free(arg.maxA);
+    return (float) avgid;
+  }
   
   if(msa->flags & eslMSA_DIGITAL) { 
     esl_dst_XAverageId(msa->abc, msa->ax, msa->nseq, (max_nseq * max_nseq), &avgid);
@@ -671,6 +919,21 @@ float _c_average_id(ESL_MSA *msa, int max_nseq)
     esl_dst_CAverageId(msa->aseq, msa->nseq, (max_nseq * max_nseq), &avgid);
   }
   return (float) avgid;
+
+ ERROR:
+  croak("out of memory");
+  return 0.;
+}
+
+/* Function:  _c_get_threads()
+ * Incept:    Sun Oct 18 11:44:52 2026
+ * Purpose:   Return the number of threads parallel kernels will use,
+ *            see bio_easel_threads.h.
+ * Returns:   number of threads, >= 1
+ */
+int _c_get_threads()
+{
+  return _c_threads_n();
 }
 
 /* Function:  _c_get_sqstring_aligned()
@@ -728,6 +991,124 @@ void _c_set_sqstring_aligned(ESL_MSA *msa, char *seqstring, int seqidx)
 
 }
 
+/* Function:  _c_grow_rows()
+ * Incept:    Sun Oct 18 23:08:44 2026
+ * Purpose:   Make room for at least one more sequence in <msa>,
+ *            doubling the allocation of all per-sequence arrays 
+ *            (sequences, names, weights and per-sequence annotation)
+ *            when they're full, so adding N sequences one at a time
+ *            costs O(N) reallocations in total, not O(N^2).
+ *            esl_msa_Expand() does the same, but only for MSAs
+ *            still being read (alen == -1).
+ * Returns:   void
+ * Dies:      if out of memory.
+ */
+static void
+_c_grow_rows(ESL_MSA *msa)
+{
+  int status;
+  int old = msa->sqalloc;
+  int new;
+  int i, g;
+
+  if(msa->nseq < msa->sqalloc) return;
+  new = ESL_MAX(16, 2 * old);
+
+  ESL_REALLOC(msa->sqname, sizeof(char *) * new);
+  ESL_REALLOC(msa->wgt,    sizeof(double) * new);
+  if(msa->flags & eslMSA_DIGITAL) ESL_REALLOC(msa->ax,   sizeof(ESL_DSQ *) * new);
+  else                            ESL_REALLOC(msa->aseq, sizeof(char *)    * new);
+  for(i = old; i < new; i++) { 
+    msa->sqname[i] = NULL;
+    msa->wgt[i]    = 1.0;
+    if(msa->flags & eslMSA_DIGITAL) msa->ax[i]   = NULL;
+    else                            msa->aseq[i] = NULL;
+  }
+
+  /* optional per-sequence arrays, only if they exist */
+  if(msa->sqacc  != NULL) { ESL_REALLOC(msa->sqacc,  sizeof(char *) * new); for(i = old; i < new; i++) msa->sqacc[i]  = NULL; }
+  if(msa->sqdesc != NULL) { ESL_REALLOC(msa->sqdesc, sizeof(char *) * new); for(i = old; i < new; i++) msa->sqdesc[i] = NULL; }
+  if(msa->ss     != NULL) { ESL_REALLOC(msa->ss,     sizeof(char *) * new); for(i = old; i < new; i++) msa->ss[i]     = NULL; }
+  if(msa->sa     != NULL) { ESL_REALLOC(msa->sa,     sizeof(char *) * new); for(i = old; i < new; i++) msa->sa[i]     = NULL; }
+  if(msa->pp     != NULL) { ESL_REALLOC(msa->pp,     sizeof(char *) * new); for(i = old; i < new; i++) msa->pp[i]     = NULL; }
+  if(msa->sqlen  != NULL) { ESL_REALLOC(msa->sqlen,  sizeof(int64_t) * new); for(i = old; i < new; i++) msa->sqlen[i] = 0; }
+  if(msa->sslen  != NULL) { ESL_REALLOC(msa->sslen,  sizeof(int64_t) * new); for(i = old; i < new; i++) msa->sslen[i] = 0; }
+  if(msa->salen  != NULL) { ESL_REALLOC(msa->salen,  sizeof(int64_t) * new); for(i = old; i < new; i++) msa->salen[i] = 0; }
+  if(msa->pplen  != NULL) { ESL_REALLOC(msa->pplen,  sizeof(int64_t) * new); for(i = old; i < new; i++) msa->pplen[i] = 0; }
+  for(g = 0; g < msa->ngs; g++) { 
+    ESL_REALLOC(msa->gs[g], sizeof(char *) * new); 
+    for(i = old; i < new; i++) msa->gs[g][i] = NULL; 
+  }
+  for(g = 0; g < msa->ngr; g++) { 
+    ESL_REALLOC(msa->gr[g], sizeof(char *) * new); 
+    for(i = old; i < new; i++) msa->gr[g][i] = NULL; 
+  }
+  msa->sqalloc = new;
+  return;
+
+ ERROR:
+  croak("_c_grow_rows(), out of memory");
+}
+
+/* Function:  _c_add_sequence_aligned()
+ * Incept:    Sun Oct 18 23:14:29 2026
+ * Purpose:   Add a sequence <name> with aligned sequence <seqstring>
+ *            to the end of <msa>, with weight <wgt> if <has_wgt>,
+ *            else 1.0. Per-sequence arrays grow geometrically (see 
+ *            _c_grow_rows()) and the name is added to the existing
+ *            msa->index keyhash, so adding sequences one at a time 
+ *            takes time proportional to their length.
+ *            If <has_wgt>, the MSA is flagged as having weights.
+ * Returns:   void
+ * Dies:      if len(seqstring) != alen, <name> is already in <msa>,
+ *            or msa is digitized and unable to digitize string;
+ *            <msa> is then unchanged.
+ */
+void _c_add_sequence_aligned(ESL_MSA *msa, char *name, char *seqstring, double wgt, int has_wgt)
+{
+  int      status;
+  int      idx;
+  ESL_DSQ *ax   = NULL;
+  char    *aseq = NULL;
+
+  if((int64_t) strlen(seqstring) != msa->alen) croak("_c_add_sequence_aligned() aligned sequence is %d long, not alen (%" PRId64 ")", (int) strlen(seqstring), msa->alen);
+
+  /* make sure the index is complete, then check the name is new */
+  if(msa->index == NULL || esl_keyhash_GetNumber(msa->index) != msa->nseq) { 
+    status = esl_msa_Hash(msa);
+    if(status == eslEDUP)    croak("_c_add_sequence_aligned() MSA has duplicated names in it");
+    else if(status != eslOK) croak("_c_add_sequence_aligned() unable to index MSA");
+  }
+  if(esl_keyhash_Lookup(msa->index, name, -1, NULL) == eslOK) croak("_c_add_sequence_aligned() sequence %s is already in the MSA", name);
+
+  /* create the row before changing anything */
+  if(msa->flags & eslMSA_DIGITAL) { 
+    ESL_ALLOC(ax, sizeof(ESL_DSQ) * (msa->alen+2));
+    if(esl_abc_Digitize(msa->abc, seqstring, ax) != eslOK) { 
+      free(ax);
+      croak("_c_add_sequence_aligned() failed to digitize aligned sequence %s", name);
+    }
+  }
+  else { 
+    if(esl_strdup(seqstring, msa->alen, &aseq) != eslOK) goto ERROR;
+  }
+
+  _c_grow_rows(msa);
+  idx = msa->nseq;
+  if(esl_msa_SetSeqName(msa, idx, name, -1) != eslOK) goto ERROR;
+  if(msa->flags & eslMSA_DIGITAL) msa->ax[idx]   = ax;
+  else                            msa->aseq[idx] = aseq;
+  msa->wgt[idx] = (has_wgt) ? wgt : 1.0;
+  if(has_wgt) msa->flags |= eslMSA_HASWGTS;
+  if(esl_keyhash_Store(msa->index, name, -1, NULL) != eslOK) goto ERROR;
+  msa->nseq++;
+
+  return;
+
+ ERROR:
+  croak("_c_add_sequence_aligned() out of memory");
+}
+
 /* Function:  _c_set_existing_ppstring_aligned()
  * Incept:    EPN, Fri Feb 19 11:12:32 2021
  * Purpose:   Set PP for sequence <seqidx> to <ppstring>. It must already be allocated!
@@ -1488,12 +1869,21 @@ int _c_getGR_tagidx (ESL_MSA *msa, char *tag)
  * Incept:    EPN, Fri May 24 10:40:00 2013
  * Purpose:   Calculate sequence weights using the GSC (Gerstein/Sonnhammer/Chotia) 
  *            algorithm.
+ *
+ *            This is a single call to esl_msaweight_GSC(), so the
+ *            progress callback (Bio::Easel->set_progress_callback())
+ *            is only told when it starts and finishes, and it can only
+ *            be cancelled before it starts.
  * Returns:   eslOK on success, ! eslOK on failure.
  */
 int _c_weight_GSC(ESL_MSA *msa) 
 {
-  int    status;
+  int         status;
+  BE_PROGRESS prg;
+
+  _c_progress_start(&prg, "weight_GSC", 1);
   status = esl_msaweight_GSC(msa);
+  if(status == eslOK) _c_progress_finish(&prg);
   return status;
 }
 
@@ -1756,6 +2146,62 @@ _c_max_rna_two_letter_ambiguity(double act, double cct, double gct, double uct,
   return;
 }
 
+/* Function:  _c_comp_rows_task()
+ * Incept:    Sun Oct 18 20:48:05 2026
+ * Synopsis:  Task function for _c_threads_parallel_for(): residue
+ *            counts and nongap lengths of sequences i in [start..end-1],
+ *            into flat buffers, for _c_rfam_comp_and_len_stats() and 
+ *            _c_comp_and_len_stats().
+ */
+typedef struct {
+  ESL_MSA *msa;
+  int      use_weights;
+  double  *ctA;    /* [0..i*(K+1)+a..nseq*(K+1)-1]: weighted count of residue a in sequence i, a==abc->K are gaps */
+  int     *lenA;   /* [0..i..nseq-1]: nongap length of sequence i */
+} COMP_ROWS_ARG;
+
+static void
+_c_comp_rows_task(void *varg, int64_t start, int64_t end, int tid)
+{
+  COMP_ROWS_ARG *arg = (COMP_ROWS_ARG *) varg;
+  ESL_MSA       *msa = arg->msa;
+  int            K1  = msa->abc->K+1;
+  int64_t        i;
+  int64_t        apos;
+  double         seqwt;
+  double        *ct;
+
+  for(i = start; i < end; i++) { 
+    seqwt = (arg->use_weights) ? msa->wgt[i] : 1.0;
+    ct    = arg->ctA + i * K1;
+    esl_vec_DSet(ct, K1, 0.);
+    arg->lenA[i] = 0;
+    for(apos = 0; apos < msa->alen; apos++) { 
+      if(esl_abc_XIsResidue(msa->abc, msa->ax[i][apos+1])) arg->lenA[i]++; 
+      esl_abc_DCount(msa->abc, ct, msa->ax[i][apos+1], seqwt);
+    }
+  }
+}
+
+/* Function:  _c_comp_rows()
+ * Incept:    Sun Oct 18 20:51:26 2026
+ * Synopsis:  Run _c_comp_rows_task() over all sequences, in parallel
+ *            for large alignments (see bio_easel_threads.h).
+ */
+static void
+_c_comp_rows(ESL_MSA *msa, int use_weights, double *ctA, int *lenA)
+{
+  COMP_ROWS_ARG arg;
+  int           nthreads = 1;
+
+  arg.msa         = msa;
+  arg.use_weights = use_weights;
+  arg.ctA         = ctA;
+  arg.lenA        = lenA;
+  if((double) msa->nseq * (double) msa->alen > 4e6) nthreads = _c_threads_n();
+  _c_threads_parallel_for(nthreads, msa->nseq, ESL_MAX(1, msa->nseq / (nthreads * 16)), _c_comp_rows_task, &arg);
+}
+
 /* Function: _c_rfam_comp_and_len_stats
  * Incept:   EPN, Tue Jul 16 09:06:31 2013
  * Purpose:  Helper function for _c_rfam_qc_stats().  Determine the
@@ -1766,9 +2212,13 @@ _c_max_rna_two_letter_ambiguity(double act, double cct, double gct, double uct,
  *           MSA must be digitized because we count up number of
  *           each residue.
  *
+ *           The sequences are counted in parallel for large 
+ *           alignments, see _c_comp_rows().
+ *
  * Returns:  Allocated and returned:
  *         
  *           ret_abcAA:    [0..i..msa->nseq-1][0..a..msa->abc->K]: weighted counts of nt 'a' in sequence 'i',  a==abc->K are gaps, missing residues or nonresidues 
+ *                         the rows are one flat buffer: free ret_abcAA[0], then ret_abcAA
  *           ret_abc_totA: [0..a..msa->abc->K]:                    weighted counts of nt 'a' in all sequences, a==abc->K are gaps, missing residues or nonresidues 
  *           ret_lenA:     [0..i..msa->nseq-1]:                    nongap len of sequence i 
  *           ret_len_tot:  total length of all sequences
@@ -1783,38 +2233,31 @@ _c_rfam_comp_and_len_stats(ESL_MSA *msa, double ***ret_abcAA, double **ret_abc_t
 {
   int        status;           /* Easel status */
   int        i;                /* counter over sequences */
-  int        apos;             /* alignment position counter */
   double   **abcAA    = NULL;  /* [0..i..msa->nseq-1][0..a..abc->K]: count of nt 'a' in sequence 'i', a==abc->K are gaps, missing residues or nonresidues */
+  double    *ctA      = NULL;  /* flat buffer of the rows of abcAA */
   double    *abc_totA = NULL;  /* [0..a..abc->K]: count of nt 'a' in all sequences, a==abc->K are gaps, missing residues or nonresidues */
   int       *lenA     = NULL;  /* [0..i..msa->nseq-1]: nongap length of sequence i */
   int        len_tot  = 0;     /* total length of all seqs */ 
   int        len_min  = 0;     /* minimum seq length */
   int        len_max  = 0;     /* maximum seq length */
-  double     seqwt;            /* sequence weight */
   int        have_weights;     /* set to '1' if MSA has valid weights, else it does not and we'll use 1.0 as the weight for all sequences */
   
   if(! (msa->flags & eslMSA_DIGITAL)) croak("_c_rfam_comp_stats() contract violation, MSA is not digitized");
   have_weights = (msa->flags & eslMSA_HASWGTS) ? 1 : 0;
 
   /* allocate and initialize */
-  ESL_ALLOC(abcAA,       sizeof(double *)  * msa->nseq); 
+  ESL_ALLOC(abcAA,       sizeof(double *)  * ESL_MAX(1, msa->nseq)); 
+  ESL_ALLOC(ctA,         sizeof(double) * ESL_MAX(1, msa->nseq) * (msa->abc->K+1));
   ESL_ALLOC(abc_totA,    sizeof(double) * (msa->abc->K+1)); 
   esl_vec_DSet(abc_totA, msa->abc->K+1, 0.);
-  for(i = 0; i < msa->nseq; i++) { 
-    ESL_ALLOC(abcAA[i], sizeof(double) * (msa->abc->K+1));
-    esl_vec_DSet(abcAA[i], (msa->abc->K+1), 0.);
-  }
+  abcAA[0] = ctA;
+  for(i = 1; i < msa->nseq; i++) abcAA[i] = ctA + (int64_t) i * (msa->abc->K+1);
 
-  ESL_ALLOC(lenA, sizeof(int) * msa->nseq); 
-  esl_vec_ISet(lenA, msa->nseq, 0);
+  ESL_ALLOC(lenA, sizeof(int) * ESL_MAX(1, msa->nseq)); 
 
   /* add counts and compute lengths */
+  _c_comp_rows(msa, have_weights, ctA, lenA);
   for(i = 0; i < msa->nseq; i++) { 
-    seqwt = (have_weights) ? msa->wgt[i] : 1.0;
-    for(apos = 0; apos < msa->alen; apos++) { 
-      if(esl_abc_XIsResidue(msa->abc, msa->ax[i][apos+1])) lenA[i]++; 
-      if((status = esl_abc_DCount(msa->abc, abcAA[i], msa->ax[i][apos+1], seqwt)) != eslOK) croak("problem counting residue %d of seq %d", apos, i);
-    }
     esl_vec_DAdd(abc_totA, abcAA[i], msa->abc->K+1); /* add this seqs count to the abc_totA array */
     len_tot += lenA[i];
     len_min = (i == 0) ? lenA[i] : ESL_MIN(len_min, lenA[i]);
@@ -1833,12 +2276,8 @@ _c_rfam_comp_and_len_stats(ESL_MSA *msa, double ***ret_abcAA, double **ret_abc_t
   return eslOK;
 
  ERROR: 
-  if(abcAA) { 
-    for(i = 0; i < msa->nseq; i++) { 
-      if(abcAA[i]) free(abcAA[i]);
-    }
-    free(abcAA);
-  }
+  if(abcAA)    free(abcAA);
+  if(ctA)      free(ctA);
   if(abc_totA) free(abc_totA);
   if(lenA)     free(lenA);
 
@@ -1846,6 +2285,92 @@ _c_rfam_comp_and_len_stats(ESL_MSA *msa, double ***ret_abcAA, double **ret_abc_t
   return eslEMEM; /* NOTREACHED */
 }
 
+/* Function:  _c_comp_and_len_stats()
+ * Incept:    Sun Oct 18 20:57:10 2026
+ * Purpose:   Determine the composition, GC fraction and nongap length
+ *            of each sequence of a digital alignment, as 
+ *            _c_rfam_comp_and_len_stats() does for _c_rfam_qc_stats(),
+ *            but returned as packed arrays instead of written to a
+ *            file. The composition of a sequence is the frequency of
+ *            each residue among its residues, with degenerate residues
+ *            split over the residues they stand for; weights don't 
+ *            matter. Sequences are counted in parallel for large 
+ *            alignments, into one flat buffer.
+ *
+ * Returns:   (on the perl stack) three strings: 
+ *            composition: nseq * K packed native doubles, sequence by sequence
+ *            GC fraction: nseq packed native doubles, undef unless the
+ *                         alphabet is RNA or DNA
+ *            length:      nseq packed native ints
+ *            Sequences with no residues have all frequencies 0.
+ * Dies:      if MSA is NOT digitized
+ */
+void
+_c_comp_and_len_stats(ESL_MSA *msa)
+{
+  Inline_Stack_Vars;
+
+  int      status;
+  int      K;
+  int      K1;
+  int      do_gc;
+  double  *ctA  = NULL;  /* [0..i*(K+1)+a..nseq*(K+1)-1]: count of residue a in sequence i, a==abc->K are gaps */
+  int     *lenA = NULL;  /* [0..i..nseq-1]: nongap length of sequence i */
+  SV      *compSV;
+  SV      *gcSV;
+  double  *compA;
+  double  *gcA = NULL;
+  double   rtot;
+  int      i, a;
+
+  if(! (msa->flags & eslMSA_DIGITAL)) croak("_c_comp_and_len_stats() contract violation, MSA is not digitized");
+  K     = msa->abc->K;
+  K1    = K+1;
+  do_gc = (msa->abc->type == eslRNA || msa->abc->type == eslDNA) ? TRUE : FALSE;
+
+  ESL_ALLOC(ctA,  sizeof(double) * ESL_MAX(1, msa->nseq) * K1);
+  ESL_ALLOC(lenA, sizeof(int)    * ESL_MAX(1, msa->nseq));
+  _c_comp_rows(msa, FALSE, ctA, lenA);
+
+  compSV = newSV(sizeof(double) * msa->nseq * K + 1);
+  SvPOK_on(compSV);
+  SvCUR_set(compSV, sizeof(double) * msa->nseq * K);
+  *SvEND(compSV) = '\0';
+  compA  = (double *) SvPVX(compSV);
+  gcSV   = (do_gc) ? newSV(sizeof(double) * msa->nseq + 1) : newSV(0);
+  if(do_gc) { 
+    SvPOK_on(gcSV);
+    SvCUR_set(gcSV, sizeof(double) * msa->nseq);
+    *SvEND(gcSV) = '\0';
+    gcA = (double *) SvPVX(gcSV);
+  }
+
+  for(i = 0; i < msa->nseq; i++) { 
+    rtot = esl_vec_DSum(ctA + (int64_t) i * K1, K);
+    for(a = 0; a < K; a++) { 
+      compA[(int64_t) i * K + a] = (rtot > 0.) ? ctA[(int64_t) i * K1 + a] / rtot : 0.;
+    }
+    if(do_gc) gcA[i] = compA[(int64_t) i * K + 1] + compA[(int64_t) i * K + 2]; /* C and G */
+  }
+
+  Inline_Stack_Reset;
+  Inline_Stack_Push(sv_2mortal(compSV));
+  Inline_Stack_Push(sv_2mortal(gcSV));
+  Inline_Stack_Push(sv_2mortal(newSVpvn((char *) lenA, sizeof(int) * msa->nseq)));
+  Inline_Stack_Done;
+
+  free(ctA);
+  free(lenA);
+  Inline_Stack_Return(3);
+  return;
+
+ ERROR:
+  if(ctA)  free(ctA);
+  if(lenA) free(lenA);
+  croak("out of memory in _c_comp_and_len_stats()");
+  return; /* NEVERREACHED */
+}
+
 /* Function: _c_rfam_bp_stats
  * Incept:   EPN, Mon Jul 15 14:20:49 2013
  * Purpose:  Helper function for _c_rfam_qc_stats().  Determine the
@@ -2021,10 +2546,14 @@ _c_rfam_bp_stats(ESL_MSA *msa, int *ret_nbp, int **ret_rposA, int **ret_seq_canA
  *           average, maximum and minimum percent identity between
  *           all pairs of sequences.
  *
- *           Note: this is slow for very large alignments, but the
- *           largest seed in Rfam 11.0 is 1020 (glnA) so * it's
- *           probably safe at least for seeds, which is what it's
- *           designed for.
+ *           Pairs are compared in parallel, see _c_pid_rows(), so
+ *           this is no longer as slow for large alignments as it
+ *           used to be, although it is still quadratic in the
+ *           number of sequences.
+ *
+ *           Progress, in pairs compared, is reported to <prg> if
+ *           it isn't NULL; the results are not valid if it was
+ *           cancelled.
  *
  * Returns:  ret_pid_mean:  mean    pairwise identity between all pairs of seqs 
  *           ret_pid_min:   minimum pairwise identity between all pairs of seqs 
@@ -2033,35 +2562,440 @@ _c_rfam_bp_stats(ESL_MSA *msa, int *ret_nbp, int **ret_rposA, int **ret_seq_canA
  *           eslOK if successful
  */
 int
-_c_rfam_pid_stats(ESL_MSA *msa, double *ret_pid_mean, double *ret_pid_min, double *ret_pid_max)
-{
-  int    status;         /* Easel status */
-  int    i, j;           /* sequence index counters */
-  double pid_mean = 0.;  /* mean    pairwise id between all pairs of seqs */
-  double pid_min  = 1.;  /* minimum pairwise id between all pairs of seqs */
-  double pid_max  = 0.;  /* maximum pairwise id between all pairs of seqs */
-  double pid;            /* current pairwise id */
-
-  for (i = 0; i < msa->nseq; i++) { 
-    for (j = i+1; j < msa->nseq; j++) { 
-      if(msa->flags & eslMSA_DIGITAL) { 
-        if ((status = esl_dst_XPairId(msa->abc, msa->ax[i], msa->ax[j], &pid, NULL, NULL)) != eslOK) return status;
-      }
-      else { /* text mode */
-        if ((status = esl_dst_CPairId(msa->aseq[i], msa->aseq[j], &pid, NULL, NULL)) != eslOK) return status;
-      }
-      pid_min   = ESL_MIN(pid_min, pid);
-      pid_max   = ESL_MAX(pid_max, pid);
-      pid_mean += pid;
-    }
+_c_rfam_pid_stats(ESL_MSA *msa, BE_PROGRESS *prg, double *ret_pid_mean, double *ret_pid_min, double *ret_pid_max)
+{
+  int          status;         /* Easel status */
+  int          i;              /* sequence index counter */
+  double       pid_mean = 0.;  /* mean    pairwise id between all pairs of seqs */
+  double       pid_min  = 1.;  /* minimum pairwise id between all pairs of seqs */
+  double       pid_max  = 0.;  /* maximum pairwise id between all pairs of seqs */
+  PID_ROWS_ARG arg;            /* per-sequence results from _c_pid_rows() */
+
+  arg.msa = msa;
+  arg.prg = prg;
+  ESL_ALLOC(arg.sumA, sizeof(double) * ESL_MAX(1, msa->nseq));
+  ESL_ALLOC(arg.minA, sizeof(double) * ESL_MAX(1, msa->nseq));
+  ESL_ALLOC(arg.maxA, sizeof(double) * ESL_MAX(1, msa->nseq));
+  if((status = _c_pid_rows(&arg)) != eslOK) { 
+    free(arg.sumA); free(arg.minA); free(arg.maxA);
+    return status;
+  }
+
+  /* combine the rows in order, so the result doesn't depend on the number of threads */
+  for (i = 0; i < msa->nseq-1; i++) { 
+    pid_min   = ESL_MIN(pid_min, arg.minA[i]);
+    pid_max   = ESL_MAX(pid_max, arg.maxA[i]);
+    pid_mean += arg.sumA[i];
   }
   pid_mean /= (double) (msa->nseq * (msa->nseq-1) / 2);
 
+  free(arg.sumA);
+  free(arg.minA);
+  free(arg.maxA);
+
   *ret_pid_mean = pid_mean;
   *ret_pid_min  = pid_min;
   *ret_pid_max  = pid_max;
 
   return eslOK;
+
+ ERROR:
+  croak("out of memory");
+  return eslEMEM;
+}
+
+/* Function:  _c_obuf_*()
+ * Incept:    Sun Oct 18 21:20:14 2026
+ * Synopsis:  A large buffered writer to a file descriptor, for the
+ *            _c_rfam_qc_stats*() tables: rows are formatted straight
+ *            into one buffer that is written with write(2) only when
+ *            it fills up, instead of through stdio one row at a time.
+ *            Errors are sticky: once a write fails, <status> is 
+ *            set, with the errno of the failure in <errnum>, and 
+ *            later calls do nothing, so callers only check the 
+ *            status once they're done.
+ */
+#define BE_OBUF_SIZE (1 << 20)
+
+typedef struct {
+  int     fd;      /* file descriptor written to */
+  char   *buf;     /* [0..size-1] buffer */
+  size_t  n;       /* number of bytes in buf */
+  size_t  size;    /* allocated size of buf */
+  int     status;  /* eslOK, or eslEWRITE once a write failed */
+  int     errnum;  /* errno of the failed write, 0 if none */
+} BE_OBUF;
+
+static int
+_c_obuf_open(BE_OBUF *ob, int fd)
+{
+  ob->fd     = fd;
+  ob->n      = 0;
+  ob->size   = BE_OBUF_SIZE;
+  ob->status = eslOK;
+  ob->errnum = 0;
+  ob->buf    = malloc(ob->size);
+  return (ob->buf == NULL) ? eslEMEM : eslOK;
+}
+
+static void
+_c_obuf_flush(BE_OBUF *ob)
+{
+  size_t  done = 0;
+  ssize_t nw;
+
+  while(ob->status == eslOK && done < ob->n) { 
+    nw = write(ob->fd, ob->buf + done, ob->n - done);
+    if(nw < 0 && errno == EINTR) continue;
+    if(nw <= 0) { ob->status = eslEWRITE; ob->errnum = (nw < 0) ? errno : EIO; }
+    else        done += nw;
+  }
+  ob->n = 0;
+}
+
+static void
+_c_obuf_write(BE_OBUF *ob, const void *data, size_t len)
+{
+  if(ob->status != eslOK) return;
+  if(ob->n + len > ob->size) _c_obuf_flush(ob);
+  if(len > ob->size) { /* bigger than the buffer, write it directly */
+    memcpy(ob->buf, data, ob->size); /* keep the order: flush in buffer sized pieces */
+    ob->n = ob->size;
+    _c_obuf_flush(ob);
+    _c_obuf_write(ob, (const char *) data + ob->size, len - ob->size);
+    return;
+  }
+  memcpy(ob->buf + ob->n, data, len);
+  ob->n += len;
+}
+
+static void
+_c_obuf_printf(BE_OBUF *ob, const char *format, ...)
+{
+  va_list ap;
+  int     len;
+
+  if(ob->status != eslOK) return;
+  va_start(ap, format);
+  len = vsnprintf(ob->buf + ob->n, ob->size - ob->n, format, ap);
+  va_end(ap);
+  if(len >= 0 && (size_t) len >= ob->size - ob->n) { /* didn't fit, flush and try again */
+    _c_obuf_flush(ob);
+    va_start(ap, format);
+    len = vsnprintf(ob->buf, ob->size, format, ap);
+    va_end(ap);
+    if(len >= 0 && (size_t) len >= ob->size) croak("_c_obuf_printf(), line of %d characters is too long", len);
+  }
+  if(len < 0) { ob->status = eslEWRITE; ob->errnum = errno; return; }
+  ob->n += len;
+}
+
+/* binary fields, in native byte order */
+static void _c_obuf_char  (BE_OBUF *ob, char    c) { _c_obuf_write(ob, &c, sizeof(char));    }
+static void _c_obuf_int32 (BE_OBUF *ob, int32_t x) { _c_obuf_write(ob, &x, sizeof(int32_t)); }
+static void _c_obuf_int64 (BE_OBUF *ob, int64_t x) { _c_obuf_write(ob, &x, sizeof(int64_t)); }
+static void _c_obuf_double(BE_OBUF *ob, double  x) { _c_obuf_write(ob, &x, sizeof(double));  }
+static void
+_c_obuf_string(BE_OBUF *ob, char *s)
+{ 
+  uint32_t len = (s == NULL) ? 0 : strlen(s);
+  _c_obuf_write(ob, &len, sizeof(uint32_t));
+  if(len > 0) _c_obuf_write(ob, s, len);
+}
+
+/* returns the status of <ob>, and frees it, after flushing it */
+static int
+_c_obuf_close(BE_OBUF *ob)
+{
+  if(ob->buf != NULL) { 
+    _c_obuf_flush(ob);
+    free(ob->buf);
+    ob->buf = NULL;
+  }
+  return ob->status;
+}
+
+/* Function:  _c_rfam_qc_calc()
+ * Incept:    Sun Oct 18 21:31:50 2026
+ * Purpose:   Calculate everything _c_rfam_qc_stats() and 
+ *            _c_rfam_qc_stats_stream() output, see _c_rfam_qc_stats(),
+ *            into <qc>, before anything is written. Free with
+ *            _c_rfam_qc_free().
+ *
+ * Returns:   eslOK on success; eslFAIL if cancelled,
+ *            with <qc> partially filled.
+ */
+typedef struct { 
+  int       have_weights; /* set to '1' if MSA has valid weights, else it does not and we'll use 1.0 as the weight for all sequences */
+
+  /* seq composition statistics, from _c_rfam_comp_and_len_stats() */
+  double  **abcAA;        /* [0..i..msa->nseq-1][0..a..abc->K]: count of nt 'a' in sequence 'i', a==abc->K are gaps, missing residues or nonresidues */
+  double   *abc_totA;     /* [0..a..abc->K]: count of nt 'a' in all sequences, a==abc->K are gaps, missing residues or nonresidues */
+  int      *lenA;         /* [0..i..msa->nseq-1]: nongap length of sequence i */
+  int       len_tot;      /* total (summed) sequence length */
+  int       len_min;      /* minimum sequence length */
+  int       len_max;      /* maximum sequence length */
+
+  /* sequence pairwise identities, from _c_rfam_pid_stats() */
+  double    pid_mean;     /* mean    pairwise id between all pairs of seqs */
+  double    pid_min;      /* minimum pairwise id between all pairs of seqs */
+  double    pid_max;      /* maximum pairwise id between all pairs of seqs */
+
+  /* basepair statistics, from _c_rfam_bp_stats() */
+  int      *rposA;        /* [0..apos..msa->alen-1]: right position for basepair with left half position of 'i', else -1 if 'i' is not left half of a pair (i always < j) */
+  int      *seq_canA;     /* [0..i..msa->nseq-1]: number of canonical basepairs in sequence i */
+  int      *pos_canA;     /* [0..apos..msa->alen-1]: number of canonical basepairs with left half position of 'i' */
+  double   *covA;         /* [0..apos..msa->alen-1]: covariation per basepair */
+  int       nbp;          /* number of canonical basepairs in the (possibly deknotted) consensus secondary structure */
+  double    mean_cov;     /* mean covariation */  
+
+  /* the most common 2-letter ambiguity over the full alignment,
+   * what Paul called a 'dinucleotide' in rqc-ss-cons.pl */
+  char      max_2l;       /* most common 2-letter ambiguity */
+  double    max_2l_frac;  /* fraction of residues represented by most common 2-letter ambiguity */
+} RFAM_QC;
+
+static int
+_c_rfam_qc_calc(ESL_MSA *msa, BE_PROGRESS *prg, RFAM_QC *qc)
+{
+  memset(qc, 0, sizeof(RFAM_QC));
+  qc->have_weights = (msa->flags & eslMSA_HASWGTS) ? 1 : 0;
+
+  _c_rfam_comp_and_len_stats(msa, &(qc->abcAA), &(qc->abc_totA), &(qc->lenA), &(qc->len_tot), &(qc->len_min), &(qc->len_max));
+  _c_rfam_pid_stats         (msa, prg, &(qc->pid_mean), &(qc->pid_min), &(qc->pid_max));
+  if(_c_progress_cancelled(prg)) return eslFAIL;
+  _c_rfam_bp_stats          (msa, &(qc->nbp), &(qc->rposA), &(qc->seq_canA), &(qc->pos_canA), &(qc->covA), &(qc->mean_cov));
+
+  /* calc most common 2-letter ambiguity for full alignment */
+  _c_max_rna_two_letter_ambiguity(qc->abc_totA[0], qc->abc_totA[1], qc->abc_totA[2], qc->abc_totA[3], &(qc->max_2l), &(qc->max_2l_frac));
+
+  return eslOK;
+}
+
+static void
+_c_rfam_qc_free(RFAM_QC *qc)
+{
+  if(qc->abcAA) { 
+    free(qc->abcAA[0]); /* the rows are one flat buffer */
+    free(qc->abcAA);
+  }
+  if(qc->abc_totA) free(qc->abc_totA);
+  if(qc->lenA)     free(qc->lenA);
+  if(qc->rposA)    free(qc->rposA);
+  if(qc->seq_canA) free(qc->seq_canA);
+  if(qc->pos_canA) free(qc->pos_canA);
+  if(qc->covA)     free(qc->covA);
+}
+
+/* Function:  _c_rfam_qc_seq()
+ * Incept:    Sun Oct 18 21:36:03 2026
+ * Purpose:   Per-sequence stats of sequence <i> from <qc>, as
+ *            _c_rfam_qc_stats() outputs them: fraction of
+ *            canonical basepairs, fractions of A/C/G/U, most common
+ *            dinucleotide and its fraction, and fraction of CG, in
+ *            <ret_fracA> [0..6] (dinucleotide fraction in [5]), and 
+ *            most common dinucleotide in <ret_max_2l>.
+ */
+static void
+_c_rfam_qc_seq(ESL_MSA *msa, RFAM_QC *qc, int i, double *ret_fracA, char *ret_max_2l)
+{
+  double seqwt = (qc->have_weights) ? msa->wgt[i] : 1.0;
+  double tot   = seqwt * qc->lenA[i];
+
+  ret_fracA[0] = (qc->nbp == 0) ? 0. : (double) qc->seq_canA[i] / (double) qc->nbp; /* fraction of canonical bps */
+  ret_fracA[1] = qc->abcAA[i][0] / tot;                     /* fraction of As */
+  ret_fracA[2] = qc->abcAA[i][1] / tot;                     /* fraction of Cs */
+  ret_fracA[3] = qc->abcAA[i][2] / tot;                     /* fraction of Gs */
+  ret_fracA[4] = qc->abcAA[i][3] / tot;                     /* fraction of Us */
+  /* get most common two-letter iupac ambiguity */
+  _c_max_rna_two_letter_ambiguity(qc->abcAA[i][0], qc->abcAA[i][1], qc->abcAA[i][2], qc->abcAA[i][3], ret_max_2l, &(ret_fracA[5]));
+  ret_fracA[6] = (qc->abcAA[i][1] + qc->abcAA[i][2]) / tot; /* CG fraction */
+}
+
+/* Function:  _c_rfam_qc_write_text()
+ * Incept:    Sun Oct 18 21:40:27 2026
+ * Purpose:   Write the three _c_rfam_qc_stats() tables from <qc>,
+ *            as space padded text with a header line each, to 
+ *            <ffo> (per-family), <sfo> (per-sequence) and 
+ *            <bfo> (per-basepair).
+ */
+static void
+_c_rfam_qc_write_text(ESL_MSA *msa, RFAM_QC *qc, BE_OBUF *ffo, BE_OBUF *sfo, BE_OBUF *bfo)
+{
+  int    i;           /* sequence index */
+  int    apos;        /* alignment position */
+  double fracA[7];    /* per-sequence stats, see _c_rfam_qc_seq() */
+  char   max_2l;      /* most common 2-letter ambiguity of a sequence */
+
+  /* print 'ss-stats-per-family' */
+  _c_obuf_printf(ffo, "%-20s  %25s  %11s  %7s  %10s  %6s  %7s  %8s  %7s  %7s  %8s  %7s  %7s  %11s  %6s  %6s  %6s  %6s  %9s  %10s\n", 
+                 "FAMILY", "MEAN_FRACTN_CANONICAL_BPs", "COVARIATION", "NO_SEQs", "ALN_LENGTH", "NO_BPs", "NO_NUCs", "mean_PID", "max_PID", "min_PID", "mean_LEN", "max_LEN", "min_LEN", "FRACTN_NUCs", "FRAC_A", "FRAC_C", "FRAC_G", "FRAC_U", "MAX_DINUC", "CG_CONTENT");
+  _c_obuf_printf(ffo, "%-20s  %25.5f  %11.5f  %7d  %10" PRId64 "  %6d  %7d  %8.3f  %7.3f  %7.3f  %8.3f  %7d  %7d  %11.3f  %6.3f  %6.3f  %6.3f  %6.3f  %c:%-7.3f  %10.3f\n", 
+                 msa->name,                                                /* family name */
+                 (qc->nbp == 0) ? 0. : ((double) esl_vec_ISum(qc->seq_canA, msa->nseq)) / ((double) msa->nseq * qc->nbp), /* fractional canonical basepairs */
+                 qc->mean_cov,                                             /* the 'covariation' statistic, mean */
+                 msa->nseq,                                                /* number of sequences */
+                 msa->alen,                                                /* alignment length */
+                 qc->nbp,                                                  /* number of basepairs in (possibly deknotted) consensus secondary structure */
+                 qc->len_tot,                                              /* total number of non-gap/missing/nonresidues in alignment (non-weighted) */
+                 qc->pid_mean,                                             /* average pairwise seq identity */
+                 qc->pid_max,                                              /* max pairwise seq identity */
+                 qc->pid_min,                                              /* min pairwise seq identity */
+                 (double) qc->len_tot / msa->nseq,                         /* avg length */
+                 qc->len_max,                                              /* max sequence length */
+                 qc->len_min,                                              /* min sequence length */       
+                 (double) qc->len_tot / ((double) (msa->alen*msa->nseq)),  /* fraction nucleotides (nongaps) */
+                 qc->abc_totA[0] / (double) qc->len_tot,                   /* fraction of As */
+                 qc->abc_totA[1] / (double) qc->len_tot,                   /* fraction of Cs */
+                 qc->abc_totA[2] / (double) qc->len_tot,                   /* fraction of Gs */
+                 qc->abc_totA[3] / (double) qc->len_tot,                   /* fraction of U/Ts */
+                 qc->max_2l,                                               /* identity of most common two-letter iupac code */
+                 qc->max_2l_frac,                                          /* fraction of most common two-letter iupac code */
+                 (qc->abc_totA[1] + qc->abc_totA[2]) / (double) qc->len_tot); /* CG fraction */
+  
+  /* print ss-stats-persequence */
+  _c_obuf_printf(sfo, "%-20s  %-30s  %20s  %5s  %6s  %6s  %6s  %6s  %9s  %10s\n", 
+                 "FAMILY", "SEQID", "FRACTN_CANONICAL_BPs", "LEN", "FRAC_A", "FRAC_C", "FRAC_G", "FRAC_U", "MAX_DINUC", "CG_CONTENT");
+  for(i = 0; i < msa->nseq; i++) { 
+    _c_rfam_qc_seq(msa, qc, i, fracA, &max_2l);
+    _c_obuf_printf(sfo, "%-20s  %-30s  %20.5f  %5d  %6.3f  %6.3f  %6.3f  %6.3f  %c:%-7.3f  %10.3f\n", 
+                   msa->name, msa->sqname[i], fracA[0], qc->lenA[i], fracA[1], fracA[2], fracA[3], fracA[4], max_2l, fracA[5], fracA[6]);
+  }
+
+  /* print ss-stats-perbasepair */
+  _c_obuf_printf(bfo, "%-20s  %11s  %20s  %11s\n", 
+                 "FAMILY", "BP_COORDS", "FRACTN_CANONICAL_BPs", "COVARIATION");
+  for(apos = 0; apos < msa->alen; apos++) { 
+    if(qc->rposA[apos] != -1) { 
+      _c_obuf_printf(bfo, "%-20s  %5d:%-5d  %20.4f  %11.4f\n", 
+                     msa->name,                                         /* family name */
+                     (apos+1), (qc->rposA[apos]+1),                     /* left and right position of bp, note off-by-one b/c apos is 0..alen-1 */
+                     (double) qc->pos_canA[apos] / (double) msa->nseq,  /* fraction of this bp that are canonical */
+                     qc->covA[apos]);                                   /* 'covariation statistic' for this bp */
+    }
+  }
+}
+
+/* Function:  _c_rfam_qc_write_tsv()
+ * Incept:    Sun Oct 18 21:47:19 2026
+ * Purpose:   Write the three _c_rfam_qc_stats() tables from <qc>
+ *            to one stream <ob>, as tab separated lines whose first
+ *            field says which table they belong to: 'family', 
+ *            'sequence' or 'basepair'. If <do_header>, each table
+ *            starts with its column names, on a line starting with
+ *            '#'. The other fields are those of the text tables.
+ */
+static void
+_c_rfam_qc_write_tsv(ESL_MSA *msa, RFAM_QC *qc, BE_OBUF *ob, int do_header)
+{
+  int    i;           /* sequence index */
+  int    apos;        /* alignment position */
+  double fracA[7];    /* per-sequence stats, see _c_rfam_qc_seq() */
+  char   max_2l;      /* most common 2-letter ambiguity of a sequence */
+
+  if(do_header) _c_obuf_printf(ob, "#family\tFAMILY\tMEAN_FRACTN_CANONICAL_BPs\tCOVARIATION\tNO_SEQs\tALN_LENGTH\tNO_BPs\tNO_NUCs\tmean_PID\tmax_PID\tmin_PID\tmean_LEN\tmax_LEN\tmin_LEN\tFRACTN_NUCs\tFRAC_A\tFRAC_C\tFRAC_G\tFRAC_U\tMAX_DINUC\tCG_CONTENT\n");
+  _c_obuf_printf(ob, "family\t%s\t%.5f\t%.5f\t%d\t%" PRId64 "\t%d\t%d\t%.3f\t%.3f\t%.3f\t%.3f\t%d\t%d\t%.3f\t%.3f\t%.3f\t%.3f\t%.3f\t%c:%.3f\t%.3f\n", 
+                 msa->name,
+                 (qc->nbp == 0) ? 0. : ((double) esl_vec_ISum(qc->seq_canA, msa->nseq)) / ((double) msa->nseq * qc->nbp),
+                 qc->mean_cov, msa->nseq, msa->alen, qc->nbp, qc->len_tot, 
+                 qc->pid_mean, qc->pid_max, qc->pid_min,
+                 (double) qc->len_tot / msa->nseq, qc->len_max, qc->len_min,
+                 (double) qc->len_tot / ((double) (msa->alen*msa->nseq)),
+                 qc->abc_totA[0] / (double) qc->len_tot, qc->abc_totA[1] / (double) qc->len_tot, 
+                 qc->abc_totA[2] / (double) qc->len_tot, qc->abc_totA[3] / (double) qc->len_tot,
+                 qc->max_2l, qc->max_2l_frac,
+                 (qc->abc_totA[1] + qc->abc_totA[2]) / (double) qc->len_tot);
+
+  if(do_header) _c_obuf_printf(ob, "#sequence\tFAMILY\tSEQID\tFRACTN_CANONICAL_BPs\tLEN\tFRAC_A\tFRAC_C\tFRAC_G\tFRAC_U\tMAX_DINUC\tCG_CONTENT\n");
+  for(i = 0; i < msa->nseq; i++) { 
+    _c_rfam_qc_seq(msa, qc, i, fracA, &max_2l);
+    _c_obuf_printf(ob, "sequence\t%s\t%s\t%.5f\t%d\t%.3f\t%.3f\t%.3f\t%.3f\t%c:%.3f\t%.3f\n", 
+                   msa->name, msa->sqname[i], fracA[0], qc->lenA[i], fracA[1], fracA[2], fracA[3], fracA[4], max_2l, fracA[5], fracA[6]);
+  }
+
+  if(do_header) _c_obuf_printf(ob, "#basepair\tFAMILY\tBP_COORDS\tFRACTN_CANONICAL_BPs\tCOVARIATION\n");
+  for(apos = 0; apos < msa->alen; apos++) { 
+    if(qc->rposA[apos] != -1) { 
+      _c_obuf_printf(ob, "basepair\t%s\t%d:%d\t%.4f\t%.4f\n", 
+                     msa->name, (apos+1), (qc->rposA[apos]+1), (double) qc->pos_canA[apos] / (double) msa->nseq, qc->covA[apos]);
+    }
+  }
+}
+
+/* Function:  _c_rfam_qc_write_bin()
+ * Incept:    Sun Oct 18 21:52:46 2026
+ * Purpose:   Write the three _c_rfam_qc_stats() tables from <qc>
+ *            to one stream <ob>, as compact binary records, unrounded,
+ *            in native byte order. Each record starts with one 
+ *            character saying what it is, followed by its fields;
+ *            strings are a uint32 length followed by the characters.
+ *            As perl unpack() templates (see MSA.pm):
+ *            'F': family:   L/a d2 l q l l d4 l l d5 a d2
+ *                           family name, fraction canonical bps, covariation,
+ *                           nseq, alen, nbp, total length, pid mean/max/min, 
+ *                           mean length, max/min length, fraction nongap,
+ *                           fraction A/C/G/U, dinucleotide and its
+ *                           fraction, fraction CG
+ *            'S': sequence: L/a L/a d l d4 a d2
+ *            'B': basepair: L/a l l d d
+ */
+static void
+_c_rfam_qc_write_bin(ESL_MSA *msa, RFAM_QC *qc, BE_OBUF *ob)
+{
+  int    i;           /* sequence index */
+  int    apos;        /* alignment position */
+  double fracA[7];    /* per-sequence stats, see _c_rfam_qc_seq() */
+  char   max_2l;      /* most common 2-letter ambiguity of a sequence */
+
+  _c_obuf_char  (ob, 'F');
+  _c_obuf_string(ob, msa->name);
+  _c_obuf_double(ob, (qc->nbp == 0) ? 0. : ((double) esl_vec_ISum(qc->seq_canA, msa->nseq)) / ((double) msa->nseq * qc->nbp));
+  _c_obuf_double(ob, qc->mean_cov);
+  _c_obuf_int32 (ob, msa->nseq);
+  _c_obuf_int64 (ob, msa->alen);
+  _c_obuf_int32 (ob, qc->nbp);
+  _c_obuf_int32 (ob, qc->len_tot);
+  _c_obuf_double(ob, qc->pid_mean);
+  _c_obuf_double(ob, qc->pid_max);
+  _c_obuf_double(ob, qc->pid_min);
+  _c_obuf_double(ob, (double) qc->len_tot / msa->nseq);
+  _c_obuf_int32 (ob, qc->len_max);
+  _c_obuf_int32 (ob, qc->len_min);
+  _c_obuf_double(ob, (double) qc->len_tot / ((double) (msa->alen*msa->nseq)));
+  _c_obuf_double(ob, qc->abc_totA[0] / (double) qc->len_tot);
+  _c_obuf_double(ob, qc->abc_totA[1] / (double) qc->len_tot);
+  _c_obuf_double(ob, qc->abc_totA[2] / (double) qc->len_tot);
+  _c_obuf_double(ob, qc->abc_totA[3] / (double) qc->len_tot);
+  _c_obuf_char  (ob, qc->max_2l);
+  _c_obuf_double(ob, qc->max_2l_frac);
+  _c_obuf_double(ob, (qc->abc_totA[1] + qc->abc_totA[2]) / (double) qc->len_tot);
+
+  for(i = 0; i < msa->nseq; i++) { 
+    _c_rfam_qc_seq(msa, qc, i, fracA, &max_2l);
+    _c_obuf_char  (ob, 'S');
+    _c_obuf_string(ob, msa->name);
+    _c_obuf_string(ob, msa->sqname[i]);
+    _c_obuf_double(ob, fracA[0]);
+    _c_obuf_int32 (ob, qc->lenA[i]);
+    _c_obuf_double(ob, fracA[1]);
+    _c_obuf_double(ob, fracA[2]);
+    _c_obuf_double(ob, fracA[3]);
+    _c_obuf_double(ob, fracA[4]);
+    _c_obuf_char  (ob, max_2l);
+    _c_obuf_double(ob, fracA[5]);
+    _c_obuf_double(ob, fracA[6]);
+  }
+
+  for(apos = 0; apos < msa->alen; apos++) { 
+    if(qc->rposA[apos] != -1) { 
+      _c_obuf_char  (ob, 'B');
+      _c_obuf_string(ob, msa->name);
+      _c_obuf_int32 (ob, apos+1);
+      _c_obuf_int32 (ob, qc->rposA[apos]+1);
+      _c_obuf_double(ob, (double) qc->pos_canA[apos] / (double) msa->nseq);
+      _c_obuf_double(ob, qc->covA[apos]);
+    }
+  }
 }
 
 /* Function:  _c_rfam_qc_stats()
@@ -2100,153 +3034,114 @@ _c_rfam_pid_stats(ESL_MSA *msa, double *ret_pid_mean, double *ret_pid_min, doubl
  * _c_rfam_comp_and_len_stats(): sequence length and composition stats
  * _c_rfam_bp_stats():           all basepair-related stats
  * _c_rfam_pid_stats():          percent identity stats
+ * and _c_rfam_qc_write_text() writes the tables, each through a 
+ * large buffer (see _c_obuf_*()).
  *
  * This function reproduces all functionality in Paul Gardner's
  * rqc-ss-cons.pl script, last used in Rfam 10.0 and deprecated during
  * Sanger->EBI transition code overhaul.
+ *
+ * Progress, in pairs of sequences compared (by far the slowest
+ * part), is reported to the callback set with
+ * Bio::Easel->set_progress_callback(). If it is cancelled the
+ * output files are left empty.
  * 
  * Returns:   eslOK on success.
+ * Dies:      with croak if cancelled, or if a file can't be written.
  */
 
 int _c_rfam_qc_stats(ESL_MSA *msa, char *fam_outfile, char *seq_outfile, char *bp_outfile)
 {
-  FILE  *ffp;          /* open output per-family   stats output file */
-  FILE  *sfp;          /* open output per-sequence stats output file */
-  FILE  *bfp;          /* open output per-basepair stats output file */
-  int    i;            /* sequence index */
-  int    apos;         /* alignment position */
-  double seqwt;        /* sequence weight */
-  int    have_weights; /* set to '1' if MSA has valid weights, else it does not and we'll use 1.0 as the weight for all sequences */
-
-  /* variables related to seq composition statistics, mainly
-   * used by _c_rfam_comp_stats() 
-   */
-  double   **abcAA    = NULL;  /* [0..i..msa->nseq-1][0..a..abc->K]: count of nt 'a' in sequence 'i', a==abc->K are gaps, missing residues or nonresidues */
-  double    *abc_totA = NULL;  /* [0..a..abc->K]: count of nt 'a' in all sequences, a==abc->K are gaps, missing residues or nonresidues */
-  int       *lenA     = NULL;  /* [0..i..msa->nseq-1]: nongap length of sequence i */
-  int        len_tot;          /* total (summed) sequence length */
-  int        len_min;          /* minimum sequence length */
-  int        len_max;          /* maximum sequence length */
-
-  /* variables related to sequence pairwise identities, 
-   * mainly used by _c_rfam_pid_stats()
-   */
-  double pid_mean;  /* mean    pairwise id between all pairs of seqs */
-  double pid_min;   /* minimum pairwise id between all pairs of seqs */
-  double pid_max;   /* maximum pairwise id between all pairs of seqs */
-
-  /* variables related to basepair statistics, mainly used
-   * by _c_rfam_bp_stats() helper function.
-   */
-  int       *rposA    = NULL;  /* [0..apos..msa->alen-1]: right position for basepair with left half position of 'i', else -1 if 'i' is not left half of a pair (i always < j) */
-  int       *seq_canA = NULL;  /* [0..i..msa->nseq-1]: number of canonical basepairs in sequence i */
-  int       *pos_canA = NULL;  /* [0..apos..msa->alen-1]: number of canonical basepairs with left half position of 'i' */
-  double    *covA     = NULL;  /* [0..apos..msa->alen-1]: covariation per basepair */
-  int        nbp = 0;          /* number of canonical basepairs in the (possibly deknotted) consensus secondary structure */
-  double     mean_cov;         /* mean covariation */  
-
-  /* variables related to the most common 2-letter ambiguity,
-   * what Paul called a 'dinucleotide' in rqc-ss-cons.pl */
-  char       max_2l;           /* most common 2-letter ambiguity */
-  double     max_2l_frac;      /* fraction of residues represented by most common 2-letter ambiguity */
+  RFAM_QC      qc;           /* all the stats */
+  BE_OBUF      obA[3];       /* per-family, per-sequence and per-basepair output */
+  char        *fileA[3];     /* names of the files written by obA */
+  int          f;            /* counter over files */
+  int          status;       /* Easel status */
+  int          wstatus = eslOK; /* status of writing the files */
+  BE_PROGRESS  prg;          /* progress of the pairwise identity calculation */
 
   if(! (msa->flags & eslMSA_DIGITAL)) croak("_c_rfam_qc_stats() contract violation, MSA is not digitized");
-  have_weights = (msa->flags & eslMSA_HASWGTS) ? 1 : 0;
+  _c_progress_start(&prg, "rfam_qc_stats", (int64_t) msa->nseq * (int64_t) (msa->nseq-1) / 2);
 
   /* open output files */
-  if((ffp = fopen(fam_outfile, "w"))  == NULL) { croak("unable to open %s for writing", fam_outfile); }
-  if((sfp = fopen(seq_outfile, "w"))  == NULL) { croak("unable to open %s for writing", seq_outfile); }
-  if((bfp = fopen(bp_outfile,  "w"))  == NULL) { croak("unable to open %s for writing", bp_outfile); }
-
-  _c_rfam_comp_and_len_stats(msa, &abcAA, &abc_totA, &lenA, &len_tot, &len_min, &len_max);
-  _c_rfam_pid_stats         (msa, &pid_mean, &pid_min, &pid_max);
-  _c_rfam_bp_stats          (msa, &nbp, &rposA, &seq_canA, &pos_canA, &covA, &mean_cov);
-
-  /* calc most common 2-letter ambiguity for full alignment */
-  _c_max_rna_two_letter_ambiguity(abc_totA[0], abc_totA[1], abc_totA[2], abc_totA[3], &max_2l, &max_2l_frac);
-
-  /* print 'ss-stats-per-family' */
-  fprintf(ffp, "%-20s  %25s  %11s  %7s  %10s  %6s  %7s  %8s  %7s  %7s  %8s  %7s  %7s  %11s  %6s  %6s  %6s  %6s  %9s  %10s\n", 
-         "FAMILY", "MEAN_FRACTN_CANONICAL_BPs", "COVARIATION", "NO_SEQs", "ALN_LENGTH", "NO_BPs", "NO_NUCs", "mean_PID", "max_PID", "min_PID", "mean_LEN", "max_LEN", "min_LEN", "FRACTN_NUCs", "FRAC_A", "FRAC_C", "FRAC_G", "FRAC_U", "MAX_DINUC", "CG_CONTENT");
-  fprintf(ffp, "%-20s  %25.5f  %11.5f  %7d  %10" PRId64 "  %6d  %7d  %8.3f  %7.3f  %7.3f  %8.3f  %7d  %7d  %11.3f  %6.3f  %6.3f  %6.3f  %6.3f  %c:%-7.3f  %10.3f\n", 
-          msa->name,                                           /* family name */
-          (nbp == 0) ? 0. : ((double) esl_vec_ISum(seq_canA, msa->nseq)) / ((double) msa->nseq * nbp), /* fractional canonical basepairs */
-          mean_cov,                                            /* the 'covariation' statistic, mean */
-          msa->nseq,                                           /* number of sequences */
-          msa->alen,                                           /* alignment length */
-          nbp,                                                 /* number of basepairs in (possibly deknotted) consensus secondary structure */
-          len_tot,                                             /* total number of non-gap/missing/nonresidues in alignment (non-weighted) */
-          pid_mean,                                            /* average pairwise seq identity */
-          pid_max,                                             /* max pairwise seq identity */
-          pid_min,                                             /* min pairwise seq identity */
-          (double) len_tot / msa->nseq,                        /* avg length */
-          len_max,                                             /* max sequence length */
-          len_min,                                             /* min sequence length */       
-          (double) len_tot / ((double) (msa->alen*msa->nseq)), /* fraction nucleotides (nongaps) */
-          abc_totA[0] / (double) len_tot,                      /* fraction of As */
-          abc_totA[1] / (double) len_tot,                      /* fraction of Cs */
-          abc_totA[2] / (double) len_tot,                      /* fraction of Gs */
-          abc_totA[3] / (double) len_tot,                      /* fraction of U/Ts */
-          max_2l,                                              /* identity of most common two-letter iupac code */
-          max_2l_frac,                                         /* fraction of most common two-letter iupac code */
-          (abc_totA[1] + abc_totA[2]) / (double) len_tot);     /* CG fraction */
-  
-  /* print ss-stats-persequence */
-  fprintf(sfp, "%-20s  %-30s  %20s  %5s  %6s  %6s  %6s  %6s  %9s  %10s\n", 
-          "FAMILY", "SEQID", "FRACTN_CANONICAL_BPs", "LEN", "FRAC_A", "FRAC_C", "FRAC_G", "FRAC_U", "MAX_DINUC", "CG_CONTENT");
-  for(i = 0; i < msa->nseq; i++) { 
-    seqwt = (have_weights) ? msa->wgt[i] : 1.0;
-    /* get most common two-letter iupac ambiguity */
-    _c_max_rna_two_letter_ambiguity(abcAA[i][0], abcAA[i][1], abcAA[i][2], abcAA[i][3], &max_2l, &max_2l_frac);
-    fprintf(sfp, "%-20s  %-30s  %20.5f  %5d  %6.3f  %6.3f  %6.3f  %6.3f  %c:%-7.3f  %10.3f\n", 
-            msa->name,                                         /* family name */
-            msa->sqname[i],                                    /* seq name */
-            (nbp == 0) ? 0. : (double) seq_canA[i] / (double) nbp, /* fraction of canonical bps */
-            lenA[i],                                           /* seq length */
-            abcAA[i][0] / (seqwt * lenA[i]),                   /* fraction of As */
-            abcAA[i][1] / (seqwt * lenA[i]),                   /* fraction of Cs */
-            abcAA[i][2] / (seqwt * lenA[i]),                   /* fraction of Gs */
-            abcAA[i][3] / (seqwt * lenA[i]),                   /* fraction of Us */
-            max_2l,                                            /* identity of most common dinuc */
-            max_2l_frac,                                       /* fraction of most common dinuc */
-            (abcAA[i][1] + abcAA[i][2]) / (seqwt * lenA[i]));  /* CG fraction */
-  }
-
-  /* print ss-stats-perbasepair */
-  fprintf(bfp, "%-20s  %11s  %20s  %11s\n", 
-         "FAMILY", "BP_COORDS", "FRACTN_CANONICAL_BPs", "COVARIATION");
-  for(apos = 0; apos < msa->alen; apos++) { 
-    if(rposA[apos] != -1) { 
-      fprintf(bfp, "%-20s  %5d:%-5d  %20.4f  %11.4f\n", 
-              msa->name,                                     /* family name */
-              (apos+1), (rposA[apos]+1),                     /* left and right position of bp, note off-by-one b/c apos is 0..alen-1 */
-              (double) pos_canA[apos] / (double) msa->nseq,  /* fraction of this bp that are canonical */
-              covA[apos]);                                   /* 'covariation statistic' for this bp */
+  fileA[0] = fam_outfile;
+  fileA[1] = seq_outfile;
+  fileA[2] = bp_outfile;
+  for(f = 0; f < 3; f++) obA[f].buf = NULL;
+  for(f = 0; f < 3; f++) { 
+    if((obA[f].fd = open(fileA[f], O_WRONLY | O_CREAT | O_TRUNC, 0666)) < 0) { 
+      char *badfile = fileA[f];
+      while(--f >= 0) { _c_obuf_close(&(obA[f])); close(obA[f].fd); }
+      croak("unable to open %s for writing", badfile);
+    }
+    if(_c_obuf_open(&(obA[f]), obA[f].fd) != eslOK) { 
+      for(; f >= 0; f--) { _c_obuf_close(&(obA[f])); close(obA[f].fd); }
+      croak("out of memory");
     }
   }
 
+  status = _c_rfam_qc_calc(msa, &prg, &qc);
+  if(status == eslOK) _c_rfam_qc_write_text(msa, &qc, &(obA[0]), &(obA[1]), &(obA[2]));
+
   /* close output files */
-  fclose(ffp);
-  fclose(sfp);
-  fclose(bfp);
+  for(f = 0; f < 3; f++) { 
+    if(_c_obuf_close(&(obA[f])) != eslOK && wstatus == eslOK) wstatus = eslEWRITE;
+    if(close(obA[f].fd) != 0 && wstatus == eslOK)              wstatus = eslEWRITE;
+  }
 
   /* cleanup and exit */
-  if(abcAA) { 
-    for(i = 0; i < msa->nseq; i++) { 
-      if(abcAA[i]) free(abcAA[i]);
-    }
-    free(abcAA);
-  }
-  if(abc_totA) free(abc_totA);
-  if(lenA)     free(lenA);
-  if(rposA)    free(rposA);
-  if(seq_canA) free(seq_canA);
-  if(pos_canA) free(pos_canA);
-  if(covA)     free(covA);
+  _c_rfam_qc_free(&qc);
+  _c_progress_finish(&prg); /* dies if cancelled */
+  if(wstatus != eslOK) croak("error writing rfam qc stats output files");
   
   return eslOK;
 }
 
+/* Function:  _c_rfam_qc_stats_stream()
+ * Incept:    Sun Oct 18 21:58:31 2026
+ * Purpose:   Calculate the same stats as _c_rfam_qc_stats(), and 
+ *            write all three tables to one open file descriptor <fd>
+ *            through one large buffer, in <format> "tsv" (see 
+ *            _c_rfam_qc_write_tsv()) or "binary" (see 
+ *            _c_rfam_qc_write_bin()). The stats of many alignments
+ *            can be written, one after another, to the same
+ *            descriptor. <fd> is not closed. Nothing is written if
+ *            cancelled.
+ *
+ * Returns:   eslOK on success.
+ * Dies:      with croak if cancelled, if <format> is unknown, or if
+ *            <fd> can't be written.
+ */
+int _c_rfam_qc_stats_stream(ESL_MSA *msa, int fd, char *format, int do_header)
+{
+  RFAM_QC      qc;           /* all the stats */
+  BE_OBUF      ob;           /* output */
+  int          do_bin;       /* TRUE for binary, FALSE for TSV */
+  int          status;       /* Easel status */
+  int          wstatus;      /* status of writing */
+  BE_PROGRESS  prg;          /* progress of the pairwise identity calculation */
+
+  if(! (msa->flags & eslMSA_DIGITAL)) croak("_c_rfam_qc_stats_stream() contract violation, MSA is not digitized");
+  if     (strcmp(format, "tsv")    == 0) do_bin = FALSE;
+  else if(strcmp(format, "binary") == 0) do_bin = TRUE;
+  else croak("_c_rfam_qc_stats_stream(), unknown format %s, should be \"tsv\" or \"binary\"", format);
+  _c_progress_start(&prg, "rfam_qc_stats", (int64_t) msa->nseq * (int64_t) (msa->nseq-1) / 2);
+
+  if(_c_obuf_open(&ob, fd) != eslOK) croak("out of memory");
+  status = _c_rfam_qc_calc(msa, &prg, &qc);
+  if(status == eslOK) { 
+    if(do_bin) _c_rfam_qc_write_bin(msa, &qc, &ob);
+    else       _c_rfam_qc_write_tsv(msa, &qc, &ob, do_header);
+  }
+  wstatus = _c_obuf_close(&ob);
+
+  _c_rfam_qc_free(&qc);
+  _c_progress_finish(&prg); /* dies if cancelled */
+  if(wstatus != eslOK) croak("error writing rfam qc stats: %s", strerror(ob.errnum));
+
+  return eslOK;
+}
+
 /* Function: _c_check_reqd_format
  * Incept:   EPN, Thu Jul 18 11:07:44 2013
  * Purpose:  Check if <format> string is a valid format,
@@ -2376,6 +3271,550 @@ _c_sequence_subset(ESL_MSA *msa, AV *usemeAR)
   return NULL; /* NEVERREACHED */
 }
 
+/* Function:  _c_row_char()
+ * Incept:    Sun Oct 18 15:52:10 2026
+ * Synopsis:  Return the residue at position <apos> (0..alen-1) of
+ *            sequence <i>, as compared by _c_identical_sequence_groups():
+ *            its digital code or (text mode) character, with all
+ *            gaps the same if <gaps_equal> and (text mode) in upper
+ *            case if <case_equal>.
+ */
+static inline int
+_c_row_char(ESL_MSA *msa, int i, int64_t apos, int gaps_equal, int case_equal)
+{
+  int c;
+
+  if(msa->flags & eslMSA_DIGITAL) { 
+    c = msa->ax[i][apos+1];
+    if(gaps_equal && (esl_abc_XIsGap(msa->abc, c) || esl_abc_XIsMissing(msa->abc, c))) c = msa->abc->K;
+  }
+  else { 
+    c = (unsigned char) msa->aseq[i][apos];
+    if(gaps_equal && (c == '-' || c == '.' || c == '_' || c == '~')) c = '-';
+    else if(case_equal) c = toupper(c);
+  }
+  return c;
+}
+
+/* Function:  _c_row_hash_task()
+ * Incept:    Sun Oct 18 15:55:31 2026
+ * Synopsis:  Task function for _c_threads_parallel_for(): FNV-1a
+ *            hash of each sequence first+i for i in [start..end-1],
+ *            as compared by _c_identical_sequence_groups().
+ */
+typedef struct {
+  ESL_MSA  *msa;
+  int       first;    /* index of first sequence to hash */
+  int       gaps_equal;
+  int       case_equal;
+  uint64_t *hashA;    /* [0..i..n-1]: hash of sequence first+i */
+} ROW_HASH_ARG;
+
+static void
+_c_row_hash_task(void *varg, int64_t start, int64_t end, int tid)
+{
+  ROW_HASH_ARG *arg = (ROW_HASH_ARG *) varg;
+  int64_t       i;
+  int64_t       apos;
+  uint64_t      h;
+
+  for(i = start; i < end; i++) { 
+    h = 14695981039346656037ULL;
+    for(apos = 0; apos < arg->msa->alen; apos++) { 
+      h ^= (uint64_t) _c_row_char(arg->msa, arg->first + i, apos, arg->gaps_equal, arg->case_equal);
+      h *= 1099511628211ULL;
+    }
+    arg->hashA[i] = h;
+  }
+}
+
+/* Function:  _c_identical_sequence_groups()
+ * Incept:    Sun Oct 18 15:58:44 2026
+ * Purpose:   Group the aligned sequences of <msa> that are identical,
+ *            column for column, optionally treating all gap characters
+ *            as the same (<gaps_equal>) and, in text mode, upper and
+ *            lower case as the same (<case_equal>). (In digital mode
+ *            case is never significant and '-' and '.' are always the
+ *            same gap.)
+ *
+ *            Each sequence is hashed (in parallel for large alignments,
+ *            see bio_easel_threads.h) and looked up in a hash table of
+ *            the groups found so far, so this is linear in the size
+ *            of the alignment, not quadratic in the number of sequences.
+ *
+ * Returns:   (on the perl stack) [0..i..nseq-1]: index of the first
+ *            sequence in i's group, which is i itself if i is the first.
+ * Dies:      with croak if out of memory.
+ */
+void
+_c_identical_sequence_groups(ESL_MSA *msa, int gaps_equal, int case_equal)
+{
+  Inline_Stack_Vars;
+
+  int           status;
+  ROW_HASH_ARG  arg;
+  int          *tableA = NULL;  /* hash table of group representatives, -1 for empty slots */
+  int          *repA   = NULL;  /* [0..i..nseq-1]: first sequence of i's group */
+  uint64_t      mask;           /* table size minus 1, size is a power of 2 */
+  uint64_t      slot;
+  int           nthreads = 1;
+  int64_t       apos;
+  int           i, r;
+
+  arg.msa        = msa;
+  arg.first      = 0;
+  arg.gaps_equal = gaps_equal;
+  arg.case_equal = case_equal;
+  arg.hashA      = NULL;
+  ESL_ALLOC(arg.hashA, sizeof(uint64_t) * ESL_MAX(1, msa->nseq));
+  ESL_ALLOC(repA,      sizeof(int)      * ESL_MAX(1, msa->nseq));
+
+  if((double) msa->nseq * (double) msa->alen > 4e6) nthreads = _c_threads_n();
+  _c_threads_parallel_for(nthreads, msa->nseq, ESL_MAX(1, msa->nseq / (nthreads * 16)), _c_row_hash_task, &arg);
+
+  for(mask = 1; mask < 2 * (uint64_t) msa->nseq; mask <<= 1) ;
+  ESL_ALLOC(tableA, sizeof(int) * mask);
+  for(slot = 0; slot < mask; slot++) tableA[slot] = -1;
+  mask--;
+
+  /* linear probing; rows with the same hash are compared in full */
+  for(i = 0; i < msa->nseq; i++) { 
+    repA[i] = i;
+    for(slot = arg.hashA[i] & mask; (r = tableA[slot]) != -1; slot = (slot + 1) & mask) { 
+      if(arg.hashA[r] != arg.hashA[i]) continue;
+      for(apos = 0; apos < msa->alen; apos++) { 
+        if(_c_row_char(msa, r, apos, gaps_equal, case_equal) != _c_row_char(msa, i, apos, gaps_equal, case_equal)) break;
+      }
+      if(apos == msa->alen) { repA[i] = r; break; }
+    }
+    if(repA[i] == i) tableA[slot] = i;
+  }
+
+  Inline_Stack_Reset;
+  for(i = 0; i < msa->nseq; i++) { 
+    Inline_Stack_Push(sv_2mortal(newSViv(repA[i])));
+  }
+  Inline_Stack_Done;
+
+  free(arg.hashA);
+  free(repA);
+  free(tableA);
+  Inline_Stack_Return(msa->nseq);
+  return;
+
+ ERROR:
+  if(arg.hashA) free(arg.hashA);
+  if(repA)      free(repA);
+  croak("out of memory");
+  return; /* NEVERREACHED */
+}
+
+/* Function:  _c_row_hashes()
+ * Incept:    Sun Oct 18 17:02:37 2026
+ * Purpose:   Hash the aligned sequences <first>..<first>+<n>-1 of
+ *            <msa>, each character counting (no gap or case
+ *            equivalence), for an incrementally maintained
+ *            alignment checksum, see _c_combine_row_hashes().
+ *            Large alignments are hashed in parallel.
+ *
+ * Returns:   a string of <n> packed native 64-bit hashes,
+ *            to be unpacked with "Q*", or spliced with substr().
+ * Dies:      with croak if <first>..<first>+<n>-1 is not a valid range.
+ */
+SV *
+_c_row_hashes(ESL_MSA *msa, int first, int n)
+{
+  SV           *hashesSV;
+  ROW_HASH_ARG  arg;
+  int           nthreads = 1;
+
+  if(first < 0 || n < 0 || first + n > msa->nseq) croak("_c_row_hashes() invalid sequence range %d..%d", first, first + n - 1);
+
+  /* hash straight into the returned string's buffer */
+  hashesSV = newSV(sizeof(uint64_t) * n + 1);
+  SvPOK_on(hashesSV);
+  SvCUR_set(hashesSV, sizeof(uint64_t) * n);
+  *SvEND(hashesSV) = '\0';
+
+  arg.msa        = msa;
+  arg.first      = first;
+  arg.gaps_equal = FALSE;
+  arg.case_equal = FALSE;
+  arg.hashA      = (uint64_t *) SvPVX(hashesSV);
+
+  if((double) n * (double) msa->alen > 4e6) nthreads = _c_threads_n();
+  _c_threads_parallel_for(nthreads, n, ESL_MAX(1, n / (nthreads * 16)), _c_row_hash_task, &arg);
+
+  return hashesSV;
+}
+
+/* Function:  _c_combine_row_hashes()
+ * Incept:    Sun Oct 18 17:09:15 2026
+ * Purpose:   Combine the packed per-sequence hashes from _c_row_hashes()
+ *            of an alignment of length <alen> into a single checksum.
+ *            The combination depends on the order of the sequences,
+ *            so reordering changes it, but only takes time linear in
+ *            the number of sequences, so an alignment in which a few
+ *            sequences change need only rehash those.
+ *
+ * Returns:   the checksum, as a string of 16 hexadecimal digits.
+ * Dies:      with croak if <hashes> isn't a whole number of hashes.
+ */
+SV *
+_c_combine_row_hashes(SV *hashes, int alen)
+{
+  STRLEN    len;
+  char     *p = SvPV(hashes, len);
+  uint64_t  rh;
+  uint64_t  h = 14695981039346656037ULL;
+  uint64_t  n;
+  uint64_t  i;
+
+  if(len % sizeof(uint64_t) != 0) croak("_c_combine_row_hashes() hashes string has wrong length %lu", (unsigned long) len);
+  n = len / sizeof(uint64_t);
+
+  for(i = 0; i < n; i++) { 
+    memcpy(&rh, p + i * sizeof(uint64_t), sizeof(uint64_t));
+    h = (h ^ rh) * 1099511628211ULL;
+    h ^= h >> 29;
+  }
+  h ^= n * 0x9E3779B97F4A7C15ULL;
+  h ^= (uint64_t) alen * 0xC2B2AE3D27D4EB4FULL;
+
+  /* splitmix64 finalizer, so similar alignments get dissimilar checksums */
+  h ^= h >> 30; h *= 0xBF58476D1CE4E5B9ULL;
+  h ^= h >> 27; h *= 0x94D049BB133111EBULL;
+  h ^= h >> 31;
+
+  return newSVpvf("%08lx%08lx", (unsigned long) (h >> 32), (unsigned long) (h & 0xffffffffUL));
+}
+
+/* Function:  _c_msas_from_perl()
+ * Incept:    Sun Oct 18 22:24:38 2026
+ * Synopsis:  Get the ESL_MSAs referenced by the perl array <msaAR>
+ *            for _c_concatenate() and _c_merge_rows(), and check 
+ *            they can be combined: all digital with the same type 
+ *            of alphabet, or all text. 
+ * Returns:   allocated array of the <ret_nmsa> ESL_MSAs in <ret_msaA>.
+ * Dies:      if <msaAR> is empty, an element is not an ESL_MSA, 
+ *            or the MSAs can't be combined.
+ */
+static void
+_c_msas_from_perl(AV *msaAR, char *caller, ESL_MSA ***ret_msaA, int *ret_nmsa)
+{
+  int       status;
+  ESL_MSA **msaA = NULL;
+  int       nmsa = av_len(msaAR) + 1;
+  SV      **value;
+  int       m;
+
+  if(nmsa < 1) croak("%s(), no alignments", caller);
+  ESL_ALLOC(msaA, sizeof(ESL_MSA *) * nmsa);
+  for(m = 0; m < nmsa; m++) { 
+    value   = av_fetch(msaAR, m, 0);
+    msaA[m] = (value == NULL) ? NULL : c_obj(*value, ESL_MSA);
+    if(msaA[m] == NULL) { free(msaA); croak("%s(), alignment %d is not an ESL_MSA", caller, m); }
+    if((msaA[m]->flags & eslMSA_DIGITAL) != (msaA[0]->flags & eslMSA_DIGITAL)) { 
+      free(msaA); croak("%s(), alignments must be all digital or all text", caller);
+    }
+    if((msaA[m]->flags & eslMSA_DIGITAL) && msaA[m]->abc->type != msaA[0]->abc->type) { 
+      free(msaA); croak("%s(), alignment %d has a different alphabet", caller, m);
+    }
+  }
+  *ret_msaA = msaA;
+  *ret_nmsa = nmsa;
+  return;
+
+ ERROR:
+  croak("%s(), out of memory", caller);
+}
+
+/* Function:  _c_msa_create_like()
+ * Incept:    Sun Oct 18 22:27:55 2026
+ * Synopsis:  Create a new MSA of <nseq> x <alen>, digital with a new
+ *            alphabet of the same type if <msa> is digital, else text.
+ *            Rows are left uninitialized, apart from the sentinels
+ *            of digital ones.
+ * Returns:   the new MSA, or NULL if out of memory.
+ */
+static ESL_MSA *
+_c_msa_create_like(ESL_MSA *msa, int nseq, int64_t alen)
+{
+  ESL_MSA      *new_msa;
+  ESL_ALPHABET *abc;
+  int           i;
+
+  if(msa->flags & eslMSA_DIGITAL) { 
+    if((abc = esl_alphabet_Create(msa->abc->type)) == NULL) return NULL;
+    if((new_msa = esl_msa_CreateDigital(abc, nseq, alen)) == NULL) return NULL;
+    for(i = 0; i < nseq; i++) new_msa->ax[i][0] = new_msa->ax[i][alen+1] = eslDSQ_SENTINEL;
+  }
+  else { 
+    if((new_msa = esl_msa_Create(nseq, alen)) == NULL) return NULL;
+    for(i = 0; i < nseq; i++) new_msa->aseq[i][alen] = '\0';
+  }
+  new_msa->nseq = nseq;
+  new_msa->alen = alen;
+
+  return new_msa;
+}
+
+/* row <i> of <msa> as bytes, [0..alen-1], digital or text */
+#define BE_MSA_ROW(msa, i) (((msa)->flags & eslMSA_DIGITAL) ? (uint8_t *) (msa)->ax[(i)] + 1 : (uint8_t *) (msa)->aseq[(i)])
+
+/* Function:  _c_concatenate()
+ * Incept:    Sun Oct 18 22:32:14 2026
+ * Purpose:   Concatenate the alignments in <msaAR> column-wise, 
+ *            into one with a row per sequence name (a supermatrix),
+ *            with the columns of each alignment in order. Rows are
+ *            matched by name through a keyhash, in order of first
+ *            appearance. A sequence missing from an alignment is all
+ *            gaps in its columns, or, if <keep_common>, only sequences
+ *            in all alignments are kept. The new alignment is 
+ *            allocated once, and each row of each alignment is 
+ *            copied with one memcpy().
+ *
+ *            RF and SS_cons are concatenated if all alignments
+ *            have them. Weights and other annotation are not kept.
+ *
+ * Returns:   the new MSA
+ * Dies:      if a name is duplicated within an alignment, or the 
+ *            alignments can't be combined (see _c_msas_from_perl()),
+ *            or no sequences are left.
+ */
+SV *
+_c_concatenate(AV *msaAR, int keep_common)
+{
+  int           status;
+  ESL_MSA     **msaA     = NULL;   /* [0..m..nmsa-1] the alignments */
+  int           nmsa;              /* number of alignments */
+  ESL_MSA      *new_msa  = NULL;   /* the new alignment */
+  ESL_KEYHASH  *kh       = NULL;   /* all sequence names, in order of first appearance */
+  int          *nfoundA  = NULL;   /* [0..k..nkey-1]: number of alignments name k is in */
+  int          *lastmA   = NULL;   /* [0..k..nkey-1]: last alignment name k was seen in */
+  int          *newidxA  = NULL;   /* [0..k..nkey-1]: row of name k in new_msa, -1 if dropped */
+  int          *srcA     = NULL;   /* [0..r..new_msa->nseq-1]: row of current alignment copied to row r, -1 if none */
+  int         **mapAA    = NULL;   /* [0..m..nmsa-1][0..i..nseq-1]: key of seq i of alignment m */
+  int           ntot     = 0;      /* total number of sequences */
+  int           nkey;              /* number of distinct names */
+  int           nseq     = 0;      /* number of sequences in new_msa */
+  int64_t       alen     = 0;      /* length of new_msa */
+  int64_t       offset;            /* first column of current alignment in new_msa */
+  int           do_rf    = TRUE;   /* TRUE to concatenate RF */
+  int           do_ss    = TRUE;   /* TRUE to concatenate SS_cons */
+  uint8_t       gap;               /* gap in new_msa */
+  int           m, i, k, r;
+
+  _c_msas_from_perl(msaAR, "_c_concatenate", &msaA, &nmsa);
+  for(m = 0; m < nmsa; m++) { 
+    ntot += msaA[m]->nseq;
+    alen += msaA[m]->alen;
+    if(msaA[m]->rf      == NULL) do_rf = FALSE;
+    if(msaA[m]->ss_cons == NULL) do_ss = FALSE;
+  }
+
+  /* match up names */
+  if((kh = esl_keyhash_Create()) == NULL) goto ERROR;
+  ESL_ALLOC(mapAA,   sizeof(int *) * nmsa);
+  for(m = 0; m < nmsa; m++) mapAA[m] = NULL;
+  ESL_ALLOC(nfoundA, sizeof(int) * ESL_MAX(1, ntot));
+  ESL_ALLOC(lastmA,  sizeof(int) * ESL_MAX(1, ntot));
+  for(m = 0; m < nmsa; m++) { 
+    ESL_ALLOC(mapAA[m], sizeof(int) * ESL_MAX(1, msaA[m]->nseq));
+    for(i = 0; i < msaA[m]->nseq; i++) { 
+      status = esl_keyhash_Store(kh, msaA[m]->sqname[i], -1, &k);
+      if(status == eslOK) { 
+        nfoundA[k] = 0;
+        lastmA[k]  = -1;
+      }
+      else if(status == eslEMEM) goto ERROR;
+      else if(status != eslEDUP) croak("_c_concatenate(), unexpected error storing name %s", msaA[m]->sqname[i]);
+      if(lastmA[k] == m) { 
+        croak("_c_concatenate(), sequence name %s occurs more than once in alignment %d", msaA[m]->sqname[i], m);
+      }
+      lastmA[k] = m;
+      nfoundA[k]++;
+      mapAA[m][i] = k;
+    }
+  }
+  nkey = esl_keyhash_GetNumber(kh);
+  ESL_ALLOC(newidxA, sizeof(int) * ESL_MAX(1, nkey));
+  for(k = 0; k < nkey; k++) newidxA[k] = (keep_common && nfoundA[k] < nmsa) ? -1 : nseq++;
+  if(nseq == 0) croak("_c_concatenate(), no sequences are in all alignments");
+
+  /* allocate the new alignment once */
+  if((new_msa = _c_msa_create_like(msaA[0], nseq, alen)) == NULL) goto ERROR;
+  for(k = 0; k < nkey; k++) { 
+    if(newidxA[k] != -1) { 
+      if(esl_msa_SetSeqName(new_msa, newidxA[k], esl_keyhash_Get(kh, k), -1) != eslOK) goto ERROR;
+    }
+  }
+  if(do_rf) { ESL_ALLOC(new_msa->rf,      sizeof(char) * (alen+1)); new_msa->rf[alen]      = '\0'; }
+  if(do_ss) { ESL_ALLOC(new_msa->ss_cons, sizeof(char) * (alen+1)); new_msa->ss_cons[alen] = '\0'; }
+  gap = (new_msa->flags & eslMSA_DIGITAL) ? esl_abc_XGetGap(new_msa->abc) : '-';
+
+  /* copy each alignment's block of columns */
+  ESL_ALLOC(srcA, sizeof(int) * nseq);
+  offset = 0;
+  for(m = 0; m < nmsa; m++) { 
+    for(r = 0; r < nseq; r++) srcA[r] = -1;
+    for(i = 0; i < msaA[m]->nseq; i++) { 
+      if(newidxA[mapAA[m][i]] != -1) srcA[newidxA[mapAA[m][i]]] = i;
+    }
+    for(r = 0; r < nseq; r++) { 
+      if(srcA[r] != -1) memcpy(BE_MSA_ROW(new_msa, r) + offset, BE_MSA_ROW(msaA[m], srcA[r]), msaA[m]->alen);
+      else              memset(BE_MSA_ROW(new_msa, r) + offset, gap,                            msaA[m]->alen);
+    }
+    if(do_rf) memcpy(new_msa->rf      + offset, msaA[m]->rf,      msaA[m]->alen);
+    if(do_ss) memcpy(new_msa->ss_cons + offset, msaA[m]->ss_cons, msaA[m]->alen);
+    offset += msaA[m]->alen;
+  }
+
+  for(m = 0; m < nmsa; m++) free(mapAA[m]);
+  free(mapAA);
+  free(nfoundA);
+  free(lastmA);
+  free(newidxA);
+  free(srcA);
+  free(msaA);
+  esl_keyhash_Destroy(kh);
+
+  return perl_obj(new_msa, "ESL_MSA");
+
+ ERROR:
+  croak("_c_concatenate(), out of memory");
+  return NULL; /* NEVERREACHED */
+}
+
+/* Function:  _c_merge_rows()
+ * Incept:    Sun Oct 18 22:41:06 2026
+ * Purpose:   Merge the alignments in <msaAR> row-wise, into one
+ *            with all their sequences, in order, aligned by their
+ *            nongap RF (consensus) columns, which must be the same
+ *            number in each. Between consensus columns, the new
+ *            alignment has as many insert columns as the alignment
+ *            with the most, each alignment's inserts are left
+ *            justified and padded with gaps ('.' in text mode).
+ *            The new alignment is allocated once and each insert 
+ *            run is copied with memcpy().
+ *
+ *            RF and SS_cons (if the first alignment has it) of 
+ *            consensus columns are taken from the first alignment, 
+ *            with '.' in insert columns. Weights and other 
+ *            annotation are not kept.
+ *
+ * Returns:   the new MSA
+ * Dies:      if an alignment has no RF or a different number of 
+ *            consensus columns, a name is in more than one 
+ *            alignment, or the alignments can't be combined (see 
+ *            _c_msas_from_perl()).
+ */
+SV *
+_c_merge_rows(AV *msaAR)
+{
+  int           status;
+  ESL_MSA     **msaA     = NULL;   /* [0..m..nmsa-1] the alignments */
+  int           nmsa;              /* number of alignments */
+  ESL_MSA      *new_msa  = NULL;   /* the new alignment */
+  ESL_KEYHASH  *kh       = NULL;   /* all sequence names, to check they're unique */
+  int64_t     **rfposAA  = NULL;   /* [0..m..nmsa-1][0..c..nrf]: alignment position of consensus column c of alignment m, [nrf] is alen */
+  int64_t      *maxinsA  = NULL;   /* [0..c..nrf]: max number of insert columns before consensus column c, [nrf] is after the last */
+  int64_t      *outposA  = NULL;   /* [0..c..nrf]: position of consensus column c in new_msa, [nrf] is alen */
+  int           nrf      = -1;     /* number of consensus columns */
+  int           nseq     = 0;      /* number of sequences in new_msa */
+  int64_t       alen;              /* length of new_msa */
+  int64_t       apos;              /* alignment position */
+  int64_t       start;             /* first column of an insert run */
+  int64_t       nins;              /* length of an insert run */
+  int           c;                 /* consensus column */
+  uint8_t       gap;               /* gap in new_msa, for insert columns */
+  uint8_t      *src, *dst;         /* rows being copied */
+  int           m, i, r;
+
+  _c_msas_from_perl(msaAR, "_c_merge_rows", &msaA, &nmsa);
+
+  /* find the consensus columns of each alignment */
+  ESL_ALLOC(rfposAA, sizeof(int64_t *) * nmsa);
+  for(m = 0; m < nmsa; m++) rfposAA[m] = NULL;
+  for(m = 0; m < nmsa; m++) { 
+    if(msaA[m]->rf == NULL) croak("_c_merge_rows(), alignment %d has no RF annotation", m);
+    ESL_ALLOC(rfposAA[m], sizeof(int64_t) * (msaA[m]->alen+1));
+    c = 0;
+    for(apos = 0; apos < msaA[m]->alen; apos++) { 
+      if(strchr("-_.~", msaA[m]->rf[apos]) == NULL) rfposAA[m][c++] = apos;
+    }
+    rfposAA[m][c] = msaA[m]->alen;
+    if(nrf == -1) nrf = c;
+    else if(c != nrf) croak("_c_merge_rows(), alignment %d has %d nongap RF columns, alignment 0 has %d", m, c, nrf);
+    nseq += msaA[m]->nseq;
+  }
+
+  /* widest insert before each consensus column, and after the last */
+  ESL_ALLOC(maxinsA, sizeof(int64_t) * (nrf+1));
+  ESL_ALLOC(outposA, sizeof(int64_t) * (nrf+1));
+  for(c = 0; c <= nrf; c++) { 
+    maxinsA[c] = 0;
+    for(m = 0; m < nmsa; m++) { 
+      nins = rfposAA[m][c] - ((c == 0) ? 0 : rfposAA[m][c-1]+1);
+      maxinsA[c] = ESL_MAX(maxinsA[c], nins);
+    }
+    outposA[c] = ((c == 0) ? 0 : outposA[c-1]+1) + maxinsA[c];
+  }
+  alen = outposA[nrf];
+
+  /* allocate the new alignment once */
+  if((kh = esl_keyhash_Create()) == NULL) goto ERROR;
+  if((new_msa = _c_msa_create_like(msaA[0], nseq, alen)) == NULL) goto ERROR;
+  gap = (new_msa->flags & eslMSA_DIGITAL) ? esl_abc_XGetGap(new_msa->abc) : '.';
+
+  r = 0;
+  for(m = 0; m < nmsa; m++) { 
+    for(i = 0; i < msaA[m]->nseq; i++, r++) { 
+      status = esl_keyhash_Store(kh, msaA[m]->sqname[i], -1, NULL);
+      if     (status == eslEDUP) croak("_c_merge_rows(), sequence name %s occurs more than once", msaA[m]->sqname[i]);
+      else if(status != eslOK)   goto ERROR;
+      if(esl_msa_SetSeqName(new_msa, r, msaA[m]->sqname[i], -1) != eslOK) goto ERROR;
+
+      src = BE_MSA_ROW(msaA[m], i);
+      dst = BE_MSA_ROW(new_msa, r);
+      for(c = 0; c <= nrf; c++) { 
+        /* inserts before consensus column c, left justified, then the column itself */
+        start = (c == 0) ? 0 : rfposAA[m][c-1]+1;
+        nins  = rfposAA[m][c] - start;
+        apos  = (c == 0) ? 0 : outposA[c-1]+1;
+        if(nins > 0)          memcpy(dst + apos,        src + start, nins);
+        if(maxinsA[c] > nins) memset(dst + apos + nins, gap,         maxinsA[c] - nins);
+        if(c < nrf) dst[outposA[c]] = src[rfposAA[m][c]];
+      }
+    }
+  }
+
+  /* consensus annotation from the first alignment */
+  ESL_ALLOC(new_msa->rf, sizeof(char) * (alen+1));
+  memset(new_msa->rf, '.', alen);
+  new_msa->rf[alen] = '\0';
+  for(c = 0; c < nrf; c++) new_msa->rf[outposA[c]] = msaA[0]->rf[rfposAA[0][c]];
+  if(msaA[0]->ss_cons != NULL) { 
+    ESL_ALLOC(new_msa->ss_cons, sizeof(char) * (alen+1));
+    memset(new_msa->ss_cons, '.', alen);
+    new_msa->ss_cons[alen] = '\0';
+    for(c = 0; c < nrf; c++) new_msa->ss_cons[outposA[c]] = msaA[0]->ss_cons[rfposAA[0][c]];
+  }
+
+  for(m = 0; m < nmsa; m++) free(rfposAA[m]);
+  free(rfposAA);
+  free(maxinsA);
+  free(outposA);
+  free(msaA);
+  esl_keyhash_Destroy(kh);
+
+  return perl_obj(new_msa, "ESL_MSA");
+
+ ERROR:
+  croak("_c_merge_rows(), out of memory");
+  return NULL; /* NEVERREACHED */
+}
+
 /* Function: _c_remove_all_gap_columns
  * Incept:   EPN, Thu Nov 14 13:44:02 2013
  * Purpose:  Remove columns containing all gap symbols
@@ -2537,7 +3976,8 @@ _c_is_residue(ESL_MSA *msa, int sqidx, int apos)
  * Incept:   EPN, Mon Feb  3 14:43:36 2014
  * Purpose:  Reorder sequences in an MSA by swapping pointers.
  *           Copied and slightly modified from esl-alimanip.c's
- *           reorder_msa().
+ *           reorder_msa(). The work is done by _c_reorder_core(),
+ *           which _c_reorder_by() also uses.
  *
  * Args:     msa:     the alignment
  *           orderAR: int array specifying new order (orderAR[2] = x ==> x becomes 3rd sequence)
@@ -2545,27 +3985,52 @@ _c_is_residue(ESL_MSA *msa, int sqidx, int apos)
  * Returns:  void
  * Dies:     with croak upon an error
  */
+static void _c_reorder_core(ESL_MSA *msa, int *order);
+
 void
 _c_reorder(ESL_MSA *msa, AV *orderAR)
 {
-
-  int status;
-  char **tmp; 
-  int i, a;
+  int  status;
   int *order = NULL;
-  ESL_ALLOC(tmp, sizeof(char *) * msa->nseq);
 
   /* create C int array useme */
   ESL_ALLOC(order, sizeof(int) * msa->nseq);
   /* copy the perl array into the C one */
   _c_int_copy_array_perl_to_c(orderAR, order, msa->nseq);
 
+  _c_reorder_core(msa, order);
+
+  free(order);
+  return;
+
+ ERROR:
+  croak("_c_reorder() out of memory");
+}
+
+/* Function: _c_reorder_core
+ * Incept:   Mon Oct 19 00:05:33 2026
+ * Purpose:  Reorder sequences in an MSA by swapping pointers,
+ *           order[i] = x ==> x becomes (i+1)'th sequence.
+ *           For _c_reorder() and _c_reorder_by(). Drops the
+ *           name index, which is stale after a reorder.
+ * Returns:  void
+ * Dies:     with croak upon an error
+ */
+static void
+_c_reorder_core(ESL_MSA *msa, int *order)
+{
+  int status;
+  char **tmp; 
+  int i, a;
+  ESL_ALLOC(tmp, sizeof(char *) * msa->nseq);
+
   /* contract check */
   /* 'order' must be have nseq elements, elements must be in range [0..nseq-1], no duplicates  */
   int *covered;
   ESL_ALLOC(covered, sizeof(int) * msa->nseq);
   esl_vec_ISet(covered, msa->nseq, 0);
   for(i = 0; i < msa->nseq; i++) { 
+    if(order[i] < 0 || order[i] >= msa->nseq) croak("_c_reorder() order array has out of range entry for i: %d\n", i);
     if(covered[order[i]]) croak("_c_reorder() order array has duplicate entries for i: %d\n", i);
     covered[order[i]] = 1;
   }
@@ -2588,6 +4053,15 @@ _c_reorder(ESL_MSA *msa, AV *orderAR)
   for(i = 0; i < msa->nseq; i++) tmp[i] = msa->sqname[i];
   for(i = 0; i < msa->nseq; i++) msa->sqname[i] = tmp[order[i]];
 
+  /* swap weights (mandatory) */
+  { 
+    double *tmp_wgt; 
+    ESL_ALLOC(tmp_wgt, sizeof(double) * msa->nseq);
+    for(i = 0; i < msa->nseq; i++) tmp_wgt[i] = msa->wgt[i];
+    for(i = 0; i < msa->nseq; i++) msa->wgt[i] = tmp_wgt[order[i]];
+    free(tmp_wgt);
+  }
+
   /* swap sqacc, if they exist */
   if(msa->sqacc != NULL) { 
     for(i = 0; i < msa->nseq; i++) tmp[i] = msa->sqacc[i];
@@ -2631,17 +4105,268 @@ _c_reorder(ESL_MSA *msa, AV *orderAR)
   }
   free(tmp);
 
-  free(order);
+  /* the index maps names to their old positions, _c_check_index() rebuilds it when needed */
+  if(msa->index != NULL) { 
+    esl_keyhash_Destroy(msa->index);
+    msa->index = NULL;
+  }
+
   return;
 
  ERROR:
   croak("_c_reorder() out of memory");
 }
 
+/* Function:  _c_pairid_rows_task()
+ * Incept:    Mon Oct 19 00:11:48 2026
+ * Synopsis:  Task function for _c_threads_parallel_for(): fractional
+ *            identity of each sequence i in [start..end-1] to 
+ *            sequence <ref>, or if <ref> is -1, to all sequences 
+ *            j > i, as distances 1 - pid into <D>. For _c_reorder_by().
+ */
+typedef struct {
+  ESL_MSA     *msa;
+  int          ref;      /* reference sequence, or -1 for all pairs */
+  double      *pidA;     /* [0..i..nseq-1]: identity of i to ref, if ref != -1 */
+  ESL_DMATRIX *D;        /* distances of all pairs, if ref == -1 */
+  int         *statusA;  /* [0..tid..nthreads-1]: first non-eslOK status of an esl_dst_*PairId() call by thread tid */
+} PAIRID_ROWS_ARG;
+
+static void
+_c_pairid_rows_task(void *varg, int64_t start, int64_t end, int tid)
+{
+  PAIRID_ROWS_ARG *arg = (PAIRID_ROWS_ARG *) varg;
+  ESL_MSA         *msa = arg->msa;
+  int64_t          i;
+  int              j;
+  int              status;
+  double           pid;
+
+  for(i = start; i < end; i++) { 
+    for(j = (arg->ref == -1) ? i+1 : arg->ref; j < ((arg->ref == -1) ? msa->nseq : arg->ref+1); j++) { 
+      if(msa->flags & eslMSA_DIGITAL) status = esl_dst_XPairId(msa->abc, msa->ax[i], msa->ax[j], &pid, NULL, NULL);
+      else                            status = esl_dst_CPairId(msa->aseq[i], msa->aseq[j], &pid, NULL, NULL);
+      if(status != eslOK) { arg->statusA[tid] = status; return; }
+      if(arg->ref != -1) arg->pidA[i] = pid;
+      else               arg->D->mx[i][j] = arg->D->mx[j][i] = 1. - pid;
+    }
+  }
+}
+
+/* Function:  _c_pairid_rows()
+ * Incept:    Mon Oct 19 00:15:02 2026
+ * Synopsis:  Run _c_pairid_rows_task() over all sequences, in 
+ *            parallel if there are enough comparisons to pay off.
+ * Returns:   eslOK on success, else the status of a failed esl_dst_*PairId() call.
+ */
+static int
+_c_pairid_rows(PAIRID_ROWS_ARG *arg)
+{
+  int     status;
+  int     nthreads = 1;
+  int     t;
+  double  ncmp = (double) arg->msa->alen * ((arg->ref == -1) ? (double) arg->msa->nseq * (double) arg->msa->nseq / 2. : (double) arg->msa->nseq);
+
+  if(ncmp > 4e6) nthreads = _c_threads_n();
+  ESL_ALLOC(arg->statusA, sizeof(int) * nthreads);
+  for(t = 0; t < nthreads; t++) arg->statusA[t] = eslOK;
+  _c_threads_parallel_for(nthreads, arg->msa->nseq, ESL_MAX(1, arg->msa->nseq / (nthreads * 16)), _c_pairid_rows_task, arg);
+
+  status = eslOK;
+  for(t = 0; t < nthreads; t++) if(arg->statusA[t] != eslOK) { status = arg->statusA[t]; break; }
+  free(arg->statusA);
+  arg->statusA = NULL;
+  return status;
+
+ ERROR:
+  croak("out of memory");
+  return eslEMEM;
+}
+
+/* sort keys for _c_reorder_by(): ties are broken by original index, so sorts are stable */
+typedef struct { 
+  double  x;     /* numeric key */
+  char   *name;  /* name key */
+  int     idx;   /* original index */
+} BE_SORTKEY;
+
+static int
+_c_sortkey_cmp_x(const void *a, const void *b)
+{
+  const BE_SORTKEY *ka = (const BE_SORTKEY *) a;
+  const BE_SORTKEY *kb = (const BE_SORTKEY *) b;
+  if(ka->x < kb->x) return -1;
+  if(ka->x > kb->x) return  1;
+  return ka->idx - kb->idx;
+}
+
+static int
+_c_sortkey_cmp_name(const void *a, const void *b)
+{
+  const BE_SORTKEY *ka = (const BE_SORTKEY *) a;
+  const BE_SORTKEY *kb = (const BE_SORTKEY *) b;
+  int               c  = strcmp(ka->name, kb->name);
+  return (c != 0) ? c : ka->idx - kb->idx;
+}
+
+/* Function:  _c_tree_order()
+ * Incept:    Mon Oct 19 00:19:37 2026
+ * Synopsis:  Order the sequences of <msa> as the leaves of a UPGMA
+ *            (<do_single> FALSE) or single linkage (<do_single> TRUE)
+ *            tree of their pairwise distances (1 - fractional 
+ *            identity), left to right, into <order>. Distances are
+ *            computed in parallel (see _c_pairid_rows()).
+ * Returns:   void
+ * Dies:      if out of memory or the tree can't be built.
+ */
+static void
+_c_tree_order(ESL_MSA *msa, int do_single, int *order)
+{
+  int              status;
+  PAIRID_ROWS_ARG  arg;
+  ESL_TREE        *T      = NULL;
+  int             *stackA = NULL;
+  int              nstack = 0;
+  int              n      = 0;
+  int              v, i;
+
+  if(msa->nseq < 3) { /* no choice to make */
+    for(i = 0; i < msa->nseq; i++) order[i] = i;
+    return;
+  }
+
+  arg.msa  = msa;
+  arg.ref  = -1;
+  arg.pidA = NULL;
+  if((arg.D = esl_dmatrix_Create(msa->nseq, msa->nseq)) == NULL) goto ERROR;
+  for(i = 0; i < msa->nseq; i++) arg.D->mx[i][i] = 0.;
+  if(_c_pairid_rows(&arg) != eslOK) { esl_dmatrix_Destroy(arg.D); croak("_c_tree_order() aligned sequences are different lengths"); }
+
+  status = (do_single) ? esl_tree_SingleLinkage(arg.D, &T) : esl_tree_UPGMA(arg.D, &T);
+  esl_dmatrix_Destroy(arg.D);
+  if(status != eslOK) croak("_c_tree_order() unable to build tree");
+
+  /* leaves in depth first order, left before right; internal
+   * nodes are 0..N-2 (0 is the root), a child <= 0 is leaf -child.
+   * The stack holds children as they are in the tree, left is 
+   * pushed last so it's visited first. */
+  ESL_ALLOC(stackA, sizeof(int) * 2 * msa->nseq);
+  stackA[nstack++] = T->right[0];
+  stackA[nstack++] = T->left[0];
+  while(nstack > 0) { 
+    v = stackA[--nstack];
+    if(v <= 0) { order[n++] = -v; continue; }
+    stackA[nstack++] = T->right[v];
+    stackA[nstack++] = T->left[v];
+  }
+  free(stackA);
+  esl_tree_Destroy(T);
+  if(n != msa->nseq) croak("_c_tree_order() tree has %d leaves, not %d", n, msa->nseq);
+  return;
+
+ ERROR:
+  croak("_c_tree_order() out of memory");
+}
+
+/* Function:  _c_reorder_by()
+ * Incept:    Mon Oct 19 00:27:10 2026
+ * Purpose:   Reorder the sequences of <msa> by <key>, computed and
+ *            sorted in C and passed straight to _c_reorder_core():
+ *              "name":           names, in strcmp() order
+ *              "length":         ungapped lengths, shortest first
+ *              "weight":         weights, lowest first
+ *              "identity":       fractional identity to sequence <ref>,
+ *                                most identical (<ref> itself) first
+ *              "upgma":          leaf order of a UPGMA tree
+ *              "single_linkage": leaf order of a single linkage tree
+ *            If <do_reverse>, the order is reversed. Sorts are
+ *            stable. Identities are computed in parallel for
+ *            large alignments.
+ *
+ * Returns:   the new order as packed native ints: [i] is the 
+ *            old index of the sequence that is now i'th.
+ * Dies:      if <key> is unknown or <ref> out of range.
+ */
+SV *
+_c_reorder_by(ESL_MSA *msa, char *key, int ref, int do_reverse)
+{
+  int              status;
+  BE_SORTKEY      *keyA  = NULL;
+  int             *order = NULL;
+  PAIRID_ROWS_ARG  arg;
+  int64_t          apos;
+  int              i, tmp;
+  int              do_tree = FALSE;
+  SV              *orderSV;
+
+  ESL_ALLOC(keyA,  sizeof(BE_SORTKEY) * ESL_MAX(1, msa->nseq));
+  ESL_ALLOC(order, sizeof(int)        * ESL_MAX(1, msa->nseq));
+  for(i = 0; i < msa->nseq; i++) { 
+    keyA[i].x    = 0.;
+    keyA[i].name = msa->sqname[i];
+    keyA[i].idx  = i;
+  }
+
+  if(strcmp(key, "name") == 0) { 
+    qsort(keyA, msa->nseq, sizeof(BE_SORTKEY), _c_sortkey_cmp_name);
+  }
+  else if(strcmp(key, "length") == 0) { 
+    for(i = 0; i < msa->nseq; i++) { 
+      for(apos = 0; apos < msa->alen; apos++) { 
+        if((msa->flags & eslMSA_DIGITAL) ? esl_abc_XIsResidue(msa->abc, msa->ax[i][apos+1]) : isalpha(msa->aseq[i][apos])) keyA[i].x += 1.;
+      }
+    }
+    qsort(keyA, msa->nseq, sizeof(BE_SORTKEY), _c_sortkey_cmp_x);
+  }
+  else if(strcmp(key, "weight") == 0) { 
+    for(i = 0; i < msa->nseq; i++) keyA[i].x = msa->wgt[i];
+    qsort(keyA, msa->nseq, sizeof(BE_SORTKEY), _c_sortkey_cmp_x);
+  }
+  else if(strcmp(key, "identity") == 0) { 
+    if(ref < 0 || ref >= msa->nseq) croak("_c_reorder_by() reference sequence %d out of range", ref);
+    arg.msa = msa;
+    arg.ref = ref;
+    arg.D   = NULL;
+    ESL_ALLOC(arg.pidA, sizeof(double) * msa->nseq);
+    if(_c_pairid_rows(&arg) != eslOK) croak("_c_reorder_by() aligned sequences are different lengths");
+    for(i = 0; i < msa->nseq; i++) keyA[i].x = (i == ref) ? -2. : -arg.pidA[i]; /* most identical first, ref before ties at 1.0 */
+    free(arg.pidA);
+    qsort(keyA, msa->nseq, sizeof(BE_SORTKEY), _c_sortkey_cmp_x);
+  }
+  else if(strcmp(key, "upgma") == 0 || strcmp(key, "single_linkage") == 0) { 
+    _c_tree_order(msa, (strcmp(key, "single_linkage") == 0) ? TRUE : FALSE, order);
+    do_tree = TRUE;
+  }
+  else croak("_c_reorder_by() unknown key %s", key);
+
+  if(! do_tree) for(i = 0; i < msa->nseq; i++) order[i] = keyA[i].idx;
+  if(do_reverse) { 
+    for(i = 0; i < msa->nseq / 2; i++) { 
+      tmp                      = order[i];
+      order[i]                 = order[msa->nseq - 1 - i];
+      order[msa->nseq - 1 - i] = tmp;
+    }
+  }
+
+  _c_reorder_core(msa, order);
+  orderSV = newSVpvn((char *) order, sizeof(int) * msa->nseq);
+
+  free(keyA);
+  free(order);
+  return orderSV;
+
+ ERROR:
+  croak("_c_reorder_by() out of memory");
+  return NULL; /* NEVERREACHED */
+}
+
 /* Function:  _c_check_index()
  * Incept:    EPN, Mon Feb  3 15:18:15 2014
  * Synopsis:  Check if an MSA has a valid index and if not, create it.
- * Dies:      If unable to create an index.
+ * Dies:      If unable to create an index, or if it would have to be
+ *            created for an MSA shared with another interpreter 
+ *            (shared MSAs are indexed before they are shared, see 
+ *            CLONE() in MSA.pm).
  */
 void _c_check_index (ESL_MSA *msa)
 {
@@ -2649,6 +4374,7 @@ void _c_check_index (ESL_MSA *msa)
 
   /* create the index if it doesn't exist or it seems incorrect (num keys != num seqs) */
   if(msa->index == NULL || (esl_keyhash_GetNumber(msa->index) != msa->nseq)) { 
+    if(_c_msa_nref(msa) > 1) { croak ("ERROR, _c_check_index() MSA is shared with another thread, unshare() it first"); }
     status = esl_msa_Hash(msa);
     if(status == eslEDUP)      { croak ("ERROR, _c_check_index() MSA has duplicated names in it"); }
     else if(status == eslEMEM) { croak ("ERROR, _c_check_index() out of memory"); }
@@ -2858,6 +4584,675 @@ char *_c_most_informative_sequence(ESL_MSA *msa, float gapthresh, int use_weight
   return NULL; /* not reached */
 }
 
+/* Function:  _c_column_profile_task()
+ * Incept:    Sun Oct 18 18:21:07 2026
+ * Synopsis:  Task function for _c_threads_parallel_for(): count
+ *            the residues of columns [start..end-1] for
+ *            _c_column_profile(), row by row within the block
+ *            of columns.
+ */
+typedef struct {
+  ESL_MSA *msa;
+  int      use_weights;
+  double  *profA;   /* [0..apos*(K+1)+a..alen*(K+1)-1]: weighted count of residue a in column apos, a == K are gaps */
+} COL_PROFILE_ARG;
+
+static void
+_c_column_profile_task(void *varg, int64_t start, int64_t end, int tid)
+{
+  COL_PROFILE_ARG *arg = (COL_PROFILE_ARG *) varg;
+  ESL_MSA         *msa = arg->msa;
+  int              K1  = msa->abc->K+1;
+  int64_t          apos;
+  int              i;
+  double           seqwt;
+
+  esl_vec_DSet(arg->profA + start * K1, (end - start) * K1, 0.);
+  for(i = 0; i < msa->nseq; i++) { 
+    seqwt = (arg->use_weights) ? msa->wgt[i] : 1.0;
+    for(apos = start; apos < end; apos++) { 
+      esl_abc_DCount(msa->abc, arg->profA + apos * K1, msa->ax[i][apos+1], seqwt);
+    }
+  }
+}
+
+/* Function:  _c_column_profile()
+ * Incept:    Sun Oct 18 18:24:40 2026
+ * Purpose:   Count the residues in each column of a digital alignment,
+ *            optionally weighted by the sequence weights, with
+ *            esl_abc_DCount(): degenerate residues are split
+ *            over the residues they stand for, gaps are counted
+ *            as residue K and missing data is not counted. Large
+ *            alignments are counted in parallel, in blocks of
+ *            columns (see bio_easel_threads.h).
+ *
+ *            The profile is computed once and kept by the perl
+ *            object for consensus_sequence(), see
+ *            _c_consensus_from_profile().
+ * Args:      msa:         the alignment
+ *            use_weights: '1' to use weights, '0' not to
+ * Returns:   the profile, as a string of alen * (K+1) packed
+ *            native doubles, column by column.
+ * Dies:      if MSA is NOT digitized, or if use_weights is '1' and weights are invalid
+ */
+SV *
+_c_column_profile(ESL_MSA *msa, int use_weights)
+{
+  SV              *profSV;
+  COL_PROFILE_ARG  arg;
+  int              nthreads = 1;
+  int64_t          n;
+
+  if(! (msa->flags & eslMSA_DIGITAL)) croak("_c_column_profile() contract violation, MSA is not digitized");
+  if((! (msa->flags & eslMSA_HASWGTS)) && (use_weights)) croak("_c_column_profile() trying to use weights, but they're not valid in the msa");
+
+  n = msa->alen * (msa->abc->K+1);
+  profSV = newSV(sizeof(double) * n + 1);
+  SvPOK_on(profSV);
+  SvCUR_set(profSV, sizeof(double) * n);
+  *SvEND(profSV) = '\0';
+
+  arg.msa         = msa;
+  arg.use_weights = use_weights;
+  arg.profA       = (double *) SvPVX(profSV);
+
+  if((double) msa->nseq * (double) msa->alen > 4e6) nthreads = _c_threads_n();
+  _c_threads_parallel_for(nthreads, msa->alen, ESL_MAX(64, msa->alen / (nthreads * 16)), _c_column_profile_task, &arg);
+
+  return profSV;
+}
+
+/* Function:  _c_consensus_from_profile()
+ * Incept:    Sun Oct 18 18:31:12 2026
+ * Purpose:   Determine a consensus sequence from a column profile
+ *            of <msa> from _c_column_profile(), in a single pass
+ *            over the profile. <mode> is one of:
+ *
+ *            "plurality": the most frequent symbol in each column,
+ *                         a gap if gaps are the most frequent.
+ *            "majority":  the symbol, residue or gap, with a
+ *                         frequency of more than <threshold>, else
+ *                         the unknown residue ('N' or 'X').
+ *            "iupac":     a gap if more than half the column is gaps,
+ *                         else the degenerate residue for the fewest
+ *                         residues, most frequent first, that make up
+ *                         at least <threshold> of the residues (e.g.
+ *                         'R' for A and G), the unknown residue if
+ *                         the alphabet has no such degenerate residue.
+ *            "gap":       a gap if less than <threshold> of the column
+ *                         is residues, else the most frequent residue.
+ *
+ *            Ties go to the residue earliest in the alphabet. Columns
+ *            with no residues or gaps (only missing data) are gaps.
+ *
+ * Args:      msa:       the alignment, for its alphabet and alen
+ *            profile:   packed profile from _c_column_profile()
+ *            mode:      "plurality", "majority", "iupac" or "gap"
+ *            threshold: see above, unused for "plurality"
+ * Returns:   the consensus, msa->alen long, upper case, '-' for gaps.
+ * Dies:      if MSA is NOT digitized, <mode> is invalid or <profile>
+ *            is the wrong size
+ */
+SV *
+_c_consensus_from_profile(ESL_MSA *msa, SV *profile, char *mode, double threshold)
+{
+  int      status;
+  STRLEN   len;
+  double  *profA;
+  double  *ct;                 /* counts for the current column */
+  int      K;
+  int      unk;                /* index of the unknown residue */
+  int      do_plurality = FALSE;
+  int      do_majority  = FALSE;
+  int      do_iupac     = FALSE;
+  int      do_gap       = FALSE;
+  int      apos;
+  int      a, b, n;
+  int      amax;               /* index of the most frequent residue */
+  int      amatch;             /* index of the degenerate residue matching the set */
+  double   rtot;               /* total residue count in column */
+  double   tot;                /* total residue and gap count in column */
+  double   cum;
+  int     *orderA = NULL;      /* residues, most frequent first, for "iupac" */
+  int     *inA    = NULL;      /* [0..a..K-1]: '1' if residue a is in the "iupac" set */
+  SV      *consSV;
+  char    *cons;
+
+  if(! (msa->flags & eslMSA_DIGITAL)) croak("_c_consensus_from_profile() contract violation, MSA is not digitized");
+  if     (strcmp(mode, "plurality") == 0) do_plurality = TRUE;
+  else if(strcmp(mode, "majority")  == 0) do_majority  = TRUE;
+  else if(strcmp(mode, "iupac")     == 0) do_iupac     = TRUE;
+  else if(strcmp(mode, "gap")       == 0) do_gap       = TRUE;
+  else croak("_c_consensus_from_profile() invalid mode %s", mode);
+
+  K     = msa->abc->K;
+  unk   = msa->abc->Kp-3;
+  profA = (double *) SvPV(profile, len);
+  if(len != sizeof(double) * msa->alen * (K+1)) croak("_c_consensus_from_profile() profile is the wrong size");
+
+  ESL_ALLOC(orderA, sizeof(int) * K);
+  ESL_ALLOC(inA,    sizeof(int) * K);
+
+  consSV = newSV(msa->alen + 1);
+  SvPOK_on(consSV);
+  SvCUR_set(consSV, msa->alen);
+  cons = SvPVX(consSV);
+  cons[msa->alen] = '\0';
+
+  for(apos = 0; apos < msa->alen; apos++) { 
+    ct   = profA + (int64_t) apos * (K+1);
+    amax = 0;
+    rtot = 0.;
+    for(a = 0; a < K; a++) { 
+      rtot += ct[a];
+      if(ct[a] > ct[amax]) amax = a;
+    }
+    tot = rtot + ct[K];
+
+    if(tot <= 0.) { 
+      cons[apos] = '-';
+    }
+    else if(do_plurality) { 
+      cons[apos] = (ct[K] > ct[amax]) ? '-' : msa->abc->sym[amax];
+    }
+    else if(do_majority) { 
+      if     (ct[amax] / tot > threshold) cons[apos] = msa->abc->sym[amax];
+      else if(ct[K]    / tot > threshold) cons[apos] = '-';
+      else                                cons[apos] = msa->abc->sym[unk];
+    }
+    else if(do_gap) { 
+      cons[apos] = (rtot / tot < threshold) ? '-' : msa->abc->sym[amax];
+    }
+    else if(do_iupac) { 
+      if(ct[K] / tot > 0.5) { cons[apos] = '-'; continue; }
+      /* insertion sort of the residues by count, K is small */
+      for(a = 0; a < K; a++) { 
+        for(b = a; b > 0 && ct[orderA[b-1]] < ct[a]; b--) orderA[b] = orderA[b-1];
+        orderA[b] = a;
+      }
+      esl_vec_ISet(inA, K, 0);
+      cum = 0.;
+      for(n = 0; n < K; n++) { 
+        inA[orderA[n]] = 1;
+        cum += ct[orderA[n]];
+        if(cum >= threshold * rtot) break;
+      }
+      amatch = unk;
+      for(a = 0; a < unk; a++) { 
+        for(b = 0; b < K; b++) { if(msa->abc->degen[a][b] != inA[b]) break; }
+        if(b == K) { amatch = a; break; }
+      }
+      cons[apos] = msa->abc->sym[amatch];
+    }
+  }
+
+  free(orderA);
+  free(inA);
+  return consSV;
+
+ ERROR:
+  if(orderA) free(orderA);
+  if(inA)    free(inA);
+  croak("out of memory in _c_consensus_from_profile()");
+  return NULL; /* not reached */
+}
+
+/* Function:  _c_get_alphabet()
+ * Incept:    Sun Oct 18 19:05:48 2026
+ * Synopsis:  Return the alphabet of a digital alignment: its type,
+ *            "RNA", "DNA" or "amino" (see esl_abc_DecodeType()), and
+ *            its canonical residues, in the order of their digital
+ *            codes (e.g. "ACGU").
+ * Returns:   (on the perl stack) type and residues.
+ * Dies:      if MSA is NOT digitized
+ */
+void
+_c_get_alphabet(ESL_MSA *msa)
+{
+  Inline_Stack_Vars;
+
+  if(! (msa->flags & eslMSA_DIGITAL)) croak("_c_get_alphabet() contract violation, MSA is not digitized");
+
+  Inline_Stack_Reset;
+  Inline_Stack_Push(sv_2mortal(newSVpv(esl_abc_DecodeType(msa->abc->type), 0)));
+  Inline_Stack_Push(sv_2mortal(newSVpvn(msa->abc->sym, msa->abc->K)));
+  Inline_Stack_Done;
+  Inline_Stack_Return(2);
+}
+
+/* Function:  _c_build_pssm()
+ * Incept:    Sun Oct 18 19:09:30 2026
+ * Purpose:   Build a position-specific scoring matrix from a column
+ *            profile of <msa> from _c_column_profile(): the score of
+ *            residue a in column apos is log2(p / bg[a]) bits, with
+ *            p = (count[a] + pseudocount * bg[a]) / (count + pseudocount),
+ *            where count is the number of residues (not gaps) in
+ *            the column, so an all gap column scores 0 for every
+ *            residue.
+ *
+ * Args:      msa:         the alignment, for its alphabet and alen
+ *            profile:     packed profile from _c_column_profile()
+ *            bgAR:        [0..a..K-1] background frequencies, > 0
+ *            pseudocount: total pseudocount per column, > 0
+ * Returns:   (on the perl stack) alen * K scores, column by column.
+ * Dies:      if MSA is NOT digitized, or <profile> or <bgAR> is the wrong size
+ */
+void
+_c_build_pssm(ESL_MSA *msa, SV *profile, AV *bgAR, double pseudocount)
+{
+  Inline_Stack_Vars;
+
+  int      status;
+  STRLEN   len;
+  double  *profA;
+  double  *ct;
+  double  *bgA = NULL;
+  double   rtot;
+  int      K;
+  int      apos;
+  int      a;
+  SV     **value;
+
+  if(! (msa->flags & eslMSA_DIGITAL)) croak("_c_build_pssm() contract violation, MSA is not digitized");
+  K     = msa->abc->K;
+  profA = (double *) SvPV(profile, len);
+  if(len != sizeof(double) * msa->alen * (K+1)) croak("_c_build_pssm() profile is the wrong size");
+  if(av_len(bgAR) + 1 != K) croak("_c_build_pssm() background has %d frequencies, alphabet has %d residues", (int) (av_len(bgAR) + 1), K);
+
+  ESL_ALLOC(bgA, sizeof(double) * K);
+  for(a = 0; a < K; a++) { 
+    value = av_fetch(bgAR, a, 0);
+    if(value == NULL) croak("_c_build_pssm(), failed array lookup for element %d", a);
+    bgA[a] = SvNV(*value);
+  }
+
+  Inline_Stack_Reset;
+  for(apos = 0; apos < msa->alen; apos++) { 
+    ct   = profA + (int64_t) apos * (K+1);
+    rtot = esl_vec_DSum(ct, K);
+    for(a = 0; a < K; a++) { 
+      Inline_Stack_Push(sv_2mortal(newSVnv(log(((ct[a] + pseudocount * bgA[a]) / (rtot + pseudocount)) / bgA[a]) / log(2.))));
+    }
+  }
+  Inline_Stack_Done;
+
+  free(bgA);
+  Inline_Stack_Return(msa->alen * K);
+  return;
+
+ ERROR:
+  croak("out of memory in _c_build_pssm()");
+  return; /* NEVERREACHED */
+}
+
+/* Function:  _c_window_stats()
+ * Incept:    Sun Oct 18 20:22:15 2026
+ * Purpose:   Calculate statistics of windows of <window> columns,
+ *            every <step> columns, along an alignment, from a column
+ *            profile of <msa> from _c_column_profile(): the average
+ *            entropy and sequence conservation of the columns (as in
+ *            _c_pos_entropy() and _c_pos_conservation()), and the GC 
+ *            content of the residues and the fraction of gaps. 
+ *
+ *            Windows start at the first column, and the last window
+ *            is the first one to reach the last column, so it may be 
+ *            shorter than <window>. Per-column values and counts are
+ *            summed into prefix sums in one pass, so each window takes 
+ *            constant time and the whole is O(alen), whatever the
+ *            window size.
+ *
+ * Args:      msa:     the alignment, for its alphabet and alen
+ *            profile: packed profile from _c_column_profile()
+ *            window:  window size, > 0
+ *            step:    distance between window starts, > 0
+ * Returns:   (on the perl stack) for each window: start, end (1..alen), 
+ *            entropy, conservation, GC content (undef unless the 
+ *            alphabet is RNA or DNA, 0 if no residues) and gap fraction.
+ * Dies:      if MSA is NOT digitized, <profile> is the wrong size or
+ *            <window> or <step> is not positive
+ */
+void
+_c_window_stats(ESL_MSA *msa, SV *profile, int window, int step)
+{
+  Inline_Stack_Vars;
+
+  int      status;
+  STRLEN   len;
+  double  *profA;
+  double  *ct;
+  double  *fA     = NULL;  /* frequencies of the current column */
+  double  *pentA  = NULL;  /* [0..apos..alen]: prefix sums of entropy of columns 0..apos-1 */
+  double  *pconsA = NULL;  /* same, conservation */
+  double  *pgcA   = NULL;  /* same, G and C counts */
+  double  *presA  = NULL;  /* same, residue counts */
+  double  *pgapA  = NULL;  /* same, gap counts */
+  int      K;
+  int      do_gc;
+  int      apos, a;
+  double   ent, cons, rtot;
+  int64_t  start, end;
+  int      nwin = 0;
+
+  if(! (msa->flags & eslMSA_DIGITAL)) croak("_c_window_stats() contract violation, MSA is not digitized");
+  if(window <= 0 || step <= 0) croak("_c_window_stats() window and step must be positive");
+  K     = msa->abc->K;
+  do_gc = (msa->abc->type == eslRNA || msa->abc->type == eslDNA) ? TRUE : FALSE;
+  profA = (double *) SvPV(profile, len);
+  if(len != sizeof(double) * msa->alen * (K+1)) croak("_c_window_stats() profile is the wrong size");
+
+  ESL_ALLOC(fA,     sizeof(double) * (K+1));
+  ESL_ALLOC(pentA,  sizeof(double) * (msa->alen+1));
+  ESL_ALLOC(pconsA, sizeof(double) * (msa->alen+1));
+  ESL_ALLOC(pgcA,   sizeof(double) * (msa->alen+1));
+  ESL_ALLOC(presA,  sizeof(double) * (msa->alen+1));
+  ESL_ALLOC(pgapA,  sizeof(double) * (msa->alen+1));
+  pentA[0] = pconsA[0] = pgcA[0] = presA[0] = pgapA[0] = 0.;
+
+  for(apos = 0; apos < msa->alen; apos++) { 
+    ct   = profA + (int64_t) apos * (K+1);
+    rtot = esl_vec_DSum(ct, K);
+
+    /* entropy, of the nongap residues, as in _c_pos_entropy() */
+    esl_vec_DCopy(ct, K, fA);
+    esl_vec_DNorm(fA, K);
+    ent = 0.;
+    for(a = 0; a < K; a++) { 
+      if(fA[a] > eslSMALLX1) ent -= fA[a] * (log(fA[a]) / log(2));
+    }
+    /* conservation, frequencies including gaps, as in _c_pos_conservation() */
+    esl_vec_DCopy(ct, K+1, fA);
+    esl_vec_DNorm(fA, K+1);
+    cons = 0.;
+    for(a = 0; a < K; a++) { 
+      if(fA[a] > cons) cons = fA[a];
+    }
+
+    pentA[apos+1]  = pentA[apos]  + ent;
+    pconsA[apos+1] = pconsA[apos] + cons;
+    pgcA[apos+1]   = pgcA[apos]   + ((do_gc) ? ct[1] + ct[2] : 0.); /* C and G */
+    presA[apos+1]  = presA[apos]  + rtot;
+    pgapA[apos+1]  = pgapA[apos]  + ct[K];
+  }
+
+  Inline_Stack_Reset;
+  for(start = 0; start < msa->alen; start += step) { 
+    end = ESL_MIN(start + window, msa->alen);
+    Inline_Stack_Push(sv_2mortal(newSViv(start + 1)));
+    Inline_Stack_Push(sv_2mortal(newSViv(end)));
+    Inline_Stack_Push(sv_2mortal(newSVnv((pentA[end]  - pentA[start])  / (double) (end - start))));
+    Inline_Stack_Push(sv_2mortal(newSVnv((pconsA[end] - pconsA[start]) / (double) (end - start))));
+    rtot = presA[end] - presA[start];
+    if(do_gc) Inline_Stack_Push(sv_2mortal(newSVnv((rtot > 0.) ? (pgcA[end] - pgcA[start]) / rtot : 0.)));
+    else      Inline_Stack_Push(sv_2mortal(newSV(0)));
+    Inline_Stack_Push(sv_2mortal(newSVnv((rtot + pgapA[end] - pgapA[start] > 0.) ? (pgapA[end] - pgapA[start]) / (rtot + pgapA[end] - pgapA[start]) : 0.)));
+    nwin++;
+    if(end == msa->alen) break;
+  }
+  Inline_Stack_Done;
+
+  free(fA);
+  free(pentA);
+  free(pconsA);
+  free(pgcA);
+  free(presA);
+  free(pgapA);
+  Inline_Stack_Return(nwin * 6);
+  return;
+
+ ERROR:
+  if(fA)     free(fA);
+  if(pentA)  free(pentA);
+  if(pconsA) free(pconsA);
+  if(pgcA)   free(pgcA);
+  if(presA)  free(presA);
+  if(pgapA)  free(pgapA);
+  croak("out of memory in _c_window_stats()");
+  return; /* NEVERREACHED */
+}
+
+/* Function:  _c_colmap_task()
+ * Incept:    Sun Oct 18 23:36:12 2026
+ * Synopsis:  Task function for _c_threads_parallel_for(): for each
+ *            pair of same named sequences p in [start..end-1], walk
+ *            both aligned rows once, pairing the r'th residue of one
+ *            with the r'th residue of the other, and tally the 
+ *            column of the other alignment each column of the first
+ *            one maps to. For _c_map_columns_to().
+ *
+ *            Pass 1 keeps BE_COLMAP_K candidate columns per column
+ *            with Misra-Gries counters, per thread; they are merged
+ *            by _c_map_columns_to(), and any column that more than 
+ *            1/(BE_COLMAP_K+1) of the residues map to is among
+ *            them. Pass 2 counts exactly how many residues map to
+ *            each merged candidate.
+ */
+#define BE_COLMAP_K 4
+
+typedef struct {
+  ESL_MSA  *msa;       /* alignment whose columns are mapped */
+  ESL_MSA  *other;     /* alignment they're mapped to */
+  int      *pairA;     /* [0..p..npair-1]: [2p] is index of a sequence in msa, [2p+1] of the same named one in other */
+  char     *skipA;     /* [0..p..npair-1]: TRUE if the two sequences of pair p have different numbers of residues */
+  int       pass;      /* 1 or 2, see above */
+  int     **posAA;     /* [0..tid..nthreads-1][0..r..other->alen-1]: column of residue r of the row of other, per thread */
+  int     **candAA;    /* [0..tid..nthreads-1][0..a*K+k..alen*K-1]: pass 1: candidate column k for column a, -1 if none */
+  int     **cntAA;     /* [0..tid..nthreads-1][0..a*K+k..alen*K-1]: pass 1: counter of candidate k, pass 2: count of merged candidate k */
+  int     **nresAA;    /* [0..tid..nthreads-1][0..a..alen-1]: pass 2: number of residues in column a of sequences in other */
+  int      *mergedA;   /* [0..a*K+k..alen*K-1]: merged candidate column k for column a, -1 if none, for pass 2 */
+} COLMAP_ARG;
+
+static int
+_c_colmap_is_residue(ESL_MSA *msa, int i, int64_t apos)
+{
+  if(msa->flags & eslMSA_DIGITAL) return esl_abc_XIsResidue(msa->abc, msa->ax[i][apos+1]);
+  else                            return isalpha(msa->aseq[i][apos]) ? TRUE : FALSE;
+}
+
+static void
+_c_colmap_task(void *varg, int64_t start, int64_t end, int tid)
+{
+  COLMAP_ARG *arg   = (COLMAP_ARG *) varg;
+  ESL_MSA    *msa   = arg->msa;
+  ESL_MSA    *other = arg->other;
+  int        *posA  = arg->posAA[tid];
+  int        *candA = arg->candAA[tid];
+  int        *cntA  = arg->cntAA[tid];
+  int        *nresA = arg->nresAA[tid];
+  int64_t     p;
+  int64_t     apos;
+  int         i, j;
+  int         n1, n2;   /* number of residues in row i of msa, j of other */
+  int         b;        /* column of other */
+  int        *c, *n;
+  int         k;
+
+  for(p = start; p < end; p++) { 
+    i = arg->pairA[2*p];
+    j = arg->pairA[2*p+1];
+    if(arg->pass == 2 && arg->skipA[p]) continue;
+
+    n2 = 0;
+    for(apos = 0; apos < other->alen; apos++) if(_c_colmap_is_residue(other, j, apos)) posA[n2++] = apos;
+    if(arg->pass == 1) { 
+      n1 = 0;
+      for(apos = 0; apos < msa->alen; apos++) if(_c_colmap_is_residue(msa, i, apos)) n1++;
+      if(n1 != n2) { arg->skipA[p] = TRUE; continue; }
+    }
+
+    n1 = 0;
+    for(apos = 0; apos < msa->alen; apos++) { 
+      if(! _c_colmap_is_residue(msa, i, apos)) continue;
+      b = posA[n1++];
+      c = (arg->pass == 1) ? candA + apos * BE_COLMAP_K : arg->mergedA + apos * BE_COLMAP_K;
+      n = cntA + apos * BE_COLMAP_K;
+      if(arg->pass == 1) { 
+        for(k = 0; k < BE_COLMAP_K; k++) if(c[k] == b) { n[k]++; break; }
+        if(k < BE_COLMAP_K) continue;
+        for(k = 0; k < BE_COLMAP_K; k++) if(n[k] == 0) { c[k] = b; n[k] = 1; break; }
+        if(k < BE_COLMAP_K) continue;
+        for(k = 0; k < BE_COLMAP_K; k++) n[k]--;
+      }
+      else { 
+        nresA[apos]++;
+        for(k = 0; k < BE_COLMAP_K; k++) if(c[k] == b) { n[k]++; break; }
+      }
+    }
+  }
+}
+
+/* Function:  _c_map_columns_to()
+ * Incept:    Sun Oct 18 23:44:57 2026
+ * Purpose:   Map each column of <msa> to the column of <other> its
+ *            residues are in, using the sequences in both (matched
+ *            by name) with the same number of residues: the r'th
+ *            residue of a sequence in one is the r'th in the 
+ *            other. Each pair of rows is walked once, in parallel
+ *            over sequences for large alignments; see 
+ *            _c_colmap_task() for how columns are tallied in bounded
+ *            memory. <msa> and <other> may be digital or text.
+ *
+ * Returns:   (on the perl stack) the number of sequences used, then
+ *            for each column a of <msa>, the column of <other> 
+ *            (1..other->alen) most of its residues map to, 0 if 
+ *            it has no residues in the sequences used, then for each 
+ *            column the fraction of its residues that map there
+ *            (the agreement), 0. if it has none.
+ * Dies:      if out of memory, or <other> has duplicate names.
+ */
+void
+_c_map_columns_to(ESL_MSA *msa, ESL_MSA *other)
+{
+  Inline_Stack_Vars;
+
+  int         status;
+  COLMAP_ARG  arg;
+  int         nthreads = 1;
+  int         npair = 0;
+  int         nused = 0;
+  int         ncand;
+  int         candA[BE_COLMAP_K * 64]; /* merged candidates of one column, from all threads */
+  int         cntA [BE_COLMAP_K * 64];
+  int         nres;
+  int         best;
+  int64_t     a;
+  int         i, j, k, t, u;
+  double     *agreeA = NULL;
+  int        *mapA   = NULL;
+
+  memset(&arg, 0, sizeof(COLMAP_ARG));
+  arg.msa   = msa;
+  arg.other = other;
+
+  /* pair up the sequences by name */
+  if(other->index == NULL || esl_keyhash_GetNumber(other->index) != other->nseq) { 
+    if(_c_msa_nref(other) > 1) croak("_c_map_columns_to() other MSA is shared with another thread, unshare() it first");
+    status = esl_msa_Hash(other);
+    if(status == eslEDUP)    croak("_c_map_columns_to() other MSA has duplicated names in it");
+    else if(status != eslOK) croak("_c_map_columns_to() unable to index other MSA");
+  }
+  ESL_ALLOC(arg.pairA, sizeof(int) * 2 * ESL_MAX(1, msa->nseq));
+  for(i = 0; i < msa->nseq; i++) { 
+    if(esl_keyhash_Lookup(other->index, msa->sqname[i], -1, &j) == eslOK) { 
+      arg.pairA[2*npair]   = i;
+      arg.pairA[2*npair+1] = j;
+      npair++;
+    }
+  }
+  ESL_ALLOC(arg.skipA, sizeof(char) * ESL_MAX(1, npair));
+  memset(arg.skipA, 0, sizeof(char) * ESL_MAX(1, npair));
+
+  /* per thread tallies */
+  if((double) npair * (double) (msa->alen + other->alen) > 4e6) nthreads = ESL_MIN(64, _c_threads_n());
+  ESL_ALLOC(arg.posAA,  sizeof(int *) * nthreads);
+  ESL_ALLOC(arg.candAA, sizeof(int *) * nthreads);
+  ESL_ALLOC(arg.cntAA,  sizeof(int *) * nthreads);
+  ESL_ALLOC(arg.nresAA, sizeof(int *) * nthreads);
+  for(t = 0; t < nthreads; t++) arg.posAA[t] = arg.candAA[t] = arg.cntAA[t] = arg.nresAA[t] = NULL;
+  for(t = 0; t < nthreads; t++) { 
+    ESL_ALLOC(arg.posAA[t],  sizeof(int) * ESL_MAX(1, other->alen));
+    ESL_ALLOC(arg.candAA[t], sizeof(int) * ESL_MAX(1, msa->alen * BE_COLMAP_K));
+    ESL_ALLOC(arg.cntAA[t],  sizeof(int) * ESL_MAX(1, msa->alen * BE_COLMAP_K));
+    ESL_ALLOC(arg.nresAA[t], sizeof(int) * ESL_MAX(1, msa->alen));
+    esl_vec_ISet(arg.candAA[t], msa->alen * BE_COLMAP_K, -1);
+    esl_vec_ISet(arg.cntAA[t],  msa->alen * BE_COLMAP_K, 0);
+    esl_vec_ISet(arg.nresAA[t], msa->alen, 0);
+  }
+  ESL_ALLOC(arg.mergedA, sizeof(int) * ESL_MAX(1, msa->alen * BE_COLMAP_K));
+
+  /* pass 1: candidates */
+  arg.pass = 1;
+  _c_threads_parallel_for(nthreads, npair, ESL_MAX(1, npair / (nthreads * 16)), _c_colmap_task, &arg);
+
+  /* merge each column's candidates from all threads, keep the BE_COLMAP_K with the highest counts */
+  for(a = 0; a < msa->alen; a++) { 
+    ncand = 0;
+    for(t = 0; t < nthreads; t++) { 
+      for(k = 0; k < BE_COLMAP_K; k++) { 
+        if(arg.cntAA[t][a*BE_COLMAP_K+k] == 0) continue;
+        for(u = 0; u < ncand; u++) if(candA[u] == arg.candAA[t][a*BE_COLMAP_K+k]) break;
+        if(u == ncand) { candA[ncand] = arg.candAA[t][a*BE_COLMAP_K+k]; cntA[ncand] = 0; ncand++; }
+        cntA[u] += arg.cntAA[t][a*BE_COLMAP_K+k];
+      }
+    }
+    for(k = 0; k < BE_COLMAP_K; k++) { 
+      best = -1;
+      for(u = 0; u < ncand; u++) if(cntA[u] > 0 && (best == -1 || cntA[u] > cntA[best])) best = u;
+      arg.mergedA[a*BE_COLMAP_K+k] = (best == -1) ? -1 : candA[best];
+      if(best != -1) cntA[best] = 0;
+    }
+  }
+
+  /* pass 2: exact counts of the candidates */
+  for(t = 0; t < nthreads; t++) esl_vec_ISet(arg.cntAA[t], msa->alen * BE_COLMAP_K, 0);
+  arg.pass = 2;
+  _c_threads_parallel_for(nthreads, npair, ESL_MAX(1, npair / (nthreads * 16)), _c_colmap_task, &arg);
+
+  ESL_ALLOC(mapA,   sizeof(int)    * ESL_MAX(1, msa->alen));
+  ESL_ALLOC(agreeA, sizeof(double) * ESL_MAX(1, msa->alen));
+  for(a = 0; a < msa->alen; a++) { 
+    nres = 0;
+    for(t = 0; t < nthreads; t++) nres += arg.nresAA[t][a];
+    best = -1;
+    for(k = 0; k < BE_COLMAP_K; k++) { 
+      cntA[k] = 0;
+      for(t = 0; t < nthreads; t++) cntA[k] += arg.cntAA[t][a*BE_COLMAP_K+k];
+      if(arg.mergedA[a*BE_COLMAP_K+k] != -1 && (best == -1 || cntA[k] > cntA[best])) best = k;
+    }
+    mapA[a]   = (nres == 0 || best == -1) ? 0  : arg.mergedA[a*BE_COLMAP_K+best] + 1;
+    agreeA[a] = (nres == 0 || best == -1) ? 0. : (double) cntA[best] / (double) nres;
+  }
+  for(i = 0; i < npair; i++) if(! arg.skipA[i]) nused++;
+
+  Inline_Stack_Reset;
+  Inline_Stack_Push(sv_2mortal(newSViv(nused)));
+  for(a = 0; a < msa->alen; a++) Inline_Stack_Push(sv_2mortal(newSViv(mapA[a])));
+  for(a = 0; a < msa->alen; a++) Inline_Stack_Push(sv_2mortal(newSVnv(agreeA[a])));
+  Inline_Stack_Done;
+
+  for(t = 0; t < nthreads; t++) { 
+    free(arg.posAA[t]);
+    free(arg.candAA[t]);
+    free(arg.cntAA[t]);
+    free(arg.nresAA[t]);
+  }
+  free(arg.posAA);
+  free(arg.candAA);
+  free(arg.cntAA);
+  free(arg.nresAA);
+  free(arg.mergedA);
+  free(arg.pairA);
+  free(arg.skipA);
+  free(mapA);
+  free(agreeA);
+
+  Inline_Stack_Return(1 + 2 * msa->alen);
+  return;
+
+ ERROR:
+  croak("out of memory in _c_map_columns_to()");
+  return; /* NEVERREACHED */
+}
+
 /* Function:  _c_map_rfpos_to_apos()
  * Incept:    EPN, Mon May 19 11:00:49 2014
  * Synopsis:  Given an MSA, determine the alignment position of each nongap RF position
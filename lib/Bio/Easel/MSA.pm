@@ -2,8 +2,13 @@ package Bio::Easel::MSA;
 
 use strict;
 use warnings;
+use File::Basename;
 use File::Spec;
 use Carp;
+use Scalar::Util qw(refaddr weaken);
+use Digest::MD5;
+use IO::Handle;
+use Bio::Easel ();  # for progress reporting, see Bio::Easel::set_progress_callback(), and caching, see Bio::Easel::set_cache_dir()
 
 =head1 NAME
 
@@ -49,28 +54,55 @@ our $ESLENOFORMAT      = '25';    # couldn't guess file format
 our $ESLENOALPHABET    = '26';    # couldn't guess seq alphabet
 our $ESLEWRITE         = '27';    # write failed (fprintf, etc)
 
+# what happens to the ESL_MSA of each object when an ithreads perl
+# starts a new thread (see CLONE()), unless set_clone_mode() was
+# called for the object: "copy" or "share"
+our $CLONE_MODE = "copy";
+
+# all live objects, weak references, key: refaddr(), for CLONE()
+my %live_objects = ();
+
 my $src_file      = undef;
 my $typemaps      = undef;
 my $easel_src_dir = undef;
+my $module_dir    = undef;
 
 BEGIN {
   $src_file = __FILE__;
   $src_file =~ s/\.pm/\.c/;
 
+  # for bio_easel_threads.h
+  $module_dir = File::Spec->rel2abs( File::Basename::dirname(__FILE__) );
+
   $easel_src_dir = File::Spec->catfile( $ENV{BIO_EASEL_SHARE_DIR}, 'src/easel' );
 
   $typemaps = __FILE__;
   $typemaps =~ s/\.pm/\.typemap/;
 }
 
-use Inline
-  C        => "$src_file",
-  VERSION  => '0.01',
-  ENABLE   => 'AUTOWRAP',
-  INC      => "-I$easel_src_dir",
-  LIBS     => "-L$easel_src_dir -leasel",
-  TYPEMAPS => $typemaps,
-  NAME     => 'Bio::Easel::MSA';
+# Load the precompiled XS build of MSA.c (see xs/BioEaselXS.pm) if
+# it was installed, else fall back to compiling it with Inline::C,
+# which is also what you get with BIO_EASEL_INLINE=1 (development).
+# An XS build that is installed but fails to load is an error.
+BEGIN {
+  require XSLoader;
+  my $use_inline = $ENV{BIO_EASEL_INLINE};
+  if((! $use_inline) && (! eval { XSLoader::load('Bio::Easel::MSA', '0.01'); 1; })) {
+    if($@ !~ m/^Can't locate loadable object for module/) { die $@; }
+    $use_inline = 1;
+  }
+  if($use_inline) {
+    require Inline;
+    Inline->import(
+      C        => "$src_file",
+      VERSION  => '0.01',
+      ENABLE   => 'AUTOWRAP',
+      INC      => "-I$easel_src_dir -I$module_dir",
+      LIBS     => "-L$easel_src_dir -leasel -lpthread",
+      TYPEMAPS => $typemaps,
+      NAME     => 'Bio::Easel::MSA');
+  }
+}
 
 =head1 SYNOPSIS
 
@@ -169,6 +201,9 @@ sub new {
   if ( defined $args->{aliType} ) {
     $self->{aliType} = $args->{aliType};
   }
+
+  $live_objects{ refaddr($self) } = $self;
+  weaken( $live_objects{ refaddr($self) } );
   
   return $self;
 }
@@ -311,6 +346,7 @@ sub read_msa {
   }
 
   ($self->{esl_msa}, $self->{informat}) = _c_read_msa( $self->{path}, $informat, $self->{digitize}, $self->{isRna}, $self->{isDna}, $self->{isAmino});
+  $self->_invalidate_row_hashes();
   # Possible values for 'format', a string, derived from esl_msafile.c::esl_msafile_DecodeFormat(): 
   # "unknown", "Stockholm", "Pfam", "UCSC A2M", "PSI-BLAST", "SELEX", "aligned FASTA", "Clustal", 
   # "Clustal-like", "PHYLIP (interleaved)", or "PHYLIP (sequential)".
@@ -380,6 +416,46 @@ sub checksum {
   return _c_checksum( $self->{esl_msa} );
 }
 
+#-------------------------------------------------------------------------------
+
+=head2 row_checksum
+
+  Title    : row_checksum
+  Incept   : Sun Oct 18 17:14:40 2026
+  Usage    : $msaObject->row_checksum()
+  Function : Determine a checksum for an MSA from a hash of
+           : each aligned sequence, combined in order.
+           : The per-sequence hashes are kept with the object
+           : and updated as it changes: set_sqstring_aligned()
+           : only rehashes one sequence, reorder_all() only
+           : permutes the hashes, and sequence_subset() and
+           : sequence_subset_given_names() pass the hashes of
+           : the kept sequences to the new MSA. Any other change
+           : to the aligned sequences (e.g. column_subset())
+           : rehashes all of them on the next call.
+           : Sequence names and annotation are not included.
+           : Like checksum(), the same MSA will give a different
+           : checksum depending on whether it was read in text
+           : or digital mode, and unlike checksum() the result
+           : is not compatible with esl_msa_Checksum().
+  Args     : none
+  Returns  : checksum as a string of 16 hexadecimal digits.
+
+=cut
+
+sub row_checksum {
+  my ($self) = @_;
+
+  $self->_check_msa();
+  if(! defined $self->{row_checksum}) { 
+    if(! defined $self->{row_hashes}) { 
+      $self->{row_hashes} = _c_row_hashes($self->{esl_msa}, 0, $self->nseq);
+    }
+    $self->{row_checksum} = _c_combine_row_hashes($self->{row_hashes}, $self->alen);
+  }
+  return $self->{row_checksum};
+}
+
 
 #-------------------------------------------------------------------------------
 
@@ -485,7 +561,7 @@ sub get_rflen
 sub set_rf { 
   my ( $self, $rfstr ) = @_;
 
-  $self->_check_msa();
+  $self->_check_writable();
   if(length($rfstr) != $self->alen) { croak "Trying to set RF with string of incorrect length"; }
   return _c_set_rf( $self->{esl_msa}, $rfstr );
 }
@@ -580,7 +656,7 @@ sub get_ss_cons_ct {
 sub set_ss_cons { 
   my ( $self, $ss_cons_str ) = @_;
 
-  $self->_check_msa();
+  $self->_check_writable();
   if(length($ss_cons_str) != $self->alen) { croak "Trying to set SS_cons with string of incorrect length"; }
   return _c_set_ss_cons( $self->{esl_msa}, $ss_cons_str, 0 );
 }
@@ -602,7 +678,7 @@ sub set_ss_cons {
 sub set_ss_cons_wuss { 
   my ( $self, $ss_cons_str ) = @_;
 
-  $self->_check_msa();
+  $self->_check_writable();
   if(length($ss_cons_str) != $self->alen) { croak "Trying to set SS_cons with string of incorrect length"; }
   return _c_set_ss_cons( $self->{esl_msa}, $ss_cons_str, 1 );
 }
@@ -623,7 +699,7 @@ sub set_ss_cons_wuss {
 sub set_blank_ss_cons { 
   my ( $self ) = @_;
 
-  $self->_check_msa();
+  $self->_check_writable();
   return _c_set_blank_ss_cons( $self->{esl_msa} );
 }
 
@@ -687,7 +763,7 @@ sub get_sqidx {
 sub set_sqname {
   my ( $self, $idx, $newname ) = @_;
 
-  $self->_check_msa();
+  $self->_check_writable();
   $self->_check_sqidx($idx);
   _c_set_sqname( $self->{esl_msa}, $idx, $newname );
   return;
@@ -752,8 +828,9 @@ sub get_sqwgt {
 sub remove_sqwgts {
   my ( $self ) = @_;
 
-  $self->_check_msa();
+  $self->_check_writable();
   _c_remove_sqwgts( $self->{esl_msa} );
+  delete $self->{col_profile};
   return;
 }
 
@@ -813,7 +890,7 @@ sub get_name {
 sub set_accession {
   my ( $self, $newname ) = @_;
 
-  $self->_check_msa();
+  $self->_check_writable();
   my $status = _c_set_accession( $self->{esl_msa}, $newname );
   if ( $status != $ESLOK ) {
     croak "unable to set name (failure in C code)";
@@ -837,7 +914,7 @@ sub set_accession {
 sub set_name {
   my ( $self, $newname ) = @_;
 
-  $self->_check_msa();
+  $self->_check_writable();
   my $status = _c_set_name( $self->{esl_msa}, $newname );
   if ( $status != $ESLOK ) {
     croak "unable to set name (failure in C code)";
@@ -977,6 +1054,8 @@ sub any_allgap_columns {
            : result with vary over multiple runs).
   Args     : max number of sequences for brute force calculation
   Returns  : average percent id of all seq pairs or a sample
+           : If all pairs are compared, the result is cached, see 
+           : Bio::Easel->set_cache_dir().
   
 =cut
 
@@ -990,7 +1069,16 @@ sub average_id {
 
   # average percent id is expensive to calculate, so we set it once calc'ed
   if ( !defined $self->{average_id} ) {
-    $self->{average_id} = _c_average_id( $self->{esl_msa}, $max_nseq );
+    # a sample varies between runs, so only cache it if all pairs are compared
+    my $key = ( defined Bio::Easel->get_cache_dir() && $self->nseq <= $max_nseq ) ? $self->_cache_key("average_id", 0) : undef;
+    my $cachedR = ( defined $key ) ? Bio::Easel::_cache_fetch($key) : undef;
+    if ( defined $cachedR ) {
+      $self->{average_id} = $$cachedR;
+    }
+    else {
+      $self->{average_id} = _c_average_id( $self->{esl_msa}, $max_nseq );
+      if ( defined $key ) { Bio::Easel::_cache_store($key, \$self->{average_id}); }
+    }
   }
   return $self->{average_id};
 }
@@ -1018,6 +1106,82 @@ sub get_sqstring_aligned {
 
 #-------------------------------------------------------------------------------
 
+=head2 set_sqstring_aligned
+
+  Title    : set_sqstring_aligned
+  Incept   : Sun Oct 18 17:18:02 2026
+  Usage    : $msaObject->set_sqstring_aligned($sqstring, $idx)
+  Function : Replace an aligned sequence of an MSA. Only that
+           : sequence is rehashed for row_checksum().
+  Args     : $sqstring: new aligned sequence, must be alen long
+           : $idx:      index of sequence to replace
+  Returns  : void
+  Dies     : if $sqstring is not alen long, or (digital mode)
+           : it can't be digitized
+
+=cut
+
+sub set_sqstring_aligned {
+  my ( $self, $sqstring, $idx ) = @_;
+
+  $self->_check_writable();
+  $self->_check_sqidx($idx);
+  _c_set_sqstring_aligned( $self->{esl_msa}, $sqstring, $idx );
+  $self->_update_row_hashes($idx);
+  return;
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 add_sequence_aligned
+
+  Title    : add_sequence_aligned
+  Incept   : Sun Oct 18 23:19:40 2026
+  Usage    : $msaObject->add_sequence_aligned($sqname, $sqstring, $weight)
+  Function : Add an aligned sequence to the end of an MSA, in place.
+           : Room for sequences is doubled when it runs out and the
+           : name is added to the existing name index, so building
+           : an MSA one sequence at a time takes time proportional
+           : to its size, unlike recreating it with 
+           : create_from_string() for each new sequence. 
+           : If row_checksum() was called, only the new sequence is
+           : hashed. average_id(), average_sqlen() and 
+           : count_residues() are recomputed on their next call.
+           : The new sequence has no per-sequence annotation.
+  Args     : $sqname:   name of the new sequence
+           : $sqstring: aligned sequence, must be alen long
+           : $weight:   optional: weight of the new sequence; if given
+           :            the MSA is flagged as having weights, if not 
+           :            the weight is 1.0
+  Returns  : index of the new sequence (the old nseq)
+  Dies     : if $sqstring is not alen long, (digital mode) it can't
+           : be digitized, or a sequence named $sqname is already
+           : in the MSA; the MSA is then unchanged
+
+=cut
+
+sub add_sequence_aligned {
+  my ( $self, $sqname, $sqstring, $weight ) = @_;
+
+  $self->_check_writable();
+  if ( !defined $sqname || !defined $sqstring ) { croak "ERROR: add_sequence_aligned() requires a name and an aligned sequence"; }
+  _c_add_sequence_aligned( $self->{esl_msa}, $sqname, $sqstring, ( defined $weight ? $weight : 1. ), ( defined $weight ? 1 : 0 ) );
+
+  my $idx = $self->nseq - 1;
+  if ( defined $self->{row_hashes} ) {
+    $self->{row_hashes} .= _c_row_hashes( $self->{esl_msa}, $idx, 1 );
+    delete $self->{row_checksum};
+  }
+  delete $self->{col_profile};
+  delete $self->{average_id};
+  delete $self->{average_sqlen};
+  delete $self->{nresidue};
+
+  return $idx;
+}
+
+#-------------------------------------------------------------------------------
+
 =head2 swap_gap_and_closest_residue
 
   Title    : swap_gap_and_closest_residue
@@ -1048,7 +1212,7 @@ sub swap_gap_and_closest_residue {
   my ( $self, $seqidx, $gap_apos, $do_before ) = @_;
 
   my $sub_name = "swap_gap_and_closest_residue()";
-  $self->_check_msa();
+  $self->_check_writable();
   $self->_check_sqidx($seqidx);
 
   # contract checks
@@ -1115,6 +1279,7 @@ sub swap_gap_and_closest_residue {
   $sqstring_A[($res_apos-1)] = $save_char;
   $sqstring = join("", @sqstring_A);
   _c_set_sqstring_aligned($self->{esl_msa}, $sqstring, $seqidx);
+  $self->_update_row_hashes($seqidx);
 
   if(defined $ppstring) { 
     $save_char = $ppstring_A[($gap_apos-1)];
@@ -1411,10 +1576,17 @@ sub average_sqlen {
            : SS_cons annotated RNA alignment and output it. 
            : See 'Purpose' section of _c_rfam_qc_stats() C function in
            : MSA.c for more information.
+           : Progress, in pairs of sequences compared, is reported to the
+           : callback set with Bio::Easel->set_progress_callback().
   Args     : fam_outfile: name of output file for per-family stats
            : seq_outfile: name of output file for per-sequence stats
            : bp_outfile:  name of output file for per-basepair stats
+           : The output is cached, see Bio::Easel->set_cache_dir(), and
+           : if cached the files are written from the cache, with no
+           : progress reported.
   Returns  : void
+  Dies     : with "rfam_qc_stats cancelled" if cancelled, see Bio::Easel->cancel(),
+           : the output files are then incomplete.
 
 =cut
 
@@ -1422,16 +1594,157 @@ sub rfam_qc_stats {
   my ( $self, $fam_outfile, $seq_outfile, $bp_outfile ) = @_;
 
   $self->_check_msa();
+  my @outfileA = ($fam_outfile, $seq_outfile, $bp_outfile);
+  my $key = ( defined Bio::Easel->get_cache_dir() ) ? $self->_cache_key("rfam_qc_stats", 1) : undef;
+  my $cachedAR = ( defined $key ) ? Bio::Easel::_cache_fetch($key) : undef;
+  if ( defined $cachedAR ) {
+    for ( my $f = 0; $f < scalar(@outfileA); $f++ ) {
+      open( my $out, ">", $outfileA[$f] ) || croak "ERROR: unable to open $outfileA[$f] for writing";
+      print $out $cachedAR->[$f];
+      close($out) || croak "ERROR: unable to write $outfileA[$f]";
+    }
+    return;
+  }
+
   my $status = _c_rfam_qc_stats( $self->{esl_msa}, $fam_outfile, $seq_outfile, $bp_outfile);
   if ( $status != $ESLOK ) {
     croak "ERROR: unable to calculate rfam qc stats";
   }
 
+  if ( defined $key ) {
+    my @contentA = ();
+    foreach my $outfile (@outfileA) {
+      open( my $in, "<", $outfile ) || croak "ERROR: unable to open $outfile for reading";
+      local $/;
+      push( @contentA, scalar(<$in>) );
+      close($in);
+    }
+    Bio::Easel::_cache_store($key, \@contentA);
+  }
+
+  return;
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 rfam_qc_stats_stream
+
+  Title    : rfam_qc_stats_stream
+  Incept   : Sun Oct 18 22:04:09 2026
+  Usage    : $msaObject->rfam_qc_stats_stream($fh, $optHR)
+  Function : Calculate the same per-family, per-sequence and per-basepair
+           : stats as rfam_qc_stats() and write all three tables to
+           : one open file handle, through one large buffer, so the 
+           : stats of many alignments can be written to the same 
+           : stream without the cost of many small formatted writes
+           : to three files each.
+           : Formats:
+           :   "tsv":    tab separated lines, the first field is the
+           :             table ('family', 'sequence' or 'basepair'), 
+           :             the others are the columns of rfam_qc_stats(),
+           :             unpadded. With 'header', each table starts
+           :             with a line of column names starting with '#'.
+           :   "binary": compact binary records, unrounded, in native
+           :             byte order, read them with read_rfam_qc_binary().
+           : $fh is flushed before and written to directly after, 
+           : so it must be a real file handle (with a fileno()), 
+           : not an in-memory one. Nothing is written if cancelled.
+           : The output is not cached, see Bio::Easel->set_cache_dir().
+  Args     : $fh:    open file handle to write to
+           : $optHR: optional: hash ref of options:
+           :   format: "tsv" (default) or "binary"
+           :   header: '0' to write no header lines in "tsv" format,
+           :           default '1'
+  Returns  : void
+  Dies     : with "rfam_qc_stats cancelled" if cancelled, see Bio::Easel->cancel(),
+           : if $fh has no file descriptor or can't be written, 
+           : or if an option is not one of those above.
+
+=cut
+
+sub rfam_qc_stats_stream {
+  my ( $self, $fh, $optHR ) = @_;
+
+  $self->_check_msa();
+  my %optH = ( defined $optHR ) ? ( %{$optHR} ) : ();
+  foreach my $key ( keys %optH ) {
+    if ( $key ne "format" && $key ne "header" ) { croak "rfam_qc_stats_stream() unknown option $key"; }
+  }
+  my $format = ( defined $optH{format} ) ? $optH{format} : "tsv";
+  if ( $format ne "tsv" && $format ne "binary" ) {
+    croak "ERROR: rfam_qc_stats_stream() format must be \"tsv\" or \"binary\", not $format";
+  }
+  my $header = ( defined $optH{header} ) ? $optH{header} : 1;
+
+  my $fd = ( defined $fh ) ? fileno($fh) : undef;
+  if ( !defined $fd || $fd < 0 ) { croak "ERROR: rfam_qc_stats_stream() requires a file handle with a file descriptor"; }
+  $fh->flush();
+
+  _c_rfam_qc_stats_stream( $self->{esl_msa}, $fd, $format, ( $header ? 1 : 0 ) );
+
   return;
 }
 
 #-------------------------------------------------------------------------------
 
+=head2 read_rfam_qc_binary
+
+  Title    : read_rfam_qc_binary
+  Incept   : Sun Oct 18 22:09:52 2026
+  Usage    : @recordA = Bio::Easel::MSA::read_rfam_qc_binary($data)
+  Function : Decode the records of the "binary" format of 
+           : rfam_qc_stats_stream(), as read from the stream 
+           : (on a machine with the same byte order).
+  Args     : $data: the binary stream, as a string
+  Returns  : array of hash refs, one per record, in order, with key 
+           : 'table' ('family', 'sequence' or 'basepair'), 'family'
+           : and: 
+           :   family:   fcbp, covariation, nseq, alen, nbp, nres, 
+           :             pid_mean, pid_max, pid_min, len_mean, len_max,
+           :             len_min, frac_nongap, frac_A, frac_C, frac_G,
+           :             frac_U, max_dinuc, max_dinuc_frac, cg
+           :   sequence: sqname, fcbp, len, frac_A, frac_C, frac_G,
+           :             frac_U, max_dinuc, max_dinuc_frac, cg
+           :   basepair: left, right, fcbp, covariation
+  Dies     : if $data is not a sequence of complete records.
+
+=cut
+
+my %RFAM_QC_BIN = (
+  "F" => [ "family",   "L/a d2 l q l l d4 l l d5 a d2",
+           [ "family", "fcbp", "covariation", "nseq", "alen", "nbp", "nres", "pid_mean", "pid_max", "pid_min", 
+             "len_mean", "len_max", "len_min", "frac_nongap", "frac_A", "frac_C", "frac_G", "frac_U", 
+             "max_dinuc", "max_dinuc_frac", "cg" ] ],
+  "S" => [ "sequence", "L/a L/a d l d4 a d2",
+           [ "family", "sqname", "fcbp", "len", "frac_A", "frac_C", "frac_G", "frac_U", "max_dinuc", "max_dinuc_frac", "cg" ] ],
+  "B" => [ "basepair", "L/a l l d d",
+           [ "family", "left", "right", "fcbp", "covariation" ] ],
+);
+
+sub read_rfam_qc_binary {
+  my ($data) = @_;
+
+  my @recordA = ();
+  my $pos = 0;
+  while ( $pos < length($data) ) {
+    my $type = substr( $data, $pos, 1 );
+    if ( !exists $RFAM_QC_BIN{$type} ) { croak "ERROR: read_rfam_qc_binary() unknown record type at byte $pos"; }
+    my ( $table, $template, $fieldAR ) = @{ $RFAM_QC_BIN{$type} };
+    my @valueA = eval { unpack( "\@$pos x $template .*", $data ); };
+    if ( $@ || scalar(@valueA) != scalar(@{$fieldAR}) + 1 || $valueA[-1] > length($data) ) {
+      croak "ERROR: read_rfam_qc_binary() truncated $table record at byte $pos";
+    }
+    $pos = pop(@valueA);
+    my %recordH = ( table => $table );
+    @recordH{ @{$fieldAR} } = @valueA;
+    push( @recordA, \%recordH );
+  }
+
+  return @recordA;
+}
+
+#-------------------------------------------------------------------------------
+
 =head2 setDesc
 
   Title    : setDesc
@@ -1446,7 +1759,7 @@ sub rfam_qc_stats {
 sub setDesc {
   my ( $self, $value ) = @_;
 
-  $self->_check_msa();
+  $self->_check_writable();
   my $status = _c_setDesc( $self->{esl_msa}, $value );
   if ( $status != $ESLOK ) { croak "ERROR: unable to set Desc annotation"; }
   return;
@@ -1468,7 +1781,7 @@ sub setDesc {
 sub setAccession {
   my ( $self, $value ) = @_;
 
-  $self->_check_msa();
+  $self->_check_writable();
   my $status = _c_setAccession( $self->{esl_msa}, $value );
   if ( $status != $ESLOK ) { croak "ERROR: unable to set Accession"; }
   return;
@@ -1543,7 +1856,7 @@ sub getAccession {
 sub addGF {
   my ( $self, $tag, $value ) = @_;
 
-  $self->_check_msa();
+  $self->_check_writable();
   my $status = _c_addGF( $self->{esl_msa}, $tag, $value );
   if ( $status != $ESLOK ) { croak "ERROR: unable to add GF annotation"; }
   return;
@@ -1568,7 +1881,7 @@ sub addGF {
 sub addGS {
   my ( $self, $tag, $value, $sqidx ) = @_;
 
-  $self->_check_msa();
+  $self->_check_writable();
   $self->_check_sqidx($sqidx);
 
   my $status = _c_addGS( $self->{esl_msa}, $sqidx, $tag, $value );
@@ -1598,7 +1911,7 @@ sub addGC {
 
   # contract checks
   if((! defined $annAR) || (scalar(@{$annAR}) != $self->alen)) { croak "ERROR: unable to add GC annotation because it is empty or the wrong length"; }
-  $self->_check_msa();
+  $self->_check_writable();
 
   # create the annotation string
   my $annstr = "";
@@ -1631,7 +1944,7 @@ sub addGC {
 sub addGC_identity {
   my ( $self, $use_res ) = @_;
 
-  $self->_check_msa();
+  $self->_check_writable();
   my $status = _c_addGC_identity( $self->{esl_msa}, $use_res );
   if ( $status != $ESLOK ) { croak "ERROR: unable to add GC ID annotation"; }
   return;
@@ -1654,7 +1967,7 @@ sub addGC_identity {
 sub addGC_rf_column_numbers {
   my ( $self ) = @_;
 
-  $self->_check_msa();
+  $self->_check_writable();
   if(! $self->has_rf) { croak "Trying to number RF gap columns, but no RF annotation exists in the MSA"; }
   my @num_str_A = ();
   _get_nongap_numbering_for_aligned_string($self->get_rf, \@num_str_A, ".-~", ".");
@@ -1693,7 +2006,7 @@ sub addGC_rf_column_numbers {
 sub addGC_all_column_numbers {
   my ( $self ) = @_;
 
-  $self->_check_msa();
+  $self->_check_writable();
   my @num_str_A = ();
   if($self->nseq < 1) { croak "Trying to number columns, but no seqs exists in the MSA"; }
   # fetch 1st seq, we can use any, and set gap_str to "", this tells _get_nongap_numbering_for_aligned_string()
@@ -1873,7 +2186,7 @@ sub addGR {
 
   # contract checks
   if((! defined $annstr) || (length($annstr) != $self->alen)) { croak "ERROR: unable to add GR annotation because it is empty or the wrong length"; }
-  $self->_check_msa();
+  $self->_check_writable();
   $self->_check_sqidx($sqidx);
 
   # add it
@@ -1900,7 +2213,7 @@ sub addGR {
 sub addGR_seq_position_numbers {
   my ( $self, $sqidx ) = @_;
 
-  $self->_check_msa();
+  $self->_check_writable();
   $self->_check_sqidx($sqidx);
 
   my @num_str_A = ();
@@ -2172,6 +2485,10 @@ sub getGR_tagidx {
   Usage    : $msaObject->weight_GSC($tag, $value)
   Function : Compute and annotate MSA with sequence weights using the 
            : GSC algorithm. Dies with croak if something goes wrong.
+           : The callback set with Bio::Easel->set_progress_callback()
+           : is told when this starts and finishes, but it can't be
+           : cancelled once it's started.
+           : The weights are cached, see Bio::Easel->set_cache_dir().
   Args     : none
   Returns  : void
 
@@ -2180,9 +2497,22 @@ sub getGR_tagidx {
 sub weight_GSC {
   my ( $self ) = @_;
 
-  $self->_check_msa();
+  $self->_check_writable();
+  delete $self->{col_profile};
+  my $key = ( defined Bio::Easel->get_cache_dir() ) ? $self->_cache_key("weight_GSC", 0) : undef;
+  my $cachedAR = ( defined $key ) ? Bio::Easel::_cache_fetch($key) : undef;
+  if ( defined $cachedAR ) {
+    _c_set_sqwgts( $self->{esl_msa}, $cachedAR );
+    return;
+  }
+
   my $status = _c_weight_GSC( $self->{esl_msa} );
   if ( $status != $ESLOK ) { croak "ERROR: unable to calculate GSC weights"; }
+
+  if ( defined $key ) {
+    my @wgtA = map { _c_get_sqwgt( $self->{esl_msa}, $_ ) } ( 0 .. $self->nseq - 1 );
+    Bio::Easel::_cache_store($key, \@wgtA);
+  }
   return;
 }
 
@@ -2204,6 +2534,7 @@ sub free_msa {
 
   # don't call _check_msa, if we don't have it, that's okay
   _c_free_msa( $self->{esl_msa} );
+  $self->_invalidate_row_hashes();
   return;
 }
 
@@ -2253,6 +2584,7 @@ sub weight_id_filter
   my $msa_out = _c_msaweight_IDFilter($msa_in, $idf);
   
   $self->{esl_msa} = $msa_out;
+  $self->_invalidate_row_hashes();
   
   _c_free_msa($msa_in);
   
@@ -2340,7 +2672,11 @@ sub filter_msa_subset_target_nseq
             : $idf:      fractional identity threshold no pair of seqs in $keepmeAR will exceed
             : $keepmeAR: [0..$i..$self->nseq]: '1' if seq $i survives the filtering.
             :            note that $keepmeAR->[$i] can only be '1' if $usemeAR->[$i] is also '1'.
+            : Progress, in sequences, is reported to the callback set with
+            : Bio::Easel->set_progress_callback().
   Returns   : Number of sequences that are '1' in $keepmeAR upon exit.
+  Dies      : with "filter_msa_subset cancelled" if cancelled, see Bio::Easel->cancel(),
+            : $keepmeAR is then incomplete.
 
 =cut
 
@@ -2358,6 +2694,7 @@ sub filter_msa_subset
     if($keepmeAR->[$i]) { $nkeep++; }
   }
   
+  Bio::Easel::_progress("filter_msa_subset", 0, $nseq);
   for($i = 0; $i < $nseq; $i++) { 
     if($keepmeAR->[$i]) { # we haven't removed it yet
       for($j = $i+1; $j < $nseq; $j++) { # for every other seq that ... 
@@ -2369,8 +2706,10 @@ sub filter_msa_subset
           }
         }
       }
+      Bio::Easel::_progress("filter_msa_subset", $i+1, $nseq);
     }
   }
+  Bio::Easel::_progress("filter_msa_subset", $nseq, $nseq);
 
   return $nkeep;
 }
@@ -2570,7 +2909,7 @@ sub reorder_all
 {
   my ($self, $nameorderAR) = @_;
 
-  $self->_check_msa();
+  $self->_check_writable();
   $self->_check_index();
 
   my $nseq = $self->nseq();
@@ -2590,6 +2929,80 @@ sub reorder_all
 
   _c_reorder($self->{esl_msa}, \@idxorderA);
 
+  if(defined $self->{row_hashes}) { 
+    $self->{row_hashes} = pack("(a8)*", (unpack("(a8)*", $self->{row_hashes}))[@idxorderA]);
+    delete $self->{row_checksum};
+  }
+
+  return;
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 reorder_by
+
+  Title     : reorder_by
+  Incept    : Mon Oct 19 00:34:26 2026
+  Usage     : $msaObject->reorder_by($key, $optHR)
+  Function  : Reorder all sequences in an MSA by swapping pointers,
+            : sorted by $key, computed and sorted in C, without 
+            : building perl arrays of names:
+            :   "name":           by name (string order)
+            :   "length":         by unaligned length, shortest first
+            :   "weight":         by weight, lowest first
+            :   "identity":       by fractional identity to a reference
+            :                     sequence, which comes first, then 
+            :                     the most identical
+            :   "upgma":          in the leaf order of a UPGMA tree of 
+            :                     pairwise distances (1 - identity), 
+            :                     similar sequences together
+            :   "single_linkage": in the leaf order of a single linkage
+            :                     tree of pairwise distances
+            : Sorts are stable. Pairwise identities are computed in
+            : parallel for large alignments; the trees need identities
+            : of all pairs, which takes time proportional to nseq^2 * alen.
+  Args      : $key:   one of the keys above
+            : $optHR: optional: hash ref of options:
+            :   reverse:   '1' to reverse the order
+            :   reference: name of the reference sequence for "identity",
+            :              or its index if no sequence has that name,
+            :              default the first sequence
+  Returns   : void
+  Dies      : if $key or an option is not one of those above, or the
+            : reference sequence doesn't exist.
+=cut
+
+sub reorder_by
+{
+  my ($self, $key, $optHR) = @_;
+
+  $self->_check_writable();
+  my %optH = ( defined $optHR ) ? ( %{$optHR} ) : ();
+  foreach my $opt (keys %optH) { 
+    if($opt ne "reverse" && $opt ne "reference") { croak "reorder_by() unknown option $opt"; }
+  }
+  if(! defined $key) { croak "ERROR, reorder_by() requires a key"; }
+  if($key !~ m/^(name|length|weight|identity|upgma|single_linkage)$/) { 
+    croak "ERROR, reorder_by() unknown key $key, should be \"name\", \"length\", \"weight\", \"identity\", \"upgma\" or \"single_linkage\"";
+  }
+
+  # a name first, sequences can be named "3"
+  my $ref = 0;
+  if(defined $optH{reference}) { 
+    $ref = $self->get_sqidx($optH{reference});
+    if($ref == -1) { 
+      if($optH{reference} =~ m/^\d+$/ && $optH{reference} < $self->nseq) { $ref = $optH{reference}; }
+      else { croak "ERROR, reorder_by() unable to find reference sequence $optH{reference}"; }
+    }
+  }
+
+  my $order = _c_reorder_by($self->{esl_msa}, $key, $ref, ($optH{reverse} ? 1 : 0));
+
+  if(defined $self->{row_hashes}) { 
+    $self->{row_hashes} = pack("(a8)*", (unpack("(a8)*", $self->{row_hashes}))[unpack("i*", $order)]);
+    delete $self->{row_checksum};
+  }
+
   return;
 }
 
@@ -2625,11 +3038,199 @@ sub sequence_subset
   my $new_msa = Bio::Easel::MSA->new({
     esl_msa => $new_esl_msa,
   });
+  $self->_subset_row_hashes($new_msa, $usemeAR);
 
   return $new_msa;
 }
 
 
+#-------------------------------------------------------------------------------
+
+=head2 concatenate
+
+  Title     : concatenate
+  Incept    : Sun Oct 18 22:50:31 2026
+  Usage     : ($newmsaObject, $partAR) = $msaObject->concatenate($msaAR, $optHR)
+  Function  : Create a new MSA by concatenating this MSA and those in
+            : @{$msaAR} column-wise, in that order (a supermatrix):
+            : sequences are matched by name, and there is one row per
+            : name, in order of first appearance. A sequence missing 
+            : from an MSA is all gaps in that MSA's columns. 
+            : All MSAs must be digital, with the same alphabet, or all
+            : text. RF and SS_cons are concatenated if all MSAs have
+            : them; weights and other annotation are not kept.
+            : The new MSA is allocated once and filled with one memory
+            : copy per row of each MSA, so this is much faster than 
+            : concatenating aligned sequence strings in perl.
+  Args      : $msaAR: ref to array of Bio::Easel::MSA objects to 
+            :         append to this one
+            : $optHR: optional: hash ref of options:
+            :   keep_common: '1' to keep only sequences that are in all
+            :                MSAs, instead of filling in gaps
+  Returns   : $new_msa: the new Bio::Easel::MSA object
+            : $partAR:  ref to array of [ $start, $end ] columns (1..alen)
+            :           of the new MSA that come from each MSA, this one
+            :           first
+  Dies      : if a sequence name occurs more than once in an MSA, the
+            : MSAs aren't all digital with the same alphabet or all 
+            : text, with keep_common no sequence is in all MSAs, or an
+            : option is not one of those above
+=cut
+
+sub concatenate
+{
+  my ($self, $msaAR, $optHR) = @_;
+
+  $self->_check_msa();
+  my %optH = ( defined $optHR ) ? ( %{$optHR} ) : ();
+  foreach my $key (keys %optH) { 
+    if($key ne "keep_common") { croak "concatenate() unknown option $key"; }
+  }
+  my @msaA = ($self, $self->_check_msa_list("concatenate", $msaAR));
+
+  my $new_esl_msa = _c_concatenate([ map { $_->{esl_msa} } @msaA ], ($optH{keep_common} ? 1 : 0));
+  my $new_msa = Bio::Easel::MSA->new({
+    esl_msa => $new_esl_msa,
+  });
+
+  my @partA = ();
+  my $start = 1;
+  foreach my $msa (@msaA) { 
+    push(@partA, [ $start, $start + $msa->alen - 1 ]);
+    $start += $msa->alen;
+  }
+
+  return ($new_msa, \@partA);
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 merge_rows
+
+  Title     : merge_rows
+  Incept    : Sun Oct 18 22:55:47 2026
+  Usage     : $newmsaObject = $msaObject->merge_rows($msaAR)
+  Function  : Create a new MSA with the sequences of this MSA and
+            : those in @{$msaAR}, in that order, aligned by their
+            : nongap RF (consensus) columns, which must be the same
+            : number in each MSA, as for alignments of different
+            : sequences to the same model. Between consensus columns 
+            : the new MSA has as many insert columns as the MSA with 
+            : the most; inserts are left justified.
+            : All MSAs must be digital, with the same alphabet, or all
+            : text. RF, and SS_cons if this MSA has it, are taken 
+            : from this MSA's consensus columns, with '.' in insert
+            : columns; weights and other annotation are not kept.
+            : The new MSA is allocated once and filled with memory
+            : copies of each insert run.
+  Args      : $msaAR: ref to array of Bio::Easel::MSA objects to 
+            :         merge with this one
+  Returns   : $new_msa: the new Bio::Easel::MSA object
+  Dies      : if an MSA has no RF annotation or a different number of
+            : nongap RF columns, a sequence name is in more than one
+            : MSA, or the MSAs aren't all digital with the same 
+            : alphabet or all text
+=cut
+
+sub merge_rows
+{
+  my ($self, $msaAR) = @_;
+
+  $self->_check_msa();
+  my @msaA = ($self, $self->_check_msa_list("merge_rows", $msaAR));
+
+  my $new_esl_msa = _c_merge_rows([ map { $_->{esl_msa} } @msaA ]);
+  my $new_msa = Bio::Easel::MSA->new({
+    esl_msa => $new_esl_msa,
+  });
+
+  return $new_msa;
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 collapse_identical_sequences
+
+  Title     : collapse_identical_sequences
+  Incept    : Sun Oct 18 16:06:12 2026
+  Usage     : ($newmsaObject, $countAR, $wgtAR, $groupAR) = $msaObject->collapse_identical_sequences($optHR)
+  Function  : Create a new MSA with one sequence from each group of
+            : identical aligned sequences in the MSA, the first one
+            : of each group, in their original order. Sequences are
+            : compared column for column, so two sequences are only
+            : identical if they are aligned the same way, and
+            : downstream per-pair computations on the new MSA give
+            : the same results as on the original one if each
+            : sequence is counted $countAR->[$i] times.
+            : In digital mode case never matters, and '-' and '.'
+            : are always the same gap.
+            : All gap columns will not be removed from the MSA,
+            : as with sequence_subset().
+  Args      : $optHR: optional: hash ref of options:
+            :   gaps_equal:  '1' to treat all gap and missing data
+            :                characters ('-', '.', '_', '~') as the same
+            :   case_equal:  '1' to treat upper and lower case as the
+            :                same (text mode only)
+            :   sum_weights: '1' to also return the summed weights of
+            :                each group, in $wgtAR (1.0 per sequence if
+            :                the MSA has no weights)
+  Returns   : $new_msa: a new Bio::Easel::MSA object, with 
+            :           one sequence of each group in $self.
+            : $countAR: [0..$i..$new_msa->nseq-1]: number of sequences
+            :           in the group of sequence $i of $new_msa
+            : $wgtAR:   [0..$i..$new_msa->nseq-1]: summed weight of the
+            :           group of sequence $i of $new_msa, undef unless
+            :           sum_weights was set
+            : $groupAR: [0..$j..$self->nseq-1]: index in $new_msa of the
+            :           sequence that represents sequence $j of $self
+  Dies      : if an option is not one of those above
+=cut
+
+sub collapse_identical_sequences
+{
+  my ($self, $optHR) = @_;
+
+  $self->_check_msa();
+  my %optH = ( defined $optHR ) ? ( %{$optHR} ) : ();
+  foreach my $key (keys %optH) { 
+    if($key ne "gaps_equal" && $key ne "case_equal" && $key ne "sum_weights") { 
+      croak "collapse_identical_sequences() unknown option $key";
+    }
+  }
+
+  my @repA = _c_identical_sequence_groups($self->{esl_msa}, 
+                                          ($optH{gaps_equal} ? 1 : 0), 
+                                          ($optH{case_equal} ? 1 : 0));
+  my $nseq = scalar(@repA);
+  my $has_wgts = ( $optH{sum_weights} && $self->has_sqwgts() ) ? 1 : 0;
+
+  my @usemeA  = ();
+  my @countA  = ();
+  my @wgtA    = ();
+  my @groupA  = ();
+  my $nnew    = 0;
+  for(my $i = 0; $i < $nseq; $i++) { 
+    if($repA[$i] == $i) { 
+      $usemeA[$i] = 1;
+      $groupA[$i] = $nnew++;
+      $countA[$groupA[$i]] = 0;
+      $wgtA[$groupA[$i]]   = 0.;
+    }
+    else { 
+      $usemeA[$i] = 0;
+      $groupA[$i] = $groupA[$repA[$i]];
+    }
+    $countA[$groupA[$i]]++;
+    if($optH{sum_weights}) { 
+      $wgtA[$groupA[$i]] += ($has_wgts) ? _c_get_sqwgt($self->{esl_msa}, $i) : 1.;
+    }
+  }
+
+  my $new_msa = $self->sequence_subset(\@usemeA);
+
+  return ($new_msa, \@countA, ( $optH{sum_weights} ? \@wgtA : undef ), \@groupA);
+}
+
 #-------------------------------------------------------------------------------
 
 =head2 sequence_subset_given_names
@@ -2673,6 +3274,7 @@ sub sequence_subset_given_names
   my $new_msa = Bio::Easel::MSA->new({
     esl_msa => $new_esl_msa,
   });
+  $self->_subset_row_hashes($new_msa, \@usemeA);
 
   return $new_msa;
 }
@@ -2727,8 +3329,9 @@ sub column_subset
 {
   my ($self, $usemeAR) = @_;
 
-  $self->_check_msa();
+  $self->_check_writable();
   _c_column_subset($self->{esl_msa}, $usemeAR);
+  $self->_invalidate_row_hashes();
 
   return;
 }
@@ -2784,7 +3387,7 @@ sub column_subset_rename_nse
   my ($self, $usemeAR, $do_update) = @_;
   my $sub_name = "column_subset_rename_nse";
 
-  $self->_check_msa();
+  $self->_check_writable();
   if(! defined $do_update) { 
     $do_update = 0; 
   }
@@ -2841,6 +3444,7 @@ sub column_subset_rename_nse
   }
 
   _c_column_subset($self->{esl_msa}, $usemeAR);
+  $self->_invalidate_row_hashes();
 
   return;
 }
@@ -2865,9 +3469,10 @@ sub remove_all_gap_columns
 {
   my ($self, $consider_rf) = @_;
 
-  $self->_check_msa();
+  $self->_check_writable();
 
   _c_remove_all_gap_columns($self->{esl_msa}, $consider_rf);
+  $self->_invalidate_row_hashes();
 
   return;
 }
@@ -2891,7 +3496,7 @@ sub remove_rf_gap_columns
 {
   my ($self, $gapstr) = @_;
 
-  $self->_check_msa();
+  $self->_check_writable();
   if(! defined $gapstr) { $gapstr = ".-~"; }
   
   if(! $self->has_rf) { croak "Trying to remove RF gap columns, but no RF annotation exists in the MSA"; }
@@ -2906,6 +3511,7 @@ sub remove_rf_gap_columns
   }      
   
   _c_column_subset($self->{esl_msa}, \@usemeA);
+  $self->_invalidate_row_hashes();
   
   return;
 }
@@ -3192,7 +3798,10 @@ sub capitalize_based_on_rf
 {
   my ($self) = @_;
 
+  $self->_check_writable();
+
   _c_capitalize_based_on_rf($self->{esl_msa});
+  $self->_invalidate_row_hashes();
 
   return;
 }
@@ -3250,6 +3859,274 @@ sub most_informative_sequence
 
 #-------------------------------------------------------------------------------
 
+=head2 consensus_sequence
+
+  Title     : consensus_sequence
+  Incept    : Sun Oct 18 18:40:26 2026
+  Usage     : $msaObject->consensus_sequence($mode, $threshold, $use_weights)
+  Function  : Calculate a consensus sequence of a digital MSA, one of:
+            :   "plurality": the most frequent residue in each column,
+            :                or a gap if gaps are the most frequent.
+            :   "majority":  the residue or gap with a frequency of 
+            :                more than $threshold (default 0.5), else
+            :                'N' (or 'X' for protein).
+            :   "iupac":     a gap if more than half the column is gaps, 
+            :                else the IUPAC degenerate residue for the
+            :                fewest residues, most frequent first, that 
+            :                make up at least $threshold (default 0.9)
+            :                of the residues, e.g. 'R' for A and G.
+            :   "gap":       a gap if less than $threshold (default 0.5) 
+            :                of the column is residues, else the most
+            :                frequent residue.
+            : The residue counts of each column (the profile) are 
+            : computed once and kept, so further consensus sequences
+            : of the same MSA only take one pass over the profile.
+  Args      : $mode:        "plurality" (default), "majority", "iupac" or "gap"
+            : $threshold:   see above, from 0 to 1, unused for "plurality"
+            : $use_weights: '1' to use weights in the MSA, '0' not to (default)
+  Returns   : a string of length alen, the consensus sequence, in upper case 
+            : with '-' for gaps
+  Dies      : if the MSA isn't digital, $mode is invalid, $threshold is not
+            : from 0 to 1, or $use_weights is '1' and the MSA has no weights
+=cut
+
+sub consensus_sequence
+{
+  my ($self, $mode, $threshold, $use_weights) = @_;
+
+  my %def_thresholdH = ( "plurality" => 0., "majority" => 0.5, "iupac" => 0.9, "gap" => 0.5 );
+
+  $self->_check_msa();
+  if(! defined $mode) { $mode = "plurality"; }
+  if(! exists $def_thresholdH{$mode}) { 
+    croak "ERROR, consensus_sequence() invalid mode $mode, valid modes are \"plurality\", \"majority\", \"iupac\" and \"gap\"";
+  }
+  if(! defined $threshold) { $threshold = $def_thresholdH{$mode}; }
+  if($threshold < 0. || $threshold > 1.) { croak "ERROR, consensus_sequence() threshold must be from 0 to 1, not $threshold"; }
+
+  return _c_consensus_from_profile($self->{esl_msa}, $self->_column_profile($use_weights), $mode, $threshold);
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 build_pssm
+
+  Title     : build_pssm
+  Incept    : Sun Oct 18 19:16:52 2026
+  Usage     : $pssmHR = $msaObject->build_pssm($bg, $pseudocount, $use_weights)
+  Function  : Build a position-specific scoring matrix (PSSM) from a
+            : digital MSA, one position per alignment column, from
+            : the same column profile as consensus_sequence(). The 
+            : score of residue a at a position is log2(p/bg(a)) bits,
+            : where p is the frequency of a among the residues of the
+            : column, after adding $pseudocount residues distributed
+            : as the background. Gaps are ignored. To build a PSSM of 
+            : nongap RF positions only, remove all gap RF columns with 
+            : remove_rf_gap_columns() first.
+            : The PSSM can be used to score sequences with 
+            : Bio::Easel::SqFile::score_pssm().
+  Args      : $bg:          background residue frequencies, either a hash
+            :               ref, key: residue, or an array ref in the order
+            :               of the alphabet's residues (see 'residues' in
+            :               Returns); they are normalized. Default: uniform.
+            : $pseudocount: pseudocount per column, > 0, default 1
+            : $use_weights: '1' to use weights in the MSA, '0' not to (default)
+  Returns   : hash ref with keys:
+            :   alphabet: "RNA", "DNA" or "amino"
+            :   residues: the alphabet's residues, e.g. "ACGU"
+            :   width:    number of positions, alen
+            :   bg:       [0..a..K-1] normalized background frequencies
+            :   scores:   [0..apos..alen-1][0..a..K-1] score of residue a
+            :             at position apos, in bits
+  Dies      : if the MSA isn't digital, $bg is invalid, $pseudocount is not
+            : positive or $use_weights is '1' and the MSA has no weights
+=cut
+
+sub build_pssm
+{
+  my ($self, $bg, $pseudocount, $use_weights) = @_;
+
+  $self->_check_msa();
+  my ($alphabet, $residues) = _c_get_alphabet($self->{esl_msa});
+  my @resA = split("", $residues);
+  my $K    = scalar(@resA);
+
+  my @bgA = ();
+  if(! defined $bg) { 
+    @bgA = (1. / $K) x $K;
+  }
+  elsif(ref($bg) eq "HASH") { 
+    foreach my $res (@resA) { 
+      my $freq = (exists $bg->{$res}) ? $bg->{$res} : $bg->{lc($res)};
+      if(! defined $freq) { croak "ERROR, build_pssm() no background frequency for residue $res"; }
+      push(@bgA, $freq);
+    }
+  }
+  elsif(ref($bg) eq "ARRAY") { 
+    if(scalar(@{$bg}) != $K) { croak "ERROR, build_pssm() background has " . scalar(@{$bg}) . " frequencies, alphabet has $K residues"; }
+    @bgA = @{$bg};
+  }
+  else { 
+    croak "ERROR, build_pssm() background must be a hash or array ref";
+  }
+  my $bgsum = 0.;
+  foreach my $freq (@bgA) { 
+    if($freq <= 0.) { croak "ERROR, build_pssm() background frequencies must be positive"; }
+    $bgsum += $freq;
+  }
+  @bgA = map { $_ / $bgsum } @bgA;
+
+  if(! defined $pseudocount) { $pseudocount = 1.; }
+  if($pseudocount <= 0.) { croak "ERROR, build_pssm() pseudocount must be positive, not $pseudocount"; }
+
+  my @scoreA = _c_build_pssm($self->{esl_msa}, $self->_column_profile($use_weights), \@bgA, $pseudocount);
+  my @matrixA = ();
+  while(@scoreA) { push(@matrixA, [ splice(@scoreA, 0, $K) ]); }
+
+  return { alphabet => $alphabet, residues => $residues, width => scalar(@matrixA), bg => \@bgA, scores => \@matrixA };
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 window_stats
+
+  Title     : window_stats
+  Incept    : Sun Oct 18 20:30:44 2026
+  Usage     : @winA = $msaObject->window_stats($window, $step, $use_weights)
+  Function  : Calculate statistics of windows of $window columns, 
+            : starting every $step columns, along a digital MSA:
+            :   entropy:      average entropy of the columns, as in pos_entropy()
+            :   conservation: average sequence conservation of the columns,
+            :                 as in pos_conservation()
+            :   gc:           fraction of the residues that are G or C, 
+            :                 undef unless the MSA is RNA or DNA
+            :   gap:          fraction of gaps
+            : Windows start at the first column; the last window is the
+            : first one to reach the last column, so it may be shorter. 
+            : The statistics are computed from the column profile kept
+            : for consensus_sequence(), in time proportional to alen 
+            : whatever the window size and step.
+  Args      : $window:      window size, in columns, default 100
+            : $step:        columns between window starts, default $window
+            : $use_weights: '1' to use weights in the MSA, '0' not to (default)
+  Returns   : array of hash refs, one per window, with keys 'start' 
+            : and 'end' (1..alen) and the statistics above
+  Dies      : if the MSA isn't digital, $window or $step is not a positive
+            : integer, or $use_weights is '1' and the MSA has no weights
+=cut
+
+sub window_stats
+{
+  my ($self, $window, $step, $use_weights) = @_;
+
+  $self->_check_msa();
+  if(! defined $window) { $window = 100; }
+  if(! defined $step)   { $step   = $window; }
+  if($window !~ m/^\d+$/ || $window == 0) { croak "ERROR, window_stats() window must be a positive integer, not $window"; }
+  if($step   !~ m/^\d+$/ || $step   == 0) { croak "ERROR, window_stats() step must be a positive integer, not $step"; }
+
+  my @retA = _c_window_stats($self->{esl_msa}, $self->_column_profile($use_weights), $window, $step);
+  my @winA = ();
+  while(@retA) { 
+    my ($start, $end, $ent, $cons, $gc, $gap) = splice(@retA, 0, 6);
+    push(@winA, { start => $start, end => $end, entropy => $ent, conservation => $cons, gc => $gc, gap => $gap });
+  }
+
+  return @winA;
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 comp_and_len_stats
+
+  Title     : comp_and_len_stats
+  Incept    : Sun Oct 18 21:02:37 2026
+  Usage     : $statsHR = $msaObject->comp_and_len_stats()
+  Function  : Calculate the residue composition, GC fraction and 
+            : unaligned length of each sequence of a digital MSA, 
+            : the per-sequence statistics rfam_qc_stats() writes to
+            : its composition file, without writing any file.
+            : Composition is the frequency of each residue among the
+            : residues of a sequence, degenerate residues split over
+            : the residues they stand for; a sequence with no residues
+            : has all frequencies 0. Sequences are counted in parallel
+            : for large alignments. The arrays are returned packed, 
+            : to keep them small for alignments of many sequences:
+            :   @compA = unpack("d*", $statsHR->{composition});
+            :   # frequency of residue a of sequence i: $compA[$i * $K + $a]
+            :   @gcA   = unpack("d*", $statsHR->{gc});
+            :   @lenA  = unpack("i*", $statsHR->{length});
+  Args      : none
+  Returns   : hash ref with keys:
+            :   residues:    string of the K residues of the alphabet, in 
+            :                the order of the composition of each sequence
+            :   composition: nseq * K packed doubles, sequence by sequence
+            :   gc:          nseq packed doubles, fraction of each sequence's 
+            :                residues that are G or C, undef unless the
+            :                MSA is RNA or DNA
+            :   length:      nseq packed ints, unaligned sequence lengths
+  Dies      : if the MSA isn't digital
+=cut
+
+sub comp_and_len_stats
+{
+  my ($self) = @_;
+
+  $self->_check_msa();
+  if(! $self->is_digitized) { croak "ERROR, comp_and_len_stats() requires a digital MSA"; }
+
+  my ($alphabet, $residues) = _c_get_alphabet($self->{esl_msa});
+  my ($comp, $gc, $len) = _c_comp_and_len_stats($self->{esl_msa});
+
+  return { residues => $residues, composition => $comp, gc => $gc, length => $len };
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 map_columns_to
+
+  Title     : map_columns_to
+  Incept    : Sun Oct 18 23:52:08 2026
+  Usage     : ($mapAR, $agreeAR, $nused) = $msaObject->map_columns_to($other_msa)
+  Function  : Map each column of this MSA to a column of another 
+            : alignment of (some of) the same sequences, such as a
+            : later release of the same family, to track how columns
+            : move. Sequences are matched by name; those with the 
+            : same number of residues in both are used, the r'th
+            : residue of one being the r'th of the other. Each
+            : column is mapped to the column of $other_msa most of
+            : its residues are in. Each pair of sequences is walked
+            : once, in C, in parallel over sequences for large
+            : alignments. Either MSA may be digital or text.
+  Args      : $other_msa: the Bio::Easel::MSA to map columns to
+  Returns   : $mapAR:   [0..apos..alen-1]: column (1..$other_msa->alen) 
+            :           column apos+1 maps to, 0 if it has no residues
+            :           in the sequences used
+            : $agreeAR: [0..apos..alen-1]: fraction of the residues of
+            :           column apos+1 that are in that column, 0. if 
+            :           it has none
+            : $nused:   number of sequences used
+  Dies      : if $other_msa is not a Bio::Easel::MSA, or has duplicated
+            : sequence names
+=cut
+
+sub map_columns_to
+{
+  my ($self, $other) = @_;
+
+  $self->_check_msa();
+  my ($other_msa) = $self->_check_msa_list("map_columns_to", [ $other ]);
+
+  my ($nused, @retA) = _c_map_columns_to($self->{esl_msa}, $other_msa->{esl_msa});
+  my $alen = scalar(@retA) / 2;
+  my @mapA   = @retA[0..$alen-1];
+  my @agreeA = @retA[$alen..2*$alen-1];
+
+  return (\@mapA, \@agreeA, $nused);
+}
+
+#-------------------------------------------------------------------------------
+
 =head2 pos_fcbp
 
   Title     : pos_fcbp
@@ -3281,13 +4158,21 @@ sub pos_fcbp
   Args      : none
   Returns   : array of length msa->alen: the covariation statistic
             : at each position, 0. for non-paired positions.
+            : The result is cached, see Bio::Easel->set_cache_dir().
 =cut
 
 sub pos_covariation
 {
   my ($self) = @_;
 
+  my $key = ( defined Bio::Easel->get_cache_dir() ) ? $self->_cache_key("pos_covariation", 1) : undef;
+  my $cachedAR = ( defined $key ) ? Bio::Easel::_cache_fetch($key) : undef;
+  if ( defined $cachedAR ) { 
+    return @{$cachedAR};
+  }
+
   my @retA = _c_pos_covariation($self->{esl_msa});
+  if ( defined $key ) { Bio::Easel::_cache_store($key, \@retA); }
   return @retA;
 }
 
@@ -3361,6 +4246,8 @@ sub remove_gap_rf_basepairs
 {
   my ($self, $do_wussify) = @_;
 
+  $self->_check_writable();
+
   _c_remove_gap_rf_basepairs($self->{esl_msa}, $do_wussify);
 
   return;
@@ -3612,10 +4499,141 @@ sub get_ppstr_avg {
 sub DESTROY {
   my ($self) = @_;
 
+  delete $live_objects{ refaddr($self) };
   _c_destroy( $self->{esl_msa} );
   return;
 }
 
+#-------------------------------------------------------------------------------
+
+=head2 CLONE
+
+  Title    : CLONE
+  Incept   : Sun Oct 18 13:20:38 2026
+  Usage    : called by perl in a new thread (ithreads), never directly
+  Function : Each object in the new thread is a copy of the object
+           : in the parent thread, including the pointer to its
+           : ESL_MSA. Depending on the object's clone mode (see
+           : set_clone_mode()) either:
+           :   "copy":  give the new object its own copy of the ESL_MSA
+           :            (the default, see $Bio::Easel::MSA::CLONE_MODE)
+           :   "share": let both objects use the same ESL_MSA; it is
+           :            freed when the last object using it is destroyed.
+           :            This saves copying large alignments. Methods that
+           :            modify the alignment (set_*(), add*(), weight_GSC(),
+           :            reorder_*(), column_subset(), etc.) first give
+           :            their object its own copy (see unshare()), so the
+           :            other thread's object is unaffected. Its name index
+           :            is built before it is shared; an alignment with
+           :            duplicate names is copied.
+  Args     : none (the package name)
+  Returns  : void
+
+=cut
+
+sub CLONE {
+  my @objA = grep { defined $_ } values %live_objects;
+
+  # addresses are different in the new interpreter
+  %live_objects = ();
+  foreach my $obj (@objA) {
+    $live_objects{ refaddr($obj) } = $obj;
+    weaken( $live_objects{ refaddr($obj) } );
+
+    if ( defined $obj->{esl_msa} ) {
+      my $mode = ( defined $obj->{clone_mode} ) ? $obj->{clone_mode} : $CLONE_MODE;
+      # the index is built lazily, which would write to the shared
+      # ESL_MSA, so build it now; an alignment that can't have one
+      # (duplicate names) is copied instead
+      if ( $mode eq "share" && eval { _c_check_index( $obj->{esl_msa} ); 1; } ) {
+        _c_share_msa( $obj->{esl_msa} );
+      }
+      else {
+        $obj->{esl_msa} = _c_clone_msa( $obj->{esl_msa} );
+      }
+    }
+  }
+
+  return;
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 set_clone_mode
+
+  Title    : set_clone_mode
+  Incept   : Sun Oct 18 13:24:55 2026
+  Usage    : $msaObject->set_clone_mode($mode)
+  Function : Set what happens to this object's alignment when
+           : a new thread is started, see CLONE(): "copy" or
+           : "share", or undef to use $Bio::Easel::MSA::CLONE_MODE.
+  Args     : $mode: "copy", "share" or undef
+  Returns  : void
+  Dies     : if $mode is not "copy", "share" or undef
+
+=cut
+
+sub set_clone_mode {
+  my ( $self, $mode ) = @_;
+
+  if ( defined $mode && $mode ne "copy" && $mode ne "share" ) {
+    croak "set_clone_mode() mode must be \"copy\" or \"share\", not $mode";
+  }
+  $self->{clone_mode} = $mode;
+
+  return;
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 is_shared
+
+  Title    : is_shared
+  Incept   : Sun Oct 18 13:27:16 2026
+  Usage    : $msaObject->is_shared()
+  Function : Return '1' if this object's alignment is shared with
+           : an object in another thread, see CLONE().
+  Args     : none
+  Returns  : '1' if alignment is shared, '0' if not
+
+=cut
+
+sub is_shared {
+  my ($self) = @_;
+
+  $self->_check_msa();
+  return ( _c_msa_nref( $self->{esl_msa} ) > 1 ) ? 1 : 0;
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 unshare
+
+  Title    : unshare
+  Incept   : Sun Oct 18 13:29:41 2026
+  Usage    : $msaObject->unshare()
+  Function : If this object's alignment is shared with an object
+           : in another thread (see CLONE()), give this object its
+           : own copy of it, which it can then modify. Call this
+           : before modifying an alignment that may be shared.
+  Args     : none
+  Returns  : void
+
+=cut
+
+sub unshare {
+  my ($self) = @_;
+
+  $self->_check_msa();
+  if ( _c_msa_nref( $self->{esl_msa} ) > 1 ) {
+    my $shared_msa = $self->{esl_msa};
+    $self->{esl_msa} = _c_clone_msa($shared_msa);
+    _c_free_msa($shared_msa); # only gives up our ownership, it's still in use
+  }
+
+  return;
+}
+
 
 #############################
 # Internal helper subroutines
@@ -3645,6 +4663,31 @@ sub _check_msa {
 
 #-------------------------------------------------------------------------------
 
+=head2 _check_writable
+
+  Title    : _check_writable
+  Incept   : Mon Oct 19 04:40:18 2026
+  Usage    : $msaObject->_check_writable()
+  Function : For methods that modify the alignment or its index:
+           : read the alignment if necessary (see _check_msa()) and,
+           : if it is shared with an object in another thread (see
+           : CLONE()), give this object its own copy to modify.
+  Args     : none
+  Returns  : void
+
+=cut
+
+sub _check_writable {
+  my ($self) = @_;
+
+  $self->_check_msa();
+  $self->unshare();
+
+  return;
+}
+
+#-------------------------------------------------------------------------------
+
 =head2 _check_sqidx
 
   Title    : _check_sqidx
@@ -3854,6 +4897,184 @@ sub _check_index {
 
 #-------------------------------------------------------------------------------
 
+=head2 _check_msa_list
+
+  Title    : _check_msa_list
+  Incept   : Sun Oct 18 22:58:20 2026
+  Usage    : @msaA = $msaObject->_check_msa_list($caller, $msaAR)
+  Function : Check that $msaAR is a ref to an array of 
+           : Bio::Easel::MSA objects with alignments, for 
+           : concatenate(), merge_rows() and map_columns_to().
+  Args     : $caller: name of the calling method, for errors
+           : $msaAR:  the array ref
+  Returns  : the array
+  Dies     : if $msaAR is not an array ref of Bio::Easel::MSA objects
+
+=cut
+
+sub _check_msa_list { 
+  my ($self, $caller, $msaAR) = @_;
+
+  if(ref($msaAR) ne "ARRAY") { croak "ERROR, $caller() requires an array ref of Bio::Easel::MSA objects"; }
+  foreach my $msa (@{$msaAR}) { 
+    if(! (Scalar::Util::blessed($msa) && $msa->isa("Bio::Easel::MSA"))) { 
+      croak "ERROR, $caller() requires an array ref of Bio::Easel::MSA objects";
+    }
+    $msa->_check_msa();
+  }
+
+  return @{$msaAR};
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 _invalidate_row_hashes
+
+  Title    : _invalidate_row_hashes
+  Incept   : Sun Oct 18 17:21:26 2026
+  Usage    : $msaObject->_invalidate_row_hashes()
+  Function : Forget the per-sequence hashes and checksum of
+           : row_checksum(), and the column profiles of 
+           : consensus_sequence(), after a change to all sequences.
+  Args     : none
+  Returns  : void
+
+=cut
+
+sub _invalidate_row_hashes { 
+  my ( $self ) = @_;
+
+  delete $self->{row_hashes};
+  delete $self->{row_checksum};
+  delete $self->{col_profile};
+
+  return;
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 _update_row_hashes
+
+  Title    : _update_row_hashes
+  Incept   : Sun Oct 18 17:23:50 2026
+  Usage    : $msaObject->_update_row_hashes($idx)
+  Function : Rehash sequence $idx for row_checksum(), after it
+           : has changed (nothing to do if there are no hashes yet),
+           : and forget the column profiles of consensus_sequence().
+  Args     : $idx: index of the changed sequence
+  Returns  : void
+
+=cut
+
+sub _update_row_hashes { 
+  my ( $self, $idx ) = @_;
+
+  if(defined $self->{row_hashes}) { 
+    substr($self->{row_hashes}, 8 * $idx, 8) = _c_row_hashes($self->{esl_msa}, $idx, 1);
+    delete $self->{row_checksum};
+  }
+  delete $self->{col_profile};
+
+  return;
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 _subset_row_hashes
+
+  Title    : _subset_row_hashes
+  Incept   : Sun Oct 18 17:26:05 2026
+  Usage    : $msaObject->_subset_row_hashes($new_msa, $usemeAR)
+  Function : Give $new_msa, a sequence subset of $msaObject, 
+           : the hashes of the sequences it kept, so 
+           : row_checksum() needn't rehash them.
+  Args     : $new_msa: the subset Bio::Easel::MSA object
+           : $usemeAR: [0..i..nseq-1] TRUE if seq i was kept
+  Returns  : void
+
+=cut
+
+sub _subset_row_hashes { 
+  my ( $self, $new_msa, $usemeAR ) = @_;
+
+  if(defined $self->{row_hashes}) { 
+    my @hashA = unpack("(a8)*", $self->{row_hashes});
+    $new_msa->{row_hashes} = pack("(a8)*", map { $hashA[$_] } grep { $usemeAR->[$_] } (0..$#hashA));
+  }
+
+  return;
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 _column_profile
+
+  Title    : _column_profile
+  Incept   : Sun Oct 18 19:20:35 2026
+  Usage    : $profile = $msaObject->_column_profile($use_weights)
+  Function : Return the residue counts of each column, see
+           : _c_column_profile(), computed once and kept until the
+           : sequences or weights change.
+  Args     : $use_weights: '1' to count with the MSA's weights, '0' not to
+  Returns  : the profile, packed doubles
+  Dies     : if the MSA isn't digital, or $use_weights is '1' and
+           : the MSA has no weights
+
+=cut
+
+sub _column_profile { 
+  my ( $self, $use_weights ) = @_;
+
+  $use_weights = ($use_weights) ? 1 : 0;
+  if(! defined $self->{col_profile}[$use_weights]) { 
+    $self->{col_profile}[$use_weights] = _c_column_profile($self->{esl_msa}, $use_weights);
+  }
+
+  return $self->{col_profile}[$use_weights];
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 _cache_key
+
+  Title    : _cache_key
+  Incept   : Sun Oct 18 17:52:33 2026
+  Usage    : $key = $msaObject->_cache_key($operation, $use_weights, @params)
+  Function : Return the key a result of $operation is cached under,
+           : see Bio::Easel->set_cache_dir(): an MD5 digest of the
+           : operation, its parameters, and everything about the 
+           : MSA a result could depend on: the aligned sequences
+           : (see row_checksum()), text or digital mode, the names,
+           : the MSA name, SS_cons and RF and, if $use_weights, the
+           : sequence weights.
+  Args     : $operation:   name of the operation
+           : $use_weights: '1' if the result depends on the weights
+           : @params:      the operation's parameters
+  Returns  : the key, 32 hexadecimal digits
+
+=cut
+
+sub _cache_key { 
+  my ( $self, $operation, $use_weights, @params ) = @_;
+
+  $self->_check_msa();
+  my $nseq = $self->nseq;
+  my $md5  = Digest::MD5->new();
+  $md5->add(join("\t", $operation, (map { defined $_ ? $_ : "" } @params), 
+                 $self->is_digitized, $nseq, $self->alen, $self->row_checksum, $self->get_name,
+                 ($self->has_ss_cons ? $self->get_ss_cons : ""), ($self->has_rf ? $self->get_rf : "")), "\n");
+  for(my $i = 0; $i < $nseq; $i++) { 
+    $md5->add(_c_get_sqname($self->{esl_msa}, $i), "\n");
+  }
+  if($use_weights && $self->has_sqwgts) { 
+    $md5->add(pack("d*", map { _c_get_sqwgt($self->{esl_msa}, $_) } (0..$nseq-1)));
+  }
+
+  return $md5->hexdigest;
+}
+
+#-------------------------------------------------------------------------------
+
 =head2 _sqname_nse_breakdown
 
   Title    : _sqname_nse_breakdown
@@ -4016,6 +5237,26 @@ sub _get_nongap_numbering_for_aligned_string {
 =head2 _c_set_sqname
 =head2 _c_any_allgap_columns
 =head2 _c_average_id
+=head2 _c_get_threads
+=head2 _c_share_msa
+=head2 _c_release_msa
+=head2 _c_msa_nref
+=head2 _c_identical_sequence_groups
+=head2 _c_row_hashes
+=head2 _c_combine_row_hashes
+=head2 _c_set_sqwgts
+=head2 _c_column_profile
+=head2 _c_consensus_from_profile
+=head2 _c_get_alphabet
+=head2 _c_build_pssm
+=head2 _c_window_stats
+=head2 _c_comp_and_len_stats
+=head2 _c_rfam_qc_stats_stream
+=head2 _c_concatenate
+=head2 _c_merge_rows
+=head2 _c_add_sequence_aligned
+=head2 _c_map_columns_to
+=head2 _c_reorder_by
 =head2 _c_get_sqlen
 =head2 _c_average_sqlen
 =head2 _c_addGF
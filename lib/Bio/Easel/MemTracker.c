@@ -0,0 +1,133 @@
+#include <stdio.h>
+#include <string.h>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+/* Memory accounting for Bio::Easel::MemTracker.
+ *
+ * Almost all of the memory allocated on behalf of a Bio::Easel object
+ * is allocated inside libeasel (esl_msafile_Read(), esl_msa_Clone(),
+ * esl_msa_SequenceSubset(), ...), not in our own .c files, so a
+ * counting wrapper around our own ESL_ALLOC() calls would miss nearly
+ * everything. Instead we ask the allocator itself how much heap is in
+ * use (mallinfo2()/mallinfo() with glibc) and the kernel for the
+ * resident set size and its high water mark (/proc/self/status).
+ * The high water mark can be reset (Linux >= 4.0) by writing "5" to
+ * /proc/self/clear_refs, which is what lets us measure the peak of a
+ * single call rather than of the whole process.
+ *
+ * There are no allocation counts: the allocator doesn't keep them
+ * (mallinfo() only counts free and mmap'ed chunks), and counting calls
+ * would mean interposing malloc() for the whole process, which glibc
+ * no longer supports short of LD_PRELOAD (the malloc hooks are gone
+ * since 2.34). The number of mmap'ed chunks is the only count we have.
+ *
+ * All values are in bytes, -1 if unavailable on this platform.
+ */
+
+/* Function:  _c_heap_in_use()
+ * Incept:    Sun Oct 18 09:41:12 2026
+ * Synopsis:  Ask the allocator how many bytes are currently allocated.
+ * Args:      ret_inuse:  RETURN: bytes in allocated chunks (incl. mmap'ed chunks)
+ *            ret_mmap:   RETURN: bytes in mmap'ed chunks
+ *            ret_nmmap:  RETURN: number of mmap'ed chunks
+ * Returns:   void
+ */
+
+void _c_heap_in_use(double *ret_inuse, double *ret_mmap, double *ret_nmmap)
+{
+#if defined(__GLIBC__) && ((__GLIBC__ > 2) || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+  struct mallinfo2 mi = mallinfo2();
+  *ret_inuse = (double) mi.uordblks + (double) mi.hblkhd;
+  *ret_mmap  = (double) mi.hblkhd;
+  *ret_nmmap = (double) mi.hblks;
+#elif defined(__GLIBC__)
+  /* mallinfo() fields are ints and wrap above 2Gb, but it's all we have */
+  struct mallinfo mi = mallinfo();
+  *ret_inuse = (double) ((unsigned int) mi.uordblks) + (double) ((unsigned int) mi.hblkhd);
+  *ret_mmap  = (double) ((unsigned int) mi.hblkhd);
+  *ret_nmmap = (double) mi.hblks;
+#else
+  *ret_inuse = -1.;
+  *ret_mmap  = -1.;
+  *ret_nmmap = -1.;
+#endif
+  return;
+}
+
+/* Function:  _c_read_proc_status()
+ * Incept:    Sun Oct 18 09:48:30 2026
+ * Synopsis:  Read current and peak resident set size from /proc/self/status.
+ * Args:      ret_rss:  RETURN: VmRSS in bytes, -1 if unavailable
+ *            ret_hwm:  RETURN: VmHWM in bytes, -1 if unavailable
+ * Returns:   void
+ */
+
+void _c_read_proc_status(double *ret_rss, double *ret_hwm)
+{
+  FILE *fp;
+  char  line[256];
+  long  kb;
+
+  *ret_rss = -1.;
+  *ret_hwm = -1.;
+  if((fp = fopen("/proc/self/status", "r")) == NULL) return;
+  while(fgets(line, sizeof(line), fp) != NULL) {
+    if     (strncmp(line, "VmRSS:", 6) == 0 && sscanf(line+6, "%ld", &kb) == 1) *ret_rss = (double) kb * 1024.;
+    else if(strncmp(line, "VmHWM:", 6) == 0 && sscanf(line+6, "%ld", &kb) == 1) *ret_hwm = (double) kb * 1024.;
+  }
+  fclose(fp);
+  return;
+}
+
+/* Function:  _c_mem_snapshot()
+ * Incept:    Sun Oct 18 09:52:03 2026
+ * Synopsis:  Take a snapshot of heap and resident memory usage.
+ * Returns:   list of 5 values: bytes in use on the heap, bytes in mmap'ed chunks,
+ *            number of mmap'ed chunks, resident set size and its high water mark;
+ *            -1 for any value that can't be determined.
+ */
+
+void _c_mem_snapshot()
+{
+  Inline_Stack_Vars;
+
+  double inuse, mmap, nmmap;
+  double rss, hwm;
+
+  _c_heap_in_use(&inuse, &mmap, &nmmap);
+  _c_read_proc_status(&rss, &hwm);
+
+  Inline_Stack_Reset;
+  Inline_Stack_Push(sv_2mortal(newSVnv(inuse)));
+  Inline_Stack_Push(sv_2mortal(newSVnv(mmap)));
+  Inline_Stack_Push(sv_2mortal(newSVnv(nmmap)));
+  Inline_Stack_Push(sv_2mortal(newSVnv(rss)));
+  Inline_Stack_Push(sv_2mortal(newSVnv(hwm)));
+  Inline_Stack_Done;
+  Inline_Stack_Return(5);
+}
+
+/* Function:  _c_reset_peak()
+ * Incept:    Sun Oct 18 09:55:47 2026
+ * Synopsis:  Reset the resident set size high water mark (VmHWM) to
+ *            the current RSS, so the next _c_mem_snapshot() reports
+ *            the peak since now rather than since process start.
+ *            This is process-wide: VmHWM is reset for every reader,
+ *            not just for us, see $RESET_PEAK in MemTracker.pm.
+ * Returns:   1 if the high water mark was reset, 0 if not (non-Linux,
+ *            kernel < 4.0 or /proc not mounted).
+ */
+
+int _c_reset_peak()
+{
+  FILE *fp;
+  int   ok;
+
+  if((fp = fopen("/proc/self/clear_refs", "w")) == NULL) return 0;
+  ok = (fputs("5", fp) >= 0) ? 1 : 0;
+  if(fclose(fp) != 0) ok = 0;
+
+  return ok;
+}
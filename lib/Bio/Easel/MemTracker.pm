@@ -0,0 +1,531 @@
+package Bio::Easel::MemTracker;
+
+use strict;
+use warnings;
+use File::Spec;
+use Carp;
+
+=head1 NAME
+
+Bio::Easel::MemTracker - scoped heap and peak memory accounting for Bio::Easel calls
+
+=head1 VERSION
+
+Version 0.01
+
+=cut
+
+#-------------------------------------------------------------------------------
+
+our $VERSION = '0.01';
+
+# '0' to never reset the process's resident set size high water mark,
+# see start()
+our $RESET_PEAK = 1;
+
+my $src_file      = undef;
+my $easel_src_dir = undef;
+
+BEGIN {
+  $src_file = __FILE__;
+  $src_file =~ s/\.pm/\.c/;
+
+  $easel_src_dir = File::Spec->catfile( $ENV{BIO_EASEL_SHARE_DIR}, 'src/easel' );
+}
+
+# Load the precompiled XS build of MemTracker.c (see xs/BioEaselXS.pm) if
+# it was installed, else fall back to compiling it with Inline::C,
+# which is also what you get with BIO_EASEL_INLINE=1 (development).
+# An XS build that is installed but fails to load is an error.
+BEGIN {
+  require XSLoader;
+  my $use_inline = $ENV{BIO_EASEL_INLINE};
+  if((! $use_inline) && (! eval { XSLoader::load('Bio::Easel::MemTracker', '0.01'); 1; })) {
+    if($@ !~ m/^Can't locate loadable object for module/) { die $@; }
+    $use_inline = 1;
+  }
+  if($use_inline) {
+    require Inline;
+    Inline->import(
+      C        => "$src_file",
+      VERSION  => '0.01',
+      ENABLE   => 'AUTOWRAP',
+      INC      => "-I$easel_src_dir",
+      LIBS     => "-L$easel_src_dir -leasel",
+      NAME     => 'Bio::Easel::MemTracker');
+  }
+}
+
+# default methods wrapped by instrument() when none are given
+our %DEFAULT_INSTRUMENT = (
+  'Bio::Easel::MSA'    => [ qw(read_msa clone_msa sequence_subset sequence_subset_given_names
+                               column_subset remove_all_gap_columns create_from_string
+                               rfam_qc_stats weight_GSC weight_id_filter filter_msa_subset) ],
+  'Bio::Easel::SqFile' => [ qw(open_sqfile create_ssi_index fetch_seqs_given_names
+                               fetch_consecutive_seqs) ],
+);
+
+my $global_tracker = undef; # tracker used by instrument()
+my @open_records   = ();    # records of all trackers that have been started but not stopped
+my %instrumented   = ();    # key: fully qualified sub name, value: 1 if already wrapped
+
+=head1 SYNOPSIS
+
+Measure how much memory individual Bio::Easel calls use.
+
+    use Bio::Easel::MemTracker;
+
+    my $tracker = Bio::Easel::MemTracker->new();
+    my $msa = $tracker->track("read_msa", sub { Bio::Easel::MSA->new({ fileLocation => $alnfile }) });
+    $tracker->report(\*STDERR);
+
+    # or wrap the expensive methods of Bio::Easel::MSA and Bio::Easel::SqFile,
+    # set BIO_EASEL_MEMTRACK=1 to have each call logged to STDERR as it
+    # starts and finishes (useful to find the culprit after an OOM kill)
+    Bio::Easel::MemTracker->instrument();
+
+=head1 EXPORT
+
+No functions currently exported.
+
+=head1 SUBROUTINES/METHODS
+=cut
+
+#-------------------------------------------------------------------------------
+
+=head2 new
+
+  Title    : new
+  Incept   : Sun Oct 18 10:02:15 2026
+  Usage    : Bio::Easel::MemTracker->new
+  Function : Generates a new Bio::Easel::MemTracker object.
+  Args     : <verbose>: optional: '1' to log each call to <fh> as it starts and stops,
+           :            defaults to value of environment variable BIO_EASEL_MEMTRACK
+           : <fh>:      optional: filehandle for logging, default \*STDERR
+  Returns  : Bio::Easel::MemTracker object
+
+=cut
+
+sub new {
+  my ( $caller, $args ) = @_;
+  my $class = ref($caller) || $caller;
+  my $self = {};
+
+  bless( $self, $caller );
+
+  $self->{verbose} = (defined $args->{verbose}) ? $args->{verbose} : ($ENV{BIO_EASEL_MEMTRACK} ? 1 : 0);
+  $self->{fh}      = (defined $args->{fh})      ? $args->{fh}      : \*STDERR;
+  $self->{records} = [];
+  $self->{stack}   = [];
+
+  return $self;
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 snapshot
+
+  Title    : snapshot
+  Incept   : Sun Oct 18 10:05:40 2026
+  Usage    : Bio::Easel::MemTracker->snapshot()
+  Function : Return current memory usage of this process.
+  Args     : none
+  Returns  : hash ref with keys (all in bytes, -1 if unavailable):
+           : 'heap':       bytes allocated on the heap (all C allocations, libeasel's included)
+           : 'heap_mmap':  bytes of 'heap' in large, individually mmap'ed chunks
+           : 'nmmap':      number of individually mmap'ed chunks (a count, not bytes)
+           : 'rss':        resident set size
+           : 'peak_rss':   resident set size high water mark
+
+=cut
+
+sub snapshot {
+  my ($caller) = @_;
+
+  my ($heap, $heap_mmap, $nmmap, $rss, $peak_rss) = _c_mem_snapshot();
+
+  return { heap      => $heap,
+           heap_mmap => $heap_mmap,
+           nmmap     => $nmmap,
+           rss       => $rss,
+           peak_rss  => $peak_rss };
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 start
+
+  Title    : start
+  Incept   : Sun Oct 18 10:09:12 2026
+  Usage    : $trackerObject->start($label)
+  Function : Start measuring a block of code. Calls to start() and stop()
+           : may be nested (also across trackers); each nested block gets its
+           : own peak without disturbing the peak of the enclosing blocks.
+           : The peak is measured by resetting the resident set size high
+           : water mark through /proc/self/clear_refs (Linux), which is
+           : process-wide: afterwards VmHWM in /proc/self/status, for
+           : anything in the process (or outside it) reading it, is the
+           : peak since the last start(), not since the process started.
+           : Set $Bio::Easel::MemTracker::RESET_PEAK to 0 to leave
+           : it alone; peak_rss is then the peak of the process so far.
+  Args     : $label: name for this block, e.g. 'read_msa'
+  Returns  : void
+
+=cut
+
+sub start {
+  my ( $self, $label ) = @_;
+
+  if(! defined $label) { croak "start() requires a label"; }
+
+  # We're about to reset the high water mark, first fold the
+  # current one into the peak of every enclosing open block.
+  my $before = $self->snapshot();
+  foreach my $rec (@open_records) {
+    if($before->{peak_rss} > $rec->{peak_rss}) { $rec->{peak_rss} = $before->{peak_rss}; }
+  }
+  my $peak_reset = ($RESET_PEAK) ? _c_reset_peak() : 0;
+  my $begin = ($peak_reset) ? $self->snapshot() : $before;
+
+  my $rec = { label          => $label,
+              depth          => scalar(@open_records),
+              peak_reset     => $peak_reset,
+              heap_start     => $begin->{heap},
+              rss_start      => $begin->{rss},
+              peak_rss       => $begin->{peak_rss} };
+  push(@open_records,     $rec);
+  push(@{$self->{stack}}, $rec);
+
+  if($self->{verbose}) {
+    $self->_log(sprintf("# memtrack: %sstart %s heap %s rss %s\n", "  " x $rec->{depth}, $label,
+                        _human_bytes($rec->{heap_start}), _human_bytes($rec->{rss_start})));
+  }
+
+  return;
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 stop
+
+  Title    : stop
+  Incept   : Sun Oct 18 10:14:51 2026
+  Usage    : $trackerObject->stop()
+  Function : Stop measuring the most recently started block and record it.
+  Args     : none
+  Returns  : hash ref describing the block (all sizes in bytes):
+           : 'label':      label passed to start()
+           : 'depth':      nesting depth, 0 for outermost block
+           : 'heap_start': bytes allocated on the heap at start
+           : 'heap_end':   bytes allocated on the heap at stop
+           : 'heap_delta': heap_end - heap_start, memory still held by the
+           :               results of the block (e.g. the new ESL_MSA)
+           : 'rss_start':  resident set size at start
+           : 'rss_end':    resident set size at stop
+           : 'peak_rss':   highest resident set size during the block
+           : 'peak_delta': peak_rss - rss_start, extra memory the block needed
+           : 'peak_reset': '1' if peak_rss is the peak of the block only, '0' if
+           :               the platform can't reset the high water mark, or
+           :               $RESET_PEAK is 0, and it is the peak of the whole
+           :               process so far
+  Dies     : if there is no open block
+
+=cut
+
+sub stop {
+  my ($self) = @_;
+
+  if(scalar(@{$self->{stack}}) == 0) { croak "stop() called without a matching start()"; }
+  my $rec = pop(@{$self->{stack}});
+  @open_records = grep { $_ != $rec } @open_records;
+
+  my $end = $self->snapshot();
+  if($end->{peak_rss} > $rec->{peak_rss}) { $rec->{peak_rss} = $end->{peak_rss}; }
+  $rec->{heap_end}   = $end->{heap};
+  $rec->{rss_end}    = $end->{rss};
+  $rec->{heap_delta} = ($rec->{heap_start} >= 0 && $rec->{heap_end} >= 0) ? $rec->{heap_end} - $rec->{heap_start} : -1;
+  $rec->{peak_delta} = ($rec->{rss_start}  >= 0 && $rec->{peak_rss} >= 0) ? $rec->{peak_rss} - $rec->{rss_start}  : -1;
+
+  push(@{$self->{records}}, $rec);
+
+  if($self->{verbose}) {
+    $self->_log(sprintf("# memtrack: %sstop  %s heap %s peak %s (+%s)\n", "  " x $rec->{depth}, $rec->{label},
+                        _human_bytes($rec->{heap_delta}), _human_bytes($rec->{peak_rss}), _human_bytes($rec->{peak_delta})));
+  }
+
+  return $rec;
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 track
+
+  Title    : track
+  Incept   : Sun Oct 18 10:20:33 2026
+  Usage    : $result = $trackerObject->track($label, sub { ... })
+  Function : Run a code block between start($label) and stop(). The block
+           : is stopped even if the code dies, and the error is rethrown.
+  Args     : $label:   name for this block
+           : $codeR:   code ref to run
+  Returns  : whatever $codeR returns, in the context track() was called in
+
+=cut
+
+sub track {
+  my ( $self, $label, $codeR, @args ) = @_;
+
+  if(ref($codeR) ne "CODE") { croak "track() requires a code ref"; }
+
+  my $wantarray = wantarray;
+  my @retA = ();
+  my $ret  = undef;
+
+  $self->start($label);
+  my $ok = eval {
+    if   ($wantarray)         { @retA = $codeR->(@args); }
+    elsif(defined $wantarray) { $ret  = $codeR->(@args); }
+    else                      { $codeR->(@args); }
+    1;
+  };
+  my $err = $@;
+  $self->stop();
+  if(! $ok) { die $err; }
+
+  return $wantarray ? @retA : $ret;
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 records
+
+  Title    : records
+  Incept   : Sun Oct 18 10:24:02 2026
+  Usage    : $trackerObject->records()
+  Function : Return all blocks recorded so far, in the order they finished.
+  Args     : none
+  Returns  : ref to array of hash refs, see stop() for keys
+
+=cut
+
+sub records {
+  my ($self) = @_;
+
+  return $self->{records};
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 clear
+
+  Title    : clear
+  Incept   : Sun Oct 18 10:24:45 2026
+  Usage    : $trackerObject->clear()
+  Function : Forget all recorded blocks.
+  Args     : none
+  Returns  : void
+
+=cut
+
+sub clear {
+  my ($self) = @_;
+
+  $self->{records} = [];
+
+  return;
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 report
+
+  Title    : report
+  Incept   : Sun Oct 18 10:26:18 2026
+  Usage    : $trackerObject->report($fh)
+  Function : Print a table of recorded blocks, sorted by peak
+           : memory use (largest first).
+  Args     : $fh: filehandle to print to, default \*STDOUT
+  Returns  : void
+
+=cut
+
+sub report {
+  my ( $self, $fh ) = @_;
+
+  if(! defined $fh) { $fh = \*STDOUT; }
+
+  printf $fh ("%-40s  %10s  %10s  %10s\n", "# call", "heap-delta", "peak-rss", "peak-delta");
+  printf $fh ("%-40s  %10s  %10s  %10s\n", "#" . ("-" x 39), ("-" x 10), ("-" x 10), ("-" x 10));
+  foreach my $rec (sort { $b->{peak_delta} <=> $a->{peak_delta} } @{$self->{records}}) {
+    printf $fh ("%-40s  %10s  %10s  %10s%s\n", ("  " x $rec->{depth}) . $rec->{label},
+                _human_bytes($rec->{heap_delta}), _human_bytes($rec->{peak_rss}), _human_bytes($rec->{peak_delta}),
+                ($rec->{peak_reset}) ? "" : "  (process peak)");
+  }
+
+  return;
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 instrument
+
+  Title    : instrument
+  Incept   : Sun Oct 18 10:31:55 2026
+  Usage    : Bio::Easel::MemTracker->instrument()
+           : Bio::Easel::MemTracker->instrument('Bio::Easel::MSA', 'read_msa', 'clone_msa')
+  Function : Wrap methods so that every call to them is recorded by the global
+           : tracker (see global()). Without arguments wraps the expensive
+           : methods of Bio::Easel::MSA and Bio::Easel::SqFile listed in
+           : %Bio::Easel::MemTracker::DEFAULT_INSTRUMENT. Wrapping the same
+           : method twice is a no-op.
+  Args     : $package:  optional: package whose methods to wrap
+           : @methods:  optional: names of methods to wrap
+  Returns  : the global tracker
+  Dies     : if a method to wrap does not exist
+
+=cut
+
+sub instrument {
+  my ( $caller, $package, @methods ) = @_;
+
+  my %toinstrumentH = ();
+  if(defined $package) {
+    if(scalar(@methods) == 0) {
+      if(! exists $DEFAULT_INSTRUMENT{$package}) { croak "instrument() no methods given and no defaults for $package"; }
+      @methods = @{$DEFAULT_INSTRUMENT{$package}};
+    }
+    $toinstrumentH{$package} = \@methods;
+  }
+  else {
+    %toinstrumentH = %DEFAULT_INSTRUMENT;
+  }
+
+  my $tracker = $caller->global();
+  foreach my $pkg (sort keys %toinstrumentH) {
+    eval "require $pkg; 1;" or croak "instrument() unable to load $pkg: $@";
+    foreach my $method (@{$toinstrumentH{$pkg}}) {
+      my $name = $pkg . "::" . $method;
+      if($instrumented{$name}) { next; }
+      no strict 'refs';
+      if(! defined &{$name}) { croak "instrument() no method $name"; }
+      my $origR = \&{$name};
+      no warnings 'redefine';
+      *{$name} = sub { return $tracker->track($name, $origR, @_); };
+      $instrumented{$name} = 1;
+    }
+  }
+
+  return $tracker;
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 global
+
+  Title    : global
+  Incept   : Sun Oct 18 10:36:07 2026
+  Usage    : Bio::Easel::MemTracker->global()
+  Function : Accessor for the tracker used by instrument(), creates it if nec.
+  Args     : none
+  Returns  : Bio::Easel::MemTracker object
+
+=cut
+
+sub global {
+  my ($caller) = @_;
+
+  if(! defined $global_tracker) {
+    $global_tracker = Bio::Easel::MemTracker->new();
+  }
+  return $global_tracker;
+}
+
+#############################
+# Internal helper subroutines
+#############################
+
+#-------------------------------------------------------------------------------
+
+=head2 _log
+
+  Title    : _log
+  Incept   : Sun Oct 18 10:38:21 2026
+  Usage    : $trackerObject->_log($line)
+  Function : Print $line to the log filehandle and flush it immediately,
+           : so the last line survives if the process is killed.
+  Args     : $line: line to print
+  Returns  : void
+
+=cut
+
+sub _log {
+  my ( $self, $line ) = @_;
+
+  my $fh = $self->{fh};
+  my $prev_fh = select($fh);
+  local $| = 1;
+  print $fh $line;
+  select($prev_fh);
+
+  return;
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 _human_bytes
+
+  Title    : _human_bytes
+  Incept   : Sun Oct 18 10:39:50 2026
+  Usage    : _human_bytes($nbytes)
+  Function : Format a number of bytes for printing, e.g. '12.3M'.
+  Args     : $nbytes: number of bytes, negative values are allowed
+  Returns  : string, '-' if $nbytes is undefined or -1 (unavailable)
+
+=cut
+
+sub _human_bytes {
+  my ($nbytes) = @_;
+
+  if((! defined $nbytes) || $nbytes == -1) { return "-"; }
+
+  my $sign = ($nbytes < 0) ? "-" : "";
+  my $abs  = abs($nbytes);
+  foreach my $unit ("", "K", "M", "G") {
+    if($abs < 1024) { return ($unit eq "") ? sprintf("%s%d", $sign, $abs) : sprintf("%s%.1f%s", $sign, $abs, $unit); }
+    $abs /= 1024.;
+  }
+  return sprintf("%s%.1fT", $sign, $abs);
+}
+
+=head1 AUTHORS
+
+Eric Nawrocki, C<< <nawrockie at janelia.hhmi.org> >>
+
+=head1 BUGS
+
+Please report any bugs or feature requests to C<bug-bio-easel at rt.cpan.org>.
+
+=head1 SUPPORT
+
+You can find documentation for this module with the perldoc command.
+
+    perldoc Bio::Easel::MemTracker
+
+=head1 ACKNOWLEDGEMENTS
+
+Sean R. Eddy is the author of the Easel C library of functions for
+biological sequence analysis, upon which this module is based.
+
+=head1 LICENSE AND COPYRIGHT
+
+Copyright 2013 Eric Nawrocki.
+
+This program is free software; you can redistribute it and/or modify it
+under the terms of either: the GNU General Public License as published
+by the Free Software Foundation; or the Artistic License.
+
+See http://dev.perl.org/licenses/ for more information.
+
+
+=cut
+
+1;
@@ -0,0 +1,619 @@
+package Bio::Easel::Parallel;
+
+use strict;
+use warnings;
+use Carp;
+use IO::Handle;
+use IO::Select;
+use POSIX ();
+use Storable qw(nfreeze thaw);
+
+=head1 NAME
+
+Bio::Easel::Parallel - process many alignment or sequence files in forked worker processes
+
+=head1 VERSION
+
+Version 0.01
+
+=cut
+
+#-------------------------------------------------------------------------------
+
+our $VERSION = '0.01';
+
+=head1 SYNOPSIS
+
+Run a function on each of a list of items (typically file names)
+in parallel, in a pool of forked worker processes, and get the
+results back in the order of the items.
+
+    use Bio::Easel::Parallel;
+
+    my $par = Bio::Easel::Parallel->new({ nworkers => 8 });
+
+    # each worker opens its own Bio::Easel::MSA objects
+    my @avgidA = $par->map_msa_files(\@alnfileA, sub {
+      my ($msa, $file) = @_;
+      return $msa->average_id(100);
+    });
+
+    # or anything else, with results handled as they arrive (in order)
+    $par->map(sub { my ($file) = @_; ...; return \%stats; }, \@fileA,
+              { on_result => sub { my ($idx, $file, $stats) = @_; ... } });
+
+Items are handed out to the workers one at a time as they become
+idle, so a few large files don't hold up the rest. Items and results
+are passed through pipes with Storable, so they can be any data
+structure Storable can serialize, but not objects wrapping C memory
+such as Bio::Easel::MSA objects: open and process those in the
+worker, and return the numbers or strings you need.
+
+Since the workers are processes, not threads, this works with any
+perl, threaded or not. By default each worker runs the parallel C
+code in Bio::Easel single threaded (see Bio::Easel->set_threads()),
+so that <nworkers> processes use about <nworkers> CPUs.
+
+=head1 EXPORT
+
+No functions currently exported.
+
+=head1 SUBROUTINES/METHODS
+=cut
+
+#-------------------------------------------------------------------------------
+
+=head2 new
+
+  Title    : new
+  Incept   : Sun Oct 18 12:10:33 2026
+  Usage    : Bio::Easel::Parallel->new
+  Function : Generates a new Bio::Easel::Parallel object.
+  Args     : <nworkers>:           optional: number of worker processes, default
+           :                       Bio::Easel->get_threads(); with 1 items are
+           :                       processed in this process, without forking
+           : <threads_per_worker>: optional: number of threads each worker uses
+           :                       for the parallel C code, default 1
+  Returns  : Bio::Easel::Parallel object
+  Dies     : if <nworkers> or <threads_per_worker> is not a positive integer
+
+=cut
+
+sub new {
+  my ( $caller, $args ) = @_;
+  my $class = ref($caller) || $caller;
+  my $self = {};
+
+  bless( $self, $caller );
+
+  if ( defined $args->{nworkers} ) {
+    if ( $args->{nworkers} !~ m/^\d+$/ || $args->{nworkers} < 1 ) {
+      croak "number of workers must be a positive integer, not $args->{nworkers}";
+    }
+    $self->{nworkers} = $args->{nworkers};
+  }
+  else {
+    require Bio::Easel;
+    $self->{nworkers} = Bio::Easel->get_threads();
+  }
+
+  $self->{threads_per_worker} = ( defined $args->{threads_per_worker} ) ? $args->{threads_per_worker} : 1;
+  if ( $self->{threads_per_worker} !~ m/^\d+$/ || $self->{threads_per_worker} < 1 ) {
+    croak "number of threads per worker must be a positive integer, not $self->{threads_per_worker}";
+  }
+
+  return $self;
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 nworkers
+
+  Title    : nworkers
+  Incept   : Sun Oct 18 12:12:04 2026
+  Usage    : $parObject->nworkers()
+  Function : Return the number of worker processes.
+  Args     : none
+  Returns  : number of worker processes
+
+=cut
+
+sub nworkers {
+  my ($self) = @_;
+
+  return $self->{nworkers};
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 map
+
+  Title    : map
+  Incept   : Sun Oct 18 12:14:51 2026
+  Usage    : @resultA = $parObject->map($codeCR, $itemsAR_or_CR, $optsHR)
+  Function : Call $codeCR->($item) for each item in a worker process,
+           : and return the results (scalars: return a reference for
+           : anything else) in the order of the items.
+           :
+           : Results are collected in order: as soon as the result of
+           : the next item in order is available it is passed to the
+           : <on_result> callback if there is one, or added to the
+           : returned list if not.
+  Args     : $codeCR:        code ref, called with one item, in scalar context
+           : $itemsAR_or_CR: ref to an array of items, or an iterator: a
+           :                 code ref that returns the next item on each call
+           :                 and undef when there are no more
+           : $optsHR:        optional: hash ref of options:
+           :   <on_result>:  code ref, called in this process with
+           :                 ($idx, $item, $result) for each item in order,
+           :                 $idx is the 0-based index of the item
+           :   <on_error>:   'die' (default): if $codeCR dies for any item,
+           :                 stop and die with its error message;
+           :                 'skip': warn, and give undef as that item's
+           :                 result
+  Returns  : list of results, empty if <on_result> was given
+  Dies     : if $codeCR dies for an item and <on_error> is 'die',
+           : if a worker process exits unexpectedly, or
+           : if a result can't be serialized
+
+=cut
+
+sub map {
+  my ( $self, $codeCR, $itemsR, $optsHR ) = @_;
+
+  if ( ref($codeCR) ne "CODE" ) { croak "map() first argument must be a code ref"; }
+  my $next_item = _item_iterator($itemsR);
+  my $on_result = ( defined $optsHR && defined $optsHR->{on_result} ) ? $optsHR->{on_result} : undef;
+  my $on_error  = ( defined $optsHR && defined $optsHR->{on_error} )  ? $optsHR->{on_error}  : "die";
+  if ( $on_error ne "die" && $on_error ne "skip" ) {
+    croak "map() on_error must be 'die' or 'skip', not $on_error";
+  }
+
+  my @resultA = ();
+  my $emit = sub {
+    my ( $idx, $item, $ok, $result ) = @_;
+    if ( !$ok ) {
+      if ( $on_error eq "die" ) { return "item $idx: $result"; }
+      warn "Bio::Easel::Parallel: item $idx failed: $result";
+      $result = undef;
+    }
+    if   ( defined $on_result ) { $on_result->( $idx, $item, $result ); }
+    else                        { push( @resultA, $result ); }
+    return undef;
+  };
+
+  if ( $self->{nworkers} == 1 ) {
+    $self->_map_serial( $codeCR, $next_item, $emit );
+  }
+  else {
+    $self->_map_forked( $codeCR, $next_item, $emit );
+  }
+
+  return @resultA;
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 map_msa_files
+
+  Title    : map_msa_files
+  Incept   : Sun Oct 18 12:20:16 2026
+  Usage    : @resultA = $parObject->map_msa_files($filesAR_or_CR, $codeCR, $optsHR)
+  Function : For each alignment file, open it as a Bio::Easel::MSA
+           : object in a worker process and call $codeCR->($msa, $file).
+           : See map() for how results are returned.
+  Args     : $filesAR_or_CR: ref to an array of alignment files, or an iterator
+           : $codeCR:        code ref, called with the Bio::Easel::MSA object and
+           :                 the file name
+           : $optsHR:        optional: options as for map(), and:
+           :   <open_args>:  hash ref of extra arguments for Bio::Easel::MSA->new(),
+           :                 e.g. { forceText => 1 }
+  Returns  : list of results, empty if <on_result> was given
+  Dies     : as map()
+
+=cut
+
+sub map_msa_files {
+  my ( $self, $filesR, $codeCR, $optsHR ) = @_;
+
+  my %open_args = ( defined $optsHR && defined $optsHR->{open_args} ) ? %{ $optsHR->{open_args} } : ();
+
+  return $self->map(
+    sub {
+      my ($file) = @_;
+      require Bio::Easel::MSA;
+      my $msa = Bio::Easel::MSA->new( { %open_args, fileLocation => $file } );
+      return $codeCR->( $msa, $file );
+    },
+    $filesR, $optsHR );
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 map_sqfiles
+
+  Title    : map_sqfiles
+  Incept   : Sun Oct 18 12:22:47 2026
+  Usage    : @resultA = $parObject->map_sqfiles($filesAR_or_CR, $codeCR, $optsHR)
+  Function : For each sequence file, open it as a Bio::Easel::SqFile
+           : object in a worker process and call $codeCR->($sqfile, $file).
+           : See map() for how results are returned.
+  Args     : $filesAR_or_CR: ref to an array of sequence files, or an iterator
+           : $codeCR:        code ref, called with the Bio::Easel::SqFile object and
+           :                 the file name
+           : $optsHR:        optional: options as for map(), and:
+           :   <open_args>:  hash ref of extra arguments for Bio::Easel::SqFile->new(),
+           :                 e.g. { forceIndex => 1 }
+  Returns  : list of results, empty if <on_result> was given
+  Dies     : as map()
+
+=cut
+
+sub map_sqfiles {
+  my ( $self, $filesR, $codeCR, $optsHR ) = @_;
+
+  my %open_args = ( defined $optsHR && defined $optsHR->{open_args} ) ? %{ $optsHR->{open_args} } : ();
+
+  return $self->map(
+    sub {
+      my ($file) = @_;
+      require Bio::Easel::SqFile;
+      my $sqfile = Bio::Easel::SqFile->new( { %open_args, fileLocation => $file } );
+      my $result = $codeCR->( $sqfile, $file );
+      $sqfile->close_sqfile();
+      return $result;
+    },
+    $filesR, $optsHR );
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 _item_iterator
+
+  Title    : _item_iterator
+  Incept   : Sun Oct 18 12:25:30 2026
+  Usage    : $next_item = _item_iterator($itemsAR_or_CR)
+  Function : Return an iterator over an array ref of items, or the
+           : iterator itself if given one. The iterator returns
+           : (1, $item) for each item and () at the end.
+  Args     : $itemsAR_or_CR: array ref or code ref
+  Returns  : code ref
+  Dies     : if $itemsAR_or_CR is neither
+
+=cut
+
+sub _item_iterator {
+  my ($itemsR) = @_;
+
+  if ( ref($itemsR) eq "ARRAY" ) {
+    my $i = 0;
+    return sub { return ( $i < scalar( @{$itemsR} ) ) ? ( 1, $itemsR->[ $i++ ] ) : (); };
+  }
+  if ( ref($itemsR) eq "CODE" ) {
+    return sub { my $item = $itemsR->(); return ( defined $item ) ? ( 1, $item ) : (); };
+  }
+  croak "items must be an array ref or a code ref";
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 _map_serial
+
+  Title    : _map_serial
+  Incept   : Sun Oct 18 12:27:12 2026
+  Usage    : $self->_map_serial($codeCR, $next_item, $emit)
+  Function : map() with a single worker: process the items in this
+           : process, in order.
+  Args     : $codeCR:    code ref to call for each item
+           : $next_item: iterator from _item_iterator()
+           : $emit:      code ref, called with ($idx, $item, $ok, $result)
+           :             returns an error message to die with, or undef
+  Returns  : void
+  Dies     : with the message returned by $emit
+
+=cut
+
+sub _map_serial {
+  my ( $self, $codeCR, $next_item, $emit ) = @_;
+
+  my $idx = 0;
+  while ( my ( $have, $item ) = $next_item->() ) {
+    my $result = eval { scalar( $codeCR->($item) ) };
+    my $ok     = ( $@ eq "" ) ? 1 : 0;
+    my $errmsg = $emit->( $idx, $item, $ok, $ok ? $result : $@ );
+    if ( defined $errmsg ) { croak $errmsg; }
+    $idx++;
+  }
+
+  return;
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 _map_forked
+
+  Title    : _map_forked
+  Incept   : Sun Oct 18 12:31:48 2026
+  Usage    : $self->_map_forked($codeCR, $next_item, $emit)
+  Function : map() with worker processes.
+           :
+           : Each worker has a task pipe (parent to worker) and a
+           : result pipe (worker to parent). A worker gets a new item
+           : only once it has returned the result of the previous one,
+           : so the parent never blocks writing to a busy worker, and
+           : items are spread over the workers as they become idle.
+           : Results that arrive out of order are kept until all
+           : earlier ones have been passed to $emit.
+  Args     : $codeCR:    code ref to call for each item
+           : $next_item: iterator from _item_iterator()
+           : $emit:      code ref, called with ($idx, $item, $ok, $result)
+           :             returns an error message to die with, or undef
+  Returns  : void
+  Dies     : with the message returned by $emit, if a worker can't
+           : be started or exits unexpectedly
+
+=cut
+
+sub _map_forked {
+  my ( $self, $codeCR, $next_item, $emit ) = @_;
+
+  local $SIG{PIPE} = 'IGNORE';
+
+  my @workerA  = ();  # [0..w..nworkers-1]: hash ref, keys 'pid', 'task_fh', 'result_fh', 'idx' (index of item being processed, undef if idle)
+  my %itemH    = ();  # key: index of item handed out, value: the item
+  my %doneH    = ();  # key: index of item whose result is waiting to be emitted, value: [ $ok, $result ]
+  my $nsent    = 0;   # number of items handed out
+  my $nemitted = 0;   # number of results emitted
+  my $no_more  = 0;   # set to 1 when the iterator is exhausted
+  my $errmsg   = undef;
+  my $select   = IO::Select->new();
+
+  my $shutdown = sub {
+    foreach my $worker (@workerA) {
+      if ( defined $worker->{task_fh} ) { close( $worker->{task_fh} ); $worker->{task_fh} = undef; }
+      if ( defined $worker->{result_fh} ) { close( $worker->{result_fh} ); $worker->{result_fh} = undef; }
+      if ( defined $errmsg && defined $worker->{idx} ) { kill( 'TERM', $worker->{pid} ); }
+      waitpid( $worker->{pid}, 0 );
+    }
+  };
+
+  # hand the next item, if any, to an idle worker
+  my $feed = sub {
+    my ($worker) = @_;
+    if ($no_more) { return; }
+    my ( $have, $item ) = $next_item->();
+    if ( !$have ) { $no_more = 1; return; }
+    $itemH{$nsent}  = $item;
+    $worker->{idx}  = $nsent;
+    _write_frame( $worker->{task_fh}, [ $nsent, $item ] )
+      or die "unable to send item $nsent to worker process $worker->{pid}: $!";
+    $nsent++;
+  };
+
+  for ( my $w = 0; $w < $self->{nworkers}; $w++ ) {
+    my $worker = $self->_start_worker( $codeCR, \@workerA );
+    push( @workerA, $worker );
+    $select->add( $worker->{result_fh} );
+  }
+
+  eval {
+    foreach my $worker (@workerA) { $feed->($worker); }
+
+    while ( $nemitted < $nsent && !defined $errmsg ) {
+      my @readyA = $select->can_read();
+      foreach my $fh (@readyA) {
+        my ($worker) = grep { defined $_->{result_fh} && $_->{result_fh} == $fh } @workerA;
+        my $frame = _read_frame($fh);
+        if ( !defined $frame ) {
+          my $what = ( defined $worker->{idx} ) ? "while processing item $worker->{idx}" : "";
+          die "worker process $worker->{pid} exited unexpectedly $what\n";
+        }
+        my ( $idx, $ok, $result ) = @{$frame};
+        $doneH{$idx}   = [ $ok, $result ];
+        $worker->{idx} = undef;
+        $feed->($worker);
+      }
+      # emit everything that is now in order
+      while ( exists $doneH{$nemitted} && !defined $errmsg ) {
+        my ( $ok, $result ) = @{ delete $doneH{$nemitted} };
+        $errmsg = $emit->( $nemitted, delete $itemH{$nemitted}, $ok, $result );
+        $nemitted++;
+      }
+    }
+  };
+  if ( $@ ne "" && !defined $errmsg ) { $errmsg = $@; chomp $errmsg; }
+  $shutdown->();
+
+  if ( defined $errmsg ) { croak $errmsg; }
+  return;
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 _start_worker
+
+  Title    : _start_worker
+  Incept   : Sun Oct 18 12:40:05 2026
+  Usage    : $worker = $self->_start_worker($codeCR, $workerAR)
+  Function : Fork a worker process: it reads [ $idx, $item ] frames
+           : from its task pipe, calls $codeCR->($item) and writes
+           : [ $idx, $ok, $result_or_error ] frames to its result pipe,
+           : until the task pipe is closed.
+  Args     : $codeCR:   code ref to call for each item
+           : $workerAR: workers started so far, whose pipe ends the
+           :            new worker must close
+  Returns  : hash ref with keys 'pid', 'task_fh' and 'result_fh'
+  Dies     : if pipe() or fork() fails
+
+=cut
+
+sub _start_worker {
+  my ( $self, $codeCR, $workerAR ) = @_;
+
+  my ( $task_rd,   $task_wr );
+  my ( $result_rd, $result_wr );
+  pipe( $task_rd,   $task_wr )   or croak "unable to create pipe: $!";
+  pipe( $result_rd, $result_wr ) or croak "unable to create pipe: $!";
+
+  # don't let the child inherit buffered output it would flush again
+  STDOUT->flush();
+  STDERR->flush();
+
+  my $pid = fork();
+  if ( !defined $pid ) { croak "unable to fork worker process: $!"; }
+
+  if ( $pid == 0 ) {
+    # worker
+    close($task_wr);
+    close($result_rd);
+    foreach my $other ( @{$workerAR} ) {
+      close( $other->{task_fh} );
+      close( $other->{result_fh} );
+    }
+    $Bio::Easel::NTHREADS = $self->{threads_per_worker};
+
+    while ( defined( my $frame = _read_frame($task_rd) ) ) {
+      my ( $idx, $item ) = @{$frame};
+      my $result = eval { scalar( $codeCR->($item) ) };
+      my $reply  = ( $@ eq "" ) ? [ $idx, 1, $result ] : [ $idx, 0, "$@" ];
+      if ( !eval { _write_frame( $result_wr, $reply ) } ) {
+        # most likely a result Storable can't serialize
+        my $why = ( $@ ne "" ) ? $@ : "$!";
+        _write_frame( $result_wr, [ $idx, 0, "unable to return result: $why" ] ) or last;
+      }
+    }
+    close($result_wr);
+    # skip END blocks and destructors of the parent's objects
+    POSIX::_exit(0);
+  }
+
+  close($task_rd);
+  close($result_wr);
+  $task_wr->autoflush(1);
+
+  return { pid => $pid, task_fh => $task_wr, result_fh => $result_rd, idx => undef };
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 _write_frame
+
+  Title    : _write_frame
+  Incept   : Sun Oct 18 12:44:21 2026
+  Usage    : _write_frame($fh, $dataR)
+  Function : Write a Storable serialized data structure to a pipe,
+           : preceded by its length.
+  Args     : $fh:    file handle to write to
+           : $dataR: reference to the data to write
+  Returns  : 1 on success, 0 if the write failed
+  Dies     : if $dataR can't be serialized
+
+=cut
+
+sub _write_frame {
+  my ( $fh, $dataR ) = @_;
+
+  my $buf = nfreeze($dataR);
+  $buf = pack( "N", length($buf) ) . $buf;
+
+  my $off = 0;
+  while ( $off < length($buf) ) {
+    my $n = syswrite( $fh, $buf, length($buf) - $off, $off );
+    if ( !defined $n ) {
+      if ( $!{EINTR} ) { next; }
+      return 0;
+    }
+    $off += $n;
+  }
+
+  return 1;
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 _read_frame
+
+  Title    : _read_frame
+  Incept   : Sun Oct 18 12:46:02 2026
+  Usage    : $dataR = _read_frame($fh)
+  Function : Read a data structure written by _write_frame().
+  Args     : $fh: file handle to read from
+  Returns  : reference to the data, undef at end of file
+  Dies     : if the frame is incomplete
+
+=cut
+
+sub _read_frame {
+  my ($fh) = @_;
+
+  my $len = _read_bytes( $fh, 4 );
+  if ( !defined $len ) { return undef; }
+  my $buf = _read_bytes( $fh, unpack( "N", $len ) );
+  if ( !defined $buf ) { croak "incomplete frame read from pipe"; }
+
+  return thaw($buf);
+}
+
+#-------------------------------------------------------------------------------
+
+=head2 _read_bytes
+
+  Title    : _read_bytes
+  Incept   : Sun Oct 18 12:47:39 2026
+  Usage    : $buf = _read_bytes($fh, $n)
+  Function : Read exactly $n bytes from $fh.
+  Args     : $fh: file handle to read from
+           : $n:  number of bytes to read
+  Returns  : the bytes read, undef if end of file or an error came first
+
+=cut
+
+sub _read_bytes {
+  my ( $fh, $n ) = @_;
+
+  my $buf = "";
+  while ( length($buf) < $n ) {
+    my $nread = sysread( $fh, $buf, $n - length($buf), length($buf) );
+    if ( !defined $nread ) {
+      if ( $!{EINTR} ) { next; }
+      return undef;
+    }
+    if ( $nread == 0 ) { return undef; }
+  }
+
+  return $buf;
+}
+
+=head1 AUTHORS
+
+Eric Nawrocki, C<< <nawrockie at janelia.hhmi.org> >>
+
+=head1 BUGS
+
+Please report any bugs or feature requests to C<bug-bio-easel at rt.cpan.org>.
+
+=head1 SUPPORT
+
+You can find documentation for this module with the perldoc command.
+
+    perldoc Bio::Easel::Parallel
+
+=head1 ACKNOWLEDGEMENTS
+
+Sean R. Eddy is the author of the Easel C library of functions for
+biological sequence analysis, upon which this module is based.
+
+=head1 LICENSE AND COPYRIGHT
+
+Copyright 2013 Eric Nawrocki.
+
+This program is free software; you can redistribute it and/or modify it
+under the terms of either: the GNU General Public License as published
+by the Free Software Foundation; or the Artistic License.
+
+See http://dev.perl.org/licenses/ for more information.
+
+
+=cut
+
+1;
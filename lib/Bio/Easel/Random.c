@@ -1,5 +1,12 @@
+#include <ctype.h>
+#include <inttypes.h>
+#include <math.h>
+#include <string.h>
+
 #include "easel.h"
 #include "esl_random.h"
+#include "esl_vectorops.h"
+#include "esl_wuss.h"
 
 /* Macros for converting C structs to perl, and back again)
  * from: http://www.mail-archive.com/inline@perl.org/msg03389.html
@@ -60,6 +67,25 @@ U32 _c_get_seed(ESL_RANDOMNESS *r)
   return r->seed;
 }
 
+/* Function:  _c_clone_randomness()
+ * Incept:    Sun Oct 18 14:08:30 2026
+ * Synopsis:  Create a copy of an ESL_RANDOMNESS object, in the same state.
+ *            All of the generator's state is in the structure itself.
+ * Returns:   the new ESL_RANDOMNESS, dies with 'croak' if out of memory.
+ */
+
+SV *_c_clone_randomness(ESL_RANDOMNESS *r)
+{
+  ESL_RANDOMNESS *new_r = NULL;  /* the copy */
+
+  if(r == NULL) croak("_c_clone_randomness, r is NULL");
+  new_r = malloc(sizeof(ESL_RANDOMNESS));
+  if(new_r == NULL) croak("unable to copy ESL_RANDOMNESS object, out of memory");
+  memcpy(new_r, r, sizeof(ESL_RANDOMNESS));
+
+  return perl_obj(new_r, "ESL_RANDOMNESS");
+}
+
 /* Function:  _c_destroy()
  * Incept:    EPN, Tue Apr  9 09:34:37 2013
  * Synopsis:  Destroy an ESL_RANDOMNESS object.
@@ -72,3 +98,576 @@ void _c_destroy(ESL_RANDOMNESS *r)
   r = NULL;
   return;
 }
+
+/*****************************************************************
+ * Synthetic data generators.
+ *
+ * These write Rfam-like RNA alignments and FASTA sequence databases
+ * of arbitrary size, for benchmarking and for reproducing problems
+ * seen on large production inputs. Output is written as it is
+ * generated, so memory use does not grow with the number of
+ * sequences.
+ *
+ * Each sequence is generated from its own small splitmix64 stream
+ * seeded from a master seed drawn from the ESL_RANDOMNESS. This
+ * makes the output depend only on the ESL_RANDOMNESS seed, and
+ * lets the alignment generator make two identical passes over the
+ * sequences: one to find the longest insertion at each consensus
+ * position, and one to write the alignment.
+ *****************************************************************/
+
+#define SYNTH_MAXINS 50 /* maximum length of a single insertion in _c_synth_rna_msa() */
+
+/* Function:  _c_synth_next()
+ * Incept:    Sun Oct 18 11:02:40 2026
+ * Synopsis:  splitmix64: return next 64 bit value of stream <state>.
+ */
+static uint64_t _c_synth_next(uint64_t *state)
+{
+  uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+/* Function:  _c_synth_seed_stream()
+ * Incept:    Sun Oct 18 11:04:12 2026
+ * Synopsis:  Return initial state of stream <idx> given master seed <master>.
+ */
+static uint64_t _c_synth_seed_stream(uint64_t master, uint64_t idx)
+{
+  uint64_t state = master ^ ((idx + 1) * 0xD1B54A32D192ED03ULL);
+  _c_synth_next(&state);
+  return state;
+}
+
+/* Function:  _c_synth_master_seed()
+ * Incept:    Sun Oct 18 11:05:33 2026
+ * Synopsis:  Draw a 64 bit master seed from an ESL_RANDOMNESS.
+ */
+static uint64_t _c_synth_master_seed(ESL_RANDOMNESS *r)
+{
+  uint64_t hi = (uint64_t) (esl_random(r) * 4294967296.);
+  uint64_t lo = (uint64_t) (esl_random(r) * 4294967296.);
+  return (hi << 32) | lo;
+}
+
+/* Function:  _c_synth_uniform()
+ * Incept:    Sun Oct 18 11:06:01 2026
+ * Synopsis:  Return a uniformly distributed double in [0,1).
+ */
+static double _c_synth_uniform(uint64_t *state)
+{
+  return (double) (_c_synth_next(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/* Function:  _c_synth_roll()
+ * Incept:    Sun Oct 18 11:06:29 2026
+ * Synopsis:  Return a uniformly distributed integer in 0..n-1.
+ */
+static int _c_synth_roll(uint64_t *state, int n)
+{
+  return (int) (_c_synth_uniform(state) * n);
+}
+
+/* Function:  _c_synth_geometric()
+ * Incept:    Sun Oct 18 11:07:10 2026
+ * Synopsis:  Return a geometrically distributed length >= 1 with
+ *            extension probability <ext>, capped at <max>.
+ */
+static int _c_synth_geometric(uint64_t *state, double ext, int max)
+{
+  int len = 1;
+  while(len < max && _c_synth_uniform(state) < ext) len++;
+  return len;
+}
+
+/* Function:  _c_synth_gaussian()
+ * Incept:    Sun Oct 18 11:07:52 2026
+ * Synopsis:  Return a normally distributed double (Box-Muller).
+ */
+static double _c_synth_gaussian(uint64_t *state, double mean, double sd)
+{
+  double u1, u2;
+  do { u1 = _c_synth_uniform(state); } while (u1 <= 0.);
+  u2 = _c_synth_uniform(state);
+  return mean + sd * sqrt(-2. * log(u1)) * cos(2. * M_PI * u2);
+}
+
+/* Function:  _c_synth_nt()
+ * Incept:    Sun Oct 18 11:08:31 2026
+ * Synopsis:  Return a random nucleotide from alphabet <nt> ("ACGU" or
+ *            "ACGT") with G+C fraction <gc>.
+ */
+static char _c_synth_nt(uint64_t *state, const char *nt, double gc)
+{
+  double u = _c_synth_uniform(state);
+  if(u < gc) return (u < gc / 2.) ? nt[1] : nt[2];
+  return (u < gc + (1. - gc) / 2.) ? nt[0] : nt[3];
+}
+
+/* Function:  _c_synth_basepair()
+ * Incept:    Sun Oct 18 11:09:45 2026
+ * Synopsis:  Set <ret_l> and <ret_r> to a random canonical RNA basepair,
+ *            GC and CG are most frequent, GU and UG least.
+ */
+static void _c_synth_basepair(uint64_t *state, char *ret_l, char *ret_r)
+{
+  static const char   *lA = "GCAUGU";
+  static const char   *rA = "CGUAUG";
+  static const double  pA[6] = { 0.27, 0.27, 0.19, 0.19, 0.04, 0.04 };
+  double u = _c_synth_uniform(state);
+  int    i;
+
+  for(i = 0; i < 5; i++) {
+    if(u < pA[i]) break;
+    u -= pA[i];
+  }
+  *ret_l = lA[i];
+  *ret_r = rA[i];
+  return;
+}
+
+/* Function:  _c_synth_structure()
+ * Incept:    Sun Oct 18 11:12:20 2026
+ * Synopsis:  Fill ct[lo..hi] (1..clen coords) with randomly placed,
+ *            properly nested helices separated by single stranded
+ *            regions, recursing into the loop of each helix to
+ *            create multibranch structures. ct[i] is the partner
+ *            of i, or 0 if i is unpaired; must be zeroed by caller.
+ */
+static void _c_synth_structure(uint64_t *state, int *ct, int lo, int hi, int depth)
+{
+  int i = lo;
+  int k, stem, inner, maxinner, remaining;
+
+  while(i <= hi) {
+    remaining = hi - i + 1;
+    stem      = 4 + _c_synth_roll(state, 7); /* 4..10 basepairs */
+    maxinner  = remaining - 2*stem;
+    if(maxinner >= 4 && _c_synth_uniform(state) < ((depth == 0) ? 0.7 : 0.4)) {
+      inner = 4 + _c_synth_roll(state, ESL_MIN(maxinner - 3, (depth == 0) ? 80 : 30));
+      for(k = 0; k < stem; k++) {
+        ct[i+k]                  = i + 2*stem + inner - 1 - k;
+        ct[i+2*stem+inner-1-k]   = i + k;
+      }
+      /* leave at least one unpaired position at either end of the loop */
+      if(depth < 3 && inner >= 16) _c_synth_structure(state, ct, i + stem + 1, i + stem + inner - 2, depth + 1);
+      i += 2*stem + inner;
+    }
+    i += 1 + _c_synth_roll(state, 6);
+  }
+  return;
+}
+
+/* Function:  _c_synth_rna_row()
+ * Incept:    Sun Oct 18 11:20:05 2026
+ * Synopsis:  Generate one row of a synthetic RNA alignment by evolving
+ *            <parent>, the consensus residues of the row's cluster.
+ *            Substitutions at basepaired positions are compensated
+ *            by a change at the partner position with probability
+ *            <covary>. Rows are fragmentary with probability <frag>;
+ *            deletions and insertions are geometric runs, deletions
+ *            twice as likely in unpaired regions.
+ *
+ *            Random numbers are drawn in a fixed order (substitutions,
+ *            fragment ends, deletions, insertion lengths, then insert
+ *            residues) and <insres> may be NULL to skip the last step,
+ *            so callers that only need insertion lengths consume the
+ *            same stream prefix as callers that need everything.
+ *
+ * Args:      state:    stream for this row
+ *            parent:   [1..clen] consensus residues of this row's cluster
+ *            ct:       [1..clen] consensus structure
+ *            clen:     consensus length
+ *            subst:    per position substitution probability
+ *            covary:   probability substitutions at paired positions are compensated
+ *            del_open: probability of opening a deletion (paired positions)
+ *            del_ext:  probability of extending a deletion
+ *            ins_open: probability of an insertion after each consensus position
+ *            ins_ext:  probability of extending an insertion
+ *            frag:     probability the row is a fragment
+ *            cons:     RETURN: [1..clen] residue or '-' at each consensus position
+ *            inslen:   RETURN: [0..clen] length of insertion after each consensus position
+ *            insres:   RETURN: [0..clen][0..SYNTH_MAXINS-1] inserted residues, or NULL
+ * Returns:   void
+ */
+static void _c_synth_rna_row(uint64_t *state, char *parent, int *ct, int clen, double subst, double covary,
+                             double del_open, double del_ext, double ins_open, double ins_ext, double frag,
+                             char *cons, int *inslen, char **insres)
+{
+  int  i, j, k, len;
+  int  first, last; /* first and last consensus position of the row, not a fragment: 1..clen */
+  char l, r;
+
+  memcpy(cons, parent, sizeof(char) * (clen+1));
+  for(i = 1; i <= clen; i++) {
+    if(_c_synth_uniform(state) < subst) {
+      if(ct[i] != 0 && _c_synth_uniform(state) < covary) {
+        _c_synth_basepair(state, &l, &r);
+        if(ct[i] > i) { cons[i] = l; cons[ct[i]] = r; }
+        else          { cons[i] = r; cons[ct[i]] = l; }
+      }
+      else {
+        do { l = _c_synth_nt(state, "ACGU", 0.5); } while (l == cons[i]);
+        cons[i] = l;
+      }
+    }
+  }
+
+  first = 1;
+  last  = clen;
+  if(_c_synth_uniform(state) < frag) {
+    if(_c_synth_uniform(state) < 0.6) first = 1 + _c_synth_roll(state, clen / 3);
+    if(_c_synth_uniform(state) < 0.6) last  = clen - _c_synth_roll(state, clen / 3);
+  }
+  for(i = 1;      i < first; i++) cons[i] = '-';
+  for(i = last+1; i <= clen; i++) cons[i] = '-';
+
+  for(i = first; i <= last; i++) {
+    if(_c_synth_uniform(state) < ((ct[i] == 0) ? 2. * del_open : del_open)) {
+      len = _c_synth_geometric(state, del_ext, clen);
+      for(j = i; j <= last && j < i + len; j++) cons[j] = '-';
+      i = j;
+    }
+  }
+
+  for(k = 0; k <= clen; k++) {
+    inslen[k] = 0;
+    if(k >= first && k < last && _c_synth_uniform(state) < ins_open) {
+      inslen[k] = _c_synth_geometric(state, ins_ext, SYNTH_MAXINS);
+    }
+  }
+
+  if(insres != NULL) {
+    for(k = 0; k <= clen; k++) {
+      for(j = 0; j < inslen[k]; j++) insres[k][j] = tolower(_c_synth_nt(state, "ACGU", 0.5));
+    }
+  }
+  return;
+}
+
+/* Function:  _c_synth_pp()
+ * Incept:    Sun Oct 18 11:31:44 2026
+ * Synopsis:  Return a posterior probability annotation character for
+ *            an aligned residue. Residues next to an indel (<near_indel>)
+ *            and inserted residues (<is_insert>) are less confidently
+ *            aligned than those in the middle of consensus stretches.
+ */
+static char _c_synth_pp(uint64_t *state, int near_indel, int is_insert)
+{
+  double u = _c_synth_uniform(state);
+  if(is_insert)  return "0123456"[_c_synth_roll(state, 7)];
+  if(near_indel) return (u < 0.3) ? '*' : "56789"[_c_synth_roll(state, 5)];
+  if(u < 0.85)   return '*';
+  return (u < 0.95) ? '9' : '8';
+}
+
+/* Function:  _c_synth_rna_msa()
+ * Incept:    Sun Oct 18 11:35:10 2026
+ * Purpose:   Write a synthetic Rfam-like RNA alignment in Stockholm
+ *            format: a random consensus secondary structure
+ *            (#=GC SS_cons), a consensus sequence (#=GC RF) with
+ *            canonical basepairs, <nclust> clusters of related
+ *            sequences derived from it with covarying substitutions,
+ *            fragments, deletions and insert columns, and optionally
+ *            posterior probability (#=GR PP) annotation.
+ *
+ * Args:      r:          source of randomness
+ *            outfile:    file to write
+ *            msaname:    name of the alignment (#=GF ID)
+ *            nseq:       number of sequences
+ *            clen:       consensus length
+ *            nclust:     number of sequence clusters
+ *            clust_subst: substitution probability, consensus to cluster
+ *            subst:      substitution probability, cluster to sequence
+ *            covary:     fraction of substitutions at paired positions that are compensated
+ *            del_open:   deletion open probability
+ *            del_ext:    deletion extension probability
+ *            ins_open:   insertion open probability
+ *            ins_ext:    insertion extension probability
+ *            frag:       fraction of sequences that are fragments
+ *            do_pp:      '1' to add #=GR PP annotation
+ *
+ * Returns:   alignment length
+ * Dies:      with croak if outfile can't be opened or out of memory
+ */
+long _c_synth_rna_msa(ESL_RANDOMNESS *r, char *outfile, char *msaname, int nseq, int clen, int nclust,
+                      double clust_subst, double subst, double covary, double del_open, double del_ext,
+                      double ins_open, double ins_ext, double frag, int do_pp)
+{
+  int       status;
+  FILE     *fp      = NULL;
+  uint64_t  master;              /* master seed, all streams are derived from it */
+  uint64_t  state;               /* current stream */
+  int      *ct      = NULL;      /* [1..clen] consensus structure */
+  char     *ss      = NULL;      /* [0..clen-1] consensus structure in WUSS notation */
+  char     *root    = NULL;      /* [1..clen] consensus sequence */
+  char    **clustA  = NULL;      /* [0..nclust-1][1..clen] consensus sequence of each cluster */
+  char     *cons    = NULL;      /* [1..clen] consensus residues of current row */
+  int      *inslen  = NULL;      /* [0..clen] insertion lengths of current row */
+  char    **insres  = NULL;      /* [0..clen][0..SYNTH_MAXINS-1] inserted residues of current row */
+  int      *maxins  = NULL;      /* [0..clen] max insertion length after each consensus position, over all rows */
+  char     *aseq    = NULL;      /* [0..alen-1] aligned row */
+  char     *pp      = NULL;      /* [0..alen-1] aligned PP annotation */
+  char     *name    = NULL;      /* name of current sequence */
+  long      alen;
+  int       i, j, k, s, c, apos, nres, namew, near;
+
+  if(nseq < 1)   croak("_c_synth_rna_msa(): nseq must be at least 1");
+  if(clen < 10)  croak("_c_synth_rna_msa(): consensus length must be at least 10");
+  if(nclust < 1) nclust = 1;
+  if(nclust > nseq) nclust = nseq;
+
+  master = _c_synth_master_seed(r);
+
+  ESL_ALLOC(ct,     sizeof(int)    * (clen+1));
+  ESL_ALLOC(ss,     sizeof(char)   * (clen+1));
+  ESL_ALLOC(root,   sizeof(char)   * (clen+2));
+  ESL_ALLOC(cons,   sizeof(char)   * (clen+2));
+  ESL_ALLOC(inslen, sizeof(int)    * (clen+1));
+  ESL_ALLOC(maxins, sizeof(int)    * (clen+1));
+  ESL_ALLOC(insres, sizeof(char *) * (clen+1));
+  for(k = 0; k <= clen; k++) insres[k] = NULL;
+  for(k = 0; k <= clen; k++) ESL_ALLOC(insres[k], sizeof(char) * SYNTH_MAXINS);
+  ESL_ALLOC(clustA, sizeof(char *) * nclust);
+  for(c = 0; c < nclust; c++) clustA[c] = NULL;
+
+  /* consensus structure and sequence, stream 0 */
+  state = _c_synth_seed_stream(master, 0);
+  esl_vec_ISet(ct, clen+1, 0);
+  _c_synth_structure(&state, ct, 1, clen, 0);
+  if((status = esl_ct2wuss(ct, clen, ss)) != eslOK) croak("_c_synth_rna_msa(): unable to convert structure to WUSS");
+  root[0] = root[clen+1] = '\0';
+  for(i = 1; i <= clen; i++) {
+    if     (ct[i] == 0) root[i] = _c_synth_nt(&state, "ACGU", 0.5);
+    else if(ct[i] >  i) _c_synth_basepair(&state, &(root[i]), &(root[ct[i]]));
+  }
+
+  /* cluster consensus sequences, streams 1..nclust */
+  for(c = 0; c < nclust; c++) {
+    ESL_ALLOC(clustA[c], sizeof(char) * (clen+2));
+    state = _c_synth_seed_stream(master, 1 + c);
+    _c_synth_rna_row(&state, root, ct, clen, clust_subst, covary, 0., 0., 0., 0., 0., clustA[c], inslen, NULL);
+  }
+
+  /* pass 1: maximum insertion length at each position, sequence streams nclust+1.. */
+  esl_vec_ISet(maxins, clen+1, 0);
+  for(s = 0; s < nseq; s++) {
+    state = _c_synth_seed_stream(master, 1 + nclust + s);
+    _c_synth_rna_row(&state, clustA[s % nclust], ct, clen, subst, covary, del_open, del_ext, ins_open, ins_ext, frag, cons, inslen, NULL);
+    for(k = 0; k <= clen; k++) maxins[k] = ESL_MAX(maxins[k], inslen[k]);
+  }
+  alen = clen;
+  for(k = 0; k <= clen; k++) alen += maxins[k];
+
+  ESL_ALLOC(aseq, sizeof(char) * (alen+1));
+  ESL_ALLOC(pp,   sizeof(char) * (alen+1));
+  ESL_ALLOC(name, sizeof(char) * 64);
+  aseq[alen] = pp[alen] = '\0';
+  namew = snprintf(name, 64, "synth%d/1-%ld", nseq, alen) + 8; /* width of "#=GR <name> PP" */
+
+  if((fp = fopen(outfile, "w")) == NULL) croak("_c_synth_rna_msa(): unable to open %s for writing", outfile);
+  fprintf(fp, "# STOCKHOLM 1.0\n\n");
+  fprintf(fp, "#=GF ID %s\n", msaname);
+  fprintf(fp, "#=GF DE synthetic RNA alignment (Bio::Easel::Random seed %u)\n\n", r->seed);
+
+  /* pass 2: regenerate each row from its stream and write it */
+  for(s = 0; s < nseq; s++) {
+    state = _c_synth_seed_stream(master, 1 + nclust + s);
+    _c_synth_rna_row(&state, clustA[s % nclust], ct, clen, subst, covary, del_open, del_ext, ins_open, ins_ext, frag, cons, inslen, insres);
+
+    apos = 0;
+    nres = 0;
+    for(k = 0; k <= clen; k++) {
+      for(j = 0; j < maxins[k]; j++, apos++) {
+        if(j < inslen[k]) {
+          aseq[apos] = insres[k][j];
+          pp[apos]   = (do_pp) ? _c_synth_pp(&state, 1, 1) : '.';
+          nres++;
+        }
+        else {
+          aseq[apos] = '-';
+          pp[apos]   = '.';
+        }
+      }
+      if(k < clen) {
+        aseq[apos] = cons[k+1];
+        if(cons[k+1] == '-') {
+          pp[apos] = '.';
+        }
+        else {
+          near = (inslen[k] > 0 || inslen[k+1] > 0 || (k > 0 && cons[k] == '-') || (k+2 <= clen && cons[k+2] == '-')) ? 1 : 0;
+          pp[apos] = (do_pp) ? _c_synth_pp(&state, near, 0) : '.';
+          nres++;
+        }
+        apos++;
+      }
+    }
+    snprintf(name, 64, "synth%d/1-%d", s+1, nres);
+    fprintf(fp, "%-*s %s\n", namew, name, aseq);
+    if(do_pp) fprintf(fp, "#=GR %-*s PP %s\n", namew - 8, name, pp);
+  }
+
+  /* consensus annotation */
+  for(k = 0, apos = 0; k <= clen; k++) {
+    for(j = 0; j < maxins[k]; j++, apos++) { aseq[apos] = '.'; pp[apos] = '.'; }
+    if(k < clen) { aseq[apos] = ss[k]; pp[apos] = root[k+1]; apos++; }
+  }
+  fprintf(fp, "%-*s %s\n", namew, "#=GC SS_cons", aseq);
+  fprintf(fp, "%-*s %s\n", namew, "#=GC RF", pp);
+  fprintf(fp, "//\n");
+  if(fclose(fp) != 0) croak("_c_synth_rna_msa(): error writing %s", outfile);
+
+  for(c = 0; c < nclust; c++) free(clustA[c]);
+  for(k = 0; k <= clen; k++)  free(insres[k]);
+  free(clustA);
+  free(insres);
+  free(ct);
+  free(ss);
+  free(root);
+  free(cons);
+  free(inslen);
+  free(maxins);
+  free(aseq);
+  free(pp);
+  free(name);
+
+  return alen;
+
+ ERROR:
+  croak("out of memory");
+  return -1; /* NEVERREACHED */
+}
+
+/* Function:  _c_synth_fasta()
+ * Incept:    Sun Oct 18 12:01:26 2026
+ * Purpose:   Write a synthetic FASTA sequence database. Sequence
+ *            lengths are lognormally distributed with mean <len_mean>
+ *            and standard deviation <len_sd>, clamped to
+ *            <minlen>..<maxlen>. Nucleotide sequences have G+C fraction
+ *            <gc>, protein sequences have background amino acid
+ *            frequencies. A fraction <nrun> of sequences contain runs
+ *            of unknown residues (N or X), and a fraction <softmask>
+ *            contain soft-masked (lowercase) regions.
+ *
+ * Args:      r:         source of randomness
+ *            outfile:   file to write
+ *            abc:       "rna", "dna" or "amino"
+ *            nseq:      number of sequences
+ *            len_mean:  mean sequence length
+ *            len_sd:    standard deviation of sequence length
+ *            minlen:    minimum sequence length
+ *            maxlen:    maximum sequence length
+ *            gc:        G+C fraction, ignored for protein
+ *            nrun:      fraction of sequences with runs of unknown residues
+ *            softmask:  fraction of sequences with soft-masked regions
+ *            textw:     residues per line, -1 for unlimited
+ *
+ * Returns:   total number of residues written, as a string
+ *            to avoid integer overflow
+ * Dies:      with croak if outfile can't be opened, an argument
+ *            is invalid or out of memory
+ */
+SV *_c_synth_fasta(ESL_RANDOMNESS *r, char *outfile, char *abc, long nseq, double len_mean, double len_sd,
+                   long minlen, long maxlen, double gc, double nrun, double softmask, int textw)
+{
+  int       status;
+  FILE     *fp   = NULL;
+  uint64_t  master;
+  uint64_t  state;
+  char     *seq  = NULL;       /* current sequence */
+  long      seqalloc = 0;      /* current allocation size of seq */
+  double    sigma, mu;         /* parameters of the lognormal length distribution */
+  const char *nt = NULL;       /* "ACGU" or "ACGT", NULL for amino */
+  char      unknown;           /* unknown residue, 'N' or 'X' */
+  long      s, i, j, L, start, len, nruns;
+  uint64_t  nres = 0;
+  char      nres_str[32];
+  double    u;
+  double    dL;
+  int       a;
+  static const char   *aa   = "ACDEFGHIKLMNPQRSTVWY";
+  static const double  aa_f[20] = { 0.0787945, 0.0151600, 0.0535222, 0.0668298, 0.0397062,
+                                    0.0695071, 0.0229198, 0.0590092, 0.0594422, 0.0963728,
+                                    0.0237718, 0.0414386, 0.0482904, 0.0395639, 0.0540978,
+                                    0.0683364, 0.0540687, 0.0673417, 0.0114135, 0.0304133 };
+
+  if     (strcmp(abc, "rna")   == 0) { nt = "ACGU"; unknown = 'N'; }
+  else if(strcmp(abc, "dna")   == 0) { nt = "ACGT"; unknown = 'N'; }
+  else if(strcmp(abc, "amino") == 0) { nt = NULL;   unknown = 'X'; }
+  else croak("_c_synth_fasta(): alphabet must be \"rna\", \"dna\" or \"amino\", not %s", abc);
+  if(len_mean <= 0.)    croak("_c_synth_fasta(): mean length must be positive");
+  if(minlen < 1)        minlen = 1;
+  if(maxlen < minlen)   croak("_c_synth_fasta(): maximum length %ld is less than minimum length %ld", maxlen, minlen);
+  if(textw == 0)        croak("_c_synth_fasta(): textw must be positive or -1");
+
+  sigma = sqrt(log(1. + (len_sd * len_sd) / (len_mean * len_mean)));
+  mu    = log(len_mean) - (sigma * sigma) / 2.;
+
+  master = _c_synth_master_seed(r);
+  if((fp = fopen(outfile, "w")) == NULL) croak("_c_synth_fasta(): unable to open %s for writing", outfile);
+
+  for(s = 0; s < nseq; s++) {
+    state = _c_synth_seed_stream(master, s);
+    /* clamp before the cast: a large len_sd can draw lengths (even inf) that don't fit in a long */
+    dL = exp(_c_synth_gaussian(&state, mu, sigma)) + 0.5;
+    if     (! (dL >= (double) minlen)) L = minlen; /* includes NaN */
+    else if(dL >= (double) maxlen)     L = maxlen;
+    else                               L = (long) dL;
+    if(L > seqalloc) {
+      seqalloc = ESL_MAX(L, 2 * seqalloc);
+      ESL_REALLOC(seq, sizeof(char) * seqalloc);
+    }
+
+    if(nt != NULL) {
+      for(i = 0; i < L; i++) seq[i] = _c_synth_nt(&state, nt, gc);
+    }
+    else {
+      for(i = 0; i < L; i++) {
+        u = _c_synth_uniform(&state);
+        for(a = 0; a < 19; a++) { if(u < aa_f[a]) break; u -= aa_f[a]; }
+        seq[i] = aa[a];
+      }
+    }
+
+    if(_c_synth_uniform(&state) < nrun) {
+      nruns = 1 + _c_synth_roll(&state, 3);
+      for(j = 0; j < nruns; j++) {
+        start = _c_synth_roll(&state, (int) ESL_MIN(L, 2147483647L));
+        len   = _c_synth_geometric(&state, 0.99, 1000);
+        for(i = start; i < L && i < start + len; i++) seq[i] = unknown;
+      }
+    }
+    if(_c_synth_uniform(&state) < softmask) {
+      nruns = 1 + _c_synth_roll(&state, 5);
+      for(j = 0; j < nruns; j++) {
+        start = _c_synth_roll(&state, (int) ESL_MIN(L, 2147483647L));
+        len   = 50 + _c_synth_roll(&state, 451);
+        for(i = start; i < L && i < start + len; i++) seq[i] = tolower(seq[i]);
+      }
+    }
+
+    fprintf(fp, ">synth%ld synthetic %s sequence, length %ld\n", s+1, abc, L);
+    if(textw < 0) {
+      fwrite(seq, sizeof(char), L, fp);
+      fputc('\n', fp);
+    }
+    else {
+      for(i = 0; i < L; i += textw) {
+        fwrite(seq + i, sizeof(char), ESL_MIN(textw, L - i), fp);
+        fputc('\n', fp);
+      }
+    }
+    nres += L;
+  }
+  if(fclose(fp) != 0) croak("_c_synth_fasta(): error writing %s", outfile);
+  if(seq != NULL) free(seq);
+
+  sprintf(nres_str, "%" PRIu64, nres);
+  return newSVpv(nres_str, 0);
+
+ ERROR:
+  croak("out of memory");
+  return NULL; /* NEVERREACHED */
+}
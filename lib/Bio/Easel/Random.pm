@@ -4,6 +4,7 @@ use strict;
 use warnings;
 use File::Spec;
 use Carp;
+use Scalar::Util qw(refaddr weaken);
 
 =head1 NAME
 
@@ -46,6 +47,9 @@ our $ESLENOFORMAT =      '25';    # couldn't guess file format
 our $ESLENOALPHABET =    '26';    # couldn't guess seq alphabet
 our $ESLEWRITE =         '27';    # write failed (fprintf, etc)
 
+# all live objects, weak references, key: refaddr(), for CLONE()
+my %live_objects = ();
+
 my $src_file      = undef;
 my $typemaps      = undef;
 my $easel_src_dir = undef;
@@ -60,14 +64,29 @@ BEGIN {
     $typemaps =~ s/\.pm/\.typemap/;
 }
 
-use Inline
-  C        => "$src_file",
-  VERSION  => '0.01',
-  ENABLE   => 'AUTOWRAP',
-  INC      => "-I$easel_src_dir",
-  LIBS     => "-L$easel_src_dir -leasel",
-  TYPEMAPS => $typemaps,
-  NAME     => 'Bio::Easel::Random';
+# Load the precompiled XS build of Random.c (see xs/BioEaselXS.pm) if
+# it was installed, else fall back to compiling it with Inline::C,
+# which is also what you get with BIO_EASEL_INLINE=1 (development).
+# An XS build that is installed but fails to load is an error.
+BEGIN {
+  require XSLoader;
+  my $use_inline = $ENV{BIO_EASEL_INLINE};
+  if((! $use_inline) && (! eval { XSLoader::load('Bio::Easel::Random', '0.01'); 1; })) {
+    if($@ !~ m/^Can't locate loadable object for module/) { die $@; }
+    $use_inline = 1;
+  }
+  if($use_inline) {
+    require Inline;
+    Inline->import(
+      C        => "$src_file",
+      VERSION  => '0.01',
+      ENABLE   => 'AUTOWRAP',
+      INC      => "-I$easel_src_dir",
+      LIBS     => "-L$easel_src_dir -leasel",
+      TYPEMAPS => $typemaps,
+      NAME     => 'Bio::Easel::Random');
+  }
+}
 
 =head1 SYNOPSIS
 
@@ -119,6 +138,9 @@ sub new {
     confess("Error creating ESL_RANDOMNESS, $@\n");
   }
 
+  $live_objects{ refaddr($self) } = $self;
+  weaken( $live_objects{ refaddr($self) } );
+
   return $self;
 }
 
@@ -251,6 +273,113 @@ sub random_subset_from_array {
   return;
 }
 
+=head2 synth_rna_msa
+
+  Title    : synth_rna_msa
+  Incept   : Sun Oct 18 12:20:41 2026
+  Usage    : $alen = $rngObject->synth_rna_msa($outfile, $optsHR)
+  Function : Write a synthetic Rfam-like RNA alignment in Stockholm format
+           : to $outfile: a random consensus structure (SS_cons) and
+           : sequence (RF), clusters of related sequences with covarying
+           : basepair substitutions, fragments, deletion runs, insert
+           : columns and (optionally) PP annotation. The output is
+           : determined by the seed of this object, and is written as it
+           : is generated, so any number of sequences can be generated.
+           : See _c_synth_rna_msa() in Random.c for details.
+  Args     : $outfile: name of output file
+           : $optsHR:  optional: ref to hash of options, defaults in ():
+           :   'name':        alignment name, #=GF ID ("synth")
+           :   'nseq':        number of sequences (100)
+           :   'clen':        consensus length (120)
+           :   'nclust':      number of clusters of related sequences (10)
+           :   'clust_subst': substitution probability from consensus to cluster (0.15)
+           :   'subst':       substitution probability from cluster to sequence (0.05)
+           :   'covary':      fraction of substitutions at paired positions
+           :                  that are compensated (0.7)
+           :   'del_open':    deletion opening probability per position (0.005)
+           :   'del_ext':     deletion extension probability (0.7)
+           :   'ins_open':    insertion opening probability per position (0.003)
+           :   'ins_ext':     insertion extension probability (0.6)
+           :   'frag':        fraction of sequences that are fragments (0.1)
+           :   'pp':          '1' to add PP annotation, '0' not to (1)
+  Returns  : alignment length
+  Dies     : if an option is unknown, or $outfile can't be written
+
+=cut
+
+sub synth_rna_msa {
+  my ( $self, $outfile, $optsHR ) = @_;
+
+  my %optH = ( name        => "synth",
+               nseq        => 100,
+               clen        => 120,
+               nclust      => 10,
+               clust_subst => 0.15,
+               subst       => 0.05,
+               covary      => 0.7,
+               del_open    => 0.005,
+               del_ext     => 0.7,
+               ins_open    => 0.003,
+               ins_ext     => 0.6,
+               frag        => 0.1,
+               pp          => 1 );
+  _set_synth_opts(\%optH, $optsHR, "synth_rna_msa");
+
+  $self->_check_randomness();
+  return _c_synth_rna_msa($self->{esl_randomness}, $outfile, $optH{name}, $optH{nseq}, $optH{clen}, $optH{nclust},
+                          $optH{clust_subst}, $optH{subst}, $optH{covary}, $optH{del_open}, $optH{del_ext},
+                          $optH{ins_open}, $optH{ins_ext}, $optH{frag}, $optH{pp});
+}
+
+=head2 synth_fasta
+
+  Title    : synth_fasta
+  Incept   : Sun Oct 18 12:31:02 2026
+  Usage    : $nres = $rngObject->synth_fasta($outfile, $optsHR)
+  Function : Write a synthetic FASTA sequence database to $outfile, with
+           : lognormally distributed sequence lengths, a given G+C
+           : content (nucleotides) or background amino acid frequencies
+           : (protein), and some sequences with runs of unknown residues
+           : (N or X) and with soft-masked (lowercase) regions. The output
+           : is determined by the seed of this object.
+           : See _c_synth_fasta() in Random.c for details.
+  Args     : $outfile: name of output file
+           : $optsHR:  optional: ref to hash of options, defaults in ():
+           :   'abc':      "rna", "dna" or "amino" ("dna")
+           :   'nseq':     number of sequences (1000)
+           :   'len_mean': mean sequence length (1000)
+           :   'len_sd':   standard deviation of sequence length (1000)
+           :   'minlen':   minimum sequence length (20)
+           :   'maxlen':   maximum sequence length (1000000000)
+           :   'gc':       G+C fraction (0.45)
+           :   'nrun':     fraction of sequences with runs of N or X (0.05)
+           :   'softmask': fraction of sequences with soft-masked regions (0.1)
+           :   'textw':    residues per line, -1 for unlimited (60)
+  Returns  : total number of residues written, as a string
+  Dies     : if an option is unknown, or $outfile can't be written
+
+=cut
+
+sub synth_fasta {
+  my ( $self, $outfile, $optsHR ) = @_;
+
+  my %optH = ( abc      => "dna",
+               nseq     => 1000,
+               len_mean => 1000,
+               len_sd   => 1000,
+               minlen   => 20,
+               maxlen   => 1000000000,
+               gc       => 0.45,
+               nrun     => 0.05,
+               softmask => 0.1,
+               textw    => 60 );
+  _set_synth_opts(\%optH, $optsHR, "synth_fasta");
+
+  $self->_check_randomness();
+  return _c_synth_fasta($self->{esl_randomness}, $outfile, $optH{abc}, $optH{nseq}, $optH{len_mean}, $optH{len_sd},
+                        $optH{minlen}, $optH{maxlen}, $optH{gc}, $optH{nrun}, $optH{softmask}, $optH{textw});
+}
+
 =head2 DESTROY
 
   Title    : DESTROY
@@ -265,11 +394,46 @@ sub random_subset_from_array {
 sub DESTROY {
   my ($self) = @_;
 
+  delete $live_objects{ refaddr($self) };
   _c_destroy($self->{esl_randomness});
 
   return;
 }
 
+=head2 CLONE
+
+  Title    : CLONE
+  Incept   : Sun Oct 18 14:10:52 2026
+  Usage    : called by perl in a new thread (ithreads), never directly
+  Function : Each object in the new thread is a copy of the object
+           : in the parent thread, including the pointer to its
+           : ESL_RANDOMNESS. Give each object in the new thread its
+           : own copy of the generator, in the same state. Note that
+           : the two threads will then generate the same sequence of
+           : random numbers, unless one of them calls 
+           : create_randomness() with a new seed.
+  Args     : none (the package name)
+  Returns  : void
+
+=cut
+
+sub CLONE {
+  my @objA = grep { defined $_ } values %live_objects;
+
+  # addresses are different in the new interpreter
+  %live_objects = ();
+  foreach my $obj (@objA) {
+    $live_objects{ refaddr($obj) } = $obj;
+    weaken( $live_objects{ refaddr($obj) } );
+
+    if ( defined $obj->{esl_randomness} ) {
+      $obj->{esl_randomness} = _c_clone_randomness( $obj->{esl_randomness} );
+    }
+  }
+
+  return;
+}
+
 #############################
 # Internal helper subroutines
 #############################
@@ -294,6 +458,32 @@ sub _check_randomness {
   return;
 }
 
+=head2 _set_synth_opts
+
+  Title    : _set_synth_opts
+  Incept   : Sun Oct 18 12:35:19 2026
+  Usage    : _set_synth_opts($defaultsHR, $optsHR, $caller)
+  Function : Overwrite default options in %{$defaultsHR} with
+           : those in %{$optsHR}.
+  Args     : $defaultsHR: ref to hash of default options, updated
+           : $optsHR:     ref to hash of options passed by user, may be undef
+           : $caller:     name of calling method, for error messages
+  Returns  : void
+  Dies     : if %{$optsHR} contains an option not in %{$defaultsHR}
+
+=cut
+
+sub _set_synth_opts {
+  my ( $defaultsHR, $optsHR, $caller ) = @_;
+
+  if(! defined $optsHR) { return; }
+  foreach my $key (keys %{$optsHR}) {
+    if(! exists $defaultsHR->{$key}) { croak "$caller: unknown option $key"; }
+    $defaultsHR->{$key} = $optsHR->{$key};
+  }
+  return;
+}
+
 =head2 dl_load_flags
 
 =head1 AUTHORS
@@ -1,9 +1,18 @@
+#include <ctype.h>
+#include <fcntl.h>
+#include <math.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include "easel.h"
 #include "esl_alphabet.h"
+#include "esl_keyhash.h"
 #include "esl_sqio.h"
 #include "esl_sq.h"
 #include "esl_ssi.h"
 
+#include "bio_easel_threads.h"
+
 /* Macros for converting C structs to perl, and back again)
  * from: http://www.mail-archive.com/inline@perl.org/msg03389.html
  * note the typedef in ~/perl/tw_modules/typedef
@@ -108,6 +117,9 @@ int _c_open_ssi_index (ESL_SQFILE *sqfp)
  * Incept:    EPN, Fri Mar  8 09:46:52 2013
  * Synopsis:  Create an SSI index file for an existing sequence file.
  *            Based on and nearly identical to easel's miniapps/esl-sfetch.c::create_ssi_index.
+ *            Reports progress, in bytes of the sequence file read,
+ *            to the callback set with Bio::Easel->set_progress_callback(),
+ *            and stops without writing the index if it is cancelled.
  * Returns:   eslOK on success, eslENOTFOUND if SSI file does not exist
  *            dies via croak with informative error message upon an error
  */
@@ -120,6 +132,11 @@ void _c_create_ssi_index (ESL_SQFILE *sqfp)
   char       *ssifile = NULL;
   uint16_t    fh;
   int         status;
+  BE_PROGRESS prg;
+  struct stat st;
+
+  /* progress is in bytes read, unknown for a stream or gzipped file */
+  _c_progress_start(&prg, "create_ssi_index", (stat(sqfp->filename, &st) == 0) ? (int64_t) st.st_size : 0);
 
   if(sqfp->do_digital) sq = esl_sq_CreateDigital(sqfp->abc);
   else                 sq = esl_sq_Create();
@@ -146,8 +163,21 @@ void _c_create_ssi_index (ESL_SQFILE *sqfp)
 	if (esl_newssi_AddAlias(ns, sq->acc, sq->name) != eslOK)
 	  croak("Failed to add secondary key %s to SSI index", sq->acc);
       }
+      if (prg.cb != NULL && (nseq % 1000) == 0) { 
+        prg.done = ESL_MIN((int64_t) sq->roff, prg.total);
+        if (_c_progress_poll(&prg)) break;
+      }
       esl_sq_Reuse(sq);
     }
+  if (_c_progress_cancelled(&prg)) { 
+    /* the index file was opened (truncated) but never written: remove it; rewind so the file can still be read */
+    esl_sqfile_Position(sqfp, 0);
+    esl_newssi_Close(ns);
+    remove(ssifile);
+    free(ssifile);
+    esl_sq_Destroy(sq);
+    _c_progress_finish(&prg); /* dies */
+  }
   if      (status == eslEFORMAT) croak("Parse failed (sequence file %s):\n%s\n",
 					   sqfp->filename, esl_sqfile_GetErrorBuf(sqfp));
   else if (status != eslEOF)     croak("Unexpected error %d reading sequence file %s",
@@ -167,6 +197,7 @@ void _c_create_ssi_index (ESL_SQFILE *sqfp)
   free(ssifile);
   esl_sq_Destroy(sq);
   esl_newssi_Close(ns);
+  _c_progress_finish(&prg);
 }    
 
 /* Function:  _c_fetch_one_sequence()
@@ -817,3 +848,1700 @@ SV * _c_nres_ssi(ESL_SQFILE *sqfp) {
   croak("out of memory");
   return NULL; /* NEVER REACHED */
 }
+
+/* Function:  _c_ssi_lengths
+ * Incept:    Mon Oct 19 03:58:12 2026
+ * Purpose:   Return the lengths of all sequences in a sequence file,
+ *            read from its SSI index in one pass, in index order.
+ *            No sequence is read or parsed.
+ *            
+ * Args:      sqfp - open ESL_SQFILE, with an SSI index
+ *
+ * Returns:   nseq packed int64 (unpack with "q*"), 0 for sequences
+ *            whose length isn't set in the index.
+ * Dies:      if the file has no SSI index or it can't be read.
+ */
+
+SV *_c_ssi_lengths(ESL_SQFILE *sqfp) { 
+  int      status;
+  int64_t  i;
+  int64_t  nseq;
+  int64_t *L;
+  SV      *lenSV;
+
+  if (sqfp->data.ascii.ssi == NULL) croak("sequence file has no SSI information\n"); 
+
+  nseq  = sqfp->data.ascii.ssi->nprimary;
+  lenSV = newSV(sizeof(int64_t) * nseq + 1);
+  SvPOK_on(lenSV);
+  L = (int64_t *) SvPVX(lenSV);
+  for(i = 0; i < nseq; i++) { 
+    status = esl_ssi_FindNumber(sqfp->data.ascii.ssi, i, NULL, NULL, NULL, &(L[i]), NULL);
+    if(status != eslOK) { 
+      SvREFCNT_dec(lenSV);
+      if     (status == eslEMEM)    croak("out of memory");
+      else if(status == eslEFORMAT) croak("error fetching sequence num %" PRId64 ", something wrong with SSI index?\n", i);
+      else                          croak("error fetching sequence num %" PRId64 "\n", i);
+    }
+  }
+  SvCUR_set(lenSV, sizeof(int64_t) * nseq);
+  *SvEND(lenSV) = '\0';
+
+  return lenSV;
+}
+
+/* A sequence file loaded into memory by _c_sqdb_load(), for
+ * Bio::Easel::SqFile::load_all(): the residues of all sequences, in
+ * file order, in one arena, separated (and surrounded) by a sentinel
+ * byte, '\0' in text mode and eslDSQ_SENTINEL in digital mode, so in
+ * digital mode <res> + off[i] - 1 is a valid ESL_DSQ for sequence i.
+ * Names, accessions and descriptions are '\0' terminated in a second
+ * arena, and looked up by name or accession in two keyhashes.
+ */
+typedef struct {
+  ESL_ALPHABET *abc;        /* alphabet, digital mode; NULL in text mode */
+  int64_t       nseq;       /* number of sequences */
+  int64_t       nres;       /* total number of residues */
+  char         *res;        /* residue arena, see above */
+  int64_t       nres_alloc; /* allocated size of <res> */
+  int64_t       nbytes;     /* bytes used in <res> */
+  char         *txt;        /* name arena */
+  int64_t       ntxt;       /* bytes used in <txt> */
+  int64_t       ntxt_alloc; /* allocated size of <txt> */
+  int64_t      *off;        /* [0..i..nseq-1] offset of the first residue of i in <res> */
+  int64_t      *L;          /* [0..i..nseq-1] length of i */
+  int64_t      *name_off;   /* [0..i..nseq-1] offset of the name of i in <txt> */
+  int64_t      *acc_off;    /* [0..i..nseq-1] offset of the accession of i in <txt>, "" if none */
+  int64_t      *desc_off;   /* [0..i..nseq-1] offset of the description of i in <txt>, "" if none */
+  int64_t       nalloc;     /* allocated size of the per sequence arrays */
+  ESL_KEYHASH  *kh;         /* names, key i is sequence i */
+  ESL_KEYHASH  *akh;        /* accessions, key k is sequence accidx[k] */
+  int64_t      *accidx;     /* [0..k..] sequence with accession k */
+} BE_SQDB;
+
+/* Function:  _c_sqdb_free()
+ * Incept:    Mon Oct 19 01:02:44 2026
+ * Synopsis:  Free a BE_SQDB from _c_sqdb_load().
+ * Returns:   void
+ */
+void _c_sqdb_free(BE_SQDB *db)
+{
+  if(db == NULL) return;
+  if(db->abc)      esl_alphabet_Destroy(db->abc);
+  if(db->res)      free(db->res);
+  if(db->txt)      free(db->txt);
+  if(db->off)      free(db->off);
+  if(db->L)        free(db->L);
+  if(db->name_off) free(db->name_off);
+  if(db->acc_off)  free(db->acc_off);
+  if(db->desc_off) free(db->desc_off);
+  if(db->accidx)   free(db->accidx);
+  if(db->kh)       esl_keyhash_Destroy(db->kh);
+  if(db->akh)      esl_keyhash_Destroy(db->akh);
+  free(db);
+  return;
+}
+
+/* Function:  _c_sqdb_add_txt()
+ * Incept:    Mon Oct 19 01:05:18 2026
+ * Synopsis:  Append '\0' terminated string <s> to the name arena of <db>.
+ * Returns:   eslOK, and the offset of the copy in <ret_off>; eslEMEM if out of memory.
+ */
+static int
+_c_sqdb_add_txt(BE_SQDB *db, const char *s, int64_t *ret_off)
+{
+  int     status;
+  int64_t n = strlen(s) + 1;
+
+  while(db->ntxt + n > db->ntxt_alloc) { 
+    db->ntxt_alloc *= 2;
+    ESL_REALLOC(db->txt, sizeof(char) * db->ntxt_alloc);
+  }
+  memcpy(db->txt + db->ntxt, s, n);
+  *ret_off  = db->ntxt;
+  db->ntxt += n;
+  return eslOK;
+
+ ERROR:
+  return status;
+}
+
+/* Function:  _c_sqdb_load()
+ * Incept:    Mon Oct 19 01:09:51 2026
+ * Purpose:   Read every sequence of <sqfp>, from the start of the
+ *            file, into a new BE_SQDB (see above), in text or digital
+ *            mode as <sqfp> is, so sequences and subsequences can be
+ *            fetched by name or accession with no more file reads or
+ *            parsing. The residue arena starts out the size of the
+ *            file, which it can't outgrow for an uncompressed file, 
+ *            and is shrunk to fit at the end. Reports progress, in
+ *            bytes of the file read, to the callback set with
+ *            Bio::Easel->set_progress_callback(). The file is
+ *            rewound at the end.
+ *
+ * Returns:   the new BE_SQDB, as a perl object.
+ * Dies:      with croak if the file can't be read or rewound, a 
+ *            name occurs more than once, if out of memory, or with 
+ *            "load_all cancelled" if cancelled.
+ */
+SV *_c_sqdb_load(ESL_SQFILE *sqfp)
+{
+  int          status;
+  BE_SQDB     *db = NULL;
+  ESL_SQ      *sq = NULL;
+  char         sep;
+  int64_t      need;
+  int          k;
+  BE_PROGRESS  prg;
+  struct stat  st;
+
+  _c_progress_start(&prg, "load_all", (stat(sqfp->filename, &st) == 0) ? (int64_t) st.st_size : 0);
+  if(esl_sqfile_Position(sqfp, 0) != eslOK) croak("_c_sqdb_load() unable to rewind sequence file %s", sqfp->filename);
+
+  ESL_ALLOC(db, sizeof(BE_SQDB));
+  memset(db, 0, sizeof(BE_SQDB));
+  db->nres_alloc = ESL_MAX(prg.total, 4096);
+  db->ntxt_alloc = 4096;
+  db->nalloc     = 1024;
+  ESL_ALLOC(db->res,      sizeof(char)    * db->nres_alloc);
+  ESL_ALLOC(db->txt,      sizeof(char)    * db->ntxt_alloc);
+  ESL_ALLOC(db->off,      sizeof(int64_t) * db->nalloc);
+  ESL_ALLOC(db->L,        sizeof(int64_t) * db->nalloc);
+  ESL_ALLOC(db->name_off, sizeof(int64_t) * db->nalloc);
+  ESL_ALLOC(db->acc_off,  sizeof(int64_t) * db->nalloc);
+  ESL_ALLOC(db->desc_off, sizeof(int64_t) * db->nalloc);
+  ESL_ALLOC(db->accidx,   sizeof(int64_t) * db->nalloc);
+  if((db->kh  = esl_keyhash_Create()) == NULL) goto ERROR;
+  if((db->akh = esl_keyhash_Create()) == NULL) goto ERROR;
+  if(sqfp->do_digital && (db->abc = esl_alphabet_Create(sqfp->abc->type)) == NULL) goto ERROR;
+  sep = (sqfp->do_digital) ? (char) eslDSQ_SENTINEL : '\0';
+  db->res[db->nbytes++] = sep;
+
+  if(sqfp->do_digital) sq = esl_sq_CreateDigital(sqfp->abc);
+  else                 sq = esl_sq_Create();
+
+  while((status = esl_sqio_Read(sqfp, sq)) == eslOK) { 
+    if(db->nseq == db->nalloc) { 
+      db->nalloc *= 2;
+      ESL_REALLOC(db->off,      sizeof(int64_t) * db->nalloc);
+      ESL_REALLOC(db->L,        sizeof(int64_t) * db->nalloc);
+      ESL_REALLOC(db->name_off, sizeof(int64_t) * db->nalloc);
+      ESL_REALLOC(db->acc_off,  sizeof(int64_t) * db->nalloc);
+      ESL_REALLOC(db->desc_off, sizeof(int64_t) * db->nalloc);
+      ESL_REALLOC(db->accidx,   sizeof(int64_t) * db->nalloc);
+    }
+    /* residues, then a separator */
+    need = db->nbytes + sq->n + 1;
+    if(need > db->nres_alloc) { 
+      while(need > db->nres_alloc) db->nres_alloc *= 2;
+      ESL_REALLOC(db->res, sizeof(char) * db->nres_alloc);
+    }
+    db->off[db->nseq] = db->nbytes;
+    db->L[db->nseq]   = sq->n;
+    if(sq->n > 0) memcpy(db->res + db->nbytes, (sq->dsq != NULL) ? (char *) (sq->dsq + 1) : sq->seq, sq->n);
+    db->nbytes += sq->n;
+    db->res[db->nbytes++] = sep;
+    db->nres   += sq->n;
+
+    if(_c_sqdb_add_txt(db, sq->name, &(db->name_off[db->nseq])) != eslOK) goto ERROR;
+    if(_c_sqdb_add_txt(db, sq->acc,  &(db->acc_off[db->nseq]))  != eslOK) goto ERROR;
+    if(_c_sqdb_add_txt(db, sq->desc, &(db->desc_off[db->nseq])) != eslOK) goto ERROR;
+
+    status = esl_keyhash_Store(db->kh, sq->name, -1, NULL);
+    if(status == eslEDUP) { 
+      esl_sqfile_Position(sqfp, 0);
+      _c_sqdb_free(db);
+      croak("_c_sqdb_load() sequence name %s occurs more than once in %s", sq->name, sqfp->filename);
+    }
+    else if(status != eslOK) goto ERROR;
+    if(sq->acc[0] != '\0') { 
+      /* as in an SSI index, an accession is a secondary key; the first sequence with it wins */
+      status = esl_keyhash_Store(db->akh, sq->acc, -1, &k);
+      if     (status == eslOK)   db->accidx[k] = db->nseq;
+      else if(status != eslEDUP) goto ERROR;
+    }
+    db->nseq++;
+
+    if(prg.cb != NULL && (db->nseq % 1000) == 0) { 
+      prg.done = ESL_MIN((int64_t) sq->roff, prg.total);
+      if(_c_progress_poll(&prg)) break;
+    }
+    esl_sq_Reuse(sq);
+  }
+  esl_sq_Destroy(sq);
+  esl_sqfile_Position(sqfp, 0); /* rewind b/c we're at the end of the file */
+  if(_c_progress_cancelled(&prg)) { 
+    _c_sqdb_free(db);
+    _c_progress_finish(&prg); /* dies */
+  }
+  if(status == eslEFORMAT) { 
+    _c_sqdb_free(db);
+    croak("Parse failed (sequence file %s):\n%s\n", sqfp->filename, esl_sqfile_GetErrorBuf(sqfp));
+  }
+  else if(status != eslEOF) { 
+    _c_sqdb_free(db);
+    croak("Unexpected error %d reading sequence file %s", status, sqfp->filename);
+  }
+
+  /* shrink the residue arena to fit */
+  if(db->nbytes < db->nres_alloc) { 
+    db->nres_alloc = db->nbytes;
+    ESL_REALLOC(db->res, sizeof(char) * db->nres_alloc);
+  }
+  prg.done = prg.total;
+  _c_progress_finish(&prg);
+
+  return perl_obj(db, "BE_SQDB");
+
+ ERROR:
+  croak("_c_sqdb_load() out of memory");
+  return NULL; /* NEVERREACHED */
+}
+
+/* Function:  _c_sqdb_lookup()
+ * Incept:    Mon Oct 19 01:16:30 2026
+ * Synopsis:  Look up a sequence of <db> by name or, failing that, accession.
+ * Returns:   index of the sequence (0..nseq-1), -1 if there is none.
+ */
+static int64_t
+_c_sqdb_lookup(BE_SQDB *db, char *key)
+{
+  int k;
+
+  if(esl_keyhash_Lookup(db->kh,  key, -1, &k) == eslOK) return k;
+  if(esl_keyhash_Lookup(db->akh, key, -1, &k) == eslOK) return db->accidx[k];
+  return -1;
+}
+
+/* Function:  _c_sqdb_fasta()
+ * Incept:    Mon Oct 19 01:20:07 2026
+ * Synopsis:  Format <n> residues <rsq> (digital codes if <db> is in
+ *            digital mode, else text) as a FASTA record named <name>,
+ *            with optional accession <acc> and description <desc>
+ *            ("" for none), with lines of <textw> residues (-1 for
+ *            unlimited), exactly as _c_sq_to_seqstring() does, 
+ *            straight into a new SV.
+ * Returns:   the new SV.
+ */
+static SV *
+_c_sqdb_fasta(BE_SQDB *db, const char *name, const char *acc, const char *desc, const char *rsq, int64_t n, int textw)
+{
+  SV      *sv;
+  char    *p;
+  int64_t  nlines;
+  int64_t  len;
+  int64_t  pos, i, w;
+
+  nlines = (textw == -1) ? 1 : (n + textw - 1) / textw;
+  len    = 1 + strlen(name) + 1 + n + nlines;
+  if(acc[0]  != '\0') len += 1 + strlen(acc);
+  if(desc[0] != '\0') len += 1 + strlen(desc);
+
+  sv = newSV(len + 1);
+  SvPOK_on(sv);
+  p  = SvPVX(sv);
+  *p++ = '>';
+  memcpy(p, name, strlen(name)); p += strlen(name);
+  if(acc[0]  != '\0') { *p++ = ' '; memcpy(p, acc,  strlen(acc));  p += strlen(acc);  }
+  if(desc[0] != '\0') { *p++ = ' '; memcpy(p, desc, strlen(desc)); p += strlen(desc); }
+  *p++ = '\n';
+  w = (textw == -1) ? ESL_MAX(n, 1) : textw;
+  for(pos = 0; pos < n || (textw == -1 && pos == 0); pos += w) { 
+    for(i = pos; i < ESL_MIN(pos + w, n); i++) *p++ = (db->abc != NULL) ? db->abc->sym[(uint8_t) rsq[i]] : rsq[i];
+    *p++ = '\n';
+  }
+  *p = '\0';
+  SvCUR_set(sv, p - SvPVX(sv));
+
+  return sv;
+}
+
+/* Function:  _c_sqdb_fetch_seq_to_fasta_string()
+ * Incept:    Mon Oct 19 01:25:41 2026
+ * Synopsis:  Fetch a sequence from a loaded sequence file, see
+ *            _c_fetch_seq_to_fasta_string().
+ * Args:      db    - BE_SQDB from _c_sqdb_load()
+ *            key   - name or accession of sequence to fetch
+ *            textw - width for each sequence of FASTA record, -1 for unlimited.
+ * Returns:   the sequence in FASTA format.
+ * Dies:      if the sequence doesn't exist or textw is invalid.
+ */
+SV *_c_sqdb_fetch_seq_to_fasta_string(BE_SQDB *db, char *key, int textw)
+{
+  int64_t i;
+
+  if(textw <= 0 && textw != -1) croak("invalid value for textw\n"); 
+  if((i = _c_sqdb_lookup(db, key)) == -1) croak("seq %s not found in loaded sequence file\n", key);
+
+  return _c_sqdb_fasta(db, db->txt + db->name_off[i], db->txt + db->acc_off[i], db->txt + db->desc_off[i], 
+                       db->res + db->off[i], db->L[i], textw);
+}
+
+/* Function:  _c_sqdb_fetch_subseq_to_fasta_string()
+ * Incept:    Mon Oct 19 01:31:12 2026
+ * Synopsis:  Fetch a subsequence from a loaded sequence file, see
+ *            _c_fetch_subseq_to_fasta_string() for the meaning of 
+ *            the arguments: if <given_end> is 0 fetch to the end,
+ *            if <given_start> > <given_end> fetch the reverse 
+ *            complement. Reverse complements are made the same way
+ *            as for a sequence read from the file: with 
+ *            esl_sq_ReverseComplement() in text mode, with the
+ *            alphabet's complements in digital mode.
+ * Returns:   the subsequence in FASTA format, named <newname>.
+ * Dies:      if the sequence doesn't exist, the coordinates are out
+ *            of range, textw is invalid or the sequence can't be 
+ *            reverse complemented.
+ */
+SV *_c_sqdb_fetch_subseq_to_fasta_string(BE_SQDB *db, char *key, char *newname, long given_start, long given_end, int textw, int do_res_revcomp)
+{
+  int      status;
+  int64_t  i, j;
+  int64_t  start, end, n;
+  int      do_revcomp;
+  char    *rsq;
+  char    *buf = NULL;
+  ESL_SQ  *sq  = NULL;
+  SV      *sv;
+
+  if(textw <= 0 && textw != -1) croak("invalid value for textw\n"); 
+  if((i = _c_sqdb_lookup(db, key)) == -1) croak("Failed to fetch subseq: seq %s not found in loaded sequence file", key);
+
+  /* reverse complement indicated by coords, as in _c_fetch_one_subsequence() */
+  if     (given_end != 0 && given_start > given_end) { start = given_end;   end = given_start; do_revcomp = TRUE;  }
+  else if(given_end == given_start && do_res_revcomp) { start = given_end;   end = given_start; do_revcomp = TRUE;  }
+  else                                                { start = given_start; end = given_end;   do_revcomp = FALSE; }
+  if(end == 0) end = db->L[i];
+  if(start < 1 || end > db->L[i] || start > end) croak("Failed to fetch subseq: %s/%ld-%ld is not in 1..%" PRId64, key, given_start, given_end, db->L[i]);
+
+  n   = end - start + 1;
+  rsq = db->res + db->off[i] + start - 1;
+  if(do_revcomp) { 
+    ESL_ALLOC(buf, sizeof(char) * (n + 1));
+    if(db->abc != NULL) { 
+      if(db->abc->complement == NULL) croak("Failed to reverse complement %s; is it a protein?\n", newname);
+      for(j = 0; j < n; j++) buf[j] = (char) db->abc->complement[(uint8_t) rsq[n-1-j]];
+    }
+    else { 
+      memcpy(buf, rsq, n);
+      buf[n] = '\0';
+      if((sq = esl_sq_CreateFrom(newname, buf, NULL, NULL, NULL)) == NULL) goto ERROR;
+      if(esl_sq_ReverseComplement(sq) != eslOK) croak("Failed to reverse complement %s; is it a protein?\n", newname);
+      memcpy(buf, sq->seq, n);
+      esl_sq_Destroy(sq);
+    }
+    rsq = buf;
+  }
+  sv = _c_sqdb_fasta(db, newname, "", "", rsq, n, textw);
+  if(buf) free(buf);
+
+  return sv;
+
+ ERROR:
+  croak("out of memory");
+  return NULL; /* NEVERREACHED */
+}
+
+/* Function:  _c_sqdb_seq_length()
+ * Incept:    Mon Oct 19 01:36:55 2026
+ * Synopsis:  Length of a sequence of a loaded sequence file, by name 
+ *            or accession, see _c_fetch_seq_length_given_name().
+ * Returns:   the length, or -1 if there is no such sequence.
+ */
+long _c_sqdb_seq_length(BE_SQDB *db, char *key)
+{
+  int64_t i = _c_sqdb_lookup(db, key);
+  return (i == -1) ? -1 : (long) db->L[i];
+}
+
+/* Function:  _c_sqdb_nseq()
+ * Incept:    Mon Oct 19 01:38:09 2026
+ * Synopsis:  Number of sequences of a loaded sequence file.
+ */
+long _c_sqdb_nseq(BE_SQDB *db)
+{
+  return (long) db->nseq;
+}
+
+/* Function:  _c_sqdb_nres()
+ * Incept:    Mon Oct 19 01:38:47 2026
+ * Synopsis:  Number of residues of a loaded sequence file, as a 
+ *            string, as _c_nres_ssi() does, so as not to overflow
+ *            a 32-bit integer.
+ */
+SV *_c_sqdb_nres(BE_SQDB *db)
+{
+  char buf[32];
+
+  snprintf(buf, sizeof(buf), "%" PRId64 "", db->nres);
+  return newSVpv(buf, 0);
+}
+
+/* Function:  _c_sqdb_lengths()
+ * Incept:    Mon Oct 19 04:01:37 2026
+ * Synopsis:  Lengths of the sequences of a loaded sequence file, in
+ *            file order, as packed int64, as _c_ssi_lengths() returns.
+ */
+SV *_c_sqdb_lengths(BE_SQDB *db)
+{
+  return newSVpvn((char *) db->L, sizeof(int64_t) * db->nseq);
+}
+
+static int
+_c_int64_cmp_desc(const void *a, const void *b)
+{
+  int64_t x = *((const int64_t *) a);
+  int64_t y = *((const int64_t *) b);
+  return (x > y) ? -1 : ((x < y) ? 1 : 0);
+}
+
+/* Function:  _c_length_stats()
+ * Incept:    Mon Oct 19 04:04:50 2026
+ * Purpose:   Summarize a set of sequence lengths, from _c_ssi_lengths()
+ *            or _c_sqdb_lengths(): count, total, min, max, mean, N50
+ *            (the length L such that sequences of length >= L hold at
+ *            least half of all residues) and L50 (the number of those
+ *            sequences), and a histogram. Histogram bins are <binsize>
+ *            wide, starting at a multiple of <binsize> at or below
+ *            the minimum, if <binsize> > 0; else the range min..max
+ *            is split into <nbins> bins of equal integer width.
+ *
+ * Args:      lenSV   - packed int64 lengths
+ *            binsize - width of histogram bins, or 0 
+ *            nbins   - number of histogram bins, if <binsize> is 0
+ *
+ * Returns:   (on the perl stack) count, total (as a string, as 
+ *            _c_nres_ssi() returns it), min, max, mean, N50, L50, 
+ *            the start of the first bin, the bin width, and the bin
+ *            counts as packed int64; all 0 and an empty histogram if
+ *            there are no lengths.
+ * Dies:      with croak if the histogram would have more than 10
+ *            million bins, or out of memory.
+ */
+void _c_length_stats(SV *lenSV, long binsize, int nbins)
+{
+  Inline_Stack_Vars;
+
+  int      status;
+  STRLEN   nbytes;
+  int64_t *L       = (int64_t *) SvPV(lenSV, nbytes);
+  int64_t  n       = nbytes / sizeof(int64_t);
+  int64_t *sortL   = NULL;
+  int64_t  total   = 0;
+  int64_t  minL    = 0;
+  int64_t  maxL    = 0;
+  int64_t  n50     = 0;
+  int64_t  l50     = 0;
+  int64_t  cum     = 0;
+  int64_t  lo      = 0;
+  int64_t  w       = 1;
+  int64_t  nb      = 0;
+  int64_t  i;
+  SV      *histSV;
+  int64_t *hist;
+  char     buf[32];
+
+  if(nbins < 1 && binsize < 1) croak("_c_length_stats() needs a bin size or a number of bins");
+  if(n > 0) { 
+    minL = maxL = L[0];
+    for(i = 0; i < n; i++) { 
+      total += L[i];
+      if(L[i] < minL) minL = L[i];
+      if(L[i] > maxL) maxL = L[i];
+    }
+    if(binsize > 0) { w = binsize; lo = (minL / w) * w; }
+    else            { w = ESL_MAX(1, (maxL - minL + nbins) / nbins); lo = minL; }
+    nb = (maxL - lo) / w + 1;
+    if(nb > 10000000) croak("_c_length_stats() histogram would have %" PRId64 " bins, use a larger bin size", nb);
+
+    /* N50, L50: longest first, until half of the residues are seen */
+    ESL_ALLOC(sortL, sizeof(int64_t) * n);
+    memcpy(sortL, L, sizeof(int64_t) * n);
+    qsort(sortL, n, sizeof(int64_t), _c_int64_cmp_desc);
+    for(i = 0; i < n; i++) { 
+      cum += sortL[i];
+      if(2 * cum >= total) { n50 = sortL[i]; l50 = i + 1; break; }
+    }
+    free(sortL);
+  }
+
+  histSV = newSV(sizeof(int64_t) * nb + 1);
+  SvPOK_on(histSV);
+  hist = (int64_t *) SvPVX(histSV);
+  for(i = 0; i < nb; i++) hist[i] = 0;
+  for(i = 0; i < n;  i++) hist[(L[i] - lo) / w]++;
+  SvCUR_set(histSV, sizeof(int64_t) * nb);
+  *SvEND(histSV) = '\0';
+  snprintf(buf, sizeof(buf), "%" PRId64 "", total);
+
+  Inline_Stack_Reset;
+  Inline_Stack_Push(sv_2mortal(newSViv(n)));
+  Inline_Stack_Push(sv_2mortal(newSVpv(buf, 0)));
+  Inline_Stack_Push(sv_2mortal(newSViv(minL)));
+  Inline_Stack_Push(sv_2mortal(newSViv(maxL)));
+  Inline_Stack_Push(sv_2mortal(newSVnv((n > 0) ? (double) total / (double) n : 0.)));
+  Inline_Stack_Push(sv_2mortal(newSViv(n50)));
+  Inline_Stack_Push(sv_2mortal(newSViv(l50)));
+  Inline_Stack_Push(sv_2mortal(newSViv(lo)));
+  Inline_Stack_Push(sv_2mortal(newSViv(w)));
+  Inline_Stack_Push(sv_2mortal(histSV));
+  Inline_Stack_Done;
+  Inline_Stack_Return(10);
+  return;
+
+ ERROR:
+  croak("out of memory");
+  return; /* NEVERREACHED */
+}
+
+/* The primary keys of an SSI index, with sequence lengths, read into
+ * memory once by _c_ssi_keys_load() for _c_ssi_keys_check_subseqs(),
+ * sorted by strcmp(), as they are in the index.
+ */
+typedef struct {
+  int64_t  n;         /* number of primary keys */
+  char    *names;     /* '\0' terminated names */
+  int64_t *name_off;  /* [0..i..n-1] offset of key i in <names> */
+  int64_t *L;         /* [0..i..n-1] length of sequence i, 0 if unset */
+} BE_SSIKEYS;
+
+/* one (name, start, end) query, for sorting by name */
+typedef struct { 
+  const char *name;
+  int64_t     idx;    /* index of the query in the caller's list */
+} BE_SUBSEQ_QUERY;
+
+static int
+_c_subseq_query_cmp(const void *a, const void *b)
+{
+  const BE_SUBSEQ_QUERY *qa = (const BE_SUBSEQ_QUERY *) a;
+  const BE_SUBSEQ_QUERY *qb = (const BE_SUBSEQ_QUERY *) b;
+  int                    c  = strcmp(qa->name, qb->name);
+  return (c != 0) ? c : ((qa->idx < qb->idx) ? -1 : (qa->idx > qb->idx) ? 1 : 0);
+}
+
+/* Function:  _c_ssi_keys_free()
+ * Incept:    Mon Oct 19 02:11:26 2026
+ * Synopsis:  Free a BE_SSIKEYS from _c_ssi_keys_load().
+ */
+void _c_ssi_keys_free(BE_SSIKEYS *keys)
+{
+  if(keys == NULL) return;
+  if(keys->names)    free(keys->names);
+  if(keys->name_off) free(keys->name_off);
+  if(keys->L)        free(keys->L);
+  free(keys);
+  return;
+}
+
+/* Function:  _c_ssi_keys_load()
+ * Incept:    Mon Oct 19 02:13:50 2026
+ * Purpose:   Read the primary keys and sequence lengths of the SSI
+ *            index of <sqfp> into memory, in index order, which is
+ *            sorted by name. Keys that aren't in strcmp() order (an
+ *            index written by another tool) are sorted.
+ * Returns:   the new BE_SSIKEYS, as a perl object.
+ * Dies:      if the file has no SSI index, it can't be read, or out
+ *            of memory.
+ */
+SV *_c_ssi_keys_load(ESL_SQFILE *sqfp)
+{
+  int         status;
+  BE_SSIKEYS *keys  = NULL;
+  char       *pkey  = NULL;
+  int64_t     nalloc;
+  int64_t     len;
+  int64_t     i;
+  int         sorted = TRUE;
+
+  if (sqfp->data.ascii.ssi == NULL) croak("sequence file has no SSI information\n"); 
+
+  ESL_ALLOC(keys, sizeof(BE_SSIKEYS));
+  keys->n = sqfp->data.ascii.ssi->nprimary;
+  keys->names = NULL;
+  keys->name_off = NULL;
+  keys->L = NULL;
+  nalloc  = ESL_MAX(4096, keys->n * 16);
+  ESL_ALLOC(keys->names,    sizeof(char)    * nalloc);
+  ESL_ALLOC(keys->name_off, sizeof(int64_t) * ESL_MAX(1, keys->n));
+  ESL_ALLOC(keys->L,        sizeof(int64_t) * ESL_MAX(1, keys->n));
+
+  len = 0;
+  for(i = 0; i < keys->n; i++) { 
+    status = esl_ssi_FindNumber(sqfp->data.ascii.ssi, i, NULL, NULL, NULL, &(keys->L[i]), &pkey);
+    if     (status == eslEMEM)    goto ERROR;
+    else if(status == eslEFORMAT) croak("error fetching sequence num %" PRId64 ", something wrong with SSI index?\n", i);
+    else if(status != eslOK)      croak("error fetching sequence num %" PRId64 "\n", i);
+    while(len + (int64_t) strlen(pkey) + 1 > nalloc) { 
+      nalloc *= 2;
+      ESL_REALLOC(keys->names, sizeof(char) * nalloc);
+    }
+    keys->name_off[i] = len;
+    strcpy(keys->names + len, pkey);
+    len += strlen(pkey) + 1;
+    if(i > 0 && strcmp(keys->names + keys->name_off[i-1], pkey) > 0) sorted = FALSE;
+    free(pkey);
+    pkey = NULL;
+  }
+
+  if(! sorted) { 
+    BE_SUBSEQ_QUERY *tmpA   = NULL;
+    int64_t         *offA   = NULL;
+    int64_t         *LA     = NULL;
+    ESL_ALLOC(tmpA, sizeof(BE_SUBSEQ_QUERY) * keys->n);
+    ESL_ALLOC(offA, sizeof(int64_t) * keys->n);
+    ESL_ALLOC(LA,   sizeof(int64_t) * keys->n);
+    for(i = 0; i < keys->n; i++) { tmpA[i].name = keys->names + keys->name_off[i]; tmpA[i].idx = i; }
+    qsort(tmpA, keys->n, sizeof(BE_SUBSEQ_QUERY), _c_subseq_query_cmp);
+    for(i = 0; i < keys->n; i++) { offA[i] = keys->name_off[tmpA[i].idx]; LA[i] = keys->L[tmpA[i].idx]; }
+    free(keys->name_off);
+    free(keys->L);
+    keys->name_off = offA;
+    keys->L        = LA;
+    free(tmpA);
+  }
+
+  return perl_obj(keys, "BE_SSIKEYS");
+
+ ERROR:
+  croak("out of memory");
+  return NULL; /* NEVERREACHED */
+}
+
+/* Function:  _c_subseq_queries_from_perl()
+ * Incept:    Mon Oct 19 02:20:37 2026
+ * Synopsis:  Read a perl list of [ name, start, end ] array refs into
+ *            <ret_qA> (names point into the perl strings, which the
+ *            caller must not change while it uses them), <ret_startA>
+ *            and <ret_endA>, and the number of queries into <ret_n>.
+ * Dies:      if an element isn't an array ref of at least 3 elements,
+ *            or if out of memory.
+ */
+static void
+_c_subseq_queries_from_perl(AV *queryAR, BE_SUBSEQ_QUERY **ret_qA, long **ret_startA, long **ret_endA, int64_t *ret_n)
+{
+  int              status;
+  int64_t          n = av_len(queryAR) + 1;
+  int64_t          i;
+  SV             **svp;
+  AV              *tupleAV;
+  BE_SUBSEQ_QUERY *qA     = NULL;
+  long            *startA = NULL;
+  long            *endA   = NULL;
+
+  ESL_ALLOC(qA,     sizeof(BE_SUBSEQ_QUERY) * ESL_MAX(1, n));
+  ESL_ALLOC(startA, sizeof(long)            * ESL_MAX(1, n));
+  ESL_ALLOC(endA,   sizeof(long)            * ESL_MAX(1, n));
+  for(i = 0; i < n; i++) { 
+    svp = av_fetch(queryAR, i, 0);
+    if(svp == NULL || (! SvROK(*svp)) || SvTYPE(SvRV(*svp)) != SVt_PVAV || av_len((AV *) SvRV(*svp)) < 2) { 
+      free(qA); free(startA); free(endA);
+      croak("check_subseqs_exist() element %" PRId64 " is not an array ref of [ name, start, end ]", i);
+    }
+    tupleAV     = (AV *) SvRV(*svp);
+    qA[i].name  = SvPV_nolen(*av_fetch(tupleAV, 0, 0));
+    qA[i].idx   = i;
+    startA[i]   = (long) SvIV(*av_fetch(tupleAV, 1, 0));
+    endA[i]     = (long) SvIV(*av_fetch(tupleAV, 2, 0));
+  }
+  *ret_qA     = qA;
+  *ret_startA = startA;
+  *ret_endA   = endA;
+  *ret_n      = n;
+  return;
+
+ ERROR:
+  croak("out of memory");
+}
+
+/* Function:  _c_subseq_status()
+ * Incept:    Mon Oct 19 02:24:03 2026
+ * Synopsis:  Status of subsequence <start>..<end> of a sequence of
+ *            length <L> (-1 if the sequence doesn't exist), as
+ *            check_subseq_exists() decides it.
+ * Returns:   1 if both coordinates are in 1..L, 0 if not, -1 if the
+ *            sequence doesn't exist.
+ */
+static signed char
+_c_subseq_status(int64_t L, long start, long end)
+{
+  if(L == -1) return -1;
+  return (start >= 1 && start <= L && end >= 1 && end <= L) ? 1 : 0;
+}
+
+/* Function:  _c_ssi_keys_check_subseqs()
+ * Incept:    Mon Oct 19 02:27:45 2026
+ * Purpose:   Check a list of subsequences, [ name, start, end ], 
+ *            against the sequence lengths in <keys>, the in-memory
+ *            copy of the SSI index of <sqfp>: the queries are sorted
+ *            by name and merged with the sorted keys, so each query
+ *            costs a share of one pass over the keys instead of an
+ *            SSI lookup. Names that aren't primary keys are looked
+ *            up in the SSI index, where they may be accessions.
+ * Returns:   packed signed chars, one per query, in order: 1 if the
+ *            subsequence exists, 0 if its sequence exists but the 
+ *            coordinates aren't both in 1..L, -1 if the sequence
+ *            doesn't exist.
+ * Dies:      if a query is malformed, the SSI index can't be read, or
+ *            out of memory.
+ */
+SV *_c_ssi_keys_check_subseqs(ESL_SQFILE *sqfp, BE_SSIKEYS *keys, AV *queryAR)
+{
+  int              status;
+  BE_SUBSEQ_QUERY *qA     = NULL;
+  long            *startA = NULL;
+  long            *endA   = NULL;
+  int64_t          n;
+  int64_t          q, k;
+  int64_t          L;
+  int              c;
+  uint16_t         fh;
+  off_t            roff;
+  SV              *statusSV;
+  signed char     *statusA;
+
+  if (sqfp->data.ascii.ssi == NULL) croak("sequence file has no SSI information\n"); 
+  _c_subseq_queries_from_perl(queryAR, &qA, &startA, &endA, &n);
+  qsort(qA, n, sizeof(BE_SUBSEQ_QUERY), _c_subseq_query_cmp);
+
+  statusSV = newSV(n + 1);
+  SvPOK_on(statusSV);
+  statusA  = (signed char *) SvPVX(statusSV);
+
+  for(q = 0, k = 0; q < n; q++) { 
+    c = -1;
+    while(k < keys->n && (c = strcmp(keys->names + keys->name_off[k], qA[q].name)) < 0) k++;
+    if(k < keys->n && c == 0) { 
+      L = keys->L[k];
+    }
+    else { /* not a primary key: maybe an accession */
+      status = esl_ssi_FindName(sqfp->data.ascii.ssi, qA[q].name, &fh, &roff, NULL, &L);
+      if     (status == eslENOTFOUND) L = -1;
+      else if(status == eslEMEM)      croak("out of memory");
+      else if(status == eslEFORMAT)   croak("error fetching sequence name %s, something wrong with SSI index?\n", qA[q].name);
+      else if(status != eslOK)        croak("error fetching sequence name %s\n", qA[q].name);
+    }
+    statusA[qA[q].idx] = _c_subseq_status(L, startA[qA[q].idx], endA[qA[q].idx]);
+  }
+  SvCUR_set(statusSV, n);
+  *SvEND(statusSV) = '\0';
+
+  free(qA);
+  free(startA);
+  free(endA);
+  return statusSV;
+}
+
+/* Function:  _c_sqdb_check_subseqs()
+ * Incept:    Mon Oct 19 02:33:19 2026
+ * Synopsis:  _c_ssi_keys_check_subseqs() for a sequence file loaded
+ *            into memory by _c_sqdb_load(), with its name and 
+ *            accession hashes.
+ * Returns:   packed signed chars, see _c_ssi_keys_check_subseqs().
+ */
+SV *_c_sqdb_check_subseqs(BE_SQDB *db, AV *queryAR)
+{
+  BE_SUBSEQ_QUERY *qA     = NULL;
+  long            *startA = NULL;
+  long            *endA   = NULL;
+  int64_t          n;
+  int64_t          q, i;
+  SV              *statusSV;
+  signed char     *statusA;
+
+  _c_subseq_queries_from_perl(queryAR, &qA, &startA, &endA, &n);
+
+  statusSV = newSV(n + 1);
+  SvPOK_on(statusSV);
+  statusA  = (signed char *) SvPVX(statusSV);
+  for(q = 0; q < n; q++) { 
+    i = _c_sqdb_lookup(db, (char *) qA[q].name);
+    statusA[q] = _c_subseq_status((i == -1) ? -1 : db->L[i], startA[q], endA[q]);
+  }
+  SvCUR_set(statusSV, n);
+  *SvEND(statusSV) = '\0';
+
+  free(qA);
+  free(startA);
+  free(endA);
+  return statusSV;
+}
+
+/* Scoring matrices for _c_score_pssm() are quantized to integers.
+ * When the scale leaves enough resolution (at least BE_PSSM_MINSCALE
+ * units per bit), scores are budgeted so that no sum of W of them,
+ * including the rounding of each, can get past BE_PSSM_MAXQ in either
+ * direction: W * (maxabs * scale + 0.5) <= BE_PSSM_MAXQ. Window scores
+ * then fit in 16 bits and can be computed 16 windows at a time with
+ * SSSE3 byte shuffles, when the alphabet has at most 16 digital codes
+ * we need to score (DNA and RNA). Wider matrices are quantized with
+ * the same budget against BE_PSSM_MAXQ32 and only scored by the 
+ * scalar 32-bit scan.
+ */
+#define BE_PSSM_MAXQ      30000
+#define BE_PSSM_MAXQ32    1073741824 /* 2^30 */
+#define BE_PSSM_SCALE     100.   /* at most, quantized units per bit */
+#define BE_PSSM_MINSCALE  10.    /* at least, for 16-bit window scores */
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <tmmintrin.h>
+#define BE_PSSM_SSSE3 1
+#endif
+
+/* Function:  _c_pssm_scan()
+ * Incept:    Sun Oct 18 19:38:02 2026
+ * Synopsis:  Find the best scoring window of sequence <x> (<L> digital 
+ *            codes, clamped to 0..Kt-1) for quantized scoring matrix
+ *            <qtab> ([0..k..W-1][0..c..Kt-1]), scalar version, for
+ *            either quantization. Ties go to the first window.
+ * Returns:   <ret_best>, best window score, <ret_pos> its first position (0..L-W).
+ */
+static void
+_c_pssm_scan(const int32_t *qtab, int Kt, int W, const uint8_t *x, int64_t L, int *ret_best, int64_t *ret_pos)
+{
+  int64_t i;
+  int     k;
+  int     sc;
+  int     best = -BE_PSSM_MAXQ32 - 1;
+  int64_t pos  = 0;
+
+  for(i = 0; i + W <= L; i++) { 
+    sc = 0;
+    for(k = 0; k < W; k++) sc += qtab[k * Kt + x[i+k]];
+    if(sc > best) { best = sc; pos = i; }
+  }
+  *ret_best = best;
+  *ret_pos  = pos;
+}
+
+#ifdef BE_PSSM_SSSE3
+/* Function:  _c_pssm_scan_ssse3()
+ * Incept:    Sun Oct 18 19:44:27 2026
+ * Synopsis:  SSSE3 version of _c_pssm_scan(), for Kt <= 16: scores
+ *            windows i..i+15 together. For each matrix position k, the 
+ *            16 codes x[i+k..i+k+15] index the low and high bytes of
+ *            the 16-entry score table of k with pshufb, and the 16-bit
+ *            scores are added to two vectors of 8 window scores.
+ *            <lotab> and <hitab> are [0..k..W-1][0..15] low and high 
+ *            bytes of the scores, quantized within BE_PSSM_MAXQ; <x>
+ *            must have 16 readable bytes past x[L-1]. Same results as
+ *            _c_pssm_scan() with the same scores.
+ */
+__attribute__((target("ssse3"))) static void
+_c_pssm_scan_ssse3(const uint8_t *lotab, const uint8_t *hitab, int W, const uint8_t *x, int64_t L, int *ret_best, int64_t *ret_pos)
+{
+  int64_t  i;
+  int64_t  nwin = L - W + 1;
+  int      k, j;
+  int      best = -BE_PSSM_MAXQ - 1;
+  int64_t  pos  = 0;
+  __m128i  acc0, acc1, idx, lo, hi;
+  int16_t  scA[16];
+
+  for(i = 0; i < nwin; i += 16) { 
+    acc0 = _mm_setzero_si128();
+    acc1 = _mm_setzero_si128();
+    for(k = 0; k < W; k++) { 
+      idx  = _mm_loadu_si128((const __m128i *) (x + i + k));
+      lo   = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (lotab + k * 16)), idx);
+      hi   = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (hitab + k * 16)), idx);
+      acc0 = _mm_add_epi16(acc0, _mm_unpacklo_epi8(lo, hi));
+      acc1 = _mm_add_epi16(acc1, _mm_unpackhi_epi8(lo, hi));
+    }
+    _mm_storeu_si128((__m128i *) scA,       acc0);
+    _mm_storeu_si128((__m128i *) (scA + 8), acc1);
+    for(j = 0; j < 16 && i + j < nwin; j++) { 
+      if(scA[j] > best) { best = scA[j]; pos = i + j; }
+    }
+  }
+  *ret_best = best;
+  *ret_pos  = pos;
+}
+#endif
+
+/* Function:  _c_pssm_window_score()
+ * Incept:    Sun Oct 18 19:49:13 2026
+ * Synopsis:  Exact score, in bits, of the window of <x> starting at
+ *            <pos> with (unquantized) score table <tab>.
+ */
+static double
+_c_pssm_window_score(const double *tab, int Kt, int W, const uint8_t *x, int64_t pos)
+{
+  double sc = 0.;
+  int    k;
+
+  for(k = 0; k < W; k++) sc += tab[k * Kt + x[pos+k]];
+  return sc;
+}
+
+/* Function:  _c_score_pssm()
+ * Incept:    Sun Oct 18 19:53:40 2026
+ * Purpose:   Score every sequence of <sqfp>, from the start of the
+ *            file, with a position-specific scoring matrix (see
+ *            Bio::Easel::MSA::build_pssm()), ungapped: find the
+ *            window of <W> residues with the highest score, the sum
+ *            of the scores of its residues at the matrix's positions,
+ *            in bits, optionally on both strands.
+ *
+ *            Degenerate residues score the average of the residues
+ *            they stand for, anything else (gaps, unknown residues,
+ *            other characters) the average of all residues.
+ *
+ *            Windows are compared with scores quantized to integers,
+ *            at up to 0.01 bits: 16-bit window scores, with SSSE3
+ *            instructions when <use_simd> is TRUE, the CPU has them
+ *            and the alphabet is DNA or RNA, unless the matrix is too
+ *            wide to keep BE_PSSM_MINSCALE units per bit in 16 bits,
+ *            then 32-bit scores; the best window's score is then
+ *            recomputed exactly. 
+ *            Sequences shorter than <W> are skipped. Reports progress,
+ *            in bytes of the file read, to the callback set with
+ *            Bio::Easel->set_progress_callback(). The file is rewound
+ *            at the end.
+ *
+ * Args:      sqfp:         open ESL_SQFILE, not a stream or gzipped
+ *            pssm:         [0..k..W-1][0..a..K-1] packed native double scores
+ *            W:            matrix width
+ *            alphabet:     "RNA", "DNA" or "amino"
+ *            both_strands: TRUE to score the reverse complement too
+ *            do_min:       TRUE to only return sequences scoring >= <min_score>
+ *            min_score:    see <do_min>
+ *            use_simd:     FALSE to always use the scalar scan
+ *
+ * Returns:   (on the perl stack) for each sequence: name, best score,
+ *            start and end of the best window (1..L), with start > end
+ *            if it's on the reverse complement.
+ * Dies:      with croak upon an error, with "score_pssm cancelled"
+ *            if cancelled.
+ */
+void _c_score_pssm(ESL_SQFILE *sqfp, SV *pssm, int W, char *alphabet, int both_strands, int do_min, double min_score, int use_simd)
+{
+  Inline_Stack_Vars;
+
+  int           status;
+  int           type;
+  ESL_ALPHABET *abc    = NULL;
+  ESL_SQ       *sq     = NULL;
+  STRLEN        len;
+  double       *pssmA;
+  int           K, Kt;          /* alphabet size, number of codes scored (0..Kt-1, Kt-1 is unknown) */
+  int           nstrands;
+  int           s;              /* strand, 0 top, 1 reverse complement */
+  double       *tabA[2]  = { NULL, NULL };   /* [s][0..k..W-1][0..c..Kt-1] score of code c at position k */
+  int32_t      *qtabA[2] = { NULL, NULL };   /* tabA, quantized */
+  uint8_t      *lotabA[2] = { NULL, NULL };  /* [s][0..k..W-1][0..15] low byte of qtabA, for SSSE3 */
+  uint8_t      *hitabA[2] = { NULL, NULL };  /* [s][0..k..W-1][0..15] high byte of qtabA, for SSSE3 */
+  double        maxabs = 0.;
+  double        scale;
+  int           use16;          /* TRUE if window scores fit in 16 bits */
+  double        avg;
+  uint8_t      *x      = NULL;  /* codes of the current sequence, clamped to 0..Kt-1 */
+  int64_t       xalloc = 0;
+  int64_t       i;
+  int           k, c, a, n;
+  int           use_ssse3 = FALSE;
+  int           qbest;
+  int64_t       qpos;
+  double        sc, best_sc;
+  int64_t       best_start, best_end;
+  int           nret = 0;
+  int64_t       nseq = 0;
+  BE_PROGRESS   prg;
+  struct stat   st;
+
+  if((type = esl_abc_EncodeType(alphabet)) == eslUNKNOWN) croak("_c_score_pssm() unknown alphabet %s", alphabet);
+  if(both_strands && type == eslAMINO) croak("_c_score_pssm() can't score both strands of protein sequences");
+  if((abc = esl_alphabet_Create(type)) == NULL) croak("_c_score_pssm() unable to create alphabet");
+  K     = abc->K;
+  Kt    = abc->Kp - 2; /* up to the unknown residue, the last two codes are nonresidue and missing data */
+  pssmA = (double *) SvPV(pssm, len);
+  if(W <= 0 || len != sizeof(double) * W * K) croak("_c_score_pssm() matrix is the wrong size");
+  if(sqfp->do_digital && sqfp->abc->K != K) croak("_c_score_pssm() sequence file and matrix alphabets differ");
+  nstrands = (both_strands) ? 2 : 1;
+
+  /* score tables, for every code we score */
+  for(s = 0; s < nstrands; s++) { 
+    ESL_ALLOC(tabA[s],   sizeof(double)  * W * Kt);
+    ESL_ALLOC(qtabA[s],  sizeof(int32_t) * W * Kt);
+    ESL_ALLOC(lotabA[s], sizeof(uint8_t) * W * 16);
+    ESL_ALLOC(hitabA[s], sizeof(uint8_t) * W * 16);
+  }
+  for(k = 0; k < W; k++) { 
+    avg = 0.;
+    for(a = 0; a < K; a++) avg += pssmA[k * K + a] / (double) K;
+    for(c = 0; c < Kt; c++) { 
+      if(c < K) { 
+        tabA[0][k * Kt + c] = pssmA[k * K + c];
+      }
+      else if(c > K && c < Kt-1) { /* degenerate residue */
+        tabA[0][k * Kt + c] = 0.;
+        for(a = 0, n = 0; a < K; a++) { 
+          if(abc->degen[c][a]) { tabA[0][k * Kt + c] += pssmA[k * K + a]; n++; }
+        }
+        tabA[0][k * Kt + c] /= (double) ESL_MAX(1, n);
+      }
+      else { /* gap or unknown */
+        tabA[0][k * Kt + c] = avg;
+      }
+      maxabs = ESL_MAX(maxabs, fabs(tabA[0][k * Kt + c]));
+    }
+  }
+  /* reverse complement: position k of the matrix pairs with the complement of the residue W-1-k positions along */
+  if(both_strands) { 
+    for(k = 0; k < W; k++) { 
+      for(c = 0; c < Kt; c++) { 
+        tabA[1][k * Kt + c] = tabA[0][(W-1-k) * Kt + ESL_MIN(abc->complement[c], Kt-1)];
+      }
+    }
+  }
+  /* quantization: no window can sum past BE_PSSM_MAXQ (or MAXQ32), rounding included */
+  if(maxabs == 0.) maxabs = 1.;
+  scale = ESL_MIN(BE_PSSM_SCALE, ((double) BE_PSSM_MAXQ / (double) W - 0.5) / maxabs);
+  use16 = (scale >= BE_PSSM_MINSCALE) ? TRUE : FALSE;
+  if(! use16) { 
+    scale = ESL_MIN(BE_PSSM_SCALE, ((double) BE_PSSM_MAXQ32 / (double) W - 0.5) / maxabs);
+    if(scale <= 0.) croak("_c_score_pssm() matrix is too wide (%d positions)", W);
+  }
+  for(s = 0; s < nstrands; s++) { 
+    memset(lotabA[s], 0, W * 16);
+    memset(hitabA[s], 0, W * 16);
+    for(i = 0; i < (int64_t) W * Kt; i++) { 
+      sc = tabA[s][i] * scale;
+      qtabA[s][i] = (int32_t) ((sc >= 0.) ? sc + 0.5 : sc - 0.5);
+    }
+    if(use16 && Kt <= 16) { 
+      for(k = 0; k < W; k++) { 
+        for(c = 0; c < Kt; c++) { 
+          lotabA[s][k * 16 + c] = (uint8_t) ( (uint16_t) qtabA[s][k * Kt + c]       & 0xff);
+          hitabA[s][k * 16 + c] = (uint8_t) (((uint16_t) qtabA[s][k * Kt + c] >> 8) & 0xff);
+        }
+      }
+    }
+  }
+#ifdef BE_PSSM_SSSE3
+  use_ssse3 = (use_simd && use16 && Kt <= 16 && __builtin_cpu_supports("ssse3")) ? TRUE : FALSE;
+#endif
+
+  /* progress is in bytes read, unknown for a stream or gzipped file */
+  _c_progress_start(&prg, "score_pssm", (stat(sqfp->filename, &st) == 0) ? (int64_t) st.st_size : 0);
+
+  if(esl_sqfile_Position(sqfp, 0) != eslOK) croak("_c_score_pssm() unable to rewind sequence file %s", sqfp->filename);
+  if(sqfp->do_digital) sq = esl_sq_CreateDigital(sqfp->abc);
+  else                 sq = esl_sq_Create();
+
+  Inline_Stack_Reset;
+  while((status = esl_sqio_Read(sqfp, sq)) == eslOK) { 
+    nseq++;
+    if(sq->n >= W) { 
+      if(sq->n + 16 > xalloc) { 
+        xalloc = sq->n + 16;
+        ESL_REALLOC(x, sizeof(uint8_t) * xalloc);
+      }
+      for(i = 0; i < sq->n; i++) { 
+        c = (sq->dsq != NULL) ? sq->dsq[i+1] : abc->inmap[(int) (sq->seq[i] & 0x7f)];
+        x[i] = (uint8_t) ((c >= Kt) ? Kt-1 : c); /* includes eslDSQ_ILLEGAL and eslDSQ_IGNORED */
+      }
+      memset(x + sq->n, 0, 16); /* read, but never scored, by _c_pssm_scan_ssse3() */
+
+      best_sc    = 0.;
+      best_start = best_end = 0;
+      for(s = 0; s < nstrands; s++) { 
+#ifdef BE_PSSM_SSSE3
+        if(use_ssse3) _c_pssm_scan_ssse3(lotabA[s], hitabA[s], W, x, sq->n, &qbest, &qpos);
+        else
+#endif
+        _c_pssm_scan(qtabA[s], Kt, W, x, sq->n, &qbest, &qpos);
+        sc = _c_pssm_window_score(tabA[s], Kt, W, x, qpos);
+        if(s == 0 || sc > best_sc) { 
+          best_sc    = sc;
+          best_start = (s == 0) ? qpos + 1 : qpos + W;
+          best_end   = (s == 0) ? qpos + W : qpos + 1;
+        }
+      }
+      if((! do_min) || best_sc >= min_score) { 
+        Inline_Stack_Push(sv_2mortal(newSVpv(sq->name, 0)));
+        Inline_Stack_Push(sv_2mortal(newSVnv(best_sc)));
+        Inline_Stack_Push(sv_2mortal(newSViv((IV) best_start)));
+        Inline_Stack_Push(sv_2mortal(newSViv((IV) best_end)));
+        nret++;
+      }
+    }
+    if(prg.cb != NULL && (nseq % 1000) == 0) { 
+      prg.done = ESL_MIN((int64_t) sq->roff, prg.total);
+      if(_c_progress_poll(&prg)) break;
+    }
+    esl_sq_Reuse(sq);
+  }
+  if(! _c_progress_cancelled(&prg)) { 
+    if     (status == eslEFORMAT) croak("Parse failed (sequence file %s):\n%s\n", sqfp->filename, esl_sqfile_GetErrorBuf(sqfp));
+    else if(status != eslEOF)     croak("Unexpected error %d reading sequence file %s", status, sqfp->filename);
+    prg.done = prg.total;
+  }
+  Inline_Stack_Done;
+
+  esl_sqfile_Position(sqfp, 0); /* rewind b/c we're at the end of the file */
+  for(s = 0; s < 2; s++) { 
+    if(tabA[s])   free(tabA[s]);
+    if(qtabA[s])  free(qtabA[s]);
+    if(lotabA[s]) free(lotabA[s]);
+    if(hitabA[s]) free(hitabA[s]);
+  }
+  if(x) free(x);
+  esl_sq_Destroy(sq);
+  esl_alphabet_Destroy(abc);
+  _c_progress_finish(&prg); /* dies if cancelled */
+  Inline_Stack_Return(nret * 4);
+  return;
+
+ ERROR:
+  croak("out of memory");
+  return; /* NEVERREACHED */
+}
+
+/* Residue composition of sequence files, for _c_composition_stats():
+ * the bytes of each sequence are counted in a 256 bin histogram, then
+ * folded into residue counts with a table from byte to digital code.
+ * Histograms are counted in four interleaved tables, so runs of one
+ * character (poly-A, the N gaps of assemblies) don't serialize on a
+ * single counter.
+ *
+ * FASTA files are split into byte ranges that are scanned in parallel,
+ * each counting only its own bytes, so a chromosome is spread over many
+ * ranges. A range that doesn't start at the start of a line keeps the
+ * bytes up to the first newline (its "lead") apart, since only earlier
+ * ranges know if that line is a header; sequence bytes before its first
+ * header (its "pre") belong to the last record of an earlier range. Both
+ * are added to the right record once all ranges are done, in order.
+ */
+#define BE_COMP_IGNORED  254   /* byte class: not part of the sequence (whitespace, digits) */
+#define BE_COMP_ILLEGAL  255   /* byte class: not a symbol of the alphabet */
+#define BE_COMP_BLOCK    (1 << 20)
+#define BE_COMP_LEAD     -2    /* histogram destinations, other than a record */
+#define BE_COMP_PRE      -1
+
+/* per sequence results; counts of the K canonical residues are in a separate flat array */
+typedef struct {
+  char    *name;
+  int64_t  len;        /* characters, other than whitespace and digits */
+  int64_t  ambig;      /* degenerate and unknown residues */
+  int64_t  soft;       /* lower case residues */
+  int64_t  other;      /* gaps, nonresidues, missing data and illegal characters */
+} BE_COMP_REC;
+
+/* results of one byte range (or of the whole file, read serially) */
+typedef struct {
+  BE_COMP_REC *recA;            /* records whose '>' is in the range, in order */
+  int64_t     *cntA;            /* [0..r..nrec-1][0..a..K-1] residue counts of record r */
+  int64_t      nrec;
+  int64_t      nalloc;
+  uint64_t     tot[256];        /* histogram of the bytes counted in recA */
+  uint64_t     lead[256];       /* histogram of the lead, see above */
+  uint64_t     pre[256];        /* histogram of the pre, see above */
+  int          line_start;      /* TRUE if the range starts at the start of a line */
+  int          has_nl;          /* TRUE if the range has a newline (ends its lead) */
+  int          ends_in_header;  /* TRUE if the range ends inside a header line */
+  int          status;          /* eslOK, eslEMEM, or eslESYS if the file can't be read */
+} BE_COMP_CHUNK;
+
+typedef struct {
+  const ESL_ALPHABET *abc;
+  const char         *filename;
+  uint8_t             cls[256];   /* byte to digital code, or BE_COMP_IGNORED/BE_COMP_ILLEGAL */
+  int64_t             fsize;
+  int64_t             nchunks;
+  BE_COMP_CHUNK      *chunkA;     /* [0..nchunks-1] */
+  BE_PROGRESS        *prg;
+} COMP_SCAN_ARG;
+
+/* Function:  _c_comp_hist_add()
+ * Incept:    Mon Oct 19 02:52:30 2026
+ * Synopsis:  Add the <n> bytes <s> to the four interleaved histograms <h4>.
+ */
+static void
+_c_comp_hist_add(uint64_t h4[4][256], const uint8_t *s, int64_t n)
+{
+  int64_t i = 0;
+
+  for(; i + 4 <= n; i += 4) { 
+    h4[0][s[i]]++;
+    h4[1][s[i+1]]++;
+    h4[2][s[i+2]]++;
+    h4[3][s[i+3]]++;
+  }
+  for(; i < n; i++) h4[0][s[i]]++;
+}
+
+/* Function:  _c_comp_fold()
+ * Incept:    Mon Oct 19 02:55:08 2026
+ * Synopsis:  Add the counts of byte histogram <hist> to record <rec>
+ *            and its residue counts <cnt>.
+ */
+static void
+_c_comp_fold(const COMP_SCAN_ARG *arg, const uint64_t *hist, BE_COMP_REC *rec, int64_t *cnt)
+{
+  int      c;
+  uint8_t  x;
+  uint64_t n;
+
+  for(c = 0; c < 256; c++) { 
+    if((n = hist[c]) == 0) continue;
+    x = arg->cls[c];
+    if(x == BE_COMP_IGNORED) continue;
+    rec->len += n;
+    if(x == BE_COMP_ILLEGAL || ! esl_abc_XIsResidue(arg->abc, x)) { rec->other += n; continue; }
+    if(x < arg->abc->K) cnt[x]     += n;
+    else                rec->ambig += n;
+    if(islower(c))      rec->soft  += n;
+  }
+}
+
+/* Function:  _c_comp_flush()
+ * Incept:    Mon Oct 19 02:58:41 2026
+ * Synopsis:  Empty histograms <h4> into destination <dest> of chunk
+ *            <ck>: record <dest>, or its BE_COMP_LEAD or BE_COMP_PRE
+ *            histogram.
+ */
+static void
+_c_comp_flush(const COMP_SCAN_ARG *arg, BE_COMP_CHUNK *ck, uint64_t h4[4][256], int64_t dest)
+{
+  uint64_t hist[256];
+  int      c;
+
+  for(c = 0; c < 256; c++) hist[c] = h4[0][c] + h4[1][c] + h4[2][c] + h4[3][c];
+  memset(h4, 0, sizeof(uint64_t) * 4 * 256);
+  if(dest == BE_COMP_LEAD) { for(c = 0; c < 256; c++) ck->lead[c] += hist[c]; return; }
+  if(dest == BE_COMP_PRE)  { for(c = 0; c < 256; c++) ck->pre[c]  += hist[c]; return; }
+  for(c = 0; c < 256; c++) ck->tot[c] += hist[c];
+  _c_comp_fold(arg, hist, &(ck->recA[dest]), ck->cntA + dest * arg->abc->K);
+}
+
+/* Function:  _c_comp_rec_new()
+ * Incept:    Mon Oct 19 03:00:19 2026
+ * Synopsis:  Add a new, empty record named <name> (<nlen> bytes, not
+ *            '\0' terminated) to <ck>.
+ * Returns:   eslOK, or eslEMEM if out of memory.
+ */
+static int
+_c_comp_rec_new(const COMP_SCAN_ARG *arg, BE_COMP_CHUNK *ck, const char *name, int64_t nlen)
+{
+  int          status;
+  int          K = arg->abc->K;
+  BE_COMP_REC *rec;
+
+  if(ck->nrec == ck->nalloc) { 
+    ck->nalloc = (ck->nalloc == 0) ? 256 : ck->nalloc * 2;
+    ESL_REALLOC(ck->recA, sizeof(BE_COMP_REC) * ck->nalloc);
+    ESL_REALLOC(ck->cntA, sizeof(int64_t) * ck->nalloc * K);
+  }
+  rec = &(ck->recA[ck->nrec]);
+  rec->name = NULL;
+  rec->len  = rec->ambig = rec->soft = rec->other = 0;
+  memset(ck->cntA + ck->nrec * K, 0, sizeof(int64_t) * K);
+  ck->nrec++;
+  ESL_ALLOC(rec->name, sizeof(char) * (nlen + 1));
+  memcpy(rec->name, name, nlen);
+  rec->name[nlen] = '\0';
+  return eslOK;
+
+ ERROR:
+  return eslEMEM;
+}
+
+/* Function:  _c_comp_scan_task()
+ * Incept:    Mon Oct 19 03:01:44 2026
+ * Synopsis:  Task function for _c_threads_parallel_for_progress():
+ *            scan byte ranges [start..end-1] of a FASTA file, range c
+ *            being bytes [c*fsize/nchunks, (c+1)*fsize/nchunks), see
+ *            above. A header line that crosses the end of the range
+ *            is read to its end, for its name.
+ */
+static void
+_c_comp_scan_task(void *varg, int64_t start, int64_t end, int tid)
+{
+  COMP_SCAN_ARG *arg = (COMP_SCAN_ARG *) varg;
+  BE_COMP_CHUNK *ck  = NULL;
+  int64_t        ci;
+  int64_t        cstart, cend;
+  int64_t        off, lim;
+  int64_t        dest;
+  ssize_t        nread;
+  int            fd = -1;
+  uint8_t       *buf  = NULL;
+  char          *name = NULL;
+  char          *tmp;
+  int64_t        nlen, nalloc;
+  uint64_t     (*h4)[256] = NULL;
+  const uint8_t *p, *e, *ce, *nl;
+  uint8_t        b;
+  int            at_line_start, in_header, name_done, done;
+
+  nalloc = 256;
+  if((buf  = malloc(BE_COMP_BLOCK))                  == NULL) goto ERROR;
+  if((h4   = calloc(4, sizeof(uint64_t) * 256))      == NULL) goto ERROR;
+  if((name = malloc(nalloc))                         == NULL) goto ERROR;
+  if((fd   = open(arg->filename, O_RDONLY))          <  0)    { arg->chunkA[start].status = eslESYS; goto CLEANUP; }
+
+  for(ci = start; ci < end; ci++) { 
+    if(arg->prg != NULL && _c_progress_cancelled(arg->prg)) break;
+    ck     = &(arg->chunkA[ci]);
+    cstart = (arg->fsize * ci)     / arg->nchunks;
+    cend   = (arg->fsize * (ci+1)) / arg->nchunks;
+    if(cstart > 0) { 
+      if(pread(fd, &b, 1, cstart - 1) != 1) { ck->status = eslESYS; goto CLEANUP; }
+      ck->line_start = (b == '\n') ? TRUE : FALSE;
+    }
+    else ck->line_start = TRUE;
+    dest          = (ck->line_start) ? BE_COMP_PRE : BE_COMP_LEAD;
+    at_line_start = ck->line_start;
+    in_header = name_done = done = FALSE;
+    nlen = 0;
+    off  = cstart;
+
+    while(! done) { 
+      lim = (in_header) ? BE_COMP_BLOCK : ESL_MIN(BE_COMP_BLOCK, cend - off);
+      if(lim <= 0) break;
+      if((nread = pread(fd, buf, lim, off)) < 0) { ck->status = eslESYS; goto CLEANUP; }
+      if(nread == 0) break; /* EOF */
+      p  = buf;
+      e  = buf + nread;
+      ce = buf + ESL_MIN(nread, ESL_MAX(0, cend - off)); /* end of the range's bytes in buf */
+      while(p < e) { 
+        if(in_header) { 
+          nl = memchr(p, '\n', e - p);
+          for(; ! name_done && p < ((nl != NULL) ? nl : e); p++) { 
+            if(isspace(*p)) { name_done = TRUE; break; }
+            if(nlen == nalloc) { 
+              nalloc *= 2;
+              if((tmp = realloc(name, nalloc)) == NULL) goto ERROR;
+              name = tmp;
+            }
+            name[nlen++] = (char) *p;
+          }
+          if(nl == NULL) { p = e; break; }
+          if(_c_comp_rec_new(arg, ck, name, nlen) != eslOK) goto ERROR;
+          dest      = ck->nrec - 1;
+          in_header = FALSE;
+          if(off + (nl - buf) >= cend) { ck->ends_in_header = TRUE; done = TRUE; break; }
+          at_line_start = TRUE;
+          p = nl + 1;
+          continue;
+        }
+        if(p >= ce) { done = TRUE; break; } /* read past cend for a header */
+        if(dest == BE_COMP_LEAD) { 
+          nl = memchr(p, '\n', ce - p);
+          _c_comp_hist_add(h4, p, ((nl != NULL) ? nl : ce) - p);
+          if(nl == NULL) { p = ce; continue; }
+          _c_comp_flush(arg, ck, h4, BE_COMP_LEAD);
+          ck->has_nl    = TRUE;
+          dest          = BE_COMP_PRE;
+          at_line_start = TRUE;
+          p = nl + 1;
+          continue;
+        }
+        if(at_line_start && *p == '>') { 
+          _c_comp_flush(arg, ck, h4, dest);
+          in_header = TRUE;
+          name_done = FALSE;
+          nlen      = 0;
+          p++;
+          continue;
+        }
+        nl = memchr(p, '\n', ce - p);
+        _c_comp_hist_add(h4, p, ((nl != NULL) ? nl : ce) - p);
+        if(nl == NULL) { at_line_start = FALSE; p = ce; }
+        else           { at_line_start = TRUE;  p = nl + 1; }
+      }
+      if(arg->prg != NULL) _c_progress_add(arg->prg, ESL_MIN(cend, off + nread) - ESL_MIN(cend, off));
+      off += nread;
+    }
+    if(in_header) { /* header without a newline at the end of the file */
+      if(_c_comp_rec_new(arg, ck, name, nlen) != eslOK) goto ERROR;
+      dest = ck->nrec - 1;
+      ck->ends_in_header = TRUE;
+    }
+    _c_comp_flush(arg, ck, h4, dest);
+  }
+  goto CLEANUP;
+
+ ERROR:
+  if(ck != NULL) ck->status = eslEMEM;
+  else           arg->chunkA[start].status = eslEMEM;
+ CLEANUP:
+  if(fd >= 0) close(fd);
+  if(buf)  free(buf);
+  if(name) free(name);
+  if(h4)   free(h4);
+}
+
+/* Function:  _c_comp_read_serial()
+ * Incept:    Mon Oct 19 03:09:57 2026
+ * Synopsis:  Count the composition of every sequence of <filename>,
+ *            format <format>, reading it with its own text mode 
+ *            ESL_SQFILE (so case is kept), into chunk <ck>, for files 
+ *            _c_comp_scan_task() can't split (not FASTA, gzipped).
+ * Returns:   eslOK on success, eslEMEM if out of memory, eslEFORMAT
+ *            (with the message in <errbuf>) if the file can't be 
+ *            parsed, eslFAIL if cancelled.
+ */
+static int
+_c_comp_read_serial(COMP_SCAN_ARG *arg, BE_COMP_CHUNK *ck, const char *filename, int format, char *errbuf)
+{
+  int          status;
+  ESL_SQFILE  *tfp = NULL;
+  ESL_SQ      *sq  = NULL;
+  uint64_t   (*h4)[256] = NULL;
+
+  ck->line_start = TRUE;
+  if(esl_sqfile_Open(filename, format, NULL, &tfp) != eslOK) { 
+    snprintf(errbuf, eslERRBUFSIZE, "unable to open %s", filename);
+    return eslEFORMAT;
+  }
+  if((sq = esl_sq_Create())                     == NULL) { status = eslEMEM; goto CLEANUP; }
+  if((h4 = calloc(4, sizeof(uint64_t) * 256))   == NULL) { status = eslEMEM; goto CLEANUP; }
+  while((status = esl_sqio_Read(tfp, sq)) == eslOK) { 
+    if(_c_comp_rec_new(arg, ck, sq->name, strlen(sq->name)) != eslOK) { status = eslEMEM; goto CLEANUP; }
+    _c_comp_hist_add(h4, (const uint8_t *) sq->seq, sq->n);
+    _c_comp_flush(arg, ck, h4, ck->nrec - 1);
+    if(arg->prg->cb != NULL && (ck->nrec % 1000) == 0) { 
+      arg->prg->done = ESL_MIN((int64_t) sq->roff, arg->prg->total);
+      if(_c_progress_poll(arg->prg)) { status = eslFAIL; goto CLEANUP; }
+    }
+    esl_sq_Reuse(sq);
+  }
+  if     (status == eslEOF)     status = eslOK;
+  else if(status == eslEFORMAT) snprintf(errbuf, eslERRBUFSIZE, "Parse failed (sequence file %s):\n%s", filename, esl_sqfile_GetErrorBuf(tfp));
+  else                          snprintf(errbuf, eslERRBUFSIZE, "Unexpected error %d reading sequence file %s", status, filename);
+
+ CLEANUP:
+  if(h4) free(h4);
+  if(sq) esl_sq_Destroy(sq);
+  esl_sqfile_Close(tfp);
+  return status;
+}
+
+/* Function:  _c_comp_chunks_free()
+ * Incept:    Mon Oct 19 03:12:02 2026
+ * Synopsis:  Free the chunks of <arg>, and their records.
+ */
+static void
+_c_comp_chunks_free(COMP_SCAN_ARG *arg)
+{
+  int64_t ci, r;
+
+  for(ci = 0; ci < arg->nchunks; ci++) { 
+    for(r = 0; r < arg->chunkA[ci].nrec; r++) free(arg->chunkA[ci].recA[r].name);
+    if(arg->chunkA[ci].recA) free(arg->chunkA[ci].recA);
+    if(arg->chunkA[ci].cntA) free(arg->chunkA[ci].cntA);
+  }
+  free(arg->chunkA);
+  arg->chunkA = NULL;
+}
+
+/* Function:  _c_composition_stats()
+ * Incept:    Mon Oct 19 03:15:21 2026
+ * Purpose:   Count the residues of every sequence of the file of
+ *            <sqfp>: each canonical residue of the alphabet, 
+ *            ambiguous (degenerate and unknown) residues, soft-masked
+ *            (lower case) residues, and everything else (gaps, 
+ *            nonresidues, missing data, illegal characters); and the
+ *            GC fraction of the canonical residues, for DNA and RNA.
+ *            Whitespace and digits aren't counted. Uncompressed FASTA
+ *            files are read in parallel byte ranges, with their own
+ *            file descriptors, other files serially with their own
+ *            text mode ESL_SQFILE: <sqfp> isn't read or moved. Reports
+ *            progress, in bytes of the file read, to the callback set
+ *            with Bio::Easel->set_progress_callback().
+ *
+ * Args:      sqfp     - open ESL_SQFILE
+ *            alphabet - "RNA", "DNA" or "amino", or "" for the 
+ *                       alphabet of <sqfp> if it is digital, else
+ *                       guessed from the file
+ *
+ * Returns:   (on the perl stack) alphabet name, the K canonical 
+ *            residues, all Kp symbols of the alphabet, then per
+ *            sequence in file order: names, each followed by '\0';
+ *            lengths, nseq packed int64; residue counts, nseq * K
+ *            packed int64; ambiguous, soft-masked and other counts,
+ *            nseq packed int64 each; GC fractions, nseq packed 
+ *            doubles (undef for protein); then totals, Kp + 2 packed
+ *            int64: count of each symbol, illegal characters and 
+ *            soft-masked residues.
+ * Dies:      with croak upon an error, with "composition_stats
+ *            cancelled" if cancelled.
+ */
+void _c_composition_stats(ESL_SQFILE *sqfp, char *alphabet)
+{
+  Inline_Stack_Vars;
+
+  int            status;
+  int            type = eslUNKNOWN;
+  ESL_ALPHABET  *abc  = NULL;
+  ESL_SQFILE    *gfp  = NULL;
+  COMP_SCAN_ARG  arg;
+  BE_COMP_CHUNK *ck;
+  BE_COMP_CHUNK *cur_ck = NULL;   /* chunk of the last record seen, while merging */
+  BE_COMP_REC   *rec;
+  BE_PROGRESS    prg;
+  struct stat    st;
+  char           errbuf[eslERRBUFSIZE];
+  int            nthreads = 1;
+  int            do_split;
+  int            in_header;
+  int64_t        nseq, ci, r, i;
+  int            K, c, a;
+  uint64_t       tot[256];
+  SV            *namesSV, *lenSV, *cntSV, *ambigSV, *softSV, *otherSV, *gcSV, *totSV;
+  int64_t       *lenp, *cntp, *ambigp, *softp, *otherp, *totp;
+  double        *gcp = NULL;
+  int64_t        at, cg;
+
+  /* the alphabet */
+  if(alphabet[0] != '\0') { 
+    if((type = esl_abc_EncodeType(alphabet)) == eslUNKNOWN) croak("_c_composition_stats() unknown alphabet %s", alphabet);
+  }
+  else if(sqfp->do_digital) type = sqfp->abc->type;
+  else { 
+    if(esl_sqfile_Open(sqfp->filename, sqfp->format, NULL, &gfp) != eslOK) croak("_c_composition_stats() unable to open %s", sqfp->filename);
+    status = esl_sqfile_GuessAlphabet(gfp, &type);
+    esl_sqfile_Close(gfp);
+    if     (status == eslENOALPHABET) croak("Couldn't guess alphabet from first sequence in %s", sqfp->filename);
+    else if(status == eslENODATA)     croak("Sequence file %s contains no data?", sqfp->filename);
+    else if(status != eslOK)          croak("Failed to guess alphabet of %s (error code %d)", sqfp->filename, status);
+  }
+  if((abc = esl_alphabet_Create(type)) == NULL) croak("_c_composition_stats() unable to create alphabet");
+  K = abc->K;
+
+  /* byte classes */
+  arg.abc      = abc;
+  arg.filename = sqfp->filename;
+  arg.prg      = &prg;
+  for(c = 0; c < 256; c++) { 
+    if     (c < 128 && (isspace(c) || isdigit(c)))           arg.cls[c] = BE_COMP_IGNORED;
+    else if(c < 128 && esl_abc_XIsValid(abc, abc->inmap[c])) arg.cls[c] = abc->inmap[c];
+    else                                                      arg.cls[c] = BE_COMP_ILLEGAL;
+  }
+
+  arg.fsize = (stat(sqfp->filename, &st) == 0) ? (int64_t) st.st_size : 0;
+  do_split  = (sqfp->format == eslSQFILE_FASTA && ! sqfp->data.ascii.do_gzip && ! sqfp->data.ascii.do_stdin && arg.fsize > 0) ? TRUE : FALSE;
+  if(do_split && arg.fsize > 4e6) nthreads = _c_threads_n();
+  arg.nchunks = (do_split) ? ESL_MAX(1, ESL_MIN((int64_t) nthreads * 8, arg.fsize / BE_COMP_BLOCK + 1)) : 1;
+  ESL_ALLOC(arg.chunkA, sizeof(BE_COMP_CHUNK) * arg.nchunks);
+  memset(arg.chunkA, 0, sizeof(BE_COMP_CHUNK) * arg.nchunks);
+  for(ci = 0; ci < arg.nchunks; ci++) arg.chunkA[ci].status = eslOK;
+
+  _c_progress_start(&prg, "composition_stats", arg.fsize);
+  if(do_split) { 
+    _c_threads_parallel_for_progress(nthreads, arg.nchunks, 1, _c_comp_scan_task, &arg, &prg);
+    status = eslOK;
+    for(ci = 0; ci < arg.nchunks; ci++) if(arg.chunkA[ci].status != eslOK) { status = arg.chunkA[ci].status; break; }
+    if     (status == eslESYS) snprintf(errbuf, eslERRBUFSIZE, "unable to read %s", sqfp->filename);
+    else if(status == eslEMEM) snprintf(errbuf, eslERRBUFSIZE, "out of memory");
+  }
+  else { 
+    status = _c_comp_read_serial(&arg, &(arg.chunkA[0]), sqfp->filename, sqfp->format, errbuf);
+    if(status == eslEMEM) snprintf(errbuf, eslERRBUFSIZE, "out of memory");
+  }
+  if(_c_progress_cancelled(&prg) || status != eslOK) { 
+    _c_comp_chunks_free(&arg);
+    esl_alphabet_Destroy(abc);
+    _c_progress_finish(&prg); /* dies if cancelled */
+    croak("_c_composition_stats() %s", errbuf);
+  }
+  prg.done = prg.total;
+
+  /* merge the ranges, in file order: add each range's lead and pre to
+   * the last record before it, unless the lead is part of a header */
+  memset(tot, 0, sizeof(tot));
+  in_header = FALSE;
+  nseq      = 0;
+  for(ci = 0; ci < arg.nchunks; ci++) { 
+    ck = &(arg.chunkA[ci]);
+    if(! ck->line_start) { 
+      if(! in_header && cur_ck != NULL) { 
+        _c_comp_fold(&arg, ck->lead, &(cur_ck->recA[cur_ck->nrec-1]), cur_ck->cntA + (cur_ck->nrec-1) * K);
+        for(c = 0; c < 256; c++) tot[c] += ck->lead[c];
+      }
+      if(! ck->has_nl) continue; /* all one line, still in the same state */
+    }
+    if(cur_ck != NULL) { 
+      _c_comp_fold(&arg, ck->pre, &(cur_ck->recA[cur_ck->nrec-1]), cur_ck->cntA + (cur_ck->nrec-1) * K);
+      for(c = 0; c < 256; c++) tot[c] += ck->pre[c];
+    }
+    if(ck->nrec > 0) cur_ck = ck;
+    in_header = ck->ends_in_header;
+    nseq     += ck->nrec;
+    for(c = 0; c < 256; c++) tot[c] += ck->tot[c];
+  }
+
+  namesSV = newSVpvn("", 0);
+  lenSV   = newSV(sizeof(int64_t) * nseq + 1);     SvPOK_on(lenSV);   lenp   = (int64_t *) SvPVX(lenSV);
+  cntSV   = newSV(sizeof(int64_t) * nseq * K + 1); SvPOK_on(cntSV);   cntp   = (int64_t *) SvPVX(cntSV);
+  ambigSV = newSV(sizeof(int64_t) * nseq + 1);     SvPOK_on(ambigSV); ambigp = (int64_t *) SvPVX(ambigSV);
+  softSV  = newSV(sizeof(int64_t) * nseq + 1);     SvPOK_on(softSV);  softp  = (int64_t *) SvPVX(softSV);
+  otherSV = newSV(sizeof(int64_t) * nseq + 1);     SvPOK_on(otherSV); otherp = (int64_t *) SvPVX(otherSV);
+  if(type == eslRNA || type == eslDNA) { 
+    gcSV = newSV(sizeof(double) * nseq + 1); SvPOK_on(gcSV); gcp = (double *) SvPVX(gcSV);
+  }
+  else gcSV = newSV(0);
+
+  /* totals: each symbol, illegal characters, soft-masked residues */
+  totSV = newSV(sizeof(int64_t) * (abc->Kp + 2) + 1);
+  SvPOK_on(totSV);
+  totp  = (int64_t *) SvPVX(totSV);
+  for(a = 0; a < abc->Kp + 2; a++) totp[a] = 0;
+  for(c = 0; c < 256; c++) { 
+    if     (arg.cls[c] == BE_COMP_IGNORED) continue;
+    else if(arg.cls[c] == BE_COMP_ILLEGAL) totp[abc->Kp]     += tot[c];
+    else                                   totp[arg.cls[c]] += tot[c];
+  }
+
+  i = 0;
+  for(ci = 0; ci < arg.nchunks; ci++) { 
+    ck = &(arg.chunkA[ci]);
+    for(r = 0; r < ck->nrec; r++, i++) { 
+      rec = &(ck->recA[r]);
+      sv_catpvn(namesSV, rec->name, strlen(rec->name) + 1); /* with its '\0' */
+      lenp[i]   = rec->len;
+      ambigp[i] = rec->ambig;
+      softp[i]  = rec->soft;
+      otherp[i] = rec->other;
+      totp[abc->Kp + 1] += rec->soft;
+      memcpy(cntp + i * K, ck->cntA + r * K, sizeof(int64_t) * K);
+      if(gcp != NULL) { /* A C G T/U */
+        cg = cntp[i * K + 1] + cntp[i * K + 2];
+        at = cntp[i * K + 0] + cntp[i * K + 3];
+        gcp[i] = (cg + at > 0) ? (double) cg / (double) (cg + at) : 0.;
+      }
+    }
+  }
+  _c_comp_chunks_free(&arg);
+  SvCUR_set(lenSV,   sizeof(int64_t) * nseq);          *SvEND(lenSV)   = '\0';
+  SvCUR_set(cntSV,   sizeof(int64_t) * nseq * K);      *SvEND(cntSV)   = '\0';
+  SvCUR_set(ambigSV, sizeof(int64_t) * nseq);          *SvEND(ambigSV) = '\0';
+  SvCUR_set(softSV,  sizeof(int64_t) * nseq);          *SvEND(softSV)  = '\0';
+  SvCUR_set(otherSV, sizeof(int64_t) * nseq);          *SvEND(otherSV) = '\0';
+  SvCUR_set(totSV,   sizeof(int64_t) * (abc->Kp + 2)); *SvEND(totSV)   = '\0';
+  if(gcp != NULL) { SvCUR_set(gcSV, sizeof(double) * nseq); *SvEND(gcSV) = '\0'; }
+
+  Inline_Stack_Reset;
+  Inline_Stack_Push(sv_2mortal(newSVpv(esl_abc_DecodeType(type), 0)));
+  Inline_Stack_Push(sv_2mortal(newSVpvn(abc->sym, K)));
+  Inline_Stack_Push(sv_2mortal(newSVpvn(abc->sym, abc->Kp)));
+  Inline_Stack_Push(sv_2mortal(namesSV));
+  Inline_Stack_Push(sv_2mortal(lenSV));
+  Inline_Stack_Push(sv_2mortal(cntSV));
+  Inline_Stack_Push(sv_2mortal(ambigSV));
+  Inline_Stack_Push(sv_2mortal(softSV));
+  Inline_Stack_Push(sv_2mortal(otherSV));
+  Inline_Stack_Push(sv_2mortal(gcSV));
+  Inline_Stack_Push(sv_2mortal(totSV));
+  Inline_Stack_Done;
+
+  esl_alphabet_Destroy(abc);
+  _c_progress_finish(&prg);
+  Inline_Stack_Return(11);
+  return;
+
+ ERROR:
+  croak("out of memory");
+  return; /* NEVERREACHED */
+}
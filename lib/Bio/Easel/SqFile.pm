@@ -2,8 +2,10 @@ package Bio::Easel::SqFile;
 
 use strict;
 use warnings;
+use File::Basename;
 use File::Spec;
 use Carp;
+use Scalar::Util qw(refaddr weaken);
 
 =head1 NAME
 
@@ -48,28 +50,53 @@ our $ESLEWRITE =         '27';    # write failed (fprintf, etc)
 
 our $FASTATEXTW =        '60';    # 60 characters per line in FASTA seq output
 
+# '0' to score PSSMs with the scalar scan only, see score_pssm()
+our $PSSM_SIMD = 1;
+
+# all live objects, weak references, key: refaddr(), for CLONE()
+my %live_objects = ();
+
 my $src_file      = undef;
 my $typemaps      = undef;
 my $easel_src_dir = undef;
+my $module_dir    = undef;
 
 BEGIN {
     $src_file = __FILE__;
     $src_file =~ s/\.pm/\.c/;
 
+    # for bio_easel_threads.h
+    $module_dir = File::Spec->rel2abs( File::Basename::dirname(__FILE__) );
+
     $easel_src_dir = File::Spec->catfile( $ENV{BIO_EASEL_SHARE_DIR}, 'src/easel' );
 
     $typemaps = __FILE__;
     $typemaps =~ s/\.pm/\.typemap/;
 }
 
-use Inline
-  C        => "$src_file",
-  VERSION  => '0.01',
-  ENABLE   => 'AUTOWRAP',
-  INC      => "-I$easel_src_dir",
-  LIBS     => "-L$easel_src_dir -leasel",
-  TYPEMAPS => $typemaps,
-  NAME     => 'Bio::Easel::SqFile';
+# Load the precompiled XS build of SqFile.c (see xs/BioEaselXS.pm) if
+# it was installed, else fall back to compiling it with Inline::C,
+# which is also what you get with BIO_EASEL_INLINE=1 (development).
+# An XS build that is installed but fails to load is an error.
+BEGIN {
+  require XSLoader;
+  my $use_inline = $ENV{BIO_EASEL_INLINE};
+  if((! $use_inline) && (! eval { XSLoader::load('Bio::Easel::SqFile', '0.01'); 1; })) {
+    if($@ !~ m/^Can't locate loadable object for module/) { die $@; }
+    $use_inline = 1;
+  }
+  if($use_inline) {
+    require Inline;
+    Inline->import(
+      C        => "$src_file",
+      VERSION  => '0.01',
+      ENABLE   => 'AUTOWRAP',
+      INC      => "-I$easel_src_dir -I$module_dir",
+      LIBS     => "-L$easel_src_dir -leasel -lpthread",
+      TYPEMAPS => $typemaps,
+      NAME     => 'Bio::Easel::SqFile');
+  }
+}
 
 =head1 SYNOPSIS
 
@@ -156,6 +183,9 @@ sub new {
     $self->create_ssi_index();
   }
 
+  $live_objects{ refaddr($self) } = $self;
+  weaken( $live_objects{ refaddr($self) } );
+
   return $self;
 }
 
@@ -214,6 +244,8 @@ sub open_sqfile {
   my ( $self, $fileLocation ) = @_;
 
   if ($fileLocation) {
+    # sequences loaded from another file must not answer for this one
+    if(defined $self->{path} && $fileLocation ne $self->{path}) { $self->unload(); }
     $self->{path} = $fileLocation;
   }
   if ( !defined $self->{path} ) { die "trying to read sequence file but path is not set"; }
@@ -233,6 +265,14 @@ sub open_sqfile {
     $self->{isAmino} = 0;
   }
 
+  # a new ESL_SQFILE replaces any open one, with its SSI index
+  if(defined $self->{esl_sqfile}) { 
+    _c_close_sqfile( $self->{esl_sqfile} );
+    $self->{esl_sqfile} = undef;
+    $self->{has_ssi}    = undef;
+  }
+  $self->_free_ssi_keys();
+
   $self->{esl_sqfile} = _c_open_sqfile( $self->{path}, $self->{digitize}, $self->{isRna}, $self->{isDna}, $self->{isAmino} );
 
   if ( ! defined $self->{esl_sqfile} ) { die "_c_open_sqfile returned, but esl_sqfile still undefined"; }
@@ -245,7 +285,9 @@ sub open_sqfile {
   Title    : close_sqfile
   Incept   : EPN, Thu Mar 28 10:36:06 2013
   Usage    : Bio::Easel::SqFile->close_sqfile
-  Function : Closes a sequence file and its SSI index file, and free ESL_SQFILE associated object.
+  Function : Closes a sequence file and its SSI index file, and free ESL_SQFILE associated object,
+           : the SSI names and lengths read by check_subseqs_exist(), if any, and the
+           : sequences read into memory by load_all(), if any.
            : If the file is not already open, we simply return (we do not throw an error).
   Args     : none
   Returns  : void
@@ -261,6 +303,8 @@ sub close_sqfile {
     $self->{esl_sqfile} = undef;
     $self->{has_ssi}    = undef;
   }
+  $self->_free_ssi_keys();
+  $self->unload();
 
   return;
 }
@@ -296,6 +340,7 @@ sub open_ssi_index {
     die "trying to open SSI for non-open sqfile";
   }
 
+  $self->_free_ssi_keys();
   my $status = _c_open_ssi_index( $self->{esl_sqfile} ); # this will call 'croak' upon an error 
 
   if($status == $ESLOK) { $self->{has_ssi} = 1; }
@@ -308,9 +353,13 @@ sub open_ssi_index {
   Incept   : EPN, Fri Mar  8 06:09:51 2013
   Usage    : Bio::Easel::SqFile->create_ssi_index
   Function : Creates an SSI file for a given sequence file.
+           : Progress, in bytes of the sequence file read, is reported to
+           : the callback set with Bio::Easel->set_progress_callback().
   Args     : None
   Returns  : void
   Dies     : if SSI index creation fails, via croak in _c_create_ssi_index()
+           : with "create_ssi_index cancelled" if cancelled, see Bio::Easel->cancel(),
+           : no SSI file is written then.
  
 =cut
 
@@ -321,6 +370,7 @@ sub create_ssi_index {
   if ( ! defined $self->{path} )                       { die "trying to create SSI file but path is not set"; }
   if ( ! defined $self->{esl_sqfile} )                 { die "trying to open SSI for non-open sqfile"; }
 
+  $self->_free_ssi_keys();
   _c_create_ssi_index( $self->{esl_sqfile} ); # this C function calls 'croak' if there's an error
 
   return;
@@ -348,7 +398,6 @@ sub fetch_seqs_given_names {
   my ( $self, $seqnameAR, $textw, $outfile ) = @_;
 
   $self->_check_sqfile();
-  $self->_check_ssi();    # fetching sequences by name requires SSI index
 
   my $retstring = "";
   if(defined $outfile) { 
@@ -357,7 +406,7 @@ sub fetch_seqs_given_names {
 
   my ($seqname, $seqstring);
   foreach $seqname (@{$seqnameAR}) { 
-    $seqstring = _c_fetch_seq_to_fasta_string($self->{esl_sqfile}, $seqname, $textw); 
+    $seqstring = $self->_fetch_seq_fasta($seqname, $textw); 
     if(defined $outfile) { print OUT $seqstring; }
     else                 { $retstring .= $seqstring; }
   }
@@ -460,11 +509,10 @@ sub fetch_seq_to_fasta_string {
   my ( $self, $seqname, $textw ) = @_;
 
   $self->_check_sqfile();
-  $self->_check_ssi();
 
   if(! defined $textw) { $textw = $FASTATEXTW; }
 
-  return _c_fetch_seq_to_fasta_string($self->{esl_sqfile}, $seqname, $textw); 
+  return $self->_fetch_seq_fasta($seqname, $textw);
 }
 
 =head2 fetch_seq_to_sqstring
@@ -484,9 +532,8 @@ sub fetch_seq_to_sqstring {
   my ( $self, $seqname ) = @_;
 
   $self->_check_sqfile();
-  $self->_check_ssi();
 
-  my $sqstring = _c_fetch_seq_to_fasta_string($self->{esl_sqfile}, $seqname, -1);
+  my $sqstring = $self->_fetch_seq_fasta($seqname, -1);
   
   # remove the header line 
   $sqstring =~ s/^\>\S+.*\n//;
@@ -625,7 +672,6 @@ sub fetch_subseqs {
   my ( $self, $AAR, $textw, $outfile ) = @_;
 
   $self->_check_sqfile();
-  $self->_check_ssi();    # fetching sequences by name requires SSI index
 
   my $retstring = "";
   if(defined $outfile) { 
@@ -640,7 +686,7 @@ sub fetch_subseqs {
     $listsize = scalar(@{$AAR->[$i]});
     if($listsize < 4) { die "ERROR fetch_subseqs, array too small (< 4 elements)"; }
     ($newname, $start, $end, $seqname) = ($AAR->[$i][0], $AAR->[$i][1], $AAR->[$i][2], $AAR->[$i][3]);
-    $seqstring = _c_fetch_subseq_to_fasta_string($self->{esl_sqfile}, $seqname, $newname, $start, $end, $textw, 0); 
+    $seqstring = $self->_fetch_subseq_fasta($seqname, $newname, $start, $end, $textw, 0); 
     if(defined $outfile) { print OUT $seqstring; }
     else                 { $retstring .= $seqstring; }
   }
@@ -673,13 +719,12 @@ sub fetch_subseq_to_fasta_string {
   my ( $self, $seqname, $start, $end, $textw, $do_res_revcomp ) = @_;
   
   $self->_check_sqfile();
-  $self->_check_ssi();
   
   if(! defined $textw)          { $textw = $FASTATEXTW; }
   if(! defined $do_res_revcomp) { $do_res_revcomp = 0; }
   
   my $newname = $seqname . "/" . $start . "-" . $end;
-  return _c_fetch_subseq_to_fasta_string($self->{esl_sqfile}, $seqname, $newname, $start, $end, $textw, $do_res_revcomp); 
+  return $self->_fetch_subseq_fasta($seqname, $newname, $start, $end, $textw, $do_res_revcomp);
 }
 
 =head2 fetch_subseq_to_sqstring
@@ -705,12 +750,11 @@ sub fetch_subseq_to_sqstring {
   my ( $self, $seqname, $start, $end, $do_res_revcomp ) = @_;
   
   $self->_check_sqfile();
-  $self->_check_ssi();
   
   if(! defined $do_res_revcomp) { $do_res_revcomp = 0; }
   
   my $newname = $seqname . "/" . $start . "-" . $end;
-  my $sqstring = _c_fetch_subseq_to_fasta_string($self->{esl_sqfile}, $seqname, $newname, $start, $end, -1, $do_res_revcomp);
+  my $sqstring = $self->_fetch_subseq_fasta($seqname, $newname, $start, $end, -1, $do_res_revcomp);
 
   # remove the header line 
   $sqstring =~ s/^\>\S+.*\n//;
@@ -831,9 +875,8 @@ sub fetch_seq_length_given_name {
   my ( $self, $sqname ) = @_;
 
   $self->_check_sqfile();
-  $self->_check_ssi();
 
-  return _c_fetch_seq_length_given_name($self->{esl_sqfile}, $sqname);
+  return $self->_seq_length($sqname);
 }
 
 =head2 check_seq_exists
@@ -854,6 +897,9 @@ sub check_seq_exists {
   my ( $self, $sqname ) = @_;
 
   $self->_check_sqfile();
+  if(defined $self->{sqdb}) { 
+    return (_c_sqdb_seq_length($self->{sqdb}, $sqname) == -1) ? 0 : 1;
+  }
   $self->_check_ssi();
 
   return _c_check_seq_exists($self->{esl_sqfile}, $sqname);
@@ -882,10 +928,9 @@ sub check_subseq_exists {
   my ( $self, $sqname, $start, $end ) = @_;
 
   $self->_check_sqfile();
-  $self->_check_ssi();
 
   # fetch length to see if (a) seq exists and (b) coords are valid
-  my $L = _c_fetch_seq_length_given_name($self->{esl_sqfile}, $sqname);
+  my $L = $self->_seq_length($sqname);
   if($L == -1) { 
     return 0; # sequence $sqname does not exist
   }
@@ -895,6 +940,45 @@ sub check_subseq_exists {
   return 0; # sequence $sqname exists but subseq does not
 }
 
+=head2 check_subseqs_exist
+
+  Title    : check_subseqs_exist()
+  Incept   : Mon Oct 19 02:38:12 2026
+  Usage    : $status = Bio::Easel::SqFile->check_subseqs_exist($AAR)
+  Function : Batch version of check_subseq_exists(): check a list of 
+           : subsequences, $AAR->[x] = [ $sqname, $start, $end ], in
+           : one call. The SSI index's names and lengths are read
+           : into memory on the first call and kept until the file is
+           : closed; the queries are sorted by name and matched to them
+           : in one pass. If the file was loaded with load_all(), its
+           : in-memory name index is used instead.
+  Args     : $AAR: ref to array of [ $sqname, $start, $end ] array refs
+  Returns  : packed signed chars (unpack with "c*"), one per subsequence,
+           : in order:
+           :  '1'  if the subsequence exists (start and end in 1..L)
+           :  '0'  if the sequence exists but the subsequence doesn't
+           :  '-1' if the sequence doesn't exist
+  Dies     : if an element of $AAR is not an array ref of at least 3 
+           : elements, or upon an error reading the SSI index, with 
+           : C croak() call
+=cut
+
+sub check_subseqs_exist {
+  my ( $self, $AAR ) = @_;
+
+  if(ref($AAR) ne "ARRAY") { croak "check_subseqs_exist() requires an array ref"; }
+  $self->_check_sqfile();
+  if(defined $self->{sqdb}) { 
+    return _c_sqdb_check_subseqs($self->{sqdb}, $AAR);
+  }
+  $self->_check_ssi();
+  if(! defined $self->{ssi_keys}) { 
+    $self->{ssi_keys} = _c_ssi_keys_load($self->{esl_sqfile});
+  }
+
+  return _c_ssi_keys_check_subseqs($self->{esl_sqfile}, $self->{ssi_keys}, $AAR);
+}
+
 =head2 compare_seq_to_seq
 
   Title    : compare_seq_to_seq()
@@ -972,6 +1056,7 @@ sub nseq_ssi {
   my ( $self ) = @_;
 
   $self->_check_sqfile();
+  if(defined $self->{sqdb}) { return _c_sqdb_nseq($self->{sqdb}); }
   $self->_check_ssi();
   
   return _c_nseq_ssi($self->{esl_sqfile});
@@ -994,6 +1079,7 @@ sub nres_ssi {
   my ( $self ) = @_;
 
   $self->_check_sqfile();
+  if(defined $self->{sqdb}) { return _c_sqdb_nres($self->{sqdb}); }
   $self->_check_ssi();
   
   my $Lstr; # _c_nres_ssi returns length as a string, so as not to overflow a 32-bit int
@@ -1002,6 +1088,329 @@ sub nres_ssi {
   return $Lstr;
 }
 
+=head2 length_stats
+
+  Title    : length_stats
+  Incept   : Mon Oct 19 04:12:26 2026
+  Usage    : $statsHR = $sqfile->length_stats($optHR)
+  Function : Summarize the sequence lengths of a file, read from its
+           : SSI index in one pass, with no sequence read or parsed
+           : (or from memory if the file was loaded with load_all()):
+           : count, total, min, max, mean, N50 and L50, and a
+           : histogram. N50 is the length L such that sequences of
+           : length L or more hold at least half of all residues, L50
+           : the number of those sequences.
+  Args     : $optHR: optional hash ref of options:
+           :   binsize: width of histogram bins; bins then start at
+           :            multiples of it (e.g. 0..999, 1000..1999)
+           :   nbins:   number of histogram bins of equal width from
+           :            min to max, if binsize isn't given [20]
+  Returns  : hash ref with keys 'count', 'total' (as a string, as
+           : nres_ssi() returns it), 'min', 'max', 'mean', 'N50',
+           : 'L50', 'binsize' (width of histogram bins) and 'histogram':
+           : ref to an array of [ start, end, count ] array refs, one
+           : per bin, in order. min, max, mean, N50 and L50 are undef,
+           : and the histogram is empty, if the file has no sequences.
+           : Lengths that aren't set in the SSI index count as 0.
+  Dies     : if an option is invalid, or upon an error reading the 
+           : SSI index, with C croak() call
+
+=cut
+
+sub length_stats { 
+  my ( $self, $optHR ) = @_;
+
+  $self->_check_sqfile();
+  if(! defined $optHR) { $optHR = {}; }
+  foreach my $opt (keys %{$optHR}) { 
+    if($opt ne "binsize" && $opt ne "nbins") { croak "length_stats() unknown option $opt"; }
+  }
+  if(defined $optHR->{binsize} && defined $optHR->{nbins}) { croak "length_stats() binsize and nbins are incompatible"; }
+  if(defined $optHR->{binsize} && $optHR->{binsize} < 1)   { croak "length_stats() binsize must be at least 1"; }
+  if(defined $optHR->{nbins}   && $optHR->{nbins}   < 1)   { croak "length_stats() nbins must be at least 1"; }
+  my $binsize = (defined $optHR->{binsize}) ? $optHR->{binsize} : 0;
+  my $nbins   = (defined $optHR->{nbins})   ? $optHR->{nbins}   : 20;
+
+  my $lengths;
+  if(defined $self->{sqdb}) { 
+    $lengths = _c_sqdb_lengths($self->{sqdb});
+  }
+  else { 
+    $self->_check_ssi();
+    $lengths = _c_ssi_lengths($self->{esl_sqfile});
+  }
+  my ($n, $total, $min, $max, $mean, $n50, $l50, $lo, $w, $hist) = _c_length_stats($lengths, $binsize, $nbins);
+
+  my @histA = ();
+  my $start = $lo;
+  foreach my $count (unpack("q*", $hist)) { 
+    push(@histA, [ $start, $start + $w - 1, $count ]);
+    $start += $w;
+  }
+
+  return { count     => $n,
+           total     => $total,
+           min       => ($n > 0) ? $min  : undef,
+           max       => ($n > 0) ? $max  : undef,
+           mean      => ($n > 0) ? $mean : undef,
+           N50       => ($n > 0) ? $n50  : undef,
+           L50       => ($n > 0) ? $l50  : undef,
+           binsize   => $w,
+           histogram => \@histA };
+}
+
+=head2 load_all
+
+  Title    : load_all
+  Incept   : Mon Oct 19 01:44:20 2026
+  Usage    : $nseq = $sqfile->load_all()
+  Function : Read every sequence in the file, once, into memory: all
+           : residues in one contiguous block (in digital or text
+           : mode, as the file was opened), with tables of offsets,
+           : lengths and names, indexed by name and accession. Until
+           : unload(), these methods are served from memory, with no
+           : file reads, parsing or SSI lookups:
+           :   fetch_seqs_given_names(), fetch_seq_to_fasta_string(),
+           :   fetch_seq_to_sqstring(), fetch_subseqs(),
+           :   fetch_subseq_to_fasta_string(), fetch_subseq_to_sqstring(),
+           :   fetch_seq_length_given_name(), check_seq_exists(),
+           :   check_subseq_exists(), nseq_ssi() and nres_ssi().
+           : Their results are the same as from the file. Methods that
+           : read the file in order or use SSI numbers still read the file.
+           : Loading again reloads the file. Memory needed is about the
+           : size of the file. Progress, in bytes of the file read, is 
+           : reported to the callback set with 
+           : Bio::Easel->set_progress_callback(). The file is rewound.
+  Args     : none
+  Returns  : number of sequences loaded
+  Dies     : if the file can't be read or rewound (e.g. it's gzipped),
+           : a sequence name occurs more than once, or with 
+           : "load_all cancelled" if cancelled, see Bio::Easel->cancel()
+
+=cut
+
+sub load_all {
+  my ( $self ) = @_;
+
+  $self->_check_sqfile();
+  $self->unload();
+  $self->{sqdb} = _c_sqdb_load($self->{esl_sqfile});
+
+  return _c_sqdb_nseq($self->{sqdb});
+}
+
+=head2 unload
+
+  Title    : unload
+  Incept   : Mon Oct 19 01:46:02 2026
+  Usage    : $sqfile->unload()
+  Function : Free the sequences read into memory by load_all(), if any; 
+           : sequences are fetched from the file again.
+  Args     : none
+  Returns  : void
+
+=cut
+
+sub unload {
+  my ( $self ) = @_;
+
+  if(defined $self->{sqdb}) { 
+    _c_sqdb_free($self->{sqdb});
+    $self->{sqdb} = undef;
+  }
+
+  return;
+}
+
+=head2 is_loaded
+
+  Title    : is_loaded
+  Incept   : Mon Oct 19 01:46:38 2026
+  Usage    : $sqfile->is_loaded()
+  Function : Return '1' if the file has been read into memory by load_all().
+  Args     : none
+  Returns  : '1' if loaded, '0' if not
+
+=cut
+
+sub is_loaded {
+  my ( $self ) = @_;
+
+  return (defined $self->{sqdb}) ? 1 : 0;
+}
+
+=head2 score_pssm
+
+  Title    : score_pssm
+  Incept   : Sun Oct 18 20:04:11 2026
+  Usage    : @hitA = $sqfile->score_pssm($pssmHR, $optHR)
+  Function : Score each sequence in the file with a position-specific
+           : scoring matrix from Bio::Easel::MSA::build_pssm(): find
+           : the ungapped window of the matrix's width with the highest
+           : score, the sum of its residues' scores, in bits. Meant as
+           : a fast prefilter: windows are compared 16 at a time with
+           : SSSE3 instructions on x86 CPUs that have them, for DNA
+           : and RNA, at a resolution of up to 0.01 bits; the scores
+           : returned are exact. Matrices too wide for 16-bit window
+           : scores at 0.1 bits (a few thousand positions) are scored
+           : with 32-bit scores, without SSSE3. Set
+           : $Bio::Easel::SqFile::PSSM_SIMD to 0 to never use SSSE3.
+           : Degenerate residues score the average of the residues
+           : they stand for, other characters the average of all
+           : residues. Sequences shorter than the matrix are skipped.
+           : The whole file is read, from the start, and rewound.
+           : Progress, in bytes of the file read, is reported to the
+           : callback set with Bio::Easel->set_progress_callback().
+  Args     : $pssmHR: PSSM, from Bio::Easel::MSA::build_pssm()
+           : $optHR:  optional hash ref of options:
+           :   both_strands: '1' to also score the reverse complement
+           :                 (DNA or RNA only)
+           :   min_score:    only return sequences with a best score of
+           :                 at least this
+  Returns  : array of array refs, one per sequence in file order:
+           : [ name, score, start, end ], start and end (1..L) of the best
+           : window, start > end if it is on the reverse complement.
+  Dies     : if the PSSM or an option is invalid, the file can't be read
+           : or rewound (e.g. it's gzipped), or with "score_pssm cancelled"
+           : if cancelled, see Bio::Easel->cancel()
+
+=cut
+
+sub score_pssm {
+  my ( $self, $pssmHR, $optHR ) = @_;
+
+  $self->_check_sqfile();
+  if(! defined $optHR) { $optHR = {}; }
+  foreach my $opt (keys %{$optHR}) { 
+    if($opt ne "both_strands" && $opt ne "min_score") { croak "score_pssm() unknown option $opt"; }
+  }
+  if(ref($pssmHR) ne "HASH" || ! defined $pssmHR->{alphabet} || ! defined $pssmHR->{residues} || ref($pssmHR->{scores}) ne "ARRAY") { 
+    croak "score_pssm() PSSM must be a hash ref from Bio::Easel::MSA::build_pssm()";
+  }
+  my $K = length($pssmHR->{residues});
+  my $W = scalar(@{$pssmHR->{scores}});
+  if($W == 0) { croak "score_pssm() PSSM has no positions"; }
+  foreach my $rowAR (@{$pssmHR->{scores}}) { 
+    if(scalar(@{$rowAR}) != $K) { croak "score_pssm() PSSM has a position without $K scores"; }
+  }
+  my $packed = pack("d*", map { @{$_} } @{$pssmHR->{scores}});
+  my $do_min = (defined $optHR->{min_score}) ? 1 : 0;
+
+  my @retA = _c_score_pssm($self->{esl_sqfile}, $packed, $W, $pssmHR->{alphabet}, 
+                           ($optHR->{both_strands} ? 1 : 0), $do_min, ($do_min ? $optHR->{min_score} : 0.),
+                           ($PSSM_SIMD ? 1 : 0));
+  my @hitA = ();
+  while(@retA) { push(@hitA, [ splice(@retA, 0, 4) ]); }
+
+  return @hitA;
+}
+
+=head2 composition_stats
+
+  Title    : composition_stats
+  Incept   : Mon Oct 19 03:24:40 2026
+  Usage    : $compHR = $sqfile->composition_stats($optHR)
+  Function : Count the residues of every sequence in the file: each
+           : canonical residue, ambiguous (degenerate and unknown)
+           : residues, soft-masked (lower case) residues, and other
+           : characters (gaps, nonresidues, missing data and characters
+           : that aren't in the alphabet); and the GC fraction of the
+           : canonical residues, for DNA and RNA. Whitespace and digits
+           : aren't counted. Sequence lengths include all counted
+           : characters. Uncompressed FASTA files are split into byte
+           : ranges read in parallel, so large chromosomes are spread
+           : over all threads; other files are read serially. The
+           : file is read independently of $sqfile, which isn't moved.
+           : Progress, in bytes of the file read, is reported to the
+           : callback set with Bio::Easel->set_progress_callback().
+  Args     : $optHR: optional hash ref of options:
+           :   alphabet: 'RNA', 'DNA' or 'amino'; default is the
+           :             alphabet of $sqfile if it was opened in
+           :             digital mode, else guessed from the file
+  Returns  : hash ref:
+           :   alphabet:   name of the alphabet
+           :   residues:   string of the K canonical residues
+           :   nseq:       number of sequences
+           :   names:      array ref of sequence names, in file order
+           :   length:     pack("q*") of the nseq lengths
+           :   counts:     pack("q*") of nseq * K residue counts,
+           :               K per sequence in the order of 'residues'
+           :   ambiguous:  pack("q*") of the nseq ambiguous counts
+           :   softmasked: pack("q*") of the nseq soft-masked counts
+           :   other:      pack("q*") of the nseq other counts
+           :   gc:         pack("d*") of the nseq GC fractions, undef
+           :               unless DNA or RNA
+           :   total:      hash ref of totals over all sequences, keys
+           :               'length', 'ambiguous', 'softmasked', 'other',
+           :               'gc' as above, 'counts' (hash ref, canonical
+           :               residue to count), 'symbol_counts' (hash ref,
+           :               each symbol of the alphabet seen to its
+           :               count) and 'illegal' (characters that aren't
+           :               in the alphabet)
+  Dies     : if an option is invalid, the file can't be read or
+           : parsed, or with "composition_stats cancelled" if
+           : cancelled, see Bio::Easel->cancel()
+
+=cut
+
+sub composition_stats {
+  my ( $self, $optHR ) = @_;
+
+  $self->_check_sqfile();
+  if(! defined $optHR) { $optHR = {}; }
+  foreach my $opt (keys %{$optHR}) { 
+    if($opt ne "alphabet") { croak "composition_stats() unknown option $opt"; }
+  }
+  my $alphabet = (defined $optHR->{alphabet}) ? $optHR->{alphabet} : "";
+
+  my ($abc, $residues, $symbols, $names, $len, $cnt, $ambig, $soft, $other, $gc, $tot) = 
+      _c_composition_stats($self->{esl_sqfile}, $alphabet);
+  my @nameA = split(/\0/, $names, -1);
+  pop(@nameA); # each name ends with '\0'
+  my $K     = length($residues);
+  my $Kp    = length($symbols);
+  my @totA  = unpack("q*", $tot);
+
+  my %totH = ();
+  my $sum = 0;
+  foreach my $x (unpack("q*", $len)) { $sum += $x; }
+  $totH{length} = $sum;
+  $sum = 0;
+  foreach my $x (unpack("q*", $ambig)) { $sum += $x; }
+  $totH{ambiguous} = $sum;
+  $sum = 0;
+  foreach my $x (unpack("q*", $other)) { $sum += $x; }
+  $totH{other} = $sum;
+  my @cntA = unpack("q*", $cnt);
+  my @rtotA = (0) x $K;
+  for(my $i = 0; $i < scalar(@cntA); $i++) { $rtotA[$i % $K] += $cntA[$i]; }
+  $totH{counts} = {};
+  for(my $x = 0; $x < $K; $x++) { $totH{counts}{substr($residues, $x, 1)} = $rtotA[$x]; }
+  $totH{symbol_counts} = {};
+  for(my $x = 0; $x < $Kp; $x++) { 
+    if($totA[$x] > 0) { $totH{symbol_counts}{substr($symbols, $x, 1)} = $totA[$x]; }
+  }
+  $totH{illegal}    = $totA[$Kp];
+  $totH{softmasked} = $totA[$Kp+1];
+  $totH{gc} = undef;
+  if(defined $gc) { # A C G T/U
+    my $acgt = $rtotA[0] + $rtotA[1] + $rtotA[2] + $rtotA[3];
+    $totH{gc} = ($acgt > 0) ? ($rtotA[1] + $rtotA[2]) / $acgt : 0.;
+  }
+
+  return { alphabet   => $abc, 
+           residues   => $residues, 
+           nseq       => scalar(@nameA),
+           names      => \@nameA, 
+           length     => $len, 
+           counts     => $cnt, 
+           ambiguous  => $ambig, 
+           softmasked => $soft, 
+           other      => $other, 
+           gc         => $gc, 
+           total      => \%totH };
+}
+
 =head2 DESTROY
 
   Title    : DESTROY
@@ -1016,7 +1425,56 @@ sub nres_ssi {
 sub DESTROY {
   my ($self) = @_;
 
+  delete $live_objects{ refaddr($self) };
   $self->close_sqfile();
+  $self->unload();
+
+  return;
+}
+
+=head2 CLONE
+
+  Title    : CLONE
+  Incept   : Sun Oct 18 14:02:17 2026
+  Usage    : called by perl in a new thread (ithreads), never directly
+  Function : Each object in the new thread is a copy of the object
+           : in the parent thread, including the pointer to its
+           : ESL_SQFILE, which can't be used by two threads at once.
+           : Reopen the sequence file (and its SSI index, if it was
+           : open) for each object in the new thread, so the thread
+           : gets its own file handles. The position in the file is
+           : not copied: the new thread starts reading at the
+           : beginning of the file. Files loaded with load_all() are
+           : loaded again, so each thread has its own copy to free.
+  Args     : none (the package name)
+  Returns  : void
+
+=cut
+
+sub CLONE {
+  my @objA = grep { defined $_ } values %live_objects;
+
+  # addresses are different in the new interpreter
+  %live_objects = ();
+  foreach my $obj (@objA) {
+    $live_objects{ refaddr($obj) } = $obj;
+    weaken( $live_objects{ refaddr($obj) } );
+
+    if ( defined $obj->{esl_sqfile} ) {
+      my $had_ssi = ( defined $obj->{has_ssi} && $obj->{has_ssi} ) ? 1 : 0;
+      # don't close the parent thread's ESL_SQFILE, just forget it
+      $obj->{esl_sqfile} = undef;
+      $obj->{has_ssi}    = undef;
+      $obj->{ssi_keys}   = undef; # read again when needed
+      $obj->open_sqfile();
+      if ($had_ssi) { $obj->open_ssi_index(); }
+    }
+    if ( defined $obj->{sqdb} ) {
+      # don't free the parent thread's copy, just forget it
+      $obj->{sqdb} = undef;
+      $obj->load_all();
+    }
+  }
 
   return;
 }
@@ -1079,6 +1537,100 @@ sub _check_ssi {
   return;
 }
 
+=head2 _free_ssi_keys
+
+  Title    : _free_ssi_keys
+  Incept   : Mon Oct 19 05:12:40 2026
+  Usage    : $sqfile->_free_ssi_keys()
+  Function : Free the SSI names and lengths read by check_subseqs_exist(),
+           : if any, when the ESL_SQFILE or its SSI index is replaced or
+           : closed; they are read again when needed.
+  Args     : none
+  Returns  : void
+
+=cut
+
+sub _free_ssi_keys {
+  my ($self) = @_;
+
+  if(defined $self->{ssi_keys}) { 
+    _c_ssi_keys_free( $self->{ssi_keys} );
+    $self->{ssi_keys} = undef;
+  }
+  return;
+}
+
+=head2 _fetch_seq_fasta
+
+  Title    : _fetch_seq_fasta
+  Incept   : Mon Oct 19 01:49:15 2026
+  Usage    : $self->_fetch_seq_fasta($seqname, $textw)
+  Function : Fetch a sequence as a FASTA string, from memory if the
+           : file was loaded with load_all(), else using the SSI index.
+  Args     : $seqname: name or accession of desired sequence
+           : $textw:   width of FASTA seq lines, -1 for unlimited
+  Returns  : string, the sequence in FASTA format
+
+=cut
+
+sub _fetch_seq_fasta {
+  my ($self, $seqname, $textw) = @_;
+
+  if(defined $self->{sqdb}) { 
+    return _c_sqdb_fetch_seq_to_fasta_string($self->{sqdb}, $seqname, $textw);
+  }
+  $self->_check_ssi();
+
+  return _c_fetch_seq_to_fasta_string($self->{esl_sqfile}, $seqname, $textw);
+}
+
+=head2 _fetch_subseq_fasta
+
+  Title    : _fetch_subseq_fasta
+  Incept   : Mon Oct 19 01:50:02 2026
+  Usage    : $self->_fetch_subseq_fasta($seqname, $newname, $start, $end, $textw, $do_res_revcomp)
+  Function : Fetch a subsequence as a FASTA string, from memory if the
+           : file was loaded with load_all(), else using the SSI index.
+           : See fetch_subseq_to_fasta_string() for the arguments.
+  Returns  : string, the subsequence in FASTA format, named $newname
+
+=cut
+
+sub _fetch_subseq_fasta {
+  my ($self, $seqname, $newname, $start, $end, $textw, $do_res_revcomp) = @_;
+
+  if(defined $self->{sqdb}) { 
+    return _c_sqdb_fetch_subseq_to_fasta_string($self->{sqdb}, $seqname, $newname, $start, $end, $textw, $do_res_revcomp);
+  }
+  $self->_check_ssi();
+
+  return _c_fetch_subseq_to_fasta_string($self->{esl_sqfile}, $seqname, $newname, $start, $end, $textw, $do_res_revcomp);
+}
+
+=head2 _seq_length
+
+  Title    : _seq_length
+  Incept   : Mon Oct 19 01:50:41 2026
+  Usage    : $self->_seq_length($seqname)
+  Function : Length of a sequence, from memory if the file was loaded
+           : with load_all(), else from the SSI index.
+  Args     : $seqname: name or accession of sequence
+  Returns  : length of sequence, -1 if it doesn't exist, 0 if lengths
+           : are unset in the SSI index
+
+=cut
+
+sub _seq_length {
+  my ($self, $seqname) = @_;
+
+  if(defined $self->{sqdb}) { 
+    return _c_sqdb_seq_length($self->{sqdb}, $seqname);
+  }
+  $self->_check_ssi();
+
+  return _c_fetch_seq_length_given_name($self->{esl_sqfile}, $seqname);
+}
+
 =head2 dl_load_flags
 
 =head1 AUTHORS
@@ -0,0 +1,741 @@
+/* bio_easel_threads.h
+ *
+ * The worker thread pool used by the parallel kernels in the
+ * Bio::Easel C code (lib/Bio/Easel/<Module>.c).
+ *
+ * There is one pool per perl interpreter, shared by all Bio::Easel
+ * modules: the first module that needs it creates it and stores a
+ * pointer to it in PL_modglobal, where the other modules find it.
+ * An ithread's interpreter gets a copy of PL_modglobal, with the
+ * pointer to its parent's pool, so the pointer is stored with the
+ * interpreter (and process) that owns the pool, and a pool owned by
+ * another interpreter is never used or freed: the ithread creates its
+ * own on first use, which is freed with its interpreter. The number of
+ * threads is decided on every parallel call by _c_threads_n(), in this
+ * order of precedence:
+ *
+ *   1. $Bio::Easel::NTHREADS, set by Bio::Easel->set_threads($n)
+ *   2. the BIO_EASEL_THREADS environment variable
+ *   3. the number of CPUs given to a cluster job, from the environment
+ *      set by the scheduler (SLURM_CPUS_PER_TASK, NSLOTS, PBS_NUM_PPN,
+ *      NCPUS, LSB_DJOB_NUMPROC); inside a job that doesn't say, 1
+ *   4. the number of CPUs this process may run on (sched_getaffinity())
+ *
+ * Work is submitted with _c_threads_parallel_for(), which splits an
+ * index range [0,n) into tasks and runs them on the workers and the
+ * calling thread. A pool runs one job at a time. A parallel call made
+ * while one of the interpreter's jobs runs (from the progress callback,
+ * the only perl code that can run then) runs serially instead. Each participant owns a deque of tasks, it pops from
+ * the back of its own deque and, once that is empty, steals from the
+ * front of the others', so uneven tasks (e.g. rows of a triangular
+ * all-vs-all loop) balance themselves.
+ *
+ * Task functions run outside of perl: they must not call the perl API
+ * (including croak()) or anything that does. Report errors through
+ * the task argument instead.
+ *
+ * The pool is created on first use and resized when the number of
+ * threads changes, between jobs. After a fork() the child's pool has
+ * no threads, it is abandoned (not freed: its mutexes may be held) and
+ * a new one created on first use.
+ *
+ * Long running operations report progress and can be cancelled with
+ * a BE_PROGRESS (see Bio::Easel->set_progress_callback()):
+ *
+ *   BE_PROGRESS prg;
+ *   _c_progress_start(&prg, "name", total);   dies if already cancelled
+ *   ... work, calling _c_progress_add(&prg, n) from any thread, and
+ *       _c_progress_poll(&prg) from perl's thread, which calls the
+ *       callback at most once per interval; or pass &prg to
+ *       _c_threads_parallel_for_progress(), which does the polling,
+ *       and stop early once _c_progress_cancelled(&prg) ...
+ *   clean up
+ *   _c_progress_finish(&prg);                 dies if cancelled
+ *
+ * Only the callback can cancel an operation (by calling
+ * Bio::Easel->cancel(), or by dying), so nothing is checked when
+ * there is no callback.
+ */
+#ifndef BIO_EASEL_THREADS_INCLUDED
+#define BIO_EASEL_THREADS_INCLUDED
+
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "easel.h"
+
+#define BE_MAX_THREADS 256
+#define BE_POOL_KEY    "Bio::Easel::_thread_pool_v3"  /* change the version if BE_POOL or BE_POOL_REF change */
+
+#ifdef MULTIPLICITY
+#define BE_POOL_OWNER  ((void *) PERL_GET_THX)          /* the current perl interpreter */
+#else
+#define BE_POOL_OWNER  NULL
+#endif
+
+/* a task function: process indices [start..end-1] of the current job, tid is
+ * the index of the calling participant, 0..nthreads-1, for per thread results */
+typedef void (*BE_TASK_FUNC)(void *arg, int64_t start, int64_t end, int tid);
+
+typedef struct {
+  int64_t start;
+  int64_t end;
+} BE_TASK;
+
+/* progress of a long running operation, see the top of this file;
+ * <done> and <cancelled> are read and written with atomic builtins */
+typedef struct {
+  const char *what;       /* name of the operation, for the callback and errors */
+  int64_t     total;      /* total amount of work, in any unit */
+  int64_t     done;       /* amount of work done so far */
+  int         cancelled;  /* TRUE once the operation should stop */
+  SV         *cb;         /* $Bio::Easel::PROGRESS_CB, NULL if none */
+  double      interval;   /* minimum number of seconds between callbacks */
+  double      last;       /* time of the last callback */
+  SV         *err;        /* the error, if the callback died */
+} BE_PROGRESS;
+
+typedef struct {
+  pthread_mutex_t lock;
+  BE_TASK        *taskA;    /* [head..tail-1] are waiting tasks */
+  int             head;     /* thieves take tasks from here */
+  int             tail;     /* the owner takes tasks from here */
+  int             nalloc;   /* allocated size of taskA */
+} BE_DEQUE;
+
+typedef struct {
+  int             nthreads;     /* number of threads the pool was created for */
+  int             nworkers;     /* number of worker threads, the calling thread is participant <nworkers> */
+  pid_t           pid;          /* process that created the pool */
+  pthread_t      *threadA;      /* [0..nworkers-1] */
+  BE_DEQUE       *dqA;          /* [0..nworkers], one per participant */
+  pthread_mutex_t submit_lock;  /* held while a job runs, so jobs run one at a time */
+  int             busy;         /* TRUE while a job runs; only used by the owner's perl thread */
+  pthread_mutex_t lock;         /* protects everything below */
+  pthread_cond_t  work_cv;      /* signalled when a job is started or on shutdown */
+  pthread_cond_t  done_cv;      /* signalled when the last task of a job is finished */
+  int64_t         generation;   /* number of jobs started */
+  int64_t         nleft;        /* number of tasks of the current job not yet finished */
+  int             do_shutdown;  /* TRUE to stop the workers */
+  BE_TASK_FUNC    func;         /* the current job */
+  void           *arg;
+  BE_PROGRESS    *prg;          /* its progress, NULL if none */
+} BE_POOL;
+
+typedef struct {
+  BE_POOL *pool;
+  int      tid;
+} BE_WORKER_ARG;
+
+/* what PL_modglobal holds, in the PV of the BE_POOL_KEY entry: ithreads
+ * copy it, so the owner can be checked without touching the pool, which
+ * its owner may have freed */
+typedef struct {
+  BE_POOL *pool;
+  void    *owner;   /* BE_POOL_OWNER of the interpreter that created the pool */
+  pid_t    pid;     /* process that created the pool */
+} BE_POOL_REF;
+
+/* Function:  _c_threads_env_count()
+ * Synopsis:  Return the positive integer value of environment variable
+ *            <name>, or 0 if it's not set or not a positive integer.
+ */
+static int
+_c_threads_env_count(const char *name)
+{
+  char *val = getenv(name);
+  char *end;
+  long  n;
+
+  if(val == NULL || *val == '\0') return 0;
+  n = strtol(val, &end, 10);
+  if(*end != '\0' && *end != ',' && *end != '(') return 0; /* PBS_NUM_PPN/LSB can be lists, "4(x2)" etc., first value is ours */
+  return (n > 0) ? (int) ESL_MIN(n, BE_MAX_THREADS) : 0;
+}
+
+/* Function:  _c_threads_n()
+ * Synopsis:  Return the number of threads parallel kernels should use,
+ *            see the top of this file for how it is decided.
+ */
+static int
+_c_threads_n(void)
+{
+  static const char *slot_varA[] = { "SLURM_CPUS_PER_TASK", "NSLOTS", "PBS_NUM_PPN", "NCPUS", "LSB_DJOB_NUMPROC", NULL };
+  static const char *job_varA[]  = { "SLURM_JOB_ID", "JOB_ID", "PBS_JOBID", "LSB_JOBID", NULL };
+  SV  *sv;
+  int  n;
+  int  i;
+
+  sv = get_sv("Bio::Easel::NTHREADS", 0);
+  if(sv != NULL && SvOK(sv) && SvIV(sv) > 0) return (int) ESL_MIN(SvIV(sv), BE_MAX_THREADS);
+
+  if((n = _c_threads_env_count("BIO_EASEL_THREADS")) > 0) return n;
+
+  for(i = 0; slot_varA[i] != NULL; i++) {
+    if((n = _c_threads_env_count(slot_varA[i])) > 0) return n;
+  }
+  /* in a job that didn't request more than one CPU, don't take the whole node */
+  for(i = 0; job_varA[i] != NULL; i++) {
+    if(getenv(job_varA[i]) != NULL) return 1;
+  }
+
+#if defined(__linux__) && defined(CPU_COUNT)
+  {
+    cpu_set_t cpus;
+    if(sched_getaffinity(0, sizeof(cpus), &cpus) == 0 && (n = CPU_COUNT(&cpus)) > 0) return ESL_MIN(n, BE_MAX_THREADS);
+  }
+#endif
+#if defined(_SC_NPROCESSORS_ONLN)
+  {
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    if(ncpu > 0) return (int) ESL_MIN(ncpu, BE_MAX_THREADS);
+  }
+#endif
+  return 1;
+}
+
+/* Function:  _c_progress_now()
+ * Synopsis:  Return the time in seconds, for timing callbacks.
+ */
+static double
+_c_progress_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+/* Function:  _c_progress_check_cancel()
+ * Synopsis:  If Bio::Easel->cancel() was called, mark <prg> as
+ *            cancelled and reset $Bio::Easel::CANCEL, so the
+ *            cancellation applies to this operation only.
+ *            Perl's thread only.
+ */
+static void
+_c_progress_check_cancel(BE_PROGRESS *prg)
+{
+  SV *sv = get_sv("Bio::Easel::CANCEL", 0);
+
+  if(sv != NULL && SvTRUE(sv)) {
+    __atomic_store_n(&(prg->cancelled), TRUE, __ATOMIC_RELAXED);
+    sv_setiv(sv, 0);
+  }
+}
+
+/* Function:  _c_progress_call()
+ * Synopsis:  Call the callback of <prg> with (what, done, total), 
+ *            and cancel the operation if it died or called
+ *            Bio::Easel->cancel(). Perl's thread only.
+ */
+static void
+_c_progress_call(BE_PROGRESS *prg)
+{
+  dSP;
+
+  prg->last = _c_progress_now();
+  ENTER;
+  SAVETMPS;
+  PUSHMARK(SP);
+  XPUSHs(sv_2mortal(newSVpv(prg->what, 0)));
+  XPUSHs(sv_2mortal(newSViv((IV) __atomic_load_n(&(prg->done), __ATOMIC_RELAXED))));
+  XPUSHs(sv_2mortal(newSViv((IV) prg->total)));
+  PUTBACK;
+  call_sv(prg->cb, G_DISCARD | G_EVAL);
+  if(SvTRUE(ERRSV) && prg->err == NULL) {
+    prg->err = newSVsv(ERRSV);
+    __atomic_store_n(&(prg->cancelled), TRUE, __ATOMIC_RELAXED);
+  }
+  FREETMPS;
+  LEAVE;
+
+  _c_progress_check_cancel(prg);
+}
+
+/* Function:  _c_progress_start()
+ * Synopsis:  Start reporting progress of operation <what>, which will
+ *            do <total> units of work, to the callback set with
+ *            Bio::Easel->set_progress_callback(), if any.
+ * Dies:      with croak if Bio::Easel->cancel() was called before
+ *            the operation started.
+ */
+static void
+_c_progress_start(BE_PROGRESS *prg, const char *what, int64_t total)
+{
+  SV *sv;
+
+  prg->what      = what;
+  prg->total     = total;
+  prg->done      = 0;
+  prg->cancelled = FALSE;
+  prg->cb        = NULL;
+  prg->interval  = 1.;
+  prg->last      = 0.;
+  prg->err       = NULL;
+
+  _c_progress_check_cancel(prg);
+  if(prg->cancelled) croak("%s cancelled", what);
+
+  sv = get_sv("Bio::Easel::PROGRESS_CB", 0);
+  if(sv != NULL && SvROK(sv) && SvTYPE(SvRV(sv)) == SVt_PVCV) prg->cb = sv;
+  sv = get_sv("Bio::Easel::PROGRESS_INTERVAL", 0);
+  if(sv != NULL && SvOK(sv)) prg->interval = SvNV(sv);
+
+  if(prg->cb != NULL) _c_progress_call(prg);
+}
+
+/* Function:  _c_progress_add()
+ * Synopsis:  Add <n> units to the work done. Any thread.
+ */
+static void
+_c_progress_add(BE_PROGRESS *prg, int64_t n)
+{
+  if(prg != NULL) __atomic_fetch_add(&(prg->done), n, __ATOMIC_RELAXED);
+}
+
+/* Function:  _c_progress_cancelled()
+ * Synopsis:  Return TRUE if the operation should stop. Any thread.
+ */
+static int
+_c_progress_cancelled(BE_PROGRESS *prg)
+{
+  return (prg != NULL && __atomic_load_n(&(prg->cancelled), __ATOMIC_RELAXED)) ? TRUE : FALSE;
+}
+
+/* Function:  _c_progress_poll()
+ * Synopsis:  Call the callback if one is set and it hasn't been called
+ *            for an interval. Perl's thread only.
+ * Returns:   TRUE if the operation should stop.
+ */
+static int
+_c_progress_poll(BE_PROGRESS *prg)
+{
+  if(prg == NULL || prg->cb == NULL) return FALSE;
+  if(! prg->cancelled && _c_progress_now() - prg->last >= prg->interval) _c_progress_call(prg);
+  return _c_progress_cancelled(prg);
+}
+
+/* Function:  _c_progress_finish()
+ * Synopsis:  End an operation started with _c_progress_start(): call
+ *            the callback a last time with all work done, unless
+ *            the operation was cancelled. Call after cleaning up.
+ * Dies:      with croak if the operation was cancelled, with the
+ *            callback's error if it died.
+ */
+static void
+_c_progress_finish(BE_PROGRESS *prg)
+{
+  char errbuf[eslERRBUFSIZE];
+
+  if(! prg->cancelled && prg->cb != NULL) {
+    __atomic_store_n(&(prg->done), prg->total, __ATOMIC_RELAXED);
+    _c_progress_call(prg);
+  }
+  if(prg->err != NULL) {
+    snprintf(errbuf, eslERRBUFSIZE, "%s", SvPV_nolen(prg->err));
+    SvREFCNT_dec(prg->err);
+    prg->err = NULL;
+    croak("%s cancelled, progress callback died: %s", prg->what, errbuf);
+  }
+  if(prg->cancelled) croak("%s cancelled", prg->what);
+}
+
+/* Function:  _c_threads_pop()
+ * Synopsis:  Take a task: from the back of participant <tid>'s own deque,
+ *            else from the front of another participant's deque.
+ * Returns:   TRUE and the task in <ret_task>, FALSE if there was none.
+ */
+static int
+_c_threads_pop(BE_POOL *pool, int tid, BE_TASK *ret_task)
+{
+  BE_DEQUE *dq;
+  int       npart = pool->nworkers + 1;
+  int       k;
+
+  dq = &(pool->dqA[tid]);
+  pthread_mutex_lock(&(dq->lock));
+  if(dq->tail > dq->head) {
+    *ret_task = dq->taskA[--dq->tail];
+    pthread_mutex_unlock(&(dq->lock));
+    return TRUE;
+  }
+  pthread_mutex_unlock(&(dq->lock));
+
+  for(k = 1; k < npart; k++) {
+    dq = &(pool->dqA[(tid + k) % npart]);
+    pthread_mutex_lock(&(dq->lock));
+    if(dq->tail > dq->head) {
+      *ret_task = dq->taskA[dq->head++];
+      pthread_mutex_unlock(&(dq->lock));
+      return TRUE;
+    }
+    pthread_mutex_unlock(&(dq->lock));
+  }
+  return FALSE;
+}
+
+/* Function:  _c_threads_run()
+ * Synopsis:  Run tasks of the current job as participant <tid> until
+ *            there are none left to take. Tasks taken after the job
+ *            was cancelled are skipped. <poll> is TRUE for perl's
+ *            thread, which reports progress between tasks.
+ */
+static void
+_c_threads_run(BE_POOL *pool, int tid, int poll)
+{
+  BE_TASK      task;
+  BE_TASK_FUNC func;
+  void        *arg;
+  BE_PROGRESS *prg;
+
+  while(_c_threads_pop(pool, tid, &task)) {
+    pthread_mutex_lock(&(pool->lock));
+    func = pool->func;
+    arg  = pool->arg;
+    prg  = pool->prg;
+    pthread_mutex_unlock(&(pool->lock));
+
+    if(! _c_progress_cancelled(prg)) func(arg, task.start, task.end, tid);
+    if(poll) _c_progress_poll(prg);
+
+    pthread_mutex_lock(&(pool->lock));
+    if(--pool->nleft == 0) pthread_cond_broadcast(&(pool->done_cv));
+    pthread_mutex_unlock(&(pool->lock));
+  }
+}
+
+/* Function:  _c_threads_worker()
+ * Synopsis:  A worker thread: run the tasks of each job that is started
+ *            until the pool is shut down.
+ */
+static void *
+_c_threads_worker(void *varg)
+{
+  BE_WORKER_ARG *warg = (BE_WORKER_ARG *) varg;
+  BE_POOL       *pool = warg->pool;
+  int            tid  = warg->tid;
+  int64_t        seen = 0;
+
+  free(warg);
+  pthread_mutex_lock(&(pool->lock));
+  seen = pool->generation;
+  for(;;) {
+    while(! pool->do_shutdown && pool->generation == seen) pthread_cond_wait(&(pool->work_cv), &(pool->lock));
+    if(pool->do_shutdown) break;
+    seen = pool->generation;
+    pthread_mutex_unlock(&(pool->lock));
+    _c_threads_run(pool, tid, FALSE);
+    pthread_mutex_lock(&(pool->lock));
+  }
+  pthread_mutex_unlock(&(pool->lock));
+  return NULL;
+}
+
+/* Function:  _c_threads_destroy()
+ * Synopsis:  Stop and join the worker threads of <pool>, and free it.
+ */
+static void
+_c_threads_destroy(BE_POOL *pool)
+{
+  int i;
+
+  pthread_mutex_lock(&(pool->lock));
+  pool->do_shutdown = TRUE;
+  pthread_cond_broadcast(&(pool->work_cv));
+  pthread_mutex_unlock(&(pool->lock));
+  for(i = 0; i < pool->nworkers; i++) pthread_join(pool->threadA[i], NULL);
+
+  for(i = 0; i <= pool->nworkers; i++) {
+    pthread_mutex_destroy(&(pool->dqA[i].lock));
+    if(pool->dqA[i].taskA != NULL) free(pool->dqA[i].taskA);
+  }
+  pthread_mutex_destroy(&(pool->lock));
+  pthread_mutex_destroy(&(pool->submit_lock));
+  pthread_cond_destroy(&(pool->work_cv));
+  pthread_cond_destroy(&(pool->done_cv));
+  free(pool->dqA);
+  free(pool->threadA);
+  free(pool);
+}
+
+/* Function:  _c_threads_create()
+ * Synopsis:  Create a pool with <nworkers> worker threads.
+ * Returns:   the pool, NULL if it couldn't be created.
+ */
+static BE_POOL *
+_c_threads_create(int nworkers)
+{
+  BE_POOL       *pool;
+  BE_WORKER_ARG *warg;
+  sigset_t       all, prv;
+  int            i;
+
+  if((pool = calloc(1, sizeof(BE_POOL))) == NULL) return NULL;
+  pool->pid      = getpid();
+  pool->nthreads = nworkers+1;
+  if((pool->threadA = calloc(nworkers,   sizeof(pthread_t))) == NULL) { free(pool); return NULL; }
+  if((pool->dqA     = calloc(nworkers+1, sizeof(BE_DEQUE)))  == NULL) { free(pool->threadA); free(pool); return NULL; }
+  for(i = 0; i <= nworkers; i++) pthread_mutex_init(&(pool->dqA[i].lock), NULL);
+  pthread_mutex_init(&(pool->lock),        NULL);
+  pthread_mutex_init(&(pool->submit_lock), NULL);
+  pthread_cond_init (&(pool->work_cv), NULL);
+  pthread_cond_init (&(pool->done_cv), NULL);
+
+  /* start as many workers as we can, nworkers is however many that is;
+   * signals must be delivered to perl's thread, so workers block them all */
+  sigfillset(&all);
+  pthread_sigmask(SIG_SETMASK, &all, &prv);
+  for(i = 0; i < nworkers; i++) {
+    if((warg = malloc(sizeof(BE_WORKER_ARG))) == NULL) break;
+    warg->pool = pool;
+    warg->tid  = i;
+    if(pthread_create(&(pool->threadA[i]), NULL, _c_threads_worker, warg) != 0) { free(warg); break; }
+  }
+  pthread_sigmask(SIG_SETMASK, &prv, NULL);
+  pool->nworkers = i;
+  for(i = pool->nworkers+1; i <= nworkers; i++) pthread_mutex_destroy(&(pool->dqA[i].lock));
+
+  return pool;
+}
+
+/* Function:  _c_threads_pool_free()
+ * Synopsis:  Magic free function of the PL_modglobal entry of a pool:
+ *            destroy the pool when the entry is replaced or freed with
+ *            its interpreter, if it belongs to this interpreter and
+ *            process.
+ */
+static int
+_c_threads_pool_free(pTHX_ SV *sv, MAGIC *mg)
+{
+  BE_POOL_REF *ref;
+
+  PERL_UNUSED_ARG(mg);
+  if(! SvPOK(sv) || SvCUR(sv) != sizeof(BE_POOL_REF)) return 0;
+  ref = (BE_POOL_REF *) SvPVX(sv);
+  if(ref->pool != NULL && ref->owner == BE_POOL_OWNER && ref->pid == getpid()) _c_threads_destroy(ref->pool);
+  return 0;
+}
+
+static MGVTBL be_pool_vtbl = { NULL, NULL, NULL, NULL, _c_threads_pool_free };
+
+/* Function:  _c_threads_pool_current()
+ * Synopsis:  Return this interpreter's pool, NULL if it has none yet
+ *            (or only its parent's, or one from before a fork()).
+ */
+static BE_POOL *
+_c_threads_pool_current(void)
+{
+  SV         **svp;
+  BE_POOL_REF *ref;
+
+  svp = hv_fetch(PL_modglobal, BE_POOL_KEY, strlen(BE_POOL_KEY), 0);
+  if(svp == NULL || ! SvPOK(*svp) || SvCUR(*svp) != sizeof(BE_POOL_REF)) return NULL;
+  ref = (BE_POOL_REF *) SvPVX(*svp);
+  if(ref->owner != BE_POOL_OWNER) return NULL; /* an ithread: the parent's pool */
+  if(ref->pid   != getpid())      return NULL; /* forked: abandon the parent's pool */
+  return ref->pool;
+}
+
+/* Function:  _c_threads_pool()
+ * Synopsis:  Return the interpreter's pool, (re)created for <nthreads>
+ *            threads (<nthreads>-1 workers) if necessary. Must not be
+ *            called while the pool runs a job.
+ * Returns:   the pool, NULL if <nthreads> is 1 or no pool could be created.
+ */
+static BE_POOL *
+_c_threads_pool(int nthreads)
+{
+  BE_POOL     *pool = _c_threads_pool_current();
+  BE_POOL_REF  ref;
+  SV          *sv;
+
+  if(pool != NULL && pool->nthreads == nthreads) return pool;
+  if(pool == NULL && nthreads <= 1)              return NULL;
+
+  ref.pool  = (nthreads > 1) ? _c_threads_create(nthreads-1) : NULL;
+  ref.owner = BE_POOL_OWNER;
+  ref.pid   = getpid();
+  /* replacing the entry frees the old one, which destroys the old pool if it is ours */
+  sv = newSVpvn((char *) &ref, sizeof(BE_POOL_REF));
+  sv_magicext(sv, NULL, PERL_MAGIC_ext, &be_pool_vtbl, NULL, 0);
+  hv_store(PL_modglobal, BE_POOL_KEY, strlen(BE_POOL_KEY), sv, 0);
+
+  return ref.pool;
+}
+
+/* Function:  _c_threads_serial_for()
+ * Synopsis:  _c_threads_parallel_for_progress() without threads: call
+ *            <func> for each range of <grain> indices in turn,
+ *            reporting progress in between, until done or cancelled.
+ */
+static void
+_c_threads_serial_for(int64_t n, int64_t grain, BE_TASK_FUNC func, void *arg, BE_PROGRESS *prg)
+{
+  int64_t start;
+
+  if(prg == NULL || prg->cb == NULL) {
+    func(arg, 0, n, 0);
+    return;
+  }
+  for(start = 0; start < n && ! _c_progress_cancelled(prg); start += grain) {
+    func(arg, start, ESL_MIN(start + grain, n), 0);
+    _c_progress_poll(prg);
+  }
+}
+
+/* Function:  _c_threads_parallel_for_progress()
+ * Synopsis:  Call <func>(<arg>, start, end, tid) for consecutive ranges
+ *            [start..end-1] that together cover [0..n-1], of at most
+ *            <grain> indices each, using up to <nthreads> threads
+ *            including the calling one, and wait for them all to finish.
+ *
+ *            tid is always < <nthreads>, which should be the value
+ *            _c_threads_n() returned when per thread results were
+ *            allocated.
+ *
+ *            If <prg> is not NULL, the calling thread reports its
+ *            progress while the job runs (<func> adds the work it
+ *            did with _c_progress_add()), and once it is cancelled
+ *            the remaining ranges are skipped: the caller must check
+ *            _c_progress_cancelled() before using any results.
+ *
+ * Returns:   the number of threads actually used.
+ */
+static int
+_c_threads_parallel_for_progress(int nthreads, int64_t n, int64_t grain, BE_TASK_FUNC func, void *arg, BE_PROGRESS *prg)
+{
+  BE_POOL        *pool;
+  BE_DEQUE       *dq;
+  BE_TASK        *tmp;
+  int64_t         ntasks;
+  int64_t         t;
+  int             npart;
+  int             p;
+  int             nalloc;
+  struct timespec ts;
+  double          wait;
+
+  if(n <= 0) return 1;
+  if(grain < 1) grain = 1;
+  ntasks = (n + grain - 1) / grain;
+  if(nthreads <= 1 || ntasks == 1) {
+    _c_threads_serial_for(n, grain, func, arg, prg);
+    return 1;
+  }
+  /* called from the progress callback of a job the pool is running: run
+   * serially, the pool can neither take a second job nor be resized */
+  if((pool = _c_threads_pool_current()) != NULL && pool->busy) {
+    _c_threads_serial_for(n, grain, func, arg, prg);
+    return 1;
+  }
+  if((pool = _c_threads_pool(nthreads)) == NULL) {
+    _c_threads_serial_for(n, grain, func, arg, prg);
+    return 1;
+  }
+  npart = pool->nworkers + 1;
+
+  pthread_mutex_lock(&(pool->submit_lock));
+  pool->busy = TRUE;
+
+  /* make room in every deque before queueing anything: workers still
+   * leaving the previous job steal any task as soon as it is queued, so
+   * once one is, the job can no longer be taken back and run here */
+  for(p = 0; p < npart; p++) {
+    int64_t tfirst = (ntasks *  p)    / npart;
+    int64_t tlast  = (ntasks * (p+1)) / npart;
+    dq = &(pool->dqA[p]);
+    pthread_mutex_lock(&(dq->lock));
+    if(dq->nalloc < tlast - tfirst) {
+      nalloc = (int) (tlast - tfirst);
+      if((tmp = realloc(dq->taskA, sizeof(BE_TASK) * nalloc)) == NULL) {
+        /* give up on threading this job and run it all here */
+        pthread_mutex_unlock(&(dq->lock));
+        pool->busy = FALSE;
+        pthread_mutex_unlock(&(pool->submit_lock));
+        _c_threads_serial_for(n, grain, func, arg, prg);
+        return 1;
+      }
+      dq->taskA  = tmp;
+      dq->nalloc = nalloc;
+    }
+    pthread_mutex_unlock(&(dq->lock));
+  }
+
+  pthread_mutex_lock(&(pool->lock));
+  pool->func  = func;
+  pool->arg   = arg;
+  pool->prg   = prg;
+  pool->nleft = ntasks;
+  pthread_mutex_unlock(&(pool->lock));
+
+  /* give each participant a contiguous block of the tasks; it works through its
+   * block from the back and steals from the front of other blocks */
+  for(p = 0; p < npart; p++) {
+    int64_t tfirst = (ntasks *  p)    / npart;
+    int64_t tlast  = (ntasks * (p+1)) / npart;
+    dq = &(pool->dqA[p]);
+    pthread_mutex_lock(&(dq->lock));
+    dq->head = dq->tail = 0;
+    for(t = tfirst; t < tlast; t++) {
+      dq->taskA[dq->tail].start = t * grain;
+      dq->taskA[dq->tail].end   = ESL_MIN((t+1) * grain, n);
+      dq->tail++;
+    }
+    pthread_mutex_unlock(&(dq->lock));
+  }
+
+  pthread_mutex_lock(&(pool->lock));
+  pool->generation++;
+  pthread_cond_broadcast(&(pool->work_cv));
+  pthread_mutex_unlock(&(pool->lock));
+
+  _c_threads_run(pool, pool->nworkers, TRUE);
+
+  /* wait for the workers' last tasks, still reporting progress if there's a callback */
+  pthread_mutex_lock(&(pool->lock));
+  while(pool->nleft > 0) {
+    if(prg == NULL || prg->cb == NULL) {
+      pthread_cond_wait(&(pool->done_cv), &(pool->lock));
+      continue;
+    }
+    wait = ESL_MAX(0.01, prg->interval - (_c_progress_now() - prg->last));
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec  += (time_t) wait;
+    ts.tv_nsec += (long) ((wait - (double) ((time_t) wait)) * 1e9);
+    if(ts.tv_nsec >= 1000000000L) { ts.tv_sec++; ts.tv_nsec -= 1000000000L; }
+    if(pthread_cond_timedwait(&(pool->done_cv), &(pool->lock), &ts) != 0 && pool->nleft > 0) {
+      pthread_mutex_unlock(&(pool->lock));
+      _c_progress_poll(prg);
+      pthread_mutex_lock(&(pool->lock));
+    }
+  }
+  pool->func = NULL;
+  pool->arg  = NULL;
+  pool->prg  = NULL;
+  pthread_mutex_unlock(&(pool->lock));
+  pool->busy = FALSE;
+  pthread_mutex_unlock(&(pool->submit_lock));
+
+  return npart;
+}
+
+/* Function:  _c_threads_parallel_for()
+ * Synopsis:  _c_threads_parallel_for_progress() without progress
+ *            reporting or cancellation.
+ * Returns:   the number of threads actually used.
+ */
+static int
+_c_threads_parallel_for(int nthreads, int64_t n, int64_t grain, BE_TASK_FUNC func, void *arg)
+{
+  return _c_threads_parallel_for_progress(nthreads, n, grain, func, arg, NULL);
+}
+
+
+#endif /* BIO_EASEL_THREADS_INCLUDED */
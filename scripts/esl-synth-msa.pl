@@ -0,0 +1,76 @@
+#!/usr/bin/env perl
+# 
+# esl-synth-msa.pl: generate a synthetic Rfam-like RNA alignment.
+# 
+# This script uses BioEasel's Random module to write a Stockholm
+# alignment with a random consensus secondary structure, clusters of
+# related sequences with covarying basepair substitutions, fragments,
+# deletion runs, insert columns and posterior probability annotation.
+# The same seed always gives the same alignment, so alignments of
+# any size can be regenerated instead of shipped.
+
+use strict;
+use Getopt::Long;
+use Bio::Easel::Random;
+
+my $seed   = 181;   # seed for RNG
+my %optH   = ();    # options passed to Bio::Easel::Random::synth_rna_msa(), undefined ones get defaults
+my $no_pp  = 0;     # set to 1 if --nopp
+my $do_verbose = 0; # set to 1 if -v
+
+&GetOptions( "s=s"        => \$seed,
+             "n=s"        => \$optH{nseq},
+             "L=s"        => \$optH{clen},
+             "c=s"        => \$optH{nclust},
+             "name=s"     => \$optH{name},
+             "csubst=s"   => \$optH{clust_subst},
+             "subst=s"    => \$optH{subst},
+             "covary=s"   => \$optH{covary},
+             "delopen=s"  => \$optH{del_open},
+             "delext=s"   => \$optH{del_ext},
+             "insopen=s"  => \$optH{ins_open},
+             "insext=s"   => \$optH{ins_ext},
+             "frag=s"     => \$optH{frag},
+             "nopp"       => \$no_pp,
+             "v"          => \$do_verbose);
+
+my $usage;
+$usage  = "# esl-synth-msa.pl :: generate a synthetic Rfam-like RNA alignment\n";
+$usage .= "# Bio-Easel 0.15 (June 2021)\n";
+$usage .= "# - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -\n";
+$usage .= "\n";
+$usage .= "Usage: esl-synth-msa.pl [OPTIONS] <name of output Stockholm file>\n";
+$usage .= "\tOPTIONS:\n";
+$usage .= "\t\t-s <n>         : seed random number generator with <n> [181]\n";
+$usage .= "\t\t-n <n>         : number of sequences [100]\n";
+$usage .= "\t\t-L <n>         : consensus length [120]\n";
+$usage .= "\t\t-c <n>         : number of clusters of related sequences [10]\n";
+$usage .= "\t\t--name <s>     : name of alignment (#=GF ID) [synth]\n";
+$usage .= "\t\t--csubst <f>   : substitution probability, consensus to cluster [0.15]\n";
+$usage .= "\t\t--subst <f>    : substitution probability, cluster to sequence [0.05]\n";
+$usage .= "\t\t--covary <f>   : fraction of substitutions at basepaired positions that are compensated [0.7]\n";
+$usage .= "\t\t--delopen <f>  : deletion opening probability per consensus position [0.005]\n";
+$usage .= "\t\t--delext <f>   : deletion extension probability [0.7]\n";
+$usage .= "\t\t--insopen <f>  : insertion opening probability per consensus position [0.003]\n";
+$usage .= "\t\t--insext <f>   : insertion extension probability [0.6]\n";
+$usage .= "\t\t--frag <f>     : fraction of sequences that are fragments [0.1]\n";
+$usage .= "\t\t--nopp         : do not add posterior probability annotation\n";
+$usage .= "\t\t-v             : be verbose, print alignment dimensions to stdout\n";
+
+if(scalar(@ARGV) != 1) { die $usage; }
+my ($outfile) = @ARGV;
+
+if($seed !~ m/^\d+$/) { die "ERROR with -s <n>, <n> must be a non-negative integer"; }
+foreach my $key (keys %optH) { 
+  if(! defined $optH{$key}) { delete $optH{$key}; }
+}
+if($no_pp) { $optH{pp} = 0; }
+
+my $rng  = Bio::Easel::Random->new({ seed => $seed });
+my $alen = $rng->synth_rna_msa($outfile, \%optH);
+
+if($do_verbose) { 
+  printf("Wrote %s: %d sequences, alignment length %d (seed %d)\n", $outfile, (defined $optH{nseq}) ? $optH{nseq} : 100, $alen, $seed);
+}
+
+exit 0;
@@ -0,0 +1,73 @@
+#!/usr/bin/env perl
+# 
+# esl-synth-seqdb.pl: generate a synthetic FASTA sequence database.
+# 
+# This script uses BioEasel's Random module to write a FASTA file
+# with lognormally distributed sequence lengths, given G+C content
+# (or background amino acid frequencies), runs of unknown residues
+# and soft-masked regions. The same seed always gives the same file.
+
+use strict;
+use Getopt::Long;
+use Bio::Easel::Random;
+
+my $seed       = 181;   # seed for RNG
+my %optH       = ();    # options passed to Bio::Easel::Random::synth_fasta(), undefined ones get defaults
+my $do_rna     = 0;     # set to 1 if --rna
+my $do_amino   = 0;     # set to 1 if --amino
+my $do_verbose = 0;     # set to 1 if -v
+
+&GetOptions( "s=s"        => \$seed,
+             "n=s"        => \$optH{nseq},
+             "mean=s"     => \$optH{len_mean},
+             "sd=s"       => \$optH{len_sd},
+             "min=s"      => \$optH{minlen},
+             "max=s"      => \$optH{maxlen},
+             "gc=s"       => \$optH{gc},
+             "nrun=s"     => \$optH{nrun},
+             "mask=s"     => \$optH{softmask},
+             "w=s"        => \$optH{textw},
+             "rna"        => \$do_rna,
+             "amino"      => \$do_amino,
+             "v"          => \$do_verbose);
+
+my $usage;
+$usage  = "# esl-synth-seqdb.pl :: generate a synthetic FASTA sequence database\n";
+$usage .= "# Bio-Easel 0.15 (June 2021)\n";
+$usage .= "# - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -\n";
+$usage .= "\n";
+$usage .= "Usage: esl-synth-seqdb.pl [OPTIONS] <name of output FASTA file>\n";
+$usage .= "\tOPTIONS:\n";
+$usage .= "\t\t-s <n>     : seed random number generator with <n> [181]\n";
+$usage .= "\t\t-n <n>     : number of sequences [1000]\n";
+$usage .= "\t\t--mean <f> : mean sequence length [1000]\n";
+$usage .= "\t\t--sd <f>   : standard deviation of sequence length [1000]\n";
+$usage .= "\t\t--min <n>  : minimum sequence length [20]\n";
+$usage .= "\t\t--max <n>  : maximum sequence length [1000000000]\n";
+$usage .= "\t\t--gc <f>   : G+C fraction of nucleotide sequences [0.45]\n";
+$usage .= "\t\t--nrun <f> : fraction of sequences with runs of N (X for protein) [0.05]\n";
+$usage .= "\t\t--mask <f> : fraction of sequences with soft-masked (lowercase) regions [0.1]\n";
+$usage .= "\t\t-w <n>     : number of residues per line, -1 for unlimited [60]\n";
+$usage .= "\t\t--rna      : generate RNA sequences [default: DNA]\n";
+$usage .= "\t\t--amino    : generate protein sequences [default: DNA]\n";
+$usage .= "\t\t-v         : be verbose, print number of residues to stdout\n";
+
+if(scalar(@ARGV) != 1) { die $usage; }
+my ($outfile) = @ARGV;
+
+if($seed !~ m/^\d+$/) { die "ERROR with -s <n>, <n> must be a non-negative integer"; }
+if($do_rna && $do_amino) { die "ERROR, --rna and --amino are incompatible"; }
+foreach my $key (keys %optH) { 
+  if(! defined $optH{$key}) { delete $optH{$key}; }
+}
+if   ($do_rna)   { $optH{abc} = "rna"; }
+elsif($do_amino) { $optH{abc} = "amino"; }
+
+my $rng  = Bio::Easel::Random->new({ seed => $seed });
+my $nres = $rng->synth_fasta($outfile, \%optH);
+
+if($do_verbose) { 
+  printf("Wrote %s: %d sequences, %s residues (seed %d)\n", $outfile, (defined $optH{nseq}) ? $optH{nseq} : 1000, $nres, $seed);
+}
+
+exit 0;
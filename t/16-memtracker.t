@@ -0,0 +1,50 @@
+use strict;
+use warnings FATAL => 'all';
+use Test::More tests => 15;
+
+BEGIN {
+    use_ok( 'Bio::Easel::MemTracker' ) || print "Bail out!\n";
+    use_ok( 'Bio::Easel::MSA' )        || print "Bail out!\n";
+}
+
+my $alnfile = "./t/data/RF00014-seed.sto";
+
+my $snap = Bio::Easel::MemTracker->snapshot();
+ok(defined $snap->{heap} && defined $snap->{peak_rss}, "snapshot() returns heap and peak_rss");
+
+my $tracker = Bio::Easel::MemTracker->new({ verbose => 0 });
+isa_ok($tracker, "Bio::Easel::MemTracker");
+
+# track(), scalar context
+my $msa = $tracker->track("read_msa", sub { Bio::Easel::MSA->new({ fileLocation => $alnfile }) });
+isa_ok($msa, "Bio::Easel::MSA");
+is($msa->nseq, 5, "track() returns the value of the code block");
+
+# nested start()/stop()
+$tracker->start("outer");
+my $clone = $tracker->track("clone_msa", sub { $msa->clone_msa() });
+my $rec = $tracker->stop();
+is($rec->{label}, "outer", "stop() returns record of most recently started block");
+ok($rec->{peak_rss} == -1 || $rec->{peak_rss} >= $rec->{rss_start}, "peak_rss is at least rss_start");
+
+my $recordsAR = $tracker->records();
+is(scalar(@{$recordsAR}), 3,           "three blocks recorded");
+is($recordsAR->[1]->{label}, "clone_msa", "nested block recorded first");
+is($recordsAR->[1]->{depth}, 1,           "nested block has depth 1");
+
+# a dying block is still stopped, and the error rethrown
+eval { $tracker->track("dies", sub { die "expected\n"; }); };
+is($@, "expected\n", "track() rethrows errors");
+is(scalar(@{$tracker->records()}), 4, "dying block was recorded");
+
+# the process-wide high water mark can be left alone
+$Bio::Easel::MemTracker::RESET_PEAK = 0;
+$tracker->track("noreset", sub { $msa->clone_msa() });
+is($tracker->records()->[-1]->{peak_reset}, 0, "start() doesn't reset the peak with RESET_PEAK 0");
+$Bio::Easel::MemTracker::RESET_PEAK = 1;
+
+# instrument() wraps methods in place
+my $global = Bio::Easel::MemTracker->instrument('Bio::Easel::MSA', 'clone_msa');
+undef $clone;
+$clone = $msa->clone_msa();
+is($global->records()->[-1]->{label}, "Bio::Easel::MSA::clone_msa", "instrument() records calls to wrapped methods");
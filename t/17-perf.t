@@ -0,0 +1,248 @@
+#! /usr/bin/perl
+#
+# Optional performance regression tests: time the key MSA and SqFile
+# kernels on medium sized synthetic inputs and compare throughput
+# against a stored per-machine baseline.
+#
+# Only run if BIO_EASEL_PERF_TESTS is set. Other environment variables:
+#   BIO_EASEL_PERF_BASELINE:  baseline file (default: t/data/perf-baseline.txt)
+#   BIO_EASEL_PERF_TOLERANCE: fail if throughput drops more than this fraction
+#                             below the baseline (default: 0.25)
+#   BIO_EASEL_PERF_UPDATE:    if set, (re)write the baseline file with the
+#                             throughputs measured by this run
+#   BIO_EASEL_PERF_SECONDS:   minimum time to spend timing each kernel (default: 1.0)
+#
+# Baselines are machine specific so none is distributed; create one
+# with BIO_EASEL_PERF_UPDATE=1 on a known good build first.
+#
+use strict;
+use warnings FATAL => 'all';
+use Test::More;
+use Time::HiRes qw(time);
+
+if(! $ENV{BIO_EASEL_PERF_TESTS}) {
+  plan skip_all => "performance tests not requested, set BIO_EASEL_PERF_TESTS=1 to run them";
+}
+
+require Bio::Easel::MSA;
+require Bio::Easel::SqFile;
+
+my $baseline_file = (defined $ENV{BIO_EASEL_PERF_BASELINE})  ? $ENV{BIO_EASEL_PERF_BASELINE}  : "./t/data/perf-baseline.txt";
+my $tolerance     = (defined $ENV{BIO_EASEL_PERF_TOLERANCE}) ? $ENV{BIO_EASEL_PERF_TOLERANCE} : 0.25;
+my $min_seconds   = (defined $ENV{BIO_EASEL_PERF_SECONDS})   ? $ENV{BIO_EASEL_PERF_SECONDS}   : 1.0;
+my $do_update     = (defined $ENV{BIO_EASEL_PERF_UPDATE})    ? $ENV{BIO_EASEL_PERF_UPDATE}    : 0;
+
+my $nseq   = 400;  # number of sequences in synthetic alignment
+my $alen   = 300;  # alignment length of synthetic alignment
+my $nfasta = 2000; # number of sequences in synthetic fasta file
+
+srand(181);
+
+my $tmpdir = "tmp-perf-dir";
+if(! -d $tmpdir) { mkdir($tmpdir) or die "unable to make $tmpdir"; }
+my $alnfile   = "$tmpdir/perf.sto";
+my $alnfile2x = "$tmpdir/perf.2x.sto";
+my $fafile    = "$tmpdir/perf.fa";
+my $fafile2x  = "$tmpdir/perf.2x.fa";
+write_synthetic_stockholm($alnfile,   $nseq,   $alen);
+write_synthetic_stockholm($alnfile2x, 2*$nseq, $alen);
+write_synthetic_fasta($fafile,   $nfasta);
+write_synthetic_fasta($fafile2x, 2*$nfasta);
+
+my $msa   = Bio::Easel::MSA->new({ fileLocation => $alnfile });
+my $msa2x = Bio::Easel::MSA->new({ fileLocation => $alnfile2x });
+my $sqfile   = Bio::Easel::SqFile->new({ fileLocation => $fafile,   forceIndex => 1 });
+my $sqfile2x = Bio::Easel::SqFile->new({ fileLocation => $fafile2x, forceIndex => 1 });
+my @usemeA   = (1) x $nseq;
+my @halfA    = map { $_ % 2 } (0..$nseq-1);
+my @names1A  = map { "seq" . (int(rand($nfasta))+1) } (1..200);
+my @names2A  = map { "seq" . (int(rand(2*$nfasta))+1) } (1..200);
+
+# kernels: [ name, code ref for normal input, code ref for 2x input or undef ]
+# if the 2x code ref is defined the kernel is expected to scale linearly
+# in the number of sequences, and we check that it does.
+my @kernelA = (
+  [ "read_msa",                  sub { my $m = Bio::Easel::MSA->new({ fileLocation => $alnfile }); },
+                                 sub { my $m = Bio::Easel::MSA->new({ fileLocation => $alnfile2x }); } ],
+  [ "clone_msa",                 sub { my $m = $msa->clone_msa(); },
+                                 sub { my $m = $msa2x->clone_msa(); } ],
+  [ "sequence_subset",           sub { my $m = $msa->sequence_subset(\@halfA); },
+                                 sub { my $m = $msa2x->sequence_subset([ (@halfA, @halfA) ]); } ],
+  [ "pos_entropy",               sub { my @a = $msa->pos_entropy(0); },
+                                 sub { my @a = $msa2x->pos_entropy(0); } ],
+  [ "pos_conservation",          sub { my @a = $msa->pos_conservation(0); },
+                                 sub { my @a = $msa2x->pos_conservation(0); } ],
+  [ "most_informative_sequence", sub { my $s = $msa->most_informative_sequence(0.5, 0); },
+                                 sub { my $s = $msa2x->most_informative_sequence(0.5, 0); } ],
+  [ "pos_covariation",           sub { my @a = $msa->pos_covariation(); }, undef ],
+  [ "average_id",                sub { my $id = $msa->average_id(); }, undef ],
+  [ "weight_GSC",                sub { $msa->weight_GSC(); }, undef ],
+  [ "filter_msa_subset",         sub { my @k = (); $msa->filter_msa_subset(\@usemeA, 0.9, \@k); }, undef ],
+  [ "rfam_qc_stats",             sub { $msa->rfam_qc_stats("$tmpdir/fam", "$tmpdir/seq", "$tmpdir/bp"); }, undef ],
+  [ "fetch_seqs_given_names",    sub { my $s = $sqfile->fetch_seqs_given_names(\@names1A, 60); },
+                                 sub { my $s = $sqfile2x->fetch_seqs_given_names(\@names2A, 60); } ],
+);
+
+my %baselineH = read_baseline($baseline_file);
+my $nscaling  = scalar(grep { defined $_->[2] } @kernelA);
+plan tests => scalar(@kernelA) + $nscaling;
+
+my %measuredH = ();
+foreach my $kernel (@kernelA) {
+  my ($name, $codeR, $code2xR) = @{$kernel};
+  my $rate = time_kernel($codeR, $min_seconds);
+  $measuredH{$name} = $rate;
+
+  if($do_update || (! exists $baselineH{$name})) {
+    pass(sprintf("%-26s %10.2f calls/sec (%s)", $name, $rate, ($do_update) ? "baseline updated" : "no baseline"));
+  }
+  else {
+    my $min_rate = $baselineH{$name} * (1. - $tolerance);
+    ok($rate >= $min_rate, sprintf("%-26s %10.2f calls/sec, baseline %.2f, minimum %.2f", $name, $rate, $baselineH{$name}, $min_rate));
+  }
+
+  if(defined $code2xR) {
+    # doubling nseq should at most roughly double the time per call,
+    # a quadratic kernel would take ~4 times as long
+    my $rate2x = time_kernel($code2xR, $min_seconds);
+    my $ratio  = $rate / $rate2x;
+    ok($ratio < 3.0, sprintf("%-26s scales linearly (2x input is %.2fx slower)", $name, $ratio));
+  }
+}
+
+if($do_update) { write_baseline($baseline_file, \%measuredH); }
+
+undef $msa;
+undef $msa2x;
+undef $sqfile;
+undef $sqfile2x;
+foreach my $file ($alnfile, $alnfile2x, $fafile, $fafile2x, "$fafile.ssi", "$fafile2x.ssi", "$tmpdir/fam", "$tmpdir/seq", "$tmpdir/bp") {
+  if(-e $file) { unlink $file; }
+}
+rmdir $tmpdir;
+
+###############
+# SUBROUTINES #
+###############
+
+# time_kernel: call $codeR repeatedly for at least $min_seconds
+#              seconds (and at least 3 times), return calls per second
+sub time_kernel {
+  my ($codeR, $min_seconds) = @_;
+
+  $codeR->(); # warm up
+  my $ncalls = 0;
+  my $start  = time();
+  my $elapsed = 0.;
+  while($ncalls < 3 || $elapsed < $min_seconds) {
+    $codeR->();
+    $ncalls++;
+    $elapsed = time() - $start;
+  }
+  return $ncalls / $elapsed;
+}
+
+# read_baseline: read a baseline file, return hash, key: kernel name, value: calls/sec
+sub read_baseline {
+  my ($file) = @_;
+
+  my %retH = ();
+  if(! -e $file) {
+    diag("no performance baseline file $file, only checking scaling (set BIO_EASEL_PERF_UPDATE=1 to create it)");
+    return %retH;
+  }
+  open(IN, $file) || die "ERROR unable to open $file for reading";
+  while(my $line = <IN>) {
+    if($line =~ m/^\#/) { next; }
+    if($line =~ m/^(\S+)\s+(\S+)/) { $retH{$1} = $2; }
+  }
+  close(IN);
+
+  return %retH;
+}
+
+# write_baseline: write a baseline file from hash, key: kernel name, value: calls/sec
+sub write_baseline {
+  my ($file, $measuredHR) = @_;
+
+  open(OUT, ">", $file) || die "ERROR unable to open $file for writing";
+  print OUT ("# Bio-Easel performance baseline, calls per second, see t/17-perf.t\n");
+  print OUT ("# written " . scalar(localtime()) . "\n");
+  foreach my $name (sort keys %{$measuredHR}) {
+    printf OUT ("%-26s  %.4f\n", $name, $measuredHR->{$name});
+  }
+  close(OUT);
+
+  return;
+}
+
+# write_synthetic_stockholm: write an RNA alignment of $nseq seqs and $alen
+#                            columns with a nested SS_cons, mostly conserved
+#                            base pairs and some gaps.
+sub write_synthetic_stockholm {
+  my ($file, $nseq, $alen) = @_;
+
+  my @ntA  = ("A", "C", "G", "U");
+  my %bpH  = ("A" => "U", "C" => "G", "G" => "C", "U" => "A");
+
+  # SS_cons: consecutive 'helix + hairpin loop' units, each
+  # unit is 2*stem + loop columns, the rest is unpaired
+  my @ssA = (".") x $alen;
+  my $apos = 0;
+  while($apos + 24 <= $alen) {
+    my $stem = 5 + int(rand(4));
+    my $loop = 4 + int(rand(4));
+    for(my $i = 0; $i < $stem; $i++) {
+      $ssA[$apos+$i]               = "<";
+      $ssA[$apos+2*$stem+$loop-1-$i] = ">";
+    }
+    $apos += 2*$stem + $loop + 2 + int(rand(6));
+  }
+  my @ctA = (-1) x $alen;
+  my @stackA = ();
+  for(my $i = 0; $i < $alen; $i++) {
+    if   ($ssA[$i] eq "<") { push(@stackA, $i); }
+    elsif($ssA[$i] eq ">") { my $j = pop(@stackA); $ctA[$i] = $j; $ctA[$j] = $i; }
+  }
+
+  my @rootA = map { $ntA[int(rand(4))] } (1..$alen);
+  for(my $i = 0; $i < $alen; $i++) { if($ctA[$i] > $i) { $rootA[$ctA[$i]] = $bpH{$rootA[$i]}; } }
+
+  open(OUT, ">", $file) || die "ERROR unable to open $file for writing";
+  print OUT ("# STOCKHOLM 1.0\n\n");
+  for(my $s = 1; $s <= $nseq; $s++) {
+    my @seqA = @rootA;
+    for(my $i = 0; $i < $alen; $i++) {
+      if(rand() < 0.15) {
+        $seqA[$i] = $ntA[int(rand(4))];
+        if($ctA[$i] != -1 && rand() < 0.7) { $seqA[$ctA[$i]] = $bpH{$seqA[$i]}; } # covarying substitution
+      }
+    }
+    for(my $i = 0; $i < $alen; $i++) {
+      if(rand() < 0.01) { my $len = 1 + int(rand(8)); for(my $j = $i; $j < $alen && $j < $i+$len; $j++) { $seqA[$j] = "-"; } }
+    }
+    printf OUT ("%-12s %s\n", "seq$s", join("", @seqA));
+  }
+  printf OUT ("%-12s %s\n", "#=GC SS_cons", join("", @ssA));
+  print OUT ("//\n");
+  close(OUT);
+
+  return;
+}
+
+# write_synthetic_fasta: write a fasta file of $nseq RNA seqs of lengths 50 to 2000
+sub write_synthetic_fasta {
+  my ($file, $nseq) = @_;
+
+  my @ntA = ("A", "C", "G", "U");
+  open(OUT, ">", $file) || die "ERROR unable to open $file for writing";
+  for(my $s = 1; $s <= $nseq; $s++) {
+    my $len = 50 + int(rand(1950));
+    my $seq = join("", map { $ntA[int(rand(4))] } (1..$len));
+    print OUT (">seq$s\n");
+    for(my $i = 0; $i < $len; $i += 60) { print OUT (substr($seq, $i, 60) . "\n"); }
+  }
+  close(OUT);
+
+  return;
+}
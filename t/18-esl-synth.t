@@ -0,0 +1,88 @@
+#! /usr/bin/perl
+#
+# Tests for esl-synth-msa.pl and esl-synth-seqdb.pl: scripts that use
+# BioEasel to generate synthetic alignments and sequence files.
+#
+use strict;
+use warnings FATAL => 'all';
+use Test::More tests => 15;
+
+BEGIN {
+  use_ok( 'Bio::Easel::MSA' )    || print "Bail out!\n";
+  use_ok( 'Bio::Easel::SqFile' ) || print "Bail out!\n";
+}
+
+my $scriptdir = "./scripts";
+my @unlinkA   = (); # array of files to unlink at end
+
+# alignment generator
+run_command("$scriptdir/esl-synth-msa.pl -s 33 -n 50 -L 80 synth1.stk");
+run_command("$scriptdir/esl-synth-msa.pl -s 33 -n 50 -L 80 synth2.stk");
+run_command("$scriptdir/esl-synth-msa.pl -s 34 -n 50 -L 80 synth3.stk");
+push(@unlinkA, ("synth1.stk", "synth2.stk", "synth3.stk"));
+
+my $msa = Bio::Easel::MSA->new({ fileLocation => "synth1.stk" });
+isa_ok($msa, "Bio::Easel::MSA");
+is($msa->nseq,        50, "esl-synth-msa.pl generated correct number of sequences");
+is($msa->get_rflen,   80, "esl-synth-msa.pl generated correct consensus length");
+is($msa->has_ss_cons,  1, "esl-synth-msa.pl generated SS_cons");
+ok($msa->alen >= 80,      "esl-synth-msa.pl generated alignment length at least consensus length");
+my $ppstr = $msa->get_ppstring_aligned(0);
+is(length($ppstr), $msa->alen, "esl-synth-msa.pl generated PP annotation");
+is(file_contents("synth1.stk"), file_contents("synth2.stk"), "esl-synth-msa.pl same seed gives same alignment");
+isnt(file_contents("synth1.stk"), file_contents("synth3.stk"), "esl-synth-msa.pl different seed gives different alignment");
+
+# sequence generator
+run_command("$scriptdir/esl-synth-seqdb.pl -s 33 -n 200 --mean 300 --sd 100 synth1.fa");
+run_command("$scriptdir/esl-synth-seqdb.pl -s 33 -n 200 --mean 300 --sd 100 synth2.fa");
+run_command("$scriptdir/esl-synth-seqdb.pl -s 33 -n 20 --amino synth3.fa");
+push(@unlinkA, ("synth1.fa", "synth2.fa", "synth3.fa", "synth1.fa.ssi"));
+
+my $sqfile = Bio::Easel::SqFile->new({ fileLocation => "synth1.fa", forceIndex => 1 });
+isa_ok($sqfile, "Bio::Easel::SqFile");
+is($sqfile->nseq_ssi, 200, "esl-synth-seqdb.pl generated correct number of sequences");
+my $avglen = $sqfile->nres_ssi / 200.;
+ok($avglen > 200 && $avglen < 400, "esl-synth-seqdb.pl generated sequences of roughly the requested mean length");
+is(file_contents("synth1.fa"), file_contents("synth2.fa"), "esl-synth-seqdb.pl same seed gives same sequences");
+my $aa = file_contents("synth3.fa");
+$aa =~ s/^>.*\n//mg;
+ok($aa =~ m/[EFILPQWY]/i, "esl-synth-seqdb.pl --amino generated protein sequences");
+
+undef $msa;
+undef $sqfile;
+clean_up(\@unlinkA);
+
+###############
+# SUBROUTINES #
+###############
+sub run_command {
+  if(scalar(@_) != 1) { die "ERROR run_command entered with wrong number of input args"; }
+  my ($cmd) = (@_);
+  printf("running $cmd\n");
+  system($cmd);
+  if($? != 0) { die "ERROR command $cmd failed (\$? = $?)"; }
+  return;
+}
+###############
+sub clean_up {
+  if(scalar(@_) != 1) { die "ERROR clean_up entered with wrong number of input args"; }
+  my ($unlinkAR) = (@_);
+  foreach my $file (@{$unlinkAR}) { 
+    if(-e $file) { unlink $file; }
+    if(-e $file) { die "ERROR, unable to unlink $file"; }
+  }
+  return;
+}
+###############
+sub file_contents {
+  if(scalar(@_) != 1) { die "ERROR file_contents entered with wrong number of input args"; }
+  my ($file) = (@_);
+  open(IN, $file) || die "ERROR unable to open $file";
+  my $contents = "";
+  while(my $line = <IN>) { 
+    $contents .= $line;
+  }
+  close(IN);
+  return $contents;
+}
+###############
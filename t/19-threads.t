@@ -0,0 +1,120 @@
+#! /usr/bin/perl
+#
+# Tests for the shared worker thread pool (bio_easel_threads.h):
+# the thread count setting, and that the parallel kernels give
+# the same results with any number of threads.
+#
+use strict;
+use warnings FATAL => 'all';
+use Config;
+use Test::More tests => 14;
+
+BEGIN {
+  use_ok( 'Bio::Easel' )      || print "Bail out!\n";
+  use_ok( 'Bio::Easel::MSA' ) || print "Bail out!\n";
+}
+
+my @unlinkA = (); # array of files to unlink at end
+
+# thread count setting
+Bio::Easel->set_threads(3);
+is(Bio::Easel->get_threads(), 3, "set_threads() sets number of threads");
+Bio::Easel->set_threads(undef);
+$ENV{"BIO_EASEL_THREADS"} = 2;
+is(Bio::Easel->get_threads(), 2, "BIO_EASEL_THREADS sets number of threads");
+Bio::Easel->set_threads(5);
+is(Bio::Easel->get_threads(), 5, "set_threads() takes precedence over BIO_EASEL_THREADS");
+delete $ENV{"BIO_EASEL_THREADS"};
+Bio::Easel->set_threads(0);
+ok(Bio::Easel->get_threads() >= 1, "default number of threads is at least 1");
+eval { Bio::Easel->set_threads("two"); };
+ok($@, "set_threads() dies on a non-integer");
+
+# an alignment big enough to be split among threads
+run_command("./scripts/esl-synth-msa.pl -s 7 -n 300 -L 100 -c 4 threads.stk");
+push(@unlinkA, "threads.stk");
+
+my %avgidH = ();
+my %qcH    = ();
+foreach my $nthreads (1, 2, 4) {
+  Bio::Easel->set_threads($nthreads);
+  my $msa = Bio::Easel::MSA->new({ fileLocation => "threads.stk" });
+  $avgidH{$nthreads} = $msa->average_id(1000);
+  $msa->rfam_qc_stats("threads.fam", "threads.seq", "threads.bp");
+  $qcH{$nthreads} = file_contents("threads.fam");
+  push(@unlinkA, ("threads.fam", "threads.seq", "threads.bp"));
+  undef $msa;
+}
+ok($avgidH{1} > 0. && $avgidH{1} <= 1., "average_id() with 1 thread is sane");
+is($avgidH{2}, $avgidH{1}, "average_id() with 2 threads same as with 1");
+is($avgidH{4}, $avgidH{1}, "average_id() with 4 threads same as with 1");
+is($qcH{2},    $qcH{1},    "rfam_qc_stats() with 2 threads same as with 1");
+is($qcH{4},    $qcH{1},    "rfam_qc_stats() with 4 threads same as with 1");
+
+# the pool still works in a child process after a fork() (4 threads are still set)
+my $pid = fork();
+if(! defined $pid) { die "ERROR unable to fork"; }
+if($pid == 0) {
+  my $msa = Bio::Easel::MSA->new({ fileLocation => "threads.stk" });
+  exit(($msa->average_id(1000) == $avgidH{1}) ? 0 : 1);
+}
+waitpid($pid, 0);
+is($?, 0, "average_id() with 4 threads works after fork()");
+
+# ithreads each get their own pool: two running at once, with different
+# numbers of threads, don't disturb each other
+SKIP: {
+  skip "perl not built with ithreads", 1 if ! $Config{useithreads};
+  require threads;
+  my @thrA = map { 
+    my $nthreads = $_;
+    threads->create(sub { 
+      Bio::Easel->set_threads($nthreads);
+      my $nok = 0;
+      for(my $i = 0; $i < 20; $i++) { 
+        my $msa = Bio::Easel::MSA->new({ fileLocation => "threads.stk" });
+        if($msa->average_id(1000) == $avgidH{1}) { $nok++; }
+      }
+      return $nok;
+    });
+  } (2, 3);
+  my @nokA = map { $_->join() } @thrA;
+  is(join(",", @nokA), "20,20", "average_id() works in two ithreads at once");
+}
+
+Bio::Easel->set_threads(undef);
+clean_up(\@unlinkA);
+
+###############
+# SUBROUTINES #
+###############
+sub run_command {
+  if(scalar(@_) != 1) { die "ERROR run_command entered with wrong number of input args"; }
+  my ($cmd) = (@_);
+  system($cmd);
+  if($? != 0) { die "ERROR command $cmd failed (\$? = $?)"; }
+  return;
+}
+###############
+sub clean_up {
+  if(scalar(@_) != 1) { die "ERROR clean_up entered with wrong number of input args"; }
+  my ($unlinkAR) = (@_);
+  foreach my $file (@{$unlinkAR}) {
+    if(-e $file) { unlink $file; }
+    if(-e $file) { die "ERROR, unable to unlink $file"; }
+  }
+  return;
+}
+###############
+sub file_contents {
+  if(scalar(@_) != 1) { die "ERROR file_contents entered with wrong number of input args"; }
+  my ($file) = (@_);
+  open(IN, $file) || die "ERROR unable to open $file";
+  my $contents = "";
+  while(my $line = <IN>) {
+    $contents .= $line;
+  }
+  close(IN);
+  return $contents;
+}
+###############
@@ -0,0 +1,64 @@
+#! /usr/bin/perl
+#
+# Tests for Bio::Easel::Parallel: a fork based parallel map over
+# files or other items, with results returned in order.
+#
+use strict;
+use warnings FATAL => 'all';
+use Test::More tests => 14;
+
+BEGIN {
+  use_ok( 'Bio::Easel::Parallel' ) || print "Bail out!\n";
+  use_ok( 'Bio::Easel::MSA' )      || print "Bail out!\n";
+  use_ok( 'Bio::Easel::SqFile' )   || print "Bail out!\n";
+}
+
+my $par = Bio::Easel::Parallel->new({ nworkers => 3 });
+isa_ok($par, "Bio::Easel::Parallel");
+is($par->nworkers, 3, "nworkers() returns number of workers");
+
+# plain map, results in order even if items finish out of order
+my @resultA = $par->map(sub { my ($x) = @_; select(undef, undef, undef, ($x % 3) * 0.01); return $x * $x; }, [ 1..30 ]);
+is(join(",", @resultA), join(",", map { $_ * $_ } (1..30)), "map() returns results in order");
+
+# iterator and on_result callback
+my $i = 0;
+my @seenA = ();
+$par->map(sub { return { double => 2 * $_[0] }; }, sub { return ($i < 10) ? $i++ : undef; },
+          { on_result => sub { my ($idx, $item, $result) = @_; push(@seenA, "$idx:$item:$result->{double}"); } });
+is(join(" ", @seenA), join(" ", map { "$_:$_:" . (2 * $_) } (0..9)), "map() with iterator and on_result works");
+
+# errors
+eval { $par->map(sub { if($_[0] == 5) { die "item five\n"; } return $_[0]; }, [ 1..10 ]); };
+like($@, qr/item 4: item five/, "map() dies with the worker's error");
+{
+  local $SIG{__WARN__} = sub { };
+  my @skipA = $par->map(sub { if($_[0] == 2) { die "item two\n"; } return $_[0]; }, [ 1..4 ], { on_error => "skip" });
+  is(join(",", map { defined $_ ? $_ : "undef" } @skipA), "1,undef,3,4", "map() with on_error 'skip' gives undef for failed items");
+}
+eval { $par->map(sub { if($_[0] == 3) { POSIX::_exit(1); } return $_[0]; }, [ 1..6 ]); };
+like($@, qr/exited unexpectedly/, "map() dies if a worker exits");
+
+# alignment files: same results as in this process
+my @alnfileA = ("./t/data/test.sto", "./t/data/RF00014-seed.sto", "./t/data/test.rf.sto", "./t/data/RF00177-3seqs.sto");
+my @expA = ();
+foreach my $file (@alnfileA) {
+  my $msa = Bio::Easel::MSA->new({ fileLocation => $file });
+  push(@expA, $msa->nseq . ":" . $msa->alen);
+}
+my @gotA = $par->map_msa_files(\@alnfileA, sub { my ($msa, $file) = @_; return $msa->nseq . ":" . $msa->alen; });
+is(join(",", @gotA), join(",", @expA), "map_msa_files() works");
+
+# sequence files
+my @nseqA = $par->map_sqfiles([ "./t/data/trna-11.fa", "./t/data/trna-100.fa" ],
+                              sub { my ($sqfile, $file) = @_; return $sqfile->nseq_ssi; }, { open_args => { forceIndex => 1 } });
+is(join(",", @nseqA), "12,100", "map_sqfiles() works");
+unlink("./t/data/trna-11.fa.ssi");
+unlink("./t/data/trna-100.fa.ssi");
+
+# a single worker runs in this process
+my $par1 = Bio::Easel::Parallel->new({ nworkers => 1 });
+is(join(",", $par1->map(sub { return $$; }, [ 1, 2 ])), "$$,$$", "map() with 1 worker doesn't fork");
+
+eval { Bio::Easel::Parallel->new({ nworkers => 0 }); };
+ok($@, "new() dies with 0 workers");
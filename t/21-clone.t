@@ -0,0 +1,65 @@
+#! /usr/bin/perl
+#
+# Tests for CLONE support: MSA, SqFile and Random objects are still
+# usable in a new thread, in an ithreads perl.
+#
+use strict;
+use warnings FATAL => 'all';
+use Config;
+use Test::More;
+
+BEGIN {
+  if(! $Config{useithreads}) {
+    plan skip_all => "perl not built with ithreads";
+  }
+  else {
+    plan tests => 16;
+  }
+}
+
+use threads;
+
+BEGIN {
+  use_ok( 'Bio::Easel::MSA' )    || print "Bail out!\n";
+  use_ok( 'Bio::Easel::SqFile' ) || print "Bail out!\n";
+  use_ok( 'Bio::Easel::Random' ) || print "Bail out!\n";
+}
+
+my $alnfile = "./t/data/test.sto";
+
+# default, "copy": the thread can modify its own copy
+my $msa = Bio::Easel::MSA->new({ fileLocation => $alnfile });
+my $nseq = $msa->nseq;
+$msa->set_name("parent");
+my ($thr_nseq, $thr_shared) = threads->create(sub { my @ret = ($msa->nseq, $msa->is_shared); $msa->set_name("thread"); return @ret; })->join();
+is($thr_nseq,      $nseq,    "MSA is usable in a new thread (copy)");
+is($thr_shared,    0,        "MSA is not shared in a new thread (copy)");
+is($msa->get_name, "parent", "thread's changes don't affect the copied MSA");
+
+# "share": both threads use the same ESL_MSA
+$msa->set_clone_mode("share");
+($thr_nseq, $thr_shared) = threads->create(sub { return ($msa->nseq, $msa->is_shared); })->join();
+is($thr_nseq,   $nseq, "MSA is usable in a new thread (share)");
+is($thr_shared, 1,     "MSA is shared in a new thread (share)");
+is($msa->is_shared, 0, "MSA is no longer shared once the thread is done");
+
+my $thr_name = threads->create(sub { $msa->unshare; $msa->set_name("thread"); return $msa->get_name; })->join();
+is($thr_name,      "thread", "unshare() gives the thread an MSA it can modify");
+is($msa->get_name, "parent", "thread's changes after unshare() don't affect the shared MSA");
+
+# methods that modify a shared MSA, or its index, copy it first
+my $name0 = $msa->get_sqname(0);
+my ($thr_idx, $thr_still_shared) = threads->create(sub { my $idx = $msa->get_sqidx($name0); $msa->set_name("thread"); return ($idx, $msa->is_shared); })->join();
+is($thr_idx,          0,        "get_sqidx() works on a shared MSA");
+is($thr_still_shared, 0,        "modifying a shared MSA gives the thread its own copy");
+is($msa->get_name,    "parent", "thread's changes to a shared MSA don't affect the other thread's object");
+
+# sequence files are reopened in the new thread
+my $sqfile = Bio::Easel::SqFile->new({ fileLocation => "./t/data/trna-11.fa" });
+my $first  = $sqfile->fetch_consecutive_seqs(1, "", 60);
+is(threads->create(sub { return $sqfile->fetch_consecutive_seqs(1, "", 60); })->join(), $first, "SqFile is reopened in a new thread");
+
+# random number generators are copied in the same state
+my $rng = Bio::Easel::Random->new({ seed => 33 });
+my $thr_roll = threads->create(sub { return $rng->roll(1000000); })->join();
+is($thr_roll, $rng->roll(1000000), "Random is copied in a new thread");
@@ -0,0 +1,84 @@
+#! /usr/bin/perl
+#
+# Tests for progress reporting and cancellation of long running
+# operations: Bio::Easel->set_progress_callback() and cancel().
+#
+use strict;
+use warnings FATAL => 'all';
+use Test::More tests => 19;
+
+BEGIN {
+  use_ok( 'Bio::Easel' )         || print "Bail out!\n";
+  use_ok( 'Bio::Easel::MSA' )    || print "Bail out!\n";
+  use_ok( 'Bio::Easel::SqFile' ) || print "Bail out!\n";
+}
+
+my @unlinkA = ("progress.fam", "progress.seq", "progress.bp");
+
+eval { Bio::Easel->set_progress_callback("not code"); };
+ok($@, "set_progress_callback() dies if callback is not a code ref");
+eval { Bio::Easel->set_progress_callback(sub { }, -1); };
+ok($@, "set_progress_callback() dies if interval is negative");
+
+# record every call
+my @callA = ();
+Bio::Easel->set_progress_callback(sub { push(@callA, [ @_ ]); }, 0);
+
+my $msa = Bio::Easel::MSA->new({ fileLocation => "./t/data/RF00014-seed.sto" });
+$msa->set_name("progress");
+my $npairs = $msa->nseq * ($msa->nseq - 1) / 2;
+$msa->rfam_qc_stats(@unlinkA);
+is($callA[0][0],  "rfam_qc_stats", "rfam_qc_stats() reports progress");
+is($callA[0][1],  0,               "rfam_qc_stats() reports start");
+is($callA[-1][1], $npairs,         "rfam_qc_stats() reports end, in pairs");
+is($callA[-1][2], $npairs,         "rfam_qc_stats() reports total, in pairs");
+
+@callA = ();
+$msa->weight_GSC();
+is(join(",", map { "$_->[0]:$_->[1]/$_->[2]" } @callA), "weight_GSC:0/1,weight_GSC:1/1", "weight_GSC() reports start and end");
+
+@callA = ();
+my @usemeA = (1) x $msa->nseq;
+my @keepmeA = ();
+$msa->filter_msa_subset(\@usemeA, 0.8, \@keepmeA);
+ok(scalar(@callA) >= 2 && $callA[-1][1] == $msa->nseq, "filter_msa_subset() reports progress");
+
+# parallel methods called from the callback run single threaded
+Bio::Easel->set_threads(2);
+my $avgid  = $msa->average_id(1000);
+my @nestedA = ();
+Bio::Easel->set_progress_callback(sub { push(@nestedA, Bio::Easel::MSA->new({ fileLocation => "./t/data/RF00014-seed.sto" })->average_id(1000)); }, 0);
+$msa->rfam_qc_stats(@unlinkA);
+ok(scalar(@nestedA) >= 2 && ! grep { $_ != $avgid } @nestedA, "parallel methods can be called from the callback");
+Bio::Easel->set_threads(undef);
+
+# cancellation, from the callback
+Bio::Easel->set_progress_callback(sub { Bio::Easel->cancel(); }, 0);
+eval { $msa->rfam_qc_stats(@unlinkA); };
+like($@, qr/rfam_qc_stats cancelled/, "rfam_qc_stats() can be cancelled");
+eval { $msa->filter_msa_subset(\@usemeA, 0.8, \@keepmeA); };
+like($@, qr/filter_msa_subset cancelled/, "filter_msa_subset() can be cancelled");
+
+Bio::Easel->set_progress_callback(sub { die "no more\n"; }, 0);
+eval { $msa->rfam_qc_stats(@unlinkA); };
+like($@, qr/rfam_qc_stats cancelled, progress callback died: no more/, "rfam_qc_stats() is cancelled if the callback dies");
+
+# cancelled before it starts: no index is created
+Bio::Easel->set_progress_callback(undef);
+my $sqfile = Bio::Easel::SqFile->new({ fileLocation => "./t/data/trna-100.fa" });
+unlink("./t/data/trna-100.fa.ssi");
+Bio::Easel->cancel();
+eval { $sqfile->create_ssi_index(); };
+like($@, qr/create_ssi_index cancelled/, "create_ssi_index() can be cancelled");
+ok(! -e "./t/data/trna-100.fa.ssi", "create_ssi_index() doesn't write an index when cancelled");
+
+# a cancellation only applies to one operation
+@callA = ();
+Bio::Easel->set_progress_callback(sub { push(@callA, [ @_ ]); }, 0);
+$sqfile->create_ssi_index();
+ok(-e "./t/data/trna-100.fa.ssi", "create_ssi_index() works after a cancellation");
+is($callA[-1][1], -s "./t/data/trna-100.fa", "create_ssi_index() reports progress in bytes");
+unlink("./t/data/trna-100.fa.ssi");
+
+Bio::Easel->set_progress_callback(undef);
+foreach my $file (@unlinkA) { if(-e $file) { unlink $file; } }
@@ -0,0 +1,64 @@
+#! /usr/bin/perl
+#
+# Tests for collapsing identical sequences of an MSA:
+# collapse_identical_sequences().
+#
+use strict;
+use warnings FATAL => 'all';
+use Test::More tests => 14;
+
+BEGIN {
+  use_ok( 'Bio::Easel::MSA' ) || print "Bail out!\n";
+}
+
+my $alnfile = "collapse.sto";
+open(OUT, ">", $alnfile) || die "ERROR unable to open $alnfile for writing";
+print OUT <<'EOF';
+# STOCKHOLM 1.0
+
+seq1  AAGACUUCGG-AUCUGGCG
+seq2  AAGACUUCGG-AUCUGGCG
+seq3  aagacuucgg.aucuggcg
+seq4  AUACACUUCGGAUG-CACC
+seq5  AAGACUUCGG.AUCUGGCG
+seq6  AUACACUUCGGAUG-CACC
+#=GC SS_cons  :::::::::::::::::::
+//
+EOF
+close(OUT);
+
+# digital mode: case never matters, '-' and '.' are the same gap
+my $msa = Bio::Easel::MSA->new({ fileLocation => $alnfile });
+my ($new_msa, $countAR, $wgtAR, $groupAR) = $msa->collapse_identical_sequences();
+is($new_msa->nseq, 2, "collapse_identical_sequences() collapses identical digital sequences");
+is(join(",", map { $new_msa->get_sqname($_) } (0..$new_msa->nseq-1)), "seq1,seq4", "collapse_identical_sequences() keeps first of each group");
+is(join(",", @{$countAR}), "4,2", "collapse_identical_sequences() returns multiplicities");
+is(join(",", @{$groupAR}), "0,0,0,1,0,1", "collapse_identical_sequences() returns groups");
+ok(! defined $wgtAR, "collapse_identical_sequences() returns no weights unless asked");
+
+($new_msa, $countAR, $wgtAR) = $msa->collapse_identical_sequences({ sum_weights => 1 });
+is(join(",", @{$wgtAR}), "4,2", "collapse_identical_sequences() sums weights of 1.0 without weights");
+
+$msa->weight_GSC();
+my $wtot = 0.;
+for(my $i = 0; $i < $msa->nseq; $i++) { $wtot += $msa->get_sqwgt($i); }
+($new_msa, $countAR, $wgtAR) = $msa->collapse_identical_sequences({ sum_weights => 1 });
+ok(abs(($wgtAR->[0] + $wgtAR->[1]) - $wtot) < 0.0001, "collapse_identical_sequences() sums weights");
+undef $msa;
+
+# text mode: case and gap characters only matter unless told otherwise
+$msa = Bio::Easel::MSA->new({ fileLocation => $alnfile, forceText => 1 });
+($new_msa, $countAR) = $msa->collapse_identical_sequences();
+is(join(",", @{$countAR}), "2,1,2,1", "collapse_identical_sequences() in text mode");
+($new_msa, $countAR) = $msa->collapse_identical_sequences({ gaps_equal => 1 });
+is(join(",", @{$countAR}), "3,1,2", "collapse_identical_sequences() with gaps_equal");
+($new_msa, $countAR) = $msa->collapse_identical_sequences({ case_equal => 1 });
+is(join(",", @{$countAR}), "2,2,2", "collapse_identical_sequences() with case_equal");
+($new_msa, $countAR, $wgtAR, $groupAR) = $msa->collapse_identical_sequences({ gaps_equal => 1, case_equal => 1 });
+is(join(",", @{$countAR}), "4,2", "collapse_identical_sequences() with gaps_equal and case_equal");
+is(join(",", @{$groupAR}), "0,0,0,1,0,1", "collapse_identical_sequences() with gaps_equal and case_equal returns groups");
+
+eval { $msa->collapse_identical_sequences({ ignore_case => 1 }); };
+ok($@, "collapse_identical_sequences() dies with an unknown option");
+
+unlink $alnfile;
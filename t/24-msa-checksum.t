@@ -0,0 +1,57 @@
+#! /usr/bin/perl
+#
+# Tests for the incrementally maintained alignment checksum of an MSA:
+# row_checksum() and set_sqstring_aligned().
+#
+use strict;
+use warnings FATAL => 'all';
+use Test::More tests => 14;
+
+BEGIN {
+  use_ok( 'Bio::Easel::MSA' ) || print "Bail out!\n";
+}
+
+my $alnfile = "./t/data/RF00014-seed.sto";
+my $msa = Bio::Easel::MSA->new({ fileLocation => $alnfile });
+my $orig = $msa->row_checksum();
+like($orig, qr/^[0-9a-f]{16}$/, "row_checksum() returns 16 hex digits");
+is(Bio::Easel::MSA->new({ fileLocation => $alnfile })->row_checksum(), $orig, "row_checksum() is the same for the same MSA");
+
+# changing one sequence
+my $sqstring = $msa->get_sqstring_aligned(1);
+$msa->set_sqstring_aligned($sqstring, 1);
+is($msa->row_checksum(), $orig, "set_sqstring_aligned() with the same sequence doesn't change row_checksum()");
+my $new_sqstring = $msa->get_sqstring_aligned(0);
+$msa->set_sqstring_aligned($new_sqstring, 1);
+isnt($msa->row_checksum(), $orig, "set_sqstring_aligned() changes row_checksum()");
+my $msa2 = Bio::Easel::MSA->new({ fileLocation => $alnfile });
+$msa2->set_sqstring_aligned($new_sqstring, 1);
+is($msa->row_checksum(), $msa2->row_checksum(), "row_checksum() after set_sqstring_aligned() is same as recomputed");
+$msa->set_sqstring_aligned($sqstring, 1);
+is($msa->row_checksum(), $orig, "row_checksum() is restored with the original sequence");
+eval { $msa->set_sqstring_aligned("ACGU", 1); };
+ok($@, "set_sqstring_aligned() dies with a sequence of the wrong length");
+
+# order matters
+my @nameA = map { $msa->get_sqname($_) } (0..$msa->nseq-1);
+$msa->reorder_all([ reverse @nameA ]);
+isnt($msa->row_checksum(), $orig, "reorder_all() changes row_checksum()");
+$msa->reorder_all(\@nameA);
+is($msa->row_checksum(), $orig, "reorder_all() back to the original order restores row_checksum()");
+
+# subsets get the hashes of the sequences they keep
+my @usemeA = map { $_ % 2 } (0..$msa->nseq-1);
+my $sub_msa  = $msa->sequence_subset(\@usemeA);
+my $sub_msa2 = Bio::Easel::MSA->new({ fileLocation => $alnfile })->sequence_subset(\@usemeA);
+is($sub_msa->row_checksum(), $sub_msa2->row_checksum(), "row_checksum() of sequence_subset() is same as recomputed");
+$sub_msa  = $msa->sequence_subset_given_names([ @nameA[0..2] ]);
+$sub_msa2 = Bio::Easel::MSA->new({ fileLocation => $alnfile })->sequence_subset_given_names([ @nameA[0..2] ]);
+is($sub_msa->row_checksum(), $sub_msa2->row_checksum(), "row_checksum() of sequence_subset_given_names() is same as recomputed");
+
+# other changes rehash everything
+my @colA = (0, (1) x ($msa->alen - 1));
+$msa->column_subset(\@colA);
+isnt($msa->row_checksum(), $orig, "column_subset() changes row_checksum()");
+$msa2 = Bio::Easel::MSA->new({ fileLocation => $alnfile });
+$msa2->column_subset(\@colA);
+is($msa->row_checksum(), $msa2->row_checksum(), "row_checksum() after column_subset() is same as recomputed");
@@ -0,0 +1,90 @@
+#! /usr/bin/perl
+#
+# Tests for the on-disk cache of per-alignment statistics:
+# Bio::Easel->set_cache_dir().
+#
+use strict;
+use warnings FATAL => 'all';
+use File::Temp qw(tempdir);
+use File::Find;
+use Test::More tests => 18;
+
+BEGIN {
+  use_ok( 'Bio::Easel' )      || print "Bail out!\n";
+  use_ok( 'Bio::Easel::MSA' ) || print "Bail out!\n";
+}
+
+my $alnfile = "./t/data/RF00014-seed.sto";
+my @outA    = ("cache.fam", "cache.seq", "cache.bp");
+my @out2A   = ("cache2.fam", "cache2.seq", "cache2.bp");
+my $tmpdir  = tempdir(CLEANUP => 1);
+my $dir     = "$tmpdir/cache";
+
+# operations that compute report progress, cached ones don't
+my @callA = ();
+Bio::Easel->set_progress_callback(sub { push(@callA, $_[0]); }, 0);
+
+Bio::Easel->set_cache_dir($dir);
+ok(-d $dir, "set_cache_dir() creates the directory");
+is(Bio::Easel->get_cache_dir(), $dir, "get_cache_dir() returns the directory");
+
+my $msa = Bio::Easel::MSA->new({ fileLocation => $alnfile });
+$msa->weight_GSC();
+my @wgtA  = map { $msa->get_sqwgt($_) } (0..$msa->nseq-1);
+my @covA  = $msa->pos_covariation();
+my $avgid = $msa->average_id();
+$msa->rfam_qc_stats(@outA);
+ok(scalar(@callA) > 0, "results are computed with an empty cache");
+my $nfiles = 0;
+find(sub { if(m/\.stor$/) { $nfiles++; } }, $dir);
+is($nfiles, 4, "results are written to the cache");
+
+@callA = ();
+my $msa2 = Bio::Easel::MSA->new({ fileLocation => $alnfile });
+$msa2->weight_GSC();
+is(join(",", map { $msa2->get_sqwgt($_) } (0..$msa2->nseq-1)), join(",", @wgtA), "weight_GSC() weights from the cache");
+ok($msa2->has_sqwgts(), "weight_GSC() from the cache sets weights");
+is(join(",", $msa2->pos_covariation()), join(",", @covA), "pos_covariation() from the cache");
+is($msa2->average_id(), $avgid, "average_id() from the cache");
+$msa2->rfam_qc_stats(@out2A);
+is(join("", map { _slurp($_) } @out2A), join("", map { _slurp($_) } @outA), "rfam_qc_stats() output from the cache");
+is(scalar(@callA), 0, "cached results are not recomputed");
+
+# the per-sequence output has the names, so a new name is a new result
+$msa2->set_sqname(0, "renamed");
+$msa2->rfam_qc_stats(@out2A);
+ok(scalar(@callA) > 0, "rfam_qc_stats() is recomputed when a name changes");
+like(_slurp($out2A[1]), qr/renamed/, "rfam_qc_stats() recomputed output has the new name");
+
+# unreadable cache files are ignored
+find(sub { if(m/\.stor$/) { open(my $fh, ">", $_); print $fh "garbage"; close($fh); } }, $dir);
+@callA = ();
+$msa2 = Bio::Easel::MSA->new({ fileLocation => $alnfile });
+$msa2->weight_GSC();
+ok(scalar(@callA) > 0, "weight_GSC() is recomputed if the cache file is unreadable");
+is(join(",", map { $msa2->get_sqwgt($_) } (0..$msa2->nseq-1)), join(",", @wgtA), "weight_GSC() recomputed weights are right");
+
+# covariation is weighted when there are weights: weighted and
+# unweighted results are cached separately
+my $msa3 = Bio::Easel::MSA->new({ fileLocation => $alnfile });
+my @unwgt_covA = $msa3->pos_covariation();
+$msa3->weight_GSC();
+isnt(join(",", $msa3->pos_covariation()), join(",", @unwgt_covA), "pos_covariation() with weights isn't the cached result without");
+
+# no cache
+Bio::Easel->set_cache_dir(undef);
+@callA = ();
+$msa2->weight_GSC();
+ok(scalar(@callA) > 0, "set_cache_dir(undef) turns off caching");
+
+Bio::Easel->set_progress_callback(undef);
+foreach my $file (@outA, @out2A) { if(-e $file) { unlink $file; } }
+
+sub _slurp {
+  my ($file) = @_;
+  open(my $in, "<", $file) || die "ERROR unable to open $file";
+  local $/;
+  my $content = <$in>;
+  close($in);
+  return $content;
+}
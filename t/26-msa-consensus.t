@@ -0,0 +1,55 @@
+#! /usr/bin/perl
+#
+# Tests for consensus sequences of an MSA: consensus_sequence().
+#
+use strict;
+use warnings FATAL => 'all';
+use Test::More tests => 15;
+
+BEGIN {
+  use_ok( 'Bio::Easel::MSA' ) || print "Bail out!\n";
+}
+
+my $alnfile = "consensus.sto";
+open(OUT, ">", $alnfile) || die "ERROR unable to open $alnfile for writing";
+print OUT <<'EOF2';
+# STOCKHOLM 1.0
+
+s1  AAGC-U
+s2  AAGC-U
+s3  AGGU-C
+s4  ACGU.-
+s5  A-GA-G
+//
+EOF2
+close(OUT);
+
+my $msa = Bio::Easel::MSA->new({ fileLocation => $alnfile, isRna => 1 });
+is($msa->consensus_sequence(),                 "AAGC-U", "consensus_sequence() default is plurality");
+is($msa->consensus_sequence("plurality"),      "AAGC-U", "consensus_sequence() plurality");
+is($msa->consensus_sequence("majority"),       "ANGN-N", "consensus_sequence() majority");
+is($msa->consensus_sequence("majority", 0.3),  "AAGC-U", "consensus_sequence() majority with threshold");
+is($msa->consensus_sequence("iupac"),          "AVGH-B", "consensus_sequence() iupac");
+is($msa->consensus_sequence("iupac", 0.5),     "AAGY-U", "consensus_sequence() iupac with threshold");
+is($msa->consensus_sequence("gap"),            "AAGC-U", "consensus_sequence() gap");
+is($msa->consensus_sequence("gap", 0.9),       "A-GC--", "consensus_sequence() gap with threshold");
+
+# the profile is recomputed when a sequence changes
+$msa->set_sqstring_aligned("AAGC-U", 4);
+is($msa->consensus_sequence("majority"), "AAGC-U", "consensus_sequence() after set_sqstring_aligned()");
+
+eval { $msa->consensus_sequence("majority", 0.5, 1); };
+ok($@, "consensus_sequence() dies using weights if there are none");
+$msa->weight_GSC();
+is(length($msa->consensus_sequence("majority", 0.5, 1)), $msa->alen, "consensus_sequence() with weights");
+
+eval { $msa->consensus_sequence("mode"); };
+ok($@, "consensus_sequence() dies with an invalid mode");
+eval { $msa->consensus_sequence("majority", 1.5); };
+ok($@, "consensus_sequence() dies with an invalid threshold");
+
+$msa = Bio::Easel::MSA->new({ fileLocation => $alnfile, forceText => 1 });
+eval { $msa->consensus_sequence(); };
+ok($@, "consensus_sequence() dies in text mode");
+
+unlink $alnfile;
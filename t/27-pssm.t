@@ -0,0 +1,116 @@
+#! /usr/bin/perl
+#
+# Tests for position-specific scoring matrices: MSA build_pssm() 
+# and SqFile score_pssm().
+#
+use strict;
+use warnings FATAL => 'all';
+use Test::More tests => 18;
+
+BEGIN {
+  use_ok( 'Bio::Easel::MSA' )    || print "Bail out!\n";
+  use_ok( 'Bio::Easel::SqFile' ) || print "Bail out!\n";
+}
+
+my $alnfile = "pssm.sto";
+my $seqfile = "pssm.fa";
+open(OUT, ">", $alnfile) || die "ERROR unable to open $alnfile for writing";
+print OUT <<'EOF2';
+# STOCKHOLM 1.0
+
+s1  GAUCCAAG
+s2  GAUCCAAG
+s3  GAUCCAUG
+//
+EOF2
+close(OUT);
+open(OUT, ">", $seqfile) || die "ERROR unable to open $seqfile for writing";
+print OUT <<'EOF2';
+>seqA
+UUUUGAUCCAAGUUUU
+>seqB
+GAUC
+>seqC
+AAAACUUGGAUCAAAA
+EOF2
+close(OUT);
+
+my $msa  = Bio::Easel::MSA->new({ fileLocation => $alnfile, isRna => 1 });
+my $pssm = $msa->build_pssm();
+is($pssm->{width}, $msa->alen, "build_pssm() has a position per column");
+is($pssm->{alphabet} . ":" . $pssm->{residues}, "RNA:ACGU", "build_pssm() returns the alphabet");
+ok(abs($pssm->{scores}[0][2] - log((3 + 0.25) / 4 / 0.25) / log(2)) < 0.0001, "build_pssm() scores with pseudocounts");
+ok(abs($pssm->{scores}[6][3] - log((1 + 0.25) / 4 / 0.25) / log(2)) < 0.0001, "build_pssm() scores a minority residue");
+my $pssm2 = $msa->build_pssm({ A => 2, C => 2, G => 2, U => 2 });
+is(join(",", map { @{$_} } @{$pssm2->{scores}}), join(",", map { @{$_} } @{$pssm->{scores}}), "build_pssm() normalizes the background");
+eval { $msa->build_pssm(undef, 0); };
+ok($@, "build_pssm() dies with a pseudocount of 0");
+
+# the motif's own score
+my %resH = ();
+for(my $a = 0; $a < length($pssm->{residues}); $a++) { $resH{substr($pssm->{residues}, $a, 1)} = $a; }
+my $motif_sc = 0.;
+my @motifA = split("", "GAUCCAAG");
+for(my $k = 0; $k < scalar(@motifA); $k++) { $motif_sc += $pssm->{scores}[$k][$resH{$motifA[$k]}]; }
+
+my $sqfile = Bio::Easel::SqFile->new({ fileLocation => $seqfile });
+my @hitA = $sqfile->score_pssm($pssm);
+is(join(",", map { $_->[0] } @hitA), "seqA,seqC", "score_pssm() skips sequences shorter than the PSSM");
+is("$hitA[0][2]-$hitA[0][3]", "5-12", "score_pssm() finds the best window");
+ok(abs($hitA[0][1] - $motif_sc) < 0.0001, "score_pssm() returns the exact score");
+ok($hitA[1][2] < $hitA[1][3] && $hitA[1][1] < $motif_sc, "score_pssm() scores the top strand only by default");
+
+@hitA = $sqfile->score_pssm($pssm, { both_strands => 1 });
+is("$hitA[1][2]-$hitA[1][3]", "12-5", "score_pssm() with both_strands finds the reverse complement");
+
+@hitA = $sqfile->score_pssm($pssm, { min_score => $motif_sc - 0.001 });
+is(join(",", map { $_->[0] } @hitA), "seqA", "score_pssm() with min_score");
+
+eval { $sqfile->score_pssm($pssm, { strands => 2 }); };
+ok($@, "score_pssm() dies with an unknown option");
+
+# wide matrices, several 16-window blocks per sequence: the SSSE3 and
+# scalar scans agree, with 16-bit window scores (W = 1000) and with
+# 32-bit ones (W = 7000, too wide to keep 0.1 bits in 16)
+srand(7);
+my $widefile = "pssm-wide.fa";
+foreach my $W (1000, 7000) { 
+  my @colA = ();
+  for(my $k = 0; $k < $W; $k++) { 
+    push(@colA, [ map { ($W == 1000) ? (2. * rand() - 1.) : (int(rand(5)) - 2) } (1..4) ]);
+  }
+  my $widepssm = { alphabet => "RNA", residues => "ACGU", scores => \@colA };
+  my @seqA = ();
+  open(OUT, ">", $widefile) || die "ERROR unable to open $widefile for writing";
+  for(my $i = 0; $i < 3; $i++) { 
+    push(@seqA, join("", map { substr("ACGU", int(rand(4)), 1) } (1..($W + 100))));
+    print OUT ">wide$i\n$seqA[$i]\n";
+  }
+  close(OUT);
+  my $widesq = Bio::Easel::SqFile->new({ fileLocation => $widefile });
+  my @simdA = $widesq->score_pssm($widepssm, { both_strands => 1 });
+  $Bio::Easel::SqFile::PSSM_SIMD = 0;
+  my @scalarA = $widesq->score_pssm($widepssm, { both_strands => 1 });
+  $Bio::Easel::SqFile::PSSM_SIMD = 1;
+  is(join(",", map { @{$_} } @simdA), join(",", map { @{$_} } @scalarA), "score_pssm() SSSE3 and scalar scans agree with W = $W");
+  if($W == 7000) { 
+    # integer scores are quantized exactly: the best window by brute force
+    my @expA = ();
+    foreach my $seq (@seqA) { 
+      my ($best, $pos) = (undef, 0);
+      for(my $i = 0; $i + $W <= length($seq); $i++) { 
+        my $sc = 0;
+        for(my $k = 0; $k < $W; $k++) { $sc += $colA[$k][index("ACGU", substr($seq, $i + $k, 1))]; }
+        if(! defined $best || $sc > $best) { ($best, $pos) = ($sc, $i); }
+      }
+      push(@expA, $best . ":" . ($pos + 1) . "-" . ($pos + $W));
+    }
+    @hitA = $widesq->score_pssm($widepssm);
+    is(join(",", map { "$_->[1]:$_->[2]-$_->[3]" } @hitA), join(",", @expA), "score_pssm() finds the best window with W = $W");
+  }
+  $widesq->close_sqfile();
+}
+
+unlink $alnfile;
+unlink $seqfile;
+unlink $widefile;
@@ -0,0 +1,68 @@
+#! /usr/bin/perl
+#
+# Tests for sliding window statistics of an MSA: window_stats().
+#
+use strict;
+use warnings FATAL => 'all';
+use Test::More tests => 12;
+
+BEGIN {
+  use_ok( 'Bio::Easel::MSA' ) || print "Bail out!\n";
+}
+
+my $msa  = Bio::Easel::MSA->new({ fileLocation => "./t/data/RF00014-seed.sto" });
+my $alen = $msa->alen;
+my @entA  = $msa->pos_entropy();
+my @consA = $msa->pos_conservation();
+
+# windows of one column are the columns
+my @winA = $msa->window_stats(1, 1);
+is(scalar(@winA), $alen, "window_stats() with window 1 has a window per column");
+ok(_close([ map { $_->{entropy} } @winA ], \@entA), "window_stats() with window 1 entropy is pos_entropy()");
+ok(_close([ map { $_->{conservation} } @winA ], \@consA), "window_stats() with window 1 conservation is pos_conservation()");
+
+# overlapping windows are averages
+@winA = $msa->window_stats(10, 5);
+my @expA = ();
+for(my $start = 0; $start < $alen; $start += 5) { 
+  my $end = ($start + 10 < $alen) ? $start + 10 : $alen;
+  my $sum = 0.;
+  for(my $apos = $start; $apos < $end; $apos++) { $sum += $entA[$apos]; }
+  push(@expA, $sum / ($end - $start));
+  if($end == $alen) { last; }
+}
+is(scalar(@winA), scalar(@expA), "window_stats() returns the right number of windows");
+ok(_close([ map { $_->{entropy} } @winA ], \@expA), "window_stats() entropy is the average over the window");
+is($winA[-1]{end}, $alen, "window_stats() last window ends at the last column");
+
+# GC and gaps
+my $alnfile = "window.sto";
+open(OUT, ">", $alnfile) || die "ERROR unable to open $alnfile for writing";
+print OUT <<'EOF2';
+# STOCKHOLM 1.0
+
+s1  GGCCAU-
+s2  GGCAAU-
+//
+EOF2
+close(OUT);
+$msa = Bio::Easel::MSA->new({ fileLocation => $alnfile, isRna => 1 });
+@winA = $msa->window_stats(7);
+ok(abs($winA[0]{gc} - 7/12) < 0.0001 && abs($winA[0]{gap} - 2/14) < 0.0001, "window_stats() GC and gap fraction");
+@winA = $msa->window_stats(3);
+is(join(" ", map { "$_->{start}-$_->{end}" } @winA), "1-3 4-6 7-7", "window_stats() step defaults to window");
+ok(_close([ map { $_->{gc} } @winA ], [ 1, 1/6, 0 ]), "window_stats() GC per window");
+ok(_close([ map { $_->{gap} } @winA ], [ 0, 0, 1 ]), "window_stats() gap fraction per window");
+unlink $alnfile;
+
+eval { $msa->window_stats(0); };
+ok($@, "window_stats() dies with a window of 0");
+
+sub _close {
+  my ($AR, $expAR) = @_;
+  if(scalar(@{$AR}) != scalar(@{$expAR})) { return 0; }
+  for(my $i = 0; $i < scalar(@{$AR}); $i++) { 
+    if(abs($AR->[$i] - $expAR->[$i]) > 0.0001) { return 0; }
+  }
+  return 1;
+}
@@ -0,0 +1,50 @@
+#! /usr/bin/perl
+#
+# Tests for per-sequence composition, GC and length statistics:
+# comp_and_len_stats().
+#
+use strict;
+use warnings FATAL => 'all';
+use Test::More tests => 11;
+
+BEGIN {
+  use_ok( 'Bio::Easel::MSA' ) || print "Bail out!\n";
+}
+
+my $alnfile = "comp.sto";
+open(OUT, ">", $alnfile) || die "ERROR unable to open $alnfile for writing";
+print OUT <<'EOF2';
+# STOCKHOLM 1.0
+
+seq1  AAGC-GGCUU
+seq2  GGGG--CCCC
+seq3  ----------
+seq4  AANU-..ACU
+//
+EOF2
+close(OUT);
+
+my $msa = Bio::Easel::MSA->new({ fileLocation => $alnfile });
+my $statsHR = $msa->comp_and_len_stats();
+is($statsHR->{residues}, "ACGU", "comp_and_len_stats() returns the residues");
+
+my @lenA = unpack("i*", $statsHR->{length});
+is(join(",", @lenA), "9,8,0,7", "comp_and_len_stats() returns unaligned lengths");
+my @explenA = map { length($msa->get_sqstring_unaligned($_)) } (0..$msa->nseq-1);
+is(join(",", @lenA), join(",", @explenA), "comp_and_len_stats() lengths agree with get_sqstring_unaligned()");
+
+my @compA = unpack("d*", $statsHR->{composition});
+is(scalar(@compA), 4 * $msa->nseq, "comp_and_len_stats() returns K frequencies per sequence");
+is(join(",", map { sprintf("%.3f", $_) } @compA[0..3]), "0.222,0.222,0.333,0.222", "comp_and_len_stats() returns composition");
+is(join(",", map { sprintf("%.3f", $_) } @compA[4..7]), "0.000,0.500,0.500,0.000", "comp_and_len_stats() returns composition of a second sequence");
+is(join(",", @compA[8..11]), "0,0,0,0", "comp_and_len_stats() returns zero composition for an empty sequence");
+is(join(",", map { sprintf("%.3f", $_) } @compA[12..15]), "0.464,0.179,0.036,0.321", "comp_and_len_stats() splits degenerate residues");
+
+my @gcA = unpack("d*", $statsHR->{gc});
+is(join(",", map { sprintf("%.3f", $_) } @gcA), "0.556,1.000,0.000,0.214", "comp_and_len_stats() returns GC fractions");
+
+my $textmsa = Bio::Easel::MSA->new({ fileLocation => $alnfile, forceText => 1 });
+eval { $textmsa->comp_and_len_stats(); };
+ok($@, "comp_and_len_stats() dies with a text MSA");
+
+unlink $alnfile;
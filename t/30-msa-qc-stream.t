@@ -0,0 +1,85 @@
+#! /usr/bin/perl
+#
+# Tests for writing Rfam QC stats to one stream: rfam_qc_stats_stream()
+# and read_rfam_qc_binary().
+#
+use strict;
+use warnings FATAL => 'all';
+use Test::More tests => 14;
+
+BEGIN {
+  use_ok( 'Bio::Easel::MSA' ) || print "Bail out!\n";
+}
+
+my @unlinkA = ("qcstream.fam", "qcstream.seq", "qcstream.bp", "qcstream.tsv", "qcstream.bin");
+my ($famfile, $seqfile, $bpfile, $tsvfile, $binfile) = @unlinkA;
+
+my $msa = Bio::Easel::MSA->new({ fileLocation => "./t/data/RF00014-seed.sto" });
+$msa->set_name("RF00014");
+$msa->rfam_qc_stats($famfile, $seqfile, $bpfile);
+
+# the rows of the text tables, split on whitespace, without the header
+sub table_rows { 
+  my ($file) = @_;
+  open(my $in, "<", $file) || die "ERROR unable to open $file";
+  my @rowA = map { chomp; join("|", split(/\s+/, $_)) } <$in>;
+  close($in);
+  shift(@rowA);
+  return @rowA;
+}
+
+# tsv, twice to the same handle, header only the first time
+open(my $out, ">", $tsvfile) || die "ERROR unable to open $tsvfile for writing";
+print $out "# my own comment\n";
+$msa->rfam_qc_stats_stream($out);
+$msa->rfam_qc_stats_stream($out, { header => 0 });
+close($out);
+
+open(my $in, "<", $tsvfile) || die "ERROR unable to open $tsvfile";
+my @lineA = <$in>;
+close($in);
+chomp(@lineA);
+is($lineA[0], "# my own comment", "rfam_qc_stats_stream() writes after what's already in the handle");
+my @headerA = grep { m/^#(family|sequence|basepair)\t/ } @lineA;
+is(scalar(@headerA), 3, "rfam_qc_stats_stream() writes headers once per table, if asked");
+my %tsvH = ();
+foreach my $line (grep { ! m/^#/ } @lineA) { 
+  my ($table, @fieldA) = split(/\t/, $line);
+  push(@{$tsvH{$table}}, join("|", @fieldA));
+}
+my @famA = table_rows($famfile);
+my @seqA = table_rows($seqfile);
+my @bpA  = table_rows($bpfile);
+is(join("\n", @{$tsvH{family}}),   join("\n", @famA, @famA), "rfam_qc_stats_stream() tsv family table agrees with rfam_qc_stats()");
+is(join("\n", @{$tsvH{sequence}}), join("\n", @seqA, @seqA), "rfam_qc_stats_stream() tsv sequence table agrees with rfam_qc_stats()");
+is(join("\n", @{$tsvH{basepair}}), join("\n", @bpA,  @bpA),  "rfam_qc_stats_stream() tsv basepair table agrees with rfam_qc_stats()");
+
+# binary
+open($out, ">", $binfile) || die "ERROR unable to open $binfile for writing";
+binmode($out);
+$msa->rfam_qc_stats_stream($out, { format => "binary" });
+close($out);
+open($in, "<", $binfile) || die "ERROR unable to open $binfile";
+binmode($in);
+my $data = do { local $/; <$in> };
+close($in);
+my @recordA = Bio::Easel::MSA::read_rfam_qc_binary($data);
+my @famrecA = grep { $_->{table} eq "family"   } @recordA;
+my @seqrecA = grep { $_->{table} eq "sequence" } @recordA;
+my @bprecA  = grep { $_->{table} eq "basepair" } @recordA;
+is(scalar(@famrecA), 1,                    "read_rfam_qc_binary() reads one family record");
+is(scalar(@seqrecA), $msa->nseq,           "read_rfam_qc_binary() reads one record per sequence");
+is(scalar(@bprecA),  scalar(@bpA),         "read_rfam_qc_binary() reads one record per basepair");
+my @famfieldA = split(/\|/, $famA[0]);
+is(join(",", $famrecA[0]{family}, $famrecA[0]{nseq}, $famrecA[0]{alen}, $famrecA[0]{nbp}, $famrecA[0]{nres}), 
+   join(",", @famfieldA[0,3,4,5,6]), "rfam_qc_stats_stream() binary family record agrees with rfam_qc_stats()");
+is(sprintf("%.3f", $famrecA[0]{pid_mean}), $famfieldA[7], "rfam_qc_stats_stream() binary family record isn't rounded");
+is(join(",", map { $_->{sqname} . ":" . $_->{len} } @seqrecA), join(",", map { my @f = split(/\|/); "$f[1]:$f[3]" } @seqA), 
+   "rfam_qc_stats_stream() binary sequence records agree with rfam_qc_stats()");
+
+eval { Bio::Easel::MSA::read_rfam_qc_binary(substr($data, 0, length($data) - 1)); };
+ok($@, "read_rfam_qc_binary() dies with a truncated record");
+eval { open(my $mem, ">", \my $buf); $msa->rfam_qc_stats_stream($mem); };
+ok($@, "rfam_qc_stats_stream() dies with an in-memory handle");
+
+foreach my $file (@unlinkA) { if(-e $file) { unlink $file; } }
@@ -0,0 +1,77 @@
+#! /usr/bin/perl
+#
+# Tests for combining alignments: concatenate() (column-wise, by 
+# sequence name) and merge_rows() (row-wise, by RF column).
+#
+use strict;
+use warnings FATAL => 'all';
+use Test::More tests => 19;
+
+BEGIN {
+  use_ok( 'Bio::Easel::MSA' ) || print "Bail out!\n";
+}
+
+my %alnH = (
+  "cat1.sto" => "# STOCKHOLM 1.0\n\nseqA  ACGU\nseqB  AC-U\n#=GC SS_cons  <..>\n#=GC RF       xxxx\n//\n",
+  "cat2.sto" => "# STOCKHOLM 1.0\n\nseqB  GGA\nseqC  GGU\nseqA  G-A\n#=GC SS_cons  ...\n#=GC RF       xxx\n//\n",
+  "mrg1.sto" => "# STOCKHOLM 1.0\n\nseq1  AC.GU\nseq2  ACaGU\n#=GC SS_cons  <...>\n#=GC RF       xx.xx\n//\n",
+  "mrg2.sto" => "# STOCKHOLM 1.0\n\nseq3  AcgCGU\nseq4  A..CGU\n#=GC RF       x..xxx\n//\n",
+  "mrg3.sto" => "# STOCKHOLM 1.0\n\nseq5  ACG\n#=GC RF       xxx\n//\n",
+);
+foreach my $file (keys %alnH) { 
+  open(OUT, ">", $file) || die "ERROR unable to open $file for writing";
+  print OUT $alnH{$file};
+  close(OUT);
+}
+
+sub rows { 
+  my ($msa) = @_;
+  return join(" ", map { $msa->get_sqname($_) . ":" . $msa->get_sqstring_aligned($_) } (0..$msa->nseq-1));
+}
+
+# concatenate
+my $msa1 = Bio::Easel::MSA->new({ fileLocation => "cat1.sto" });
+my $msa2 = Bio::Easel::MSA->new({ fileLocation => "cat2.sto" });
+my ($cat, $partAR) = $msa1->concatenate([ $msa2 ]);
+is($cat->nseq, 3, "concatenate() has a row per name");
+is($cat->alen, 7, "concatenate() has the columns of all alignments");
+is(rows($cat), "seqA:ACGUG-A seqB:AC-UGGA seqC:----GGU", "concatenate() matches sequences by name and fills in gaps");
+is(join(",", map { "$_->[0]-$_->[1]" } @{$partAR}), "1-4,5-7", "concatenate() returns partitions");
+is($cat->get_rf, "xxxxxxx", "concatenate() concatenates RF");
+is($cat->get_ss_cons, "<..>...", "concatenate() concatenates SS_cons");
+is($cat->get_sqidx("seqC"), 2, "concatenate() MSA can be searched by name");
+
+($cat) = $msa1->concatenate([ $msa2, $msa1 ], { keep_common => 1 });
+is(rows($cat), "seqA:ACGUG-AACGU seqB:AC-UGGAAC-U", "concatenate() with keep_common");
+
+my $text1 = Bio::Easel::MSA->new({ fileLocation => "cat1.sto", forceText => 1 });
+my $text2 = Bio::Easel::MSA->new({ fileLocation => "cat2.sto", forceText => 1 });
+($cat) = $text1->concatenate([ $text2 ]);
+is(rows($cat), "seqA:ACGUG-A seqB:AC-UGGA seqC:----GGU", "concatenate() in text mode");
+
+eval { $msa1->concatenate([ $text2 ]); };
+ok($@, "concatenate() dies with digital and text alignments");
+eval { $msa1->concatenate([ $msa2 ], { keep => 1 }); };
+ok($@, "concatenate() dies with an unknown option");
+
+# merge_rows
+my $mrg1 = Bio::Easel::MSA->new({ fileLocation => "mrg1.sto", forceText => 1 });
+my $mrg2 = Bio::Easel::MSA->new({ fileLocation => "mrg2.sto", forceText => 1 });
+my $mrg3 = Bio::Easel::MSA->new({ fileLocation => "mrg3.sto", forceText => 1 });
+my $merged = $mrg1->merge_rows([ $mrg2 ]);
+is($merged->nseq, 4, "merge_rows() has all sequences");
+is(rows($merged), "seq1:A..C.GU seq2:A..CaGU seq3:AcgC.GU seq4:A..C.GU", "merge_rows() aligns by RF columns");
+is($merged->get_rf, "x..x.xx", "merge_rows() RF");
+is($merged->get_ss_cons, "<.....>", "merge_rows() SS_cons");
+
+my $dmrg1 = Bio::Easel::MSA->new({ fileLocation => "mrg1.sto" });
+my $dmrg2 = Bio::Easel::MSA->new({ fileLocation => "mrg2.sto" });
+$merged = $dmrg1->merge_rows([ $dmrg2 ]);
+is(rows($merged), "seq1:A--C-GU seq2:A--CAGU seq3:ACGC-GU seq4:A--C-GU", "merge_rows() in digital mode");
+
+eval { $mrg1->merge_rows([ $mrg3 ]); };
+ok($@, "merge_rows() dies with a different number of RF columns");
+eval { $mrg1->merge_rows([ $mrg1 ]); };
+ok($@, "merge_rows() dies with duplicated names");
+
+foreach my $file (keys %alnH) { unlink $file; }
@@ -0,0 +1,53 @@
+#! /usr/bin/perl
+#
+# Tests for growing an MSA one sequence at a time:
+# add_sequence_aligned().
+#
+use strict;
+use warnings FATAL => 'all';
+use Test::More tests => 16;
+
+BEGIN {
+  use_ok( 'Bio::Easel::MSA' ) || print "Bail out!\n";
+}
+
+my $alnfile = "./t/data/test.sto";
+my $msa = Bio::Easel::MSA->new({ fileLocation => $alnfile });
+my $nseq = $msa->nseq;
+my $sqstring = $msa->get_sqstring_aligned(1);
+my $checksum = $msa->row_checksum();
+# memoized, forgotten by add_sequence_aligned()
+$msa->average_id(1000);
+$msa->average_sqlen();
+$msa->count_residues();
+
+my $idx = $msa->add_sequence_aligned("elf", $sqstring);
+is($idx,                                $nseq,      "add_sequence_aligned() returns the new index");
+is($msa->nseq,                          $nseq+1,    "add_sequence_aligned() adds a sequence");
+is($msa->get_sqname($idx),              "elf",      "add_sequence_aligned() sets the name");
+is($msa->get_sqstring_aligned($idx),    $sqstring,  "add_sequence_aligned() sets the aligned sequence");
+is($msa->get_sqidx("elf"),              $idx,       "add_sequence_aligned() adds the name to the index");
+isnt($msa->row_checksum(),              $checksum,  "add_sequence_aligned() changes row_checksum()");
+
+# many sequences, past several reallocations
+for(my $i = 0; $i < 100; $i++) { $msa->add_sequence_aligned("seq$i", $msa->get_sqstring_aligned($i % $nseq)); }
+is($msa->nseq, $nseq+101, "add_sequence_aligned() adds many sequences");
+is($msa->get_sqidx("seq77"), $nseq+78, "add_sequence_aligned() index is right after growing");
+
+# same as an MSA read from a file with the same sequences
+my $outfile = "add-sequence.sto";
+$msa->write_msa($outfile);
+my $readmsa = Bio::Easel::MSA->new({ fileLocation => $outfile });
+is($readmsa->row_checksum(), $msa->row_checksum(), "row_checksum() after add_sequence_aligned() is same as recomputed");
+is($msa->average_id(1000),   $readmsa->average_id(1000), "average_id() after add_sequence_aligned() is same as recomputed");
+is($msa->average_sqlen(),    $readmsa->average_sqlen(),  "average_sqlen() after add_sequence_aligned() is same as recomputed");
+is($msa->count_residues(),   $readmsa->count_residues(), "count_residues() after add_sequence_aligned() is same as recomputed");
+unlink $outfile;
+
+$msa->add_sequence_aligned("dwarf", $sqstring, 0.5);
+ok($msa->has_sqwgts && abs($msa->get_sqwgt($msa->nseq-1) - 0.5) < 0.0001, "add_sequence_aligned() sets the weight");
+
+eval { $msa->add_sequence_aligned("orc", $sqstring); };
+ok($@, "add_sequence_aligned() dies with a name already in the MSA");
+eval { $msa->add_sequence_aligned("hobbit", "ACGU"); };
+ok($@, "add_sequence_aligned() dies with a sequence of the wrong length");
@@ -0,0 +1,43 @@
+#! /usr/bin/perl
+#
+# Tests for mapping the columns of one alignment to those of another
+# of the same sequences: map_columns_to().
+#
+use strict;
+use warnings FATAL => 'all';
+use Test::More tests => 9;
+
+BEGIN {
+  use_ok( 'Bio::Easel::MSA' ) || print "Bail out!\n";
+}
+
+my %alnH = (
+  "map1.sto" => "# STOCKHOLM 1.0\n\ns1  AC-GU\ns2  A-CGU\ns3  ACG-U\ns4  ACGU-\ns5  AC-GU\ns6  AC-GU\ns7  AC-GU\ns8  ACGUA\n//\n",
+  "map2.sto" => "# STOCKHOLM 1.0\n\ns7  -ACGU\ns6  ACG-U\ns5  ACG-U\ns4  ACGUU\ns3  ACG-U\ns2  A-CGU\ns1  -ACGU\n//\n",
+);
+foreach my $file (keys %alnH) { 
+  open(OUT, ">", $file) || die "ERROR unable to open $file for writing";
+  print OUT $alnH{$file};
+  close(OUT);
+}
+
+my $msa1 = Bio::Easel::MSA->new({ fileLocation => "map1.sto" });
+my $msa2 = Bio::Easel::MSA->new({ fileLocation => "map2.sto" });
+my ($mapAR, $agreeAR, $nused) = $msa1->map_columns_to($msa2);
+is($nused, 6, "map_columns_to() uses sequences in both with the same length");
+is(join(",", @{$mapAR}), "1,2,3,4,5", "map_columns_to() maps columns");
+is(join(",", map { sprintf("%.3f", $_) } @{$agreeAR}), "0.667,0.600,1.000,0.600,1.000", "map_columns_to() returns agreement");
+
+($mapAR, $agreeAR, $nused) = $msa1->map_columns_to($msa1);
+is(join(",", @{$mapAR}), "1,2,3,4,5", "map_columns_to() maps columns of an MSA to itself");
+is(join(",", @{$agreeAR}), "1,1,1,1,1", "map_columns_to() of an MSA to itself agrees completely");
+is($nused, 8, "map_columns_to() of an MSA to itself uses all sequences");
+
+my $text2 = Bio::Easel::MSA->new({ fileLocation => "map2.sto", forceText => 1 });
+my ($textmapAR) = $msa1->map_columns_to($text2);
+is(join(",", @{$textmapAR}), "1,2,3,4,5", "map_columns_to() a text MSA");
+
+eval { $msa1->map_columns_to("map2.sto"); };
+ok($@, "map_columns_to() dies if not given an MSA");
+
+foreach my $file (keys %alnH) { unlink $file; }
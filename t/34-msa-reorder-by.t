@@ -0,0 +1,93 @@
+#! /usr/bin/perl
+#
+# Tests for sorting the sequences of an MSA in C: reorder_by().
+#
+use strict;
+use warnings FATAL => 'all';
+use Test::More tests => 17;
+
+BEGIN {
+  use_ok( 'Bio::Easel::MSA' ) || print "Bail out!\n";
+}
+
+my $alnfile = "reorder-by.sto";
+open(OUT, ">", $alnfile) || die "ERROR unable to open $alnfile for writing";
+print OUT <<'EOF2';
+# STOCKHOLM 1.0
+
+dseq  AAGACUUCGGAUCUGGCG
+bseq  AAGACUUCG-----GGCG
+eseq  CCGUCAGAGCAUAAACAU
+aseq  AAGACUUCGGAUC-----
+cseq  CCGUCAGAGCAUAAGCAU
+//
+EOF2
+close(OUT);
+
+sub names { 
+  my ($msa) = @_;
+  return join(",", map { $msa->get_sqname($_) } (0..$msa->nseq-1));
+}
+
+my $msa = Bio::Easel::MSA->new({ fileLocation => $alnfile });
+$msa->reorder_by("name");
+is(names($msa), "aseq,bseq,cseq,dseq,eseq", "reorder_by() sorts by name");
+$msa->reorder_by("name", { reverse => 1 });
+is(names($msa), "eseq,dseq,cseq,bseq,aseq", "reorder_by() reverses");
+
+# stable: ties keep their current order
+$msa->reorder_by("length");
+is(names($msa), "bseq,aseq,eseq,dseq,cseq", "reorder_by() sorts by length");
+is(join(",", map { $msa->get_sqlen($_) } (0..$msa->nseq-1)), "13,13,18,18,18", "reorder_by() moves sequences with names");
+
+$msa->reorder_by("identity", { reference => "cseq" });
+is(names($msa), "cseq,eseq,aseq,dseq,bseq", "reorder_by() sorts by identity to a reference name");
+$msa->reorder_by("identity", { reference => 3 });
+is(names($msa), "dseq,aseq,bseq,cseq,eseq", "reorder_by() sorts by identity to a reference index");
+
+# the name index follows the sequences
+is(join(",", map { $msa->get_sqidx($_) } qw(aseq bseq cseq dseq eseq)), "1,2,3,0,4", "reorder_by() updates the name index");
+$msa->reorder_all([qw(eseq dseq cseq bseq aseq)]);
+is(join(",", map { $msa->get_sqidx($_) } qw(aseq bseq cseq dseq eseq)), "4,3,2,1,0", "reorder_all() updates the name index");
+
+$msa->reorder_by("upgma");
+my $order = names($msa);
+ok($order =~ m/(cseq,eseq|eseq,cseq)/, "reorder_by() upgma keeps similar sequences together");
+$msa->reorder_by("single_linkage");
+is(join(",", sort split(",", names($msa))), "aseq,bseq,cseq,dseq,eseq", "reorder_by() single_linkage keeps all sequences");
+
+# weights move with their sequences
+$msa->weight_GSC();
+my %wgtH = map { ($msa->get_sqname($_) => $msa->get_sqwgt($_)) } (0..$msa->nseq-1);
+$msa->reorder_by("name");
+is(join(",", map { $msa->get_sqwgt($_) } (0..$msa->nseq-1)), join(",", map { $wgtH{$_} } sort keys %wgtH), "reorder_by() moves weights with sequences");
+$msa->reorder_by("weight");
+my @wgtA = map { $msa->get_sqwgt($_) } (0..$msa->nseq-1);
+is(join(",", @wgtA), join(",", sort { $a <=> $b } @wgtA), "reorder_by() sorts by weight");
+
+# a reference is a name before it's an index
+my $numfile = "reorder-by-num.sto";
+open(OUT, ">", $numfile) || die "ERROR unable to open $numfile for writing";
+print OUT <<'EOF2';
+# STOCKHOLM 1.0
+
+x  AAGACUUCGGAUCUGGCG
+y  CCGUCAGAGCAUAAACAU
+z  AAGACUUCGGAUC-----
+3  CCGUCAGAGCAUAAGCAU
+//
+EOF2
+close(OUT);
+my $nummsa = Bio::Easel::MSA->new({ fileLocation => $numfile });
+$nummsa->reorder_by("identity", { reference => "3" });
+is(names($nummsa), "3,y,z,x", "reorder_by() takes a reference named with digits as a name");
+$nummsa->reorder_by("identity", { reference => 2 });
+is(names($nummsa), "z,x,3,y", "reorder_by() takes a reference that isn't a name as an index");
+unlink $numfile;
+
+eval { $msa->reorder_by("colour"); };
+ok($@, "reorder_by() dies with an unknown key");
+eval { $msa->reorder_by("identity", { reference => "nosuchseq" }); };
+ok($@, "reorder_by() dies with an unknown reference");
+
+unlink $alnfile;
@@ -0,0 +1,71 @@
+#! /usr/bin/perl
+#
+# Tests for reading a sequence file into memory, and fetching
+# sequences from it: load_all(), unload(), is_loaded().
+#
+use strict;
+use warnings FATAL => 'all';
+use Test::More tests => 31;
+
+BEGIN {
+  use_ok( 'Bio::Easel::SqFile' ) || print "Bail out!\n";
+}
+
+my $infile = "./t/data/trna-100.fa";
+
+# everything fetched from memory should be the same as from the file,
+# in text (mode == 0) and digital (mode == 1) modes
+for(my $mode = 0; $mode <= 1; $mode++) { 
+  my $sqfile = Bio::Easel::SqFile->new({ fileLocation => $infile, forceDigital => $mode, forceIndex => 1 });
+  my $nseq   = $sqfile->nseq_ssi;
+  my $nres   = $sqfile->nres_ssi;
+  my @nameA  = map { $sqfile->fetch_seq_name_given_ssi_number($_) } (0..$nseq-1);
+  my @subA   = ([ "a", 13, 31, $nameA[0] ], [ "b", 31, 13, $nameA[1] ], [ "c", 5, 0, $nameA[2] ], [ "d", 7, 7, $nameA[3] ]);
+
+  my %expH = ();
+  $expH{fasta}  = $sqfile->fetch_seqs_given_names(\@nameA, 60);
+  $expH{fasta1} = $sqfile->fetch_seqs_given_names(\@nameA, -1);
+  $expH{sqstr}  = $sqfile->fetch_seq_to_sqstring($nameA[5]);
+  $expH{subs}   = $sqfile->fetch_subseqs(\@subA, 10);
+  $expH{rc1}    = $sqfile->fetch_subseq_to_sqstring($nameA[3], 7, 7, 1);
+  $expH{len}    = join(",", map { $sqfile->fetch_seq_length_given_name($_) } @nameA);
+
+  is($sqfile->is_loaded, 0, "is_loaded() is 0 before load_all() (mode $mode)");
+  is($sqfile->load_all, $nseq, "load_all() returns number of sequences (mode $mode)");
+  is($sqfile->is_loaded, 1, "is_loaded() is 1 after load_all() (mode $mode)");
+  is($sqfile->fetch_seqs_given_names(\@nameA, 60), $expH{fasta},  "fetch_seqs_given_names() from memory (mode $mode)");
+  is($sqfile->fetch_seqs_given_names(\@nameA, -1), $expH{fasta1}, "fetch_seqs_given_names() from memory, unlimited width (mode $mode)");
+  is($sqfile->fetch_seq_to_sqstring($nameA[5]),    $expH{sqstr},  "fetch_seq_to_sqstring() from memory (mode $mode)");
+  is($sqfile->fetch_subseqs(\@subA, 10),           $expH{subs},   "fetch_subseqs() from memory (mode $mode)");
+  is($sqfile->fetch_subseq_to_sqstring($nameA[3], 7, 7, 1), $expH{rc1}, "fetch_subseq_to_sqstring() single residue revcomp from memory (mode $mode)");
+  is(join(",", map { $sqfile->fetch_seq_length_given_name($_) } @nameA), $expH{len}, "fetch_seq_length_given_name() from memory (mode $mode)");
+  is($sqfile->nres_ssi, $nres, "nres_ssi() from memory (mode $mode)");
+  ok($sqfile->check_seq_exists($nameA[0]) && (! $sqfile->check_seq_exists("nosuchseq")) && 
+     $sqfile->check_subseq_exists($nameA[0], 1, 10) && (! $sqfile->check_subseq_exists($nameA[0], 1, 100000)), "check_*exists() from memory (mode $mode)");
+  eval { $sqfile->fetch_seq_to_fasta_string("nosuchseq"); };
+  ok($@, "fetching a sequence that doesn't exist from memory dies (mode $mode)");
+
+  $sqfile->unload();
+  is($sqfile->is_loaded, 0, "unload() frees the loaded file (mode $mode)");
+}
+
+# closing, or opening another file, drops the loaded sequences
+my $otherfile = "load-all-other.fa";
+open(OUT, ">", $otherfile) || die "ERROR unable to open $otherfile for writing";
+print OUT ">other1\nACGUACGUAC\n>other2\nGGGGCCCC\n";
+close(OUT);
+my $sqfile = Bio::Easel::SqFile->new({ fileLocation => $infile });
+my $name0  = $sqfile->fetch_seq_name_given_ssi_number(0);
+$sqfile->load_all();
+$sqfile->close_sqfile();
+is($sqfile->is_loaded, 0, "close_sqfile() frees the loaded file");
+$sqfile->load_all();
+$sqfile->open_sqfile($otherfile);
+is($sqfile->is_loaded, 0, "open_sqfile() on another file frees the loaded file");
+is($sqfile->nseq_ssi, 2, "nseq_ssi() after reopening on another file is from the new file");
+ok((! $sqfile->check_seq_exists($name0)) && $sqfile->fetch_seq_to_sqstring("other2") eq "GGGGCCCC", "fetching after reopening on another file reads the new file");
+$sqfile->close_sqfile();
+unlink($otherfile);
+unlink($otherfile . ".ssi");
+
+unlink("./t/data/trna-100.fa.ssi");
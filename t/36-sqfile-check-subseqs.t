@@ -0,0 +1,56 @@
+#! /usr/bin/perl
+#
+# Tests for checking many subsequences at once: check_subseqs_exist().
+#
+use strict;
+use warnings FATAL => 'all';
+use Test::More tests => 9;
+
+BEGIN {
+  use_ok( 'Bio::Easel::SqFile' ) || print "Bail out!\n";
+}
+
+my $infile = "./t/data/trna-100.fa";
+my $sqfile = Bio::Easel::SqFile->new({ fileLocation => $infile, forceIndex => 1 });
+
+# queries in no particular order, repeated names, in and out of range
+my @queryA = ();
+my $nseq = $sqfile->nseq_ssi;
+for(my $i = $nseq - 1; $i >= 0; $i -= 3) { 
+  my ($name, $L) = $sqfile->fetch_seq_name_and_length_given_ssi_number($i);
+  push(@queryA, [ $name, 1, $L ], [ $name, $L, 1 ], [ $name, 0, 5 ], [ $name, 2, $L + 1 ]);
+}
+push(@queryA, [ "nosuchseq", 1, 10 ], [ $queryA[0][0], 3, 4 ]);
+
+my @expA = map { $sqfile->check_seq_exists($_->[0]) ? $sqfile->check_subseq_exists(@{$_}) : -1 } @queryA;
+
+my $status = $sqfile->check_subseqs_exist(\@queryA);
+is(length($status), scalar(@queryA), "check_subseqs_exist() returns one status per subsequence");
+is(join(",", unpack("c*", $status)), join(",", @expA), "check_subseqs_exist() agrees with check_subseq_exists()");
+is(join(",", (unpack("c*", $status))[-2,-1]), "-1,1", "check_subseqs_exist() distinguishes missing sequences");
+is($sqfile->check_subseqs_exist([]), "", "check_subseqs_exist() with no subsequences");
+
+# from a file loaded into memory
+$sqfile->load_all();
+is(join(",", unpack("c*", $sqfile->check_subseqs_exist(\@queryA))), join(",", @expA), "check_subseqs_exist() after load_all()");
+$sqfile->unload();
+
+eval { $sqfile->check_subseqs_exist([ [ "tRNA5-sample1", 1 ] ]); };
+ok($@, "check_subseqs_exist() dies with a malformed subsequence");
+eval { $sqfile->check_subseqs_exist("tRNA5-sample1"); };
+ok($@, "check_subseqs_exist() dies without an array ref");
+
+# the names and lengths are read again for another file or index
+$sqfile->check_subseqs_exist(\@queryA);
+my $otherfile = "check-subseqs-other.fa";
+open(OUT, ">", $otherfile) || die "ERROR unable to open $otherfile for writing";
+print OUT ">$queryA[0][0]\nACGUA\n";
+close(OUT);
+$sqfile->open_sqfile($otherfile);
+is(join(",", unpack("c*", $sqfile->check_subseqs_exist([ [ $queryA[0][0], 1, 5 ], [ $queryA[0][0], 1, 6 ], [ $queryA[4][0], 1, 2 ] ]))), "1,0,-1", 
+   "check_subseqs_exist() after open_sqfile() on another file checks the new file");
+$sqfile->close_sqfile();
+unlink($otherfile);
+unlink($otherfile . ".ssi");
+
+unlink("./t/data/trna-100.fa.ssi");
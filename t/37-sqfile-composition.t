@@ -0,0 +1,81 @@
+#! /usr/bin/perl
+#
+# Tests for residue composition of a sequence file: composition_stats().
+#
+use strict;
+use warnings FATAL => 'all';
+use Test::More tests => 16;
+
+BEGIN {
+  use_ok( 'Bio::Easel::SqFile' ) || print "Bail out!\n";
+}
+
+my $seqfile = "composition.fa";
+open(OUT, ">", $seqfile) || die "ERROR unable to open $seqfile for writing";
+print OUT <<'EOF2';
+>seq1 first sequence
+ACGTacgtNN
+ACGT-n
+>seq2
+GGGGCCCCAATT
+>seq3 with a description
+acgtRYacgt*
+J
+EOF2
+close(OUT);
+
+my $sqfile = Bio::Easel::SqFile->new({ fileLocation => $seqfile });
+my $compHR = $sqfile->composition_stats({ alphabet => "DNA" });
+is($compHR->{alphabet}, "DNA", "composition_stats() returns alphabet");
+is(join(",", @{$compHR->{names}}), "seq1,seq2,seq3", "composition_stats() returns names");
+is(join(",", unpack("q*", $compHR->{length})), "16,12,12", "composition_stats() returns lengths");
+is(join(",", unpack("q*", $compHR->{counts})), "3,3,3,3,2,4,4,2,2,2,2,2", "composition_stats() returns residue counts");
+is(join(",", map { join(":", unpack("q*", $compHR->{$_})) } ("ambiguous", "softmasked", "other")), "3:0:2,5:0:8,1:0:2", "composition_stats() returns ambiguous, softmasked and other counts");
+is(join(",", map { sprintf("%.3f", $_) } unpack("d*", $compHR->{gc})), "0.500,0.667,0.500", "composition_stats() returns GC fractions");
+my $totHR = $compHR->{total};
+is(join(",", map { "$_:$totHR->{counts}{$_}" } sort keys %{$totHR->{counts}}), "A:7,C:9,G:9,T:7", "composition_stats() returns total residue counts");
+is(join(",", map { "$_:$totHR->{symbol_counts}{$_}" } sort keys %{$totHR->{symbol_counts}}), "*:1,-:1,A:7,C:9,G:9,N:3,R:1,T:7,Y:1", "composition_stats() returns total symbol counts");
+is(join(",", map { $totHR->{$_} } ("length", "ambiguous", "softmasked", "other", "illegal")), "40,5,13,3,1", "composition_stats() returns totals");
+undef $sqfile;
+
+# digital mode: alphabet of the file
+$sqfile = Bio::Easel::SqFile->new({ fileLocation => $seqfile, forceDigital => 1, isDna => 1 });
+my $dcompHR = $sqfile->composition_stats();
+is($dcompHR->{alphabet}, "DNA", "composition_stats() uses alphabet of a digital file");
+is($dcompHR->{counts} . $dcompHR->{softmasked}, $compHR->{counts} . $compHR->{softmasked}, "composition_stats() is the same in digital mode");
+eval { $sqfile->composition_stats({ alpha => "DNA" }); };
+ok($@, "composition_stats() dies with an unknown option");
+undef $sqfile;
+
+# a file of a few MB is split into byte ranges, some of which start
+# inside headers and sequence lines: same counts as perl's
+srand(7);
+my @symA = split(//, "ACGTACGTacgtNnRY-");
+my %expH = ();
+open(OUT, ">", $seqfile) || die "ERROR unable to open $seqfile for writing";
+for(my $i = 1; $i <= 6; $i++) { 
+  my $L = ($i == 3) ? 2000000 : int(rand(300000)) + 1;
+  my $seq = join("", map { $symA[int(rand(scalar(@symA)))] } (1..$L));
+  printf OUT (">s%d %s\n", $i, "x" x ($i * 20000));
+  for(my $j = 0; $j < $L; $j += 60) { print OUT substr($seq, $j, 60) . "\n"; }
+  $expH{"s$i"} = join(":", $L, ($seq =~ tr/Aa//), ($seq =~ tr/Cc//), ($seq =~ tr/Gg//), ($seq =~ tr/Tt//), ($seq =~ tr/NnRY//), ($seq =~ tr/acgtn//), ($seq =~ tr/-//));
+}
+close(OUT);
+ok(-s $seqfile > 2 * (1 << 20), "test file is larger than two blocks");
+
+$sqfile = Bio::Easel::SqFile->new({ fileLocation => $seqfile });
+$compHR = $sqfile->composition_stats({ alphabet => "DNA" });
+my @lenA = unpack("q*", $compHR->{length});
+my @cntA = unpack("q*", $compHR->{counts});
+my @ambA = unpack("q*", $compHR->{ambiguous});
+my @sftA = unpack("q*", $compHR->{softmasked});
+my @othA = unpack("q*", $compHR->{other});
+my @gotA = ();
+for(my $i = 0; $i < $compHR->{nseq}; $i++) { 
+  push(@gotA, join(":", $lenA[$i], @cntA[(4*$i)..(4*$i+3)], $ambA[$i], $sftA[$i], $othA[$i]));
+}
+is(join(",", @{$compHR->{names}}), "s1,s2,s3,s4,s5,s6", "composition_stats() returns names of a split file");
+is(join(",", @gotA), join(",", map { $expH{"s$_"} } (1..6)), "composition_stats() counts of a split file are correct");
+undef $sqfile;
+
+unlink $seqfile;
@@ -0,0 +1,45 @@
+#! /usr/bin/perl
+#
+# Tests for the length distribution of a sequence file, from its SSI
+# index: length_stats().
+#
+use strict;
+use warnings FATAL => 'all';
+use Test::More tests => 10;
+
+BEGIN {
+  use_ok( 'Bio::Easel::SqFile' ) || print "Bail out!\n";
+}
+
+my $seqfile = "length-stats.fa";
+open(OUT, ">", $seqfile) || die "ERROR unable to open $seqfile for writing";
+my $i = 1;
+foreach my $L (30, 10, 50, 20, 40) { 
+  printf OUT (">seq%d\n%s\n", $i++, "ACGUACGUAC" x ($L / 10));
+}
+close(OUT);
+
+my $sqfile = Bio::Easel::SqFile->new({ fileLocation => $seqfile, forceIndex => 1 });
+my $statsHR = $sqfile->length_stats({ binsize => 20 });
+is(join(",", map { $statsHR->{$_} } ("count", "total", "min", "max", "mean")), "5,150,10,50,30", "length_stats() returns count, total, min, max and mean");
+is($statsHR->{N50}, 40, "length_stats() returns N50");
+is($statsHR->{L50}, 2,  "length_stats() returns L50");
+is(join(" ", map { join(",", @{$_}) } @{$statsHR->{histogram}}), "0,19,1 20,39,2 40,59,2", "length_stats() returns histogram with bin size");
+
+$statsHR = $sqfile->length_stats({ nbins => 4 });
+is($statsHR->{binsize}, 11, "length_stats() splits min..max into nbins bins");
+is(join(" ", map { join(",", @{$_}) } @{$statsHR->{histogram}}), "10,20,2 21,31,1 32,42,1 43,53,1", "length_stats() returns histogram with nbins");
+
+$sqfile->load_all();
+my $loadedHR = $sqfile->length_stats({ nbins => 4 });
+is_deeply($loadedHR, $statsHR, "length_stats() is the same for a loaded file");
+$sqfile->unload();
+
+eval { $sqfile->length_stats({ binsize => 10, nbins => 3 }); };
+ok($@, "length_stats() dies with both binsize and nbins");
+eval { $sqfile->length_stats({ bins => 3 }); };
+ok($@, "length_stats() dies with an unknown option");
+
+undef $sqfile;
+unlink $seqfile;
+unlink $seqfile . ".ssi";
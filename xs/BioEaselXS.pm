@@ -0,0 +1,277 @@
+package BioEaselXS;
+
+# Build support for the precompiled (XS) build of Bio-Easel's C code.
+#
+# lib/Bio/Easel/<Module>.c is written for Inline::C: every function
+# whose argument and return types are in a typemap is callable from
+# Perl, and functions that return lists do so with the Inline_Stack_*
+# macros. For the XS build we generate, for each of those C files,
+# the XS glue that Inline would have generated (xs/<Module>/<Module>XS.xs,
+# which #includes the C file itself) and compile it once against
+# libeasel at 'make' time, so no compiler, Inline or source checksum
+# is involved when the module is loaded.
+#
+# Each xs/<Module>/Makefile.PL is just:
+#   use lib '..'; use BioEaselXS; BioEaselXS::write_makefile('<Module>');
+
+use strict;
+use warnings;
+use Carp;
+use Config;
+use Cwd qw(abs_path);
+use File::Basename qw(dirname);
+use File::Spec;
+use ExtUtils::MakeMaker;
+
+our $VERSION = '0.01';
+
+my $xs_dir  = abs_path(dirname(__FILE__));
+my $top_dir = abs_path(File::Spec->catdir($xs_dir, File::Spec->updir()));
+
+#-------------------------------------------------------------------------------
+# write_makefile($base): write the Makefile for Bio::Easel::$base in
+#                        the current directory (xs/$base).
+sub write_makefile {
+  my ($base) = @_;
+
+  my $c_file     = File::Spec->catfile($top_dir, 'lib', 'Bio', 'Easel', "$base.c");
+  my $pm_file    = File::Spec->catfile($top_dir, 'lib', 'Bio', 'Easel', "$base.pm");
+  my $typemap    = File::Spec->catfile($top_dir, 'lib', 'Bio', 'Easel', "$base.typemap");
+  my $easel_dir  = File::Spec->catdir($top_dir, 'src', 'easel');
+  my $module_dir = File::Spec->catdir($top_dir, 'lib', 'Bio', 'Easel');
+  my $xs_file    = "${base}XS.xs";
+  my @typemapA   = (-e $typemap) ? ($typemap) : ();
+
+  write_xs("Bio::Easel::$base", $c_file, \@typemapA, $xs_file);
+
+  # LTO/PGO flags, if any, are needed both when compiling and when
+  # linking against libeasel (which was built with the same flags)
+  my %optH = ();
+  my $profile_flags = profile_flags();
+  if($profile_flags ne "") {
+    $optH{OPTIMIZE}  = "$Config{optimize} $profile_flags";
+    $optH{LDDLFLAGS} = "$Config{lddlflags} $Config{optimize} $profile_flags";
+  }
+
+  WriteMakefile(
+    NAME          => "Bio::Easel::$base",
+    VERSION_FROM  => $pm_file,
+    XS            => { $xs_file => "${base}XS.c" },
+    OBJECT        => "${base}XS\$(OBJ_EXT)",
+    INC           => "-I$easel_dir -I$module_dir -I$xs_dir",
+    LIBS          => [ "-L$easel_dir -leasel -lm -lpthread" ],
+    TYPEMAPS      => \@typemapA,
+    PM            => {},  # the .pm files are installed by the top level Makefile
+    MAN3PODS      => {},
+    NO_META       => 1,
+    NO_MYMETA     => 1,
+    depend        => { "${base}XS\$(OBJ_EXT)" => "$c_file " . File::Spec->catfile($xs_dir, 'INLINE.h') },
+    clean         => { FILES => "$xs_file ${base}XS.c" },
+    %optH,
+  );
+
+  # regenerate the XS glue whenever the C file changes
+  open(my $MAKEFILE, '>>', 'Makefile') or croak "can't append XS generation rule to Makefile: $!";
+  print $MAKEFILE qq(
+# --- Bio-Easel XS generation section:
+$xs_file : $c_file
+\t\$(PERL) -I$xs_dir -MBioEaselXS -e 'BioEaselXS::write_xs("Bio::Easel::$base", "$c_file", [ qw(@typemapA) ], "$xs_file")'
+);
+  close($MAKEFILE);
+
+  return;
+}
+
+#-------------------------------------------------------------------------------
+# profile_flags(): compiler flags for the optimized build profile
+#   requested by the environment (set by the top level Makefile.PL
+#   from its --lto and --pgo options), "" for a default build:
+#     BIO_EASEL_LTO:     if set, link time optimization (-flto), which
+#                        lets the compiler inline libeasel functions
+#                        such as esl_abc_DCount() and esl_dst_XPairId()
+#                        into our own loops
+#     BIO_EASEL_PGO:     'generate': build instrumented, to write a profile
+#                                    when run ('make pgo-train')
+#                        'use':      build using that profile
+#     BIO_EASEL_PGO_DIR: directory for the profile (default: pgo-data)
+sub profile_flags {
+  my @flagA = ();
+
+  if($ENV{BIO_EASEL_LTO}) {
+    push(@flagA, "-flto");
+  }
+  my $pgo = (defined $ENV{BIO_EASEL_PGO}) ? $ENV{BIO_EASEL_PGO} : "";
+  if($pgo ne "") {
+    my $pgo_dir = pgo_dir();
+    if   ($pgo eq "generate") { push(@flagA, "-fprofile-generate=$pgo_dir"); }
+    elsif($pgo eq "use")      { push(@flagA, "-fprofile-use=$pgo_dir", "-fprofile-correction", "-Wno-missing-profile"); }
+    else                      { croak "BIO_EASEL_PGO must be 'generate' or 'use', not '$pgo'"; }
+  }
+
+  return join(" ", @flagA);
+}
+
+#-------------------------------------------------------------------------------
+# pgo_dir(): absolute path of the profile directory for PGO builds
+sub pgo_dir {
+  my $dir = (defined $ENV{BIO_EASEL_PGO_DIR}) ? $ENV{BIO_EASEL_PGO_DIR} : File::Spec->catdir($top_dir, 'pgo-data');
+  return File::Spec->rel2abs($dir);
+}
+
+#-------------------------------------------------------------------------------
+# write_xs($module, $c_file, $typemapAR, $xs_file): write XS glue for
+#   every function in $c_file that Inline::C would bind, given the core
+#   typemap plus the typemaps in @{$typemapAR}.
+sub write_xs {
+  my ($module, $c_file, $typemapAR, $xs_file) = @_;
+
+  my %typeH = typemap_types(core_typemap(), @{$typemapAR});
+  my @funcA = grep { is_bindable($_, \%typeH) } c_functions($c_file);
+  if(scalar(@funcA) == 0) { croak "no functions to bind in $c_file"; }
+
+  my $rel_c_file = File::Spec->abs2rel($c_file);
+  open(my $XS, '>', $xs_file) or croak "can't open $xs_file for writing: $!";
+  print $XS qq(/* Generated from $rel_c_file by xs/BioEaselXS.pm, do not edit. */
+#include "EXTERN.h"
+#include "perl.h"
+#include "XSUB.h"
+#include "INLINE.h"
+
+#include "$c_file"
+
+MODULE = $module\tPACKAGE = $module
+
+PROTOTYPES: DISABLE
+
+);
+  foreach my $func (@funcA) {
+    my @argnameA = map { $_->[1] } @{$func->{args}};
+    my $arglist  = join(", ", @argnameA);
+    print $XS "\n$func->{rtype}\n$func->{name} ($arglist)\n";
+    foreach my $arg (@{$func->{args}}) {
+      print $XS "\t$arg->[0]\t$arg->[1]\n";
+    }
+    if($func->{rtype} eq "void") {
+      # as Inline::C does: a void function either returns nothing, or
+      # pushed a list with Inline_Stack_*, which pops our mark
+      print $XS qq(        PREINIT:
+        I32* temp;
+        PPCODE:
+        temp = PL_markstack_ptr++;
+        $func->{name}($arglist);
+        if (PL_markstack_ptr != temp) {
+          /* truly void, because dXSARGS not invoked */
+          PL_markstack_ptr = temp;
+          XSRETURN_EMPTY; /* return empty stack */
+        }
+        /* must have used dXSARGS; list context implied */
+        return; /* assume stack size is correct */
+);
+    }
+  }
+  close($XS);
+
+  return;
+}
+
+#-------------------------------------------------------------------------------
+# c_functions($c_file): return list of hash refs, one per function
+#   defined in $c_file: { rtype => 'SV *', name => '_c_foo',
+#   args => [ [ 'ESL_MSA *', 'msa' ], ... ] }. Function definitions
+#   start in column 0, as everywhere in lib/Bio/Easel/*.c.
+sub c_functions {
+  my ($c_file) = @_;
+
+  open(my $IN, '<', $c_file) or croak "can't open $c_file: $!";
+  my $code = do { local $/; <$IN> };
+  close($IN);
+
+  # remove comments, string and character literals, and preprocessor lines
+  $code =~ s{/\*.*?\*/}{ }gs;
+  $code =~ s{//[^\n]*}{}g;
+  $code =~ s{"(?:\\.|[^"\\])*"}{""}g;
+  $code =~ s{'(?:\\.|[^'\\])*'}{''}g;
+  $code =~ s{^\s*#[^\n]*(?:\\\n[^\n]*)*}{}mg;
+
+  my @funcA = ();
+  while($code =~ m{^([A-Za-z_][\w\s\*]*?)\b([A-Za-z_]\w*)\s*\(([^()]*)\)\s*\{}mg) {
+    my ($rtype, $name, $args) = ($1, $2, $3);
+    $rtype = normalize_type($rtype);
+    if($rtype =~ m/^(?:if|for|while|switch|return|else|typedef|struct|enum|union)\b/) { next; }
+    my @argA  = ();
+    my $ok    = 1;
+    $args =~ s/^\s+|\s+$//g;
+    if($args ne "" && $args ne "void") {
+      foreach my $arg (split(/,/, $args)) {
+        if($arg !~ m/^\s*(.*?[\s\*])([A-Za-z_]\w*)\s*$/s) { $ok = 0; last; } # '...' or unnamed arg
+        push(@argA, [ normalize_type($1), $2 ]);
+      }
+    }
+    push(@funcA, { rtype => $rtype, name => $name, args => \@argA, ok => $ok });
+  }
+
+  return @funcA;
+}
+
+#-------------------------------------------------------------------------------
+# normalize_type($type): 'ESL_MSA*' -> 'ESL_MSA *', drop 'static'
+#   and 'inline' storage classes, collapse whitespace
+sub normalize_type {
+  my ($type) = @_;
+
+  $type =~ s/\b(?:static|inline|extern)\b//g;
+  $type =~ s/\s*\*\s*/ */g;
+  1 while $type =~ s/\*\s+\*/**/;
+  $type =~ s/\s+/ /g;
+  $type =~ s/^\s+|\s+$//g;
+
+  return $type;
+}
+
+#-------------------------------------------------------------------------------
+# is_bindable($func, $typeHR): TRUE if Inline::C would bind $func:
+#   all argument types and the return type are in the typemaps
+sub is_bindable {
+  my ($func, $typeHR) = @_;
+
+  if(! $func->{ok}) { return 0; }
+  if($func->{rtype} ne "void" && (! exists $typeHR->{$func->{rtype}})) { return 0; }
+  foreach my $arg (@{$func->{args}}) {
+    if(! exists $typeHR->{$arg->[0]}) { return 0; }
+  }
+  return 1;
+}
+
+#-------------------------------------------------------------------------------
+# core_typemap(): path to perl's own typemap
+sub core_typemap {
+  foreach my $dir (@INC, $Config{privlibexp}) {
+    my $file = File::Spec->catfile($dir, 'ExtUtils', 'typemap');
+    if(-e $file) { return $file; }
+  }
+  croak "can't find perl's ExtUtils/typemap";
+}
+
+#-------------------------------------------------------------------------------
+# typemap_types(@files): return hash of all C types in the TYPEMAP
+#   sections of @files, keys are normalized types
+sub typemap_types {
+  my (@fileA) = @_;
+
+  my %typeH = ();
+  foreach my $file (@fileA) {
+    open(my $IN, '<', $file) or croak "can't open typemap $file: $!";
+    my $section = "TYPEMAP";
+    while(my $line = <$IN>) {
+      chomp $line;
+      if($line =~ m/^(TYPEMAP|INPUT|OUTPUT)\s*$/) { $section = $1; next; }
+      if($section ne "TYPEMAP" || $line =~ m/^\s*(?:#|$)/) { next; }
+      if($line =~ m/^\s*(.*?)\s+(\S+)\s*$/) { $typeH{normalize_type($1)} = $2; }
+    }
+    close($IN);
+  }
+
+  return %typeH;
+}
+
+1;
@@ -0,0 +1,29 @@
+/* The Inline_Stack_* macros lib/Bio/Easel/<Module>.c use to return lists,
+ * as defined by Inline::C, for the XS build (see xs/BioEaselXS.pm).
+ */
+#define Inline_Stack_Vars	dXSARGS
+#define Inline_Stack_Items      items
+#define Inline_Stack_Item(x)	ST(x)
+#define Inline_Stack_Reset      sp = mark
+#define Inline_Stack_Push(x)	XPUSHs(x)
+#define Inline_Stack_Done	PUTBACK
+#define Inline_Stack_Return(x)	XSRETURN(x)
+#define Inline_Stack_Void       XSRETURN(0)
+
+#define INLINE_STACK_VARS	Inline_Stack_Vars
+#define INLINE_STACK_ITEMS	Inline_Stack_Items
+#define INLINE_STACK_ITEM(x)	Inline_Stack_Item(x)
+#define INLINE_STACK_RESET	Inline_Stack_Reset
+#define INLINE_STACK_PUSH(x)    Inline_Stack_Push(x)
+#define INLINE_STACK_DONE	Inline_Stack_Done
+#define INLINE_STACK_RETURN(x)	Inline_Stack_Return(x)
+#define INLINE_STACK_VOID	Inline_Stack_Void
+
+#define inline_stack_vars	Inline_Stack_Vars
+#define inline_stack_items	Inline_Stack_Items
+#define inline_stack_item(x)	Inline_Stack_Item(x)
+#define inline_stack_reset	Inline_Stack_Reset
+#define inline_stack_push(x)    Inline_Stack_Push(x)
+#define inline_stack_done	Inline_Stack_Done
+#define inline_stack_return(x)	Inline_Stack_Return(x)
+#define inline_stack_void	Inline_Stack_Void